@@ -0,0 +1,341 @@
+/**
+ * @file fontBench.c
+ * @brief Microbenchmark of loading the font, looking characters up and walking their strokes.
+ * @details
+ * Prints the memory the font data takes, then times the things it is used for, each repeated
+ * until it has run for a measurable time:
+ * - load: construct, parse and free the font, as main() does once per run;
+ * - binary: the same with the font compiled into a binary font file, which is mapped;
+ * - large: the same with a synthetic text font of BENCH_LARGE_GLYPHS characters and about
+ *   113000 strokes, written to a temporary file, the size of a font covering a script such as CJK;
+ * - lookup: look up every character of a text in the font, read as UTF-8 as RobotWriter reads it;
+ * - iterate: look up every character of a text in the font and scale all of its strokes;
+ * - cached: look up every character of a text in a warm glyph cache, as generate_gcode() does,
+ *   and read all of its strokes;
+ * - sizes: the same, with every pass over the text at the next of BENCH_SIZES sizes in turn, as
+ *   a batch of jobs at several heights does.
+ *
+ * The sums of the lookups and strokes are printed with the timings, which keeps the compiler from
+ * dropping the loops and shows that two builds read the same font. The memory the glyph cache
+ * holds is printed after the text has been drawn at one size and at BENCH_SIZES sizes.
+ *
+ * Usage: FontBench [font file] [text file]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L /**< clock_gettime(). */
+#endif
+
+#include "../font/fontData.h"
+#include "../font/glyphCache.h"
+#include "../misc/utf8.h"
+#include "../robot/robot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_TEXT_SIZE 65536        /**< Most bytes of the text file used. */
+#define BENCH_MIN_SECONDS 0.5        /**< Shortest time each measurement runs for. */
+#define BENCH_SCALE (5.0 / 18.0)     /**< Scale factor of the strokes read, that of 5 mm text. */
+#define BENCH_SIZES 4                /**< Sizes drawn in turn by the sizes measurement. */
+#define BENCH_BINARY "FontBench.rwf" /**< Binary font file written for the binary measurement. */
+#define BENCH_LARGE "FontBench.txt"  /**< Text font file written for the large measurement. */
+#define BENCH_LARGE_GLYPHS 5000      /**< Characters of the large font. */
+#define BENCH_LARGE_FIRST 0x4E00     /**< Code point of the first character of the large font. */
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Loads the font and frees it again.
+ * @param[in] fontFile Font file to parse.
+ * @return Strokes in the font, or 0 if it could not be loaded.
+ */
+static size_t Load(const char *const fontFile);
+
+/**
+ * @brief Writes a text font of BENCH_LARGE_GLYPHS characters with 16 to 29 strokes each.
+ * @details The strokes follow a fixed pseudo-random sequence, so every run parses the same font.
+ * @param[in] fontFile Font file to write.
+ * @return Bytes written, or 0 if the file could not be written.
+ */
+static long WriteLargeFont(const char *const fontFile);
+
+/**
+ * @brief Looks up every character of the text.
+ * @param[in] fontData The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke counts of the characters found.
+ */
+static unsigned long Lookup(const fontData_t *const fontData, const char *text, const size_t length);
+
+/**
+ * @brief Looks up every character of the text and reads its strokes.
+ * @param[in] fontData The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke vectors and pen states read.
+ */
+static double Iterate(const fontData_t *const fontData, const char *text, const size_t length);
+
+/**
+ * @brief Looks up every character of the text in the glyph cache and reads its strokes.
+ * @param[in,out] cache The glyph cache.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @param[in] scale Scale factor to draw the characters at.
+ * @return Sum of the stroke vectors and pen states read.
+ */
+static double Cached(glyphCache_t *const cache, const char *text, const size_t length, const double scale);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const char *fontFile = argc > 1 ? argv[1] : FONT_FILE;
+    const char *textFile = argc > 2 ? argv[2] : "test.txt";
+
+    // Read the text
+    static char text[BENCH_TEXT_SIZE];
+    FILE *file = fopen(textFile, "r");
+    if (!file)
+    {
+        perror(textFile);
+        return EXIT_FAILURE;
+    }
+    const size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+
+    // Load the font once for the lookups
+    fontData_t *fontData = fontDataConstructor();
+    if (!fontData || fontData->parse(fontData, fontFile) != SUCCESS)
+        return EXIT_FAILURE;
+    glyphCache_t *cache = glyphCacheConstructor(fontData);
+    if (!cache)
+        return EXIT_FAILURE;
+
+    // Memory
+    const fontTable_t *const table = &fontData->table;
+    const size_t directorySize = table->numBlocks * sizeof(uint16_t);
+    const size_t pageSize = FONT_PAGE_SIZE * sizeof(fontCharacter_t);
+    printf("memory:  %10lu bytes (%lu directory + %lu pages of %lu bytes + %lu strokes of %lu bytes)\n",
+           (unsigned long)(directorySize + table->numPages * pageSize + table->numStrokes * sizeof(stroke_t)),
+           (unsigned long)directorySize, (unsigned long)table->numPages, (unsigned long)pageSize,
+           (unsigned long)table->numStrokes, (unsigned long)sizeof(stroke_t));
+    const size_t metricsSize = table->numPages * FONT_PAGE_SIZE * sizeof(fontMetrics_t);
+    printf("metrics: %10lu bytes (%lu pages of %lu bytes)\n", (unsigned long)metricsSize,
+           (unsigned long)table->numPages, (unsigned long)(FONT_PAGE_SIZE * sizeof(fontMetrics_t)));
+
+    // Load
+    unsigned long rounds = 0;
+    size_t strokes = 0;
+    double start = Now();
+    double elapsed;
+    do
+    {
+        strokes = Load(fontFile);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    printf("load:    %10.1f us per font (%lu strokes)\n", 1e6 * elapsed / rounds, (unsigned long)strokes);
+
+    // Binary, from a binary font compiled from the font
+    if (fontData->save(fontData, BENCH_BINARY) != SUCCESS)
+        return EXIT_FAILURE;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        strokes = Load(BENCH_BINARY);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    remove(BENCH_BINARY);
+    printf("binary:  %10.1f us per font (%lu strokes)\n", 1e6 * elapsed / rounds, (unsigned long)strokes);
+
+    // Large, from a synthetic font written for it
+    const long largeSize = WriteLargeFont(BENCH_LARGE);
+    if (largeSize == 0)
+        return EXIT_FAILURE;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        strokes = Load(BENCH_LARGE);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    remove(BENCH_LARGE);
+    printf("large:   %10.1f us per font (%d characters, %lu strokes, %ld bytes)\n", 1e6 * elapsed / rounds,
+           BENCH_LARGE_GLYPHS, (unsigned long)strokes, largeSize);
+
+    // Lookup
+    unsigned long found = 0;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        found += Lookup(fontData, text, length);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    printf("lookup:  %10.2f ns per character (%lu strokes per pass)\n", 1e9 * elapsed / (rounds * length),
+           found / rounds);
+
+    // Iterate
+    double sum = 0.0;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        sum += Iterate(fontData, text, length);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    printf("iterate: %10.2f ns per character (checksum %.3f)\n", 1e9 * elapsed / (rounds * length), sum / rounds);
+
+    // Cached, after a pass to warm the cache
+    Cached(cache, text, length, BENCH_SCALE);
+    sum = 0.0;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        sum += Cached(cache, text, length, BENCH_SCALE);
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    printf("cached:  %10.2f ns per character (checksum %.3f)\n", 1e9 * elapsed / (rounds * length), sum / rounds);
+    printf("cache:   %10lu bytes at 1 size (%lu characters scaled)\n", (unsigned long)cache->bytes, cache->built);
+
+    // Sizes, after a pass to warm the cache
+    for (int size = 1; size <= BENCH_SIZES; size++)
+        Cached(cache, text, length, BENCH_SCALE * size);
+    const unsigned long built = cache->built;
+    rounds = 0;
+    start = Now();
+    do
+    {
+        Cached(cache, text, length, BENCH_SCALE * (1 + rounds % BENCH_SIZES));
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    printf("sizes:   %10.2f ns per character (%d sizes, %lu characters scaled, %lu after warm-up)\n",
+           1e9 * elapsed / (rounds * length), BENCH_SIZES, built, cache->built - built);
+    printf("cache:   %10lu bytes at %d sizes\n", (unsigned long)cache->bytes, BENCH_SIZES);
+
+    cache->free(cache);
+    fontData->free(fontData);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static size_t Load(const char *const fontFile)
+{
+    fontData_t *fontData = fontDataConstructor();
+    if (!fontData)
+        return 0;
+
+    size_t strokes = 0;
+    if (fontData->parse(fontData, fontFile) == SUCCESS)
+        strokes = fontData->table.numStrokes;
+    fontData->free(fontData);
+    return strokes;
+}
+
+static long WriteLargeFont(const char *const fontFile)
+{
+    FILE *file = fopen(fontFile, "w");
+    if (!file)
+    {
+        perror(fontFile);
+        return 0;
+    }
+
+    unsigned long state = 12345;
+    for (int i = 0; i < BENCH_LARGE_GLYPHS; i++)
+    {
+        const int numStrokes = 16 + i % 14;
+        fprintf(file, "999 %d %d\n", BENCH_LARGE_FIRST + i, numStrokes);
+        for (int k = 0; k < numStrokes; k++)
+        {
+            state = state * 1103515245UL + 12345UL;
+            const int x = (int)((state >> 8) % 46);
+            const int y = (int)((state >> 16) % 40) - 10;
+            fprintf(file, "%d %d %d\n", x, y, k > 0 && (state >> 24) % 5 != 0);
+        }
+    }
+
+    const long size = ftell(file);
+    if (fclose(file) != 0 || size <= 0)
+    {
+        perror(fontFile);
+        return 0;
+    }
+    return size;
+}
+
+static unsigned long Lookup(const fontData_t *const fontData, const char *text, const size_t length)
+{
+    const char *const end = text + length;
+    unsigned long found = 0;
+    while (text < end)
+    {
+        const fontCharacter_t *const fontChar = fontData->lookup(fontData, Utf8Decode(&text, end));
+        if (fontChar)
+            found += fontChar->numStrokes;
+    }
+    return found;
+}
+
+static double Iterate(const fontData_t *const fontData, const char *text, const size_t length)
+{
+    const char *const end = text + length;
+    double sum = 0.0;
+    while (text < end)
+    {
+        const fontCharacter_t *const fontChar = fontData->lookup(fontData, Utf8Decode(&text, end));
+        if (!fontChar)
+            continue;
+
+        const stroke_t *const strokes = &fontData->table.strokes[fontChar->first];
+        for (uint8_t i = 0; i < fontChar->numStrokes; i++)
+        {
+            const Vect2d_t vec = StrokeVector(strokes[i], BENCH_SCALE);
+            sum += vec.x + vec.y + StrokePenDown(strokes[i]);
+        }
+    }
+    return sum;
+}
+
+static double Cached(glyphCache_t *const cache, const char *text, const size_t length, const double scale)
+{
+    const char *const end = text + length;
+    double sum = 0.0;
+    while (text < end)
+    {
+        const glyph_t *const glyph = cache->lookup(cache, Utf8Decode(&text, end), scale);
+        if (!glyph)
+            continue;
+
+        for (uint8_t i = 0; i < glyph->numStrokes; i++)
+            sum += glyph->strokes[i].vec.x + glyph->strokes[i].vec.y + glyph->strokes[i].penDown;
+    }
+    return sum;
+}
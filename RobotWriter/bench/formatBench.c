@@ -0,0 +1,171 @@
+/**
+ * @file formatBench.c
+ * @brief Microbenchmark of building G-code move lines with FormatFixed() against snprintf().
+ * @details
+ * Builds "S1000 G1 X<x> Y<y>" lines for a fixed set of pseudo-random positions on the drawing
+ * area, each way repeated until it has run for a measurable time:
+ * - snprintf: one snprintf("%.*f") call for the whole line, as lines were built before;
+ * - fixed: the words copied and both numbers written with FormatFixed();
+ * - writer: gcodeWriter_t::move() in full mode, as RobotWriter builds its lines;
+ * - compact: gcodeWriter_t::move() in compact mode, with modal compression.
+ *
+ * Before timing, the lines of snprintf, fixed and writer are compared byte for byte, and the
+ * mismatches are printed; any at all means FormatFixed() no longer matches printf(). The sums of
+ * the bytes built are printed with the timings, which keeps the compiler from dropping the loops.
+ *
+ * Usage: FormatBench [decimals]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L /**< clock_gettime(). */
+#endif
+
+#include "../robot/gcodeFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_POINTS 4096     /**< Positions formatted per pass. */
+#define BENCH_MIN_SECONDS 0.5 /**< Shortest time each measurement runs for. */
+#define BENCH_WIDTH_MM 250.0  /**< Width of the area the positions are spread over. */
+#define BENCH_HEIGHT_MM 120.0 /**< Height of the area the positions are spread over, below Y = 0. */
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Fills the positions with a repeatable pseudo-random sequence.
+ * @param[out] points BENCH_POINTS positions.
+ */
+static void MakePoints(Coord2D_t *const points);
+
+/**
+ * @brief Builds a line with snprintf().
+ * @param[out] out Destination with room for GCODE_LINE_LENGTH characters.
+ * @param[in] pos Target position.
+ * @param[in] decimals Number of decimals.
+ * @return Length of the line.
+ */
+static size_t LinePrintf(char *const out, const Coord2D_t pos, const int decimals);
+
+/**
+ * @brief Builds a line with FormatFixed().
+ * @param[out] out Destination with room for GCODE_LINE_LENGTH characters.
+ * @param[in] pos Target position.
+ * @param[in] decimals Number of decimals.
+ * @return Length of the line.
+ */
+static size_t LineFixed(char *const out, const Coord2D_t pos, const int decimals);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const int decimals = argc > 1 ? atoi(argv[1]) : GCODE_DECIMALS;
+    if (decimals < 0 || decimals > GCODE_MAX_DECIMALS)
+    {
+        fprintf(stderr, "Usage: %s [decimals 0 to %d]\n", argv[0], GCODE_MAX_DECIMALS);
+        return EXIT_FAILURE;
+    }
+
+    static Coord2D_t points[BENCH_POINTS];
+    MakePoints(points);
+
+    // Check that the three full lines match
+    static char expected[GCODE_LINE_LENGTH], line[GCODE_LINE_LENGTH];
+    gcodeWriter_t writer = gcodeWriterConstructor(false, decimals);
+    unsigned long mismatches = 0;
+    for (int i = 0; i < BENCH_POINTS; i++)
+    {
+        const size_t length = LinePrintf(expected, points[i], decimals);
+        if (LineFixed(line, points[i], decimals) != length || memcmp(line, expected, length) != 0)
+            mismatches++;
+        if (writer.move(&writer, line, "S1000", "G1", points[i], NULL) != length || memcmp(line, expected, length) != 0)
+            mismatches++;
+    }
+    printf("check:   %10lu mismatches in %d lines with %d decimals\n", mismatches, BENCH_POINTS, decimals);
+
+    static const char *const names[] = {"snprintf:", "fixed:   ", "writer:  ", "compact: "};
+    double baseline = 0.0;
+    for (int way = 0; way < 4; way++)
+    {
+        writer = gcodeWriterConstructor(way == 3, decimals);
+        unsigned long bytes = 0;
+        unsigned long rounds = 0;
+        const double start = Now();
+        double elapsed;
+        do
+        {
+            for (int i = 0; i < BENCH_POINTS; i++)
+            {
+                if (way == 0)
+                    bytes += LinePrintf(line, points[i], decimals);
+                else if (way == 1)
+                    bytes += LineFixed(line, points[i], decimals);
+                else
+                    bytes += writer.move(&writer, line, "S1000", "G1", points[i], NULL);
+            }
+            rounds++;
+        } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+
+        const double rate = rounds * BENCH_POINTS / elapsed;
+        if (way == 0)
+            baseline = rate;
+        printf("%s %10.2f M lines/s, %5.1fx snprintf (%.1f bytes per line)\n", names[way], rate * 1e-6,
+               rate / baseline, (double)bytes / (rounds * BENCH_POINTS));
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void MakePoints(Coord2D_t *const points)
+{
+    unsigned long state = 12345;
+    for (int i = 0; i < BENCH_POINTS; i++)
+    {
+        state = state * 1103515245UL + 12345UL;
+        points[i].x = BENCH_WIDTH_MM * ((state >> 8) % 1000000) / 1e6;
+        state = state * 1103515245UL + 12345UL;
+        points[i].y = -BENCH_HEIGHT_MM * ((state >> 8) % 1000000) / 1e6;
+    }
+}
+
+static size_t LinePrintf(char *const out, const Coord2D_t pos, const int decimals)
+{
+    return (size_t)snprintf(out, GCODE_LINE_LENGTH, "%s %s X%.*f Y%.*f\n", "S1000", "G1", decimals, pos.x, decimals,
+                            pos.y);
+}
+
+static size_t LineFixed(char *const out, const Coord2D_t pos, const int decimals)
+{
+    char *p = out;
+    memcpy(p, "S1000 G1 X", 10);
+    p = FormatFixed(p + 10, pos.x, decimals);
+    memcpy(p, " Y", 2);
+    p = FormatFixed(p + 2, pos.y, decimals);
+    *p++ = '\n';
+    *p = '\0';
+    return (size_t)(p - out);
+}
@@ -0,0 +1,208 @@
+/**
+ * @file layoutBench.c
+ * @brief Benchmark of laying out very large documents, to show time and memory grow linearly.
+ * @details
+ * Writes a synthetic document of pseudo-random words and paragraphs to a temporary file, and lays
+ * it out as process_text_file() does: a textReader_t reads its words and a layout_t places them,
+ * greedily and balanced in turn. The document starts at BENCH_START_MB and doubles up to the
+ * size asked for, and for each size and way of breaking prints:
+ * - the time taken, in ms and in ns per byte of the document;
+ * - the memory the layout holds at the end, in MB and in bytes per byte of the document, counted
+ *   from the capacities of its arrays.
+ *
+ * A layout that is linear in time and memory keeps both ratios flat as the document doubles. The
+ * most memory the process has held is printed at the end.
+ *
+ * Usage: LayoutBench [megabytes] [font file]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L /**< clock_gettime(). */
+#endif
+
+#include "../font/fontData.h"
+#include "../robot/layout.h"
+#include "../robot/robot.h"
+#include "../robot/textReader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_MEGABYTES 16               /**< Default size of the largest document, in MB. */
+#define BENCH_START_MB 1                 /**< Size of the first document, in MB. */
+#define BENCH_SCALE (5.0 / 18.0)         /**< Scale factor of the text, that of 5 mm text. */
+#define BENCH_DOCUMENT "LayoutBench.txt" /**< Text file written for each size. */
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Writes a document of pseudo-random words, with a paragraph every 20 to 199 words.
+ * @details The words follow a fixed sequence, so every run lays out the same document.
+ * @param[in] textFile Text file to write.
+ * @param[in] bytes Size of the document.
+ * @return Bytes written, or 0 if the file could not be written.
+ */
+static long WriteDocument(const char *const textFile, const long bytes);
+
+/**
+ * @brief Lays out a text file and frees the layout again.
+ * @param[in] fontData The font.
+ * @param[in] textFile Text file to lay out.
+ * @param[in] balance true to balance the lines, false to break them greedily.
+ * @param[out] layoutBytes Memory the layout held before it was freed.
+ * @param[out] lines Lines of the layout.
+ * @param[out] pages Pages of the layout.
+ * @return SUCCESS, or the error that stopped the layout.
+ */
+static errorCode_t Layout(const fontData_t *const fontData, const char *const textFile, const bool balance,
+                          size_t *const layoutBytes, size_t *const lines, size_t *const pages);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const long megabytes = argc > 1 ? atol(argv[1]) : BENCH_MEGABYTES;
+    const char *fontFile = argc > 2 ? argv[2] : FONT_FILE;
+    if (megabytes < BENCH_START_MB)
+    {
+        fprintf(stderr, "Usage: %s [megabytes, at least %d] [font file]\n", argv[0], BENCH_START_MB);
+        return EXIT_FAILURE;
+    }
+
+    fontData_t *fontData = fontDataConstructor();
+    if (!fontData || fontData->parse(fontData, fontFile) != SUCCESS)
+        return EXIT_FAILURE;
+
+    static const char *const names[2] = {"greedy:  ", "balanced:"};
+    for (long size = BENCH_START_MB; size <= megabytes; size *= 2)
+    {
+        const long bytes = WriteDocument(BENCH_DOCUMENT, size << 20);
+        if (bytes == 0)
+            return EXIT_FAILURE;
+
+        for (int balance = 0; balance < 2; balance++)
+        {
+            size_t layoutBytes = 0, lines = 0, pages = 0;
+            const double start = Now();
+            const errorCode_t error = Layout(fontData, BENCH_DOCUMENT, balance, &layoutBytes, &lines, &pages);
+            const double elapsed = Now() - start;
+            if (error != SUCCESS)
+            {
+                remove(BENCH_DOCUMENT);
+                return EXIT_FAILURE;
+            }
+            printf("%s %4ld MB %9.1f ms %7.2f ns per byte, layout %7.1f MB %5.2f bytes per byte, %lu lines on %lu pages\n",
+                   names[balance], size, 1e3 * elapsed, 1e9 * elapsed / bytes, layoutBytes / 1048576.0,
+                   (double)layoutBytes / bytes, (unsigned long)lines, (unsigned long)pages);
+            fflush(stdout);
+        }
+        remove(BENCH_DOCUMENT);
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        printf("maxrss:  %10ld kB\n", usage.ru_maxrss);
+
+    fontData->free(fontData);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static long WriteDocument(const char *const textFile, const long bytes)
+{
+    static const char *const words[] = {"a", "the", "of", "and", "to", "in", "is", "it", "pen", "line", "page", "font",
+                                        "glyph", "robot", "writer", "stroke", "cursor", "balance", "greedy", "layout",
+                                        "G-code", "drawing", "character", "paragraph"};
+    const unsigned long numWords = sizeof(words) / sizeof(words[0]);
+
+    FILE *file = fopen(textFile, "w");
+    if (!file)
+    {
+        perror(textFile);
+        return 0;
+    }
+
+    unsigned long state = 12345;
+    long written = 0;
+    long paragraph = 0;
+    while (written < bytes)
+    {
+        state = state * 1103515245UL + 12345UL;
+        if (paragraph == 0)
+            paragraph = 20 + (long)((state >> 8) % 180);
+        const char delimiter = --paragraph == 0 ? '\n' : ' ';
+        written += fprintf(file, "%s%c", words[(state >> 16) % numWords], delimiter);
+    }
+
+    if (fclose(file) != 0)
+    {
+        perror(textFile);
+        return 0;
+    }
+    return written;
+}
+
+static errorCode_t Layout(const fontData_t *const fontData, const char *const textFile, const bool balance,
+                          size_t *const layoutBytes, size_t *const lines, size_t *const pages)
+{
+    FILE *file = fopen(textFile, "r");
+    if (!file)
+    {
+        perror(textFile);
+        return ERROR_OPEN_FILE;
+    }
+    textReader_t *reader = textReaderConstructor(file);
+    layout_t *layout = layoutConstructor(fontData, BENCH_SCALE, false, balance);
+    if (!reader || !layout)
+    {
+        if (reader)
+            reader->free(reader);
+        if (layout)
+            layout->free(layout);
+        fclose(file);
+        return ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+
+    textView_t word;
+    errorCode_t error;
+    while ((error = reader->read(reader, &word)) == SUCCESS && word.length > 0)
+        if ((error = layout->add(layout, word.text, word.length)) != SUCCESS)
+            break;
+    if (error == SUCCESS)
+        error = layout->finish(layout);
+
+    *layoutBytes = layout->glyphCapacity * sizeof(layoutGlyph_t) + layout->lineCapacity * sizeof(layoutLine_t) +
+                   layout->pageCapacity * sizeof(layoutPage_t) + layout->missingCapacity * sizeof(layoutMissing_t) +
+                   layout->textCapacity + layout->wordCapacity * sizeof(layoutWord_t) +
+                   layout->breakCapacity * sizeof(layoutBreak_t);
+    *lines = layout->numLines;
+    *pages = layout->numPages;
+
+    reader->free(reader);
+    layout->free(layout);
+    fclose(file);
+    return error;
+}
@@ -0,0 +1,459 @@
+/**
+ * @file lookupBench.c
+ * @brief Benchmark of the font as it was stored before the stroke arena against fontData_t.
+ * @details
+ * Before the stroke arena, the font was a 128-bucket hash table chained by ASCII code, and every
+ * character had a hash node, a character and a stroke array of its own, each allocated apart.
+ * This file keeps a copy of that structure, with the parser, lookup and free it had, and times it
+ * against fontData_t on the same font and text, each way repeated until it has run for a
+ * measurable time:
+ * - load: construct, parse and free the font;
+ * - lookup: look up every character of the text in the font;
+ * - iterate: look up every character of the text in the font and scale all of its strokes.
+ *
+ * The old font is read a byte at a time, as RobotWriter read its text then; fontData_t is read as
+ * UTF-8, as RobotWriter reads it now. The allocations and memory each font takes are printed
+ * first. The sums of the lookups and strokes are printed with the timings, which keeps the
+ * compiler from dropping the loops and shows that both ways read the same font.
+ *
+ * Usage: LookupBench [font file] [text file]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L /**< clock_gettime(). */
+#endif
+
+#include "../font/fontData.h"
+#include "../misc/utf8.h"
+#include "../robot/robot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_TEXT_SIZE 65536    /**< Most bytes of the text file used. */
+#define BENCH_MIN_SECONDS 0.5    /**< Shortest time each measurement runs for. */
+#define BENCH_SCALE (5.0 / 18.0) /**< Scale factor of the strokes read, that of 5 mm text. */
+#define OLD_BUCKETS 128          /**< Buckets of the old hash table, one per ASCII code. */
+
+/**
+ * @brief A stroke of the old font, in font units.
+ */
+typedef struct oldStroke_s
+{
+    Vect2d_t vec;   /**< Vector of the stroke. */
+    bool pen_state; /**< true if the pen is down. */
+} oldStroke_t;
+
+/**
+ * @brief A character of the old font, with a stroke array of its own.
+ */
+typedef struct oldCharacter_s
+{
+    char asciiKey;        /**< ASCII code of the character. */
+    uint8_t numStrokes;   /**< Number of strokes. */
+    oldStroke_t *strokes; /**< Strokes of the character. */
+} oldCharacter_t;
+
+/**
+ * @brief Node of a chain of the old hash table.
+ */
+typedef struct oldNode_s
+{
+    char key;                  /**< ASCII code of the character. */
+    oldCharacter_t *character; /**< The character. */
+    struct oldNode_s *next;    /**< Next node of the chain. */
+} oldNode_t;
+
+/**
+ * @brief The old font, a hash table of characters.
+ */
+typedef struct oldFont_s
+{
+    oldNode_t *table[OLD_BUCKETS]; /**< Chains of the characters, by ASCII code modulo 128. */
+    size_t allocations;            /**< Allocations made to load the font, the font itself included. */
+    size_t bytes;                  /**< Bytes allocated to load the font. */
+
+    /**
+     * @brief Looks up a character by ASCII code, as the old fontData_t::lookup() did.
+     * @param[in] self The font.
+     * @param[in] asciiKey ASCII code of the character.
+     * @return The character, or NULL if the font has none.
+     */
+    const oldCharacter_t *(*lookup)(const struct oldFont_s *const self, const char asciiKey);
+} oldFont_t;
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Loads a font into the old structure, as the old fontData_t::parse() did.
+ * @param[in] fontFile Font file to parse.
+ * @return The font, or NULL if it could not be loaded.
+ */
+static oldFont_t *OldLoad(const char *const fontFile);
+
+/**
+ * @brief Looks up a character in the old font.
+ * @param[in] self The font.
+ * @param[in] asciiKey ASCII code of the character.
+ * @return The character, or NULL if the font has none.
+ */
+static const oldCharacter_t *OldLookup(const oldFont_t *const self, const char asciiKey);
+
+/**
+ * @brief Frees the old font, node by node.
+ * @param[in,out] font The font.
+ */
+static void OldFree(oldFont_t *font);
+
+/**
+ * @brief Loads a font into fontData_t and frees it again.
+ * @param[in] fontFile Font file to parse.
+ * @return Strokes in the font, or 0 if it could not be loaded.
+ */
+static size_t NewLoad(const char *const fontFile);
+
+/**
+ * @brief Loads a font into the old structure and frees it again.
+ * @param[in] fontFile Font file to parse.
+ * @return Strokes in the font, or 0 if it could not be loaded.
+ */
+static size_t OldLoadFree(const char *const fontFile);
+
+/**
+ * @brief Looks up every byte of the text in the old font.
+ * @param[in] font The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke counts of the characters found.
+ */
+static unsigned long OldLookupText(const oldFont_t *const font, const char *text, const size_t length);
+
+/**
+ * @brief Looks up every character of the text in fontData_t.
+ * @param[in] fontData The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke counts of the characters found.
+ */
+static unsigned long NewLookupText(const fontData_t *const fontData, const char *text, const size_t length);
+
+/**
+ * @brief Looks up every byte of the text in the old font and scales its strokes.
+ * @param[in] font The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke vectors and pen states read.
+ */
+static double OldIterate(const oldFont_t *const font, const char *text, const size_t length);
+
+/**
+ * @brief Looks up every character of the text in fontData_t and scales its strokes.
+ * @param[in] fontData The font.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return Sum of the stroke vectors and pen states read.
+ */
+static double NewIterate(const fontData_t *const fontData, const char *text, const size_t length);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const char *fontFile = argc > 1 ? argv[1] : FONT_FILE;
+    const char *textFile = argc > 2 ? argv[2] : "test.txt";
+
+    // Read the text
+    static char text[BENCH_TEXT_SIZE];
+    FILE *file = fopen(textFile, "r");
+    if (!file)
+    {
+        perror(textFile);
+        return EXIT_FAILURE;
+    }
+    const size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+
+    // Load both fonts once for the lookups
+    oldFont_t *oldFont = OldLoad(fontFile);
+    fontData_t *fontData = fontDataConstructor();
+    if (!oldFont || !fontData || fontData->parse(fontData, fontFile) != SUCCESS)
+        return EXIT_FAILURE;
+
+    // Memory
+    const fontTable_t *const table = &fontData->table;
+    printf("old:     %10lu bytes in %lu allocations\n", (unsigned long)oldFont->bytes,
+           (unsigned long)oldFont->allocations);
+    printf("new:     %10lu bytes (%lu directory + %lu pages of %lu bytes + %lu strokes of %lu bytes)\n",
+           (unsigned long)(table->numBlocks * sizeof(uint16_t) +
+                           table->numPages * FONT_PAGE_SIZE * sizeof(fontCharacter_t) +
+                           table->numStrokes * sizeof(stroke_t)),
+           (unsigned long)(table->numBlocks * sizeof(uint16_t)), (unsigned long)table->numPages,
+           (unsigned long)(FONT_PAGE_SIZE * sizeof(fontCharacter_t)), (unsigned long)table->numStrokes,
+           (unsigned long)sizeof(stroke_t));
+
+    // Load
+    static const char *const names[2] = {"old", "new"};
+    for (int way = 0; way < 2; way++)
+    {
+        unsigned long rounds = 0;
+        size_t strokes = 0;
+        const double start = Now();
+        double elapsed;
+        do
+        {
+            strokes = way == 0 ? OldLoadFree(fontFile) : NewLoad(fontFile);
+            rounds++;
+        } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+        printf("%s load:    %10.1f us per font (%lu strokes)\n", names[way], 1e6 * elapsed / rounds,
+               (unsigned long)strokes);
+    }
+
+    // Lookup
+    for (int way = 0; way < 2; way++)
+    {
+        unsigned long found = 0;
+        unsigned long rounds = 0;
+        const double start = Now();
+        double elapsed;
+        do
+        {
+            found += way == 0 ? OldLookupText(oldFont, text, length) : NewLookupText(fontData, text, length);
+            rounds++;
+        } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+        printf("%s lookup:  %10.2f ns per character (%lu strokes per pass)\n", names[way],
+               1e9 * elapsed / (rounds * length), found / rounds);
+    }
+
+    // Iterate
+    for (int way = 0; way < 2; way++)
+    {
+        double sum = 0.0;
+        unsigned long rounds = 0;
+        const double start = Now();
+        double elapsed;
+        do
+        {
+            sum += way == 0 ? OldIterate(oldFont, text, length) : NewIterate(fontData, text, length);
+            rounds++;
+        } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+        printf("%s iterate: %10.2f ns per character (checksum %.3f)\n", names[way], 1e9 * elapsed / (rounds * length),
+               sum / rounds);
+    }
+
+    OldFree(oldFont);
+    fontData->free(fontData);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static oldFont_t *OldLoad(const char *const fontFile)
+{
+    oldFont_t *font = malloc(sizeof(oldFont_t));
+    if (!font)
+        return NULL;
+    for (int i = 0; i < OLD_BUCKETS; i++)
+        font->table[i] = NULL;
+    font->allocations = 1;
+    font->bytes = sizeof(oldFont_t);
+    font->lookup = OldLookup;
+
+    FILE *file = fopen(fontFile, "r");
+    if (!file)
+    {
+        perror(fontFile);
+        free(font);
+        return NULL;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        int id, numStrokes;
+        if (sscanf(line, "999 %d %d", &id, &numStrokes) != 2)
+            break;
+
+        oldCharacter_t *character = malloc(sizeof(oldCharacter_t));
+        oldStroke_t *strokes = malloc(numStrokes * sizeof(oldStroke_t));
+        oldNode_t *node = malloc(sizeof(oldNode_t));
+        if (!character || !strokes || !node)
+        {
+            free(character);
+            free(strokes);
+            free(node);
+            fclose(file);
+            OldFree(font);
+            return NULL;
+        }
+        font->allocations += 3;
+        font->bytes += sizeof(oldCharacter_t) + numStrokes * sizeof(oldStroke_t) + sizeof(oldNode_t);
+
+        character->asciiKey = (char)id;
+        character->numStrokes = 0;
+        character->strokes = strokes;
+        for (int i = 0; i < numStrokes; i++)
+        {
+            if (!fgets(line, sizeof(line), file))
+                break;
+
+            double x, y;
+            int pen;
+            if (sscanf(line, "%lf %lf %i", &x, &y, &pen) == 3)
+            {
+                strokes[character->numStrokes].vec.x = x;
+                strokes[character->numStrokes].vec.y = y;
+                strokes[character->numStrokes].pen_state = pen;
+                character->numStrokes++;
+            }
+        }
+
+        const unsigned int index = (unsigned int)character->asciiKey % OLD_BUCKETS;
+        node->key = character->asciiKey;
+        node->character = character;
+        node->next = font->table[index];
+        font->table[index] = node;
+    }
+
+    fclose(file);
+    return font;
+}
+
+static const oldCharacter_t *OldLookup(const oldFont_t *const self, const char asciiKey)
+{
+    if (!self)
+        return NULL;
+
+    for (const oldNode_t *node = self->table[(unsigned int)asciiKey % OLD_BUCKETS]; node; node = node->next)
+        if (node->key == asciiKey)
+            return node->character;
+    return NULL;
+}
+
+static void OldFree(oldFont_t *font)
+{
+    for (int i = 0; i < OLD_BUCKETS; i++)
+    {
+        oldNode_t *node = font->table[i];
+        while (node)
+        {
+            oldNode_t *next = node->next;
+            free(node->character->strokes);
+            free(node->character);
+            free(node);
+            node = next;
+        }
+    }
+    free(font);
+}
+
+static size_t NewLoad(const char *const fontFile)
+{
+    fontData_t *fontData = fontDataConstructor();
+    if (!fontData)
+        return 0;
+
+    size_t strokes = 0;
+    if (fontData->parse(fontData, fontFile) == SUCCESS)
+        strokes = fontData->table.numStrokes;
+    fontData->free(fontData);
+    return strokes;
+}
+
+static size_t OldLoadFree(const char *const fontFile)
+{
+    oldFont_t *font = OldLoad(fontFile);
+    if (!font)
+        return 0;
+
+    size_t strokes = 0;
+    for (int i = 0; i < OLD_BUCKETS; i++)
+        for (const oldNode_t *node = font->table[i]; node; node = node->next)
+            strokes += node->character->numStrokes;
+    OldFree(font);
+    return strokes;
+}
+
+static unsigned long OldLookupText(const oldFont_t *const font, const char *text, const size_t length)
+{
+    unsigned long found = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        const oldCharacter_t *const character = font->lookup(font, text[i]);
+        if (character)
+            found += character->numStrokes;
+    }
+    return found;
+}
+
+static unsigned long NewLookupText(const fontData_t *const fontData, const char *text, const size_t length)
+{
+    const char *const end = text + length;
+    unsigned long found = 0;
+    while (text < end)
+    {
+        const fontCharacter_t *const fontChar = fontData->lookup(fontData, Utf8Decode(&text, end));
+        if (fontChar)
+            found += fontChar->numStrokes;
+    }
+    return found;
+}
+
+static double OldIterate(const oldFont_t *const font, const char *text, const size_t length)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < length; i++)
+    {
+        const oldCharacter_t *const character = font->lookup(font, text[i]);
+        if (!character)
+            continue;
+
+        for (uint8_t k = 0; k < character->numStrokes; k++)
+        {
+            const oldStroke_t stroke = character->strokes[k];
+            sum += stroke.vec.x * BENCH_SCALE + stroke.vec.y * BENCH_SCALE + stroke.pen_state;
+        }
+    }
+    return sum;
+}
+
+static double NewIterate(const fontData_t *const fontData, const char *text, const size_t length)
+{
+    const char *const end = text + length;
+    double sum = 0.0;
+    while (text < end)
+    {
+        const fontCharacter_t *const fontChar = fontData->lookup(fontData, Utf8Decode(&text, end));
+        if (!fontChar)
+            continue;
+
+        const stroke_t *const strokes = &fontData->table.strokes[fontChar->first];
+        for (uint8_t k = 0; k < fontChar->numStrokes; k++)
+        {
+            const Vect2d_t vec = StrokeVector(strokes[k], BENCH_SCALE);
+            sum += vec.x + vec.y + StrokePenDown(strokes[k]);
+        }
+    }
+    return sum;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file serialBench.c
+ * @brief Benchmark of sending G-code through the serial library on a pseudo-terminal pair.
+ * @details
+ * A child process holds the master side of a pseudo-terminal and stands in for the controller:
+ * it reads whatever arrives at once, and answers "ok" when it has received every line of a
+ * round. The parent opens the slave side with CanRS232PortBeOpened(), as RobotWriter opens a
+ * port, and sends the same G-code lines in each of three ways:
+ * - bytes: one write() per byte, as RS232_cputs() sent before transmit was batched;
+ * - lines: one write() per line, with RS232_SendBufAll();
+ * - batched: QueueBuffer() for each line and FlushBuffer() whenever the next line would not fit
+ *   in GRBL_RX_BUFFER_SIZE bytes, as the stream does when it waits for a reply in streaming mode.
+ *
+ * Each round is timed up to the "ok", and the write() calls the parent made are counted from
+ * /proc/self/io where the system has it, so the count is that of the system calls the port
+ * took, not of the calls the library was asked for.
+ *
+ * Usage: SerialBench [lines]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700 /**< posix_openpt(), grantpt(), unlockpt() and ptsname(). */
+#endif
+
+#include "../lib/rs232.h"
+#include "../lib/serial.h"
+#include "../robot/grbl.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_LINES 20000       /**< Default number of lines sent per round. */
+#define BENCH_ROUNDS 3          /**< Rounds, one for each way of sending. */
+#define BENCH_TIMEOUT_MS 60000  /**< Longest wait for the "ok" that ends a round. */
+#define BENCH_LINE_LENGTH 32    /**< Longest line generated. */
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Reads the number of write() calls the process has made.
+ * @return The count, or -1 if the system does not report it.
+ */
+static long WriteCalls(void);
+
+/**
+ * @brief Reads the master side until the lines of every round have arrived, answering each.
+ * @param[in] master File descriptor of the master side.
+ * @param[in] lines Lines sent per round.
+ */
+static void Controller(const int master, const long lines);
+
+/**
+ * @brief Writes the text of a G-code line.
+ * @param[out] line Buffer of BENCH_LINE_LENGTH bytes.
+ * @param[in] i Number of the line.
+ * @return Bytes of the line, its newline included.
+ */
+static int MakeLine(char *const line, const long i);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const long lines = argc > 1 ? atol(argv[1]) : BENCH_LINES;
+    if (lines <= 0)
+    {
+        fprintf(stderr, "Usage: %s [lines]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Open the pseudo-terminal pair
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("posix_openpt");
+        return EXIT_FAILURE;
+    }
+    static char slave[256];
+    snprintf(slave, sizeof(slave), "%s", ptsname(master));
+
+    // Start the controller
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child < 0)
+    {
+        perror("fork");
+        return EXIT_FAILURE;
+    }
+    if (child == 0)
+    {
+        Controller(master, lines);
+        _exit(0);
+    }
+
+    SetSerialPort(slave);
+    if (CanRS232PortBeOpened() != 0)
+    {
+        kill(child, SIGTERM);
+        return EXIT_FAILURE;
+    }
+    SetSerialTimeout(BENCH_TIMEOUT_MS);
+
+    static const char *const names[BENCH_ROUNDS] = {"bytes:  ", "lines:  ", "batched:"};
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        char line[BENCH_LINE_LENGTH];
+        long bytes = 0;
+        int queued = 0;
+        const long calls = WriteCalls();
+        const double start = Now();
+        for (long i = 0; i < lines; i++)
+        {
+            const int length = MakeLine(line, i);
+            bytes += length;
+            if (round == 0)
+            {
+                for (int k = 0; k < length; k++)
+                    RS232_SendBufAll(cport_nr, (const unsigned char *)&line[k], 1);
+            }
+            else if (round == 1)
+                RS232_SendBufAll(cport_nr, (const unsigned char *)line, length);
+            else
+            {
+                if (queued + length > GRBL_RX_BUFFER_SIZE)
+                {
+                    FlushBuffer();
+                    queued = 0;
+                }
+                QueueBuffer(line);
+                queued += length;
+            }
+        }
+        FlushBuffer();
+
+        char reply[SERIAL_LINE_LENGTH];
+        if (WaitForReplyLine(reply, sizeof(reply), BENCH_TIMEOUT_MS) != 1)
+        {
+            fprintf(stderr, "No reply from the controller\n");
+            kill(child, SIGTERM);
+            return EXIT_FAILURE;
+        }
+        const double elapsed = Now() - start;
+        const long written = WriteCalls();
+
+        if (calls >= 0 && written >= 0)
+            printf("%s %8.3f s, %10.0f lines/s, %7ld write() calls for %ld lines of %ld bytes\n", names[round],
+                   elapsed, lines / elapsed, written - calls, lines, bytes);
+        else
+            printf("%s %8.3f s, %10.0f lines/s for %ld lines of %ld bytes\n", names[round], elapsed,
+                   lines / elapsed, lines, bytes);
+        fflush(stdout);
+    }
+
+    CloseRS232Port();
+    waitpid(child, NULL, 0);
+    close(master);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static long WriteCalls(void)
+{
+    FILE *file = fopen("/proc/self/io", "r");
+    if (!file)
+        return -1;
+
+    char line[128];
+    long calls = -1;
+    while (fgets(line, sizeof(line), file))
+        if (sscanf(line, "syscw: %ld", &calls) == 1)
+            break;
+    fclose(file);
+    return calls;
+}
+
+static void Controller(const int master, const long lines)
+{
+    unsigned char buffer[4096];
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        long received = 0;
+        while (received < lines)
+        {
+            const ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n <= 0)
+                return;
+            for (ssize_t i = 0; i < n; i++)
+                received += buffer[i] == '\n';
+        }
+        if (write(master, "ok\r\n", 4) != 4)
+            return;
+    }
+}
+
+static int MakeLine(char *const line, const long i)
+{
+    return snprintf(line, BENCH_LINE_LENGTH, "S1000 G1 X%ld.%02ld Y-%ld.%02ld\n", i % 100, i % 97, i % 50, i % 89);
+}
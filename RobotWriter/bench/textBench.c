@@ -0,0 +1,244 @@
+/**
+ * @file textBench.c
+ * @brief Benchmark of splitting a large text file into words, with fgetc() against textReader_t.
+ * @details
+ * Writes a corpus of pseudo-random words and paragraphs to a temporary file, BENCH_MEGABYTES in
+ * size unless another size is asked for, and splits it into words each way in turn:
+ * - fgetc: one fgetc() call per byte into a fixed word buffer, as process_text_file() read its
+ *   text before textReader_t;
+ * - reader: textReader_t, as process_text_file() reads its text now.
+ *
+ * Each way runs in a child process of its own, so the peak resident memory printed with it is
+ * its own. The file is read until the way has run for a measurable time, and the number of words
+ * and a checksum of their lengths and first bytes are printed with the rate, which keeps the
+ * compiler from dropping the loops and shows that both ways split the corpus the same.
+ *
+ * Usage: TextBench [megabytes]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L /**< clock_gettime(), fork() and waitpid(). */
+#endif
+
+#include "../robot/textReader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define BENCH_MEGABYTES 100          /**< Default size of the corpus, in MB. */
+#define BENCH_MIN_SECONDS 0.5        /**< Shortest time each way runs for. */
+#define BENCH_WORD_LENGTH 256        /**< Bytes of the word buffer of the fgetc() loop. */
+#define BENCH_CORPUS "TextBench.txt" /**< Text file the corpus is written to. */
+
+/**
+ * @brief Returns the time of a monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Writes a corpus of pseudo-random words, with a paragraph every 20 to 199 words.
+ * @details The words follow a fixed sequence, so every run splits the same corpus.
+ * @param[in] textFile Text file to write.
+ * @param[in] bytes Size of the corpus.
+ * @return Bytes written, or 0 if the file could not be written.
+ */
+static long WriteCorpus(const char *const textFile, const long bytes);
+
+/**
+ * @brief Splits a file into words with one fgetc() call per byte.
+ * @details A word ends at a space, newline or carriage return, as in textReader_t. A word longer
+ *          than the buffer is cut, which the corpus never needs.
+ * @param[in] file The file, read from its start.
+ * @param[out] bytes Checksum of the lengths and first bytes of the words.
+ * @return Number of words.
+ */
+static unsigned long SplitFgetc(FILE *const file, unsigned long *const bytes);
+
+/**
+ * @brief Splits a file into words with a textReader_t.
+ * @param[in] file The file, read from its start.
+ * @param[out] bytes Checksum of the lengths and first bytes of the words.
+ * @return Number of words, or 0 if the reader failed.
+ */
+static unsigned long SplitReader(FILE *const file, unsigned long *const bytes);
+
+/**
+ * @brief Times one way of splitting the corpus and prints its rate and peak resident memory.
+ * @details Runs in the child process of the way.
+ * @param[in] way 0 for fgetc(), 1 for textReader_t.
+ * @param[in] size Size of the corpus in bytes.
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if the corpus could not be read.
+ */
+static int Run(const int way, const long size);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const long megabytes = argc > 1 ? atol(argv[1]) : BENCH_MEGABYTES;
+    if (megabytes < 1)
+    {
+        fprintf(stderr, "Usage: %s [megabytes, at least 1]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const long size = WriteCorpus(BENCH_CORPUS, megabytes << 20);
+    if (size == 0)
+        return EXIT_FAILURE;
+    printf("corpus:  %10.1f MB\n", size / 1048576.0);
+    fflush(stdout);
+
+    int result = EXIT_SUCCESS;
+    for (int way = 0; way < 2; way++)
+    {
+        const pid_t child = fork();
+        if (child == 0)
+            _exit(Run(way, size));
+        int status;
+        if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS)
+            result = EXIT_FAILURE;
+    }
+
+    remove(BENCH_CORPUS);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static long WriteCorpus(const char *const textFile, const long bytes)
+{
+    static const char *const words[] = {"a", "the", "of", "and", "to", "in", "is", "it", "pen", "line", "page", "font",
+                                        "glyph", "robot", "writer", "stroke", "cursor", "balance", "greedy", "layout",
+                                        "G-code", "drawing", "character", "paragraph"};
+    const unsigned long numWords = sizeof(words) / sizeof(words[0]);
+
+    FILE *file = fopen(textFile, "w");
+    if (!file)
+    {
+        perror(textFile);
+        return 0;
+    }
+
+    unsigned long state = 12345;
+    long written = 0;
+    long paragraph = 0;
+    while (written < bytes)
+    {
+        state = state * 1103515245UL + 12345UL;
+        if (paragraph == 0)
+            paragraph = 20 + (long)((state >> 8) % 180);
+        const char delimiter = --paragraph == 0 ? '\n' : ' ';
+        written += fprintf(file, "%s%c", words[(state >> 16) % numWords], delimiter);
+    }
+
+    if (fclose(file) != 0)
+    {
+        perror(textFile);
+        return 0;
+    }
+    return written;
+}
+
+static unsigned long SplitFgetc(FILE *const file, unsigned long *const bytes)
+{
+    char word[BENCH_WORD_LENGTH];
+    unsigned long words = 0;
+    int index = 0;
+    int ch;
+    while ((ch = fgetc(file)) != EOF)
+    {
+        if (index < BENCH_WORD_LENGTH - 1)
+            word[index++] = (char)ch;
+        if (ch == ' ' || ch == '\n' || ch == '\r')
+        {
+            word[index] = '\0';
+            *bytes += (unsigned long)index + (unsigned char)word[0];
+            words++;
+            index = 0;
+        }
+    }
+    if (index > 0)
+    {
+        word[index] = '\0';
+        *bytes += (unsigned long)index + (unsigned char)word[0];
+        words++;
+    }
+    return words;
+}
+
+static unsigned long SplitReader(FILE *const file, unsigned long *const bytes)
+{
+    textReader_t *reader = textReaderConstructor(file);
+    if (!reader)
+        return 0;
+
+    textView_t word;
+    unsigned long words = 0;
+    errorCode_t error;
+    while ((error = reader->read(reader, &word)) == SUCCESS && word.length > 0)
+    {
+        *bytes += (unsigned long)word.length + (unsigned char)word.text[0];
+        words++;
+    }
+    reader->free(reader);
+    return error == SUCCESS ? words : 0;
+}
+
+static int Run(const int way, const long size)
+{
+    static const char *const names[2] = {"fgetc:  ", "reader: "};
+    FILE *file = fopen(BENCH_CORPUS, "r");
+    if (!file)
+    {
+        perror(BENCH_CORPUS);
+        return EXIT_FAILURE;
+    }
+
+    unsigned long words = 0;
+    unsigned long bytes = 0;
+    unsigned long rounds = 0;
+    const double start = Now();
+    double elapsed;
+    do
+    {
+        rewind(file);
+        bytes = 0;
+        words = way == 0 ? SplitFgetc(file, &bytes) : SplitReader(file, &bytes);
+        if (words == 0)
+        {
+            fclose(file);
+            return EXIT_FAILURE;
+        }
+        rounds++;
+    } while ((elapsed = Now() - start) < BENCH_MIN_SECONDS);
+    fclose(file);
+
+    struct rusage usage;
+    const long maxrss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+    printf("%s %10.1f MB/s, %lu words (checksum %lu), maxrss %ld kB\n", names[way],
+           rounds * (size / 1048576.0) / elapsed, words, bytes, maxrss);
+    fflush(stdout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file fontCompiler.c
+ * @brief Compiles a text font into a binary font file or into C source.
+ * @details
+ * Parses a font with the same parser RobotWriter uses and writes its header, page table and
+ * packed strokes as a binary font file. RobotWriter maps a binary font given with -f instead
+ * of parsing it, which takes no time however large the font is. A binary font is only read by
+ * builds with the same version of the format, byte order and stroke format; compile it again from
+ * the text font after any of them changes.
+ *
+ * An output file ending in ".c" is written as C source instead, defining the table declared in
+ * fontEmbedded.h over const, statically initialised arrays. The build compiles the default font this
+ * way into RobotWriter, which then needs no font file at all.
+ *
+ * Usage: FontCompiler [text font] [binary font | C source]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "../font/fontData.h"
+#include "../robot/robot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define COMPILER_OUTPUT "SingleStrokeFont.rwf" /**< Binary font file written by default. */
+#define COMPILER_STROKES_PER_LINE 6            /**< Strokes per line of C source. */
+#define COMPILER_BLOCKS_PER_LINE 16            /**< Directory entries per line of C source. */
+
+/**
+ * @brief Tells whether a file name ends in ".c".
+ * @param[in] filename The file name.
+ * @return true if the output is to be C source.
+ */
+static bool IsSource(const char *const filename);
+
+/**
+ * @brief Writes the font as C source defining the table declared in fontEmbedded.h.
+ * @param[in] fontData The font.
+ * @param[in] textFile Name of the text font, recorded in the source.
+ * @param[in] filename Name of the C source file to create.
+ * @return SUCCESS, ERROR_OPEN_FILE or ERROR_FONT_WRITE.
+ */
+static errorCode_t WriteSource(const fontData_t *const fontData, const char *const textFile,
+                               const char *const filename);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const char *textFile = argc > 1 ? argv[1] : FONT_FILE;
+    const char *outputFile = argc > 2 ? argv[2] : COMPILER_OUTPUT;
+    if (argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [text font] [binary font | C source]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse the text font
+    fontData_t *fontData = fontDataConstructor();
+    if (!fontData)
+        return EXIT_FAILURE;
+    if (fontData->parse(fontData, textFile) != SUCCESS || fontData->mapped)
+    {
+        fprintf(stderr, "%s: not a text font\n", textFile);
+        fontData->free(fontData);
+        return EXIT_FAILURE;
+    }
+
+    // Write the binary font or the C source
+    const errorCode_t error = IsSource(outputFile) ? WriteSource(fontData, textFile, outputFile)
+                                                   : fontData->save(fontData, outputFile);
+    if (error != SUCCESS)
+    {
+        fontData->free(fontData);
+        return EXIT_FAILURE;
+    }
+
+    const fontTable_t *const table = &fontData->table;
+    size_t characters = 0;
+    for (size_t i = 0; i < table->numPages * FONT_PAGE_SIZE; i++)
+        characters += table->pages[i].defined;
+    const size_t tableSize = table->numBlocks * sizeof(uint16_t) + table->numPages * FONT_PAGE_SIZE * sizeof(fontCharacter_t);
+    printf("%s: %lu characters, %lu strokes, page table of %lu bytes\n", outputFile, (unsigned long)characters,
+           (unsigned long)table->numStrokes, (unsigned long)tableSize);
+
+    fontData->free(fontData);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static bool IsSource(const char *const filename)
+{
+    const size_t length = strlen(filename);
+    return length > 2 && strcmp(filename + length - 2, ".c") == 0;
+}
+
+static errorCode_t WriteSource(const fontData_t *const fontData, const char *const textFile,
+                               const char *const filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file)
+        return ErrorHandler(ERROR_OPEN_FILE);
+
+    // Header and font file name
+    fprintf(file, "/**\n"
+                  " * @file fontEmbedded.c\n"
+                  " * @brief The embedded font, generated by FontCompiler from %s; do not edit.\n"
+                  " */\n\n"
+                  "#include \"../font/fontEmbedded.h\"\n\n",
+            textFile);
+    fprintf(file, "const char fontEmbeddedSource[] = \"");
+    for (const char *c = textFile; *c; c++)
+        fprintf(file, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+    fprintf(file, "\";\n\n");
+
+    // Directory; an empty one still needs an element
+    const fontTable_t *const table = &fontData->table;
+    fprintf(file, "static const uint16_t directory[] = {");
+    for (size_t i = 0; i < table->numBlocks; i++)
+        fprintf(file, "%s%u,", i % COMPILER_BLOCKS_PER_LINE ? " " : "\n    ", (unsigned)table->directory[i]);
+    fprintf(file, table->numBlocks ? "\n};\n\n" : "\n    0,\n};\n\n");
+
+    // Pages, one defined character per line; the others are left cleared
+    fprintf(file, "static const fontCharacter_t pages[%lu] = {\n", (unsigned long)(table->numPages * FONT_PAGE_SIZE));
+    for (size_t block = 0; block < table->numBlocks; block++)
+    {
+        for (uint32_t i = 0; table->directory[block] && i < FONT_PAGE_SIZE; i++)
+        {
+            const uint32_t codePoint = (uint32_t)block * FONT_PAGE_SIZE + i;
+            const size_t index = FontIndex(table, codePoint);
+            const fontCharacter_t *const fontChar = &table->pages[index];
+            if (!fontChar->defined)
+                continue;
+            fprintf(file, "    [%lu] = {%lu, %u, true}, /* U+%04lX", (unsigned long)index, (unsigned long)fontChar->first,
+                    (unsigned)fontChar->numStrokes, (unsigned long)codePoint);
+            if (codePoint > ' ' && codePoint < 127 && codePoint != '*' && codePoint != '/')
+                fprintf(file, " %c", (char)codePoint);
+            fprintf(file, " */\n");
+        }
+    }
+    fprintf(file, "};\n\n");
+
+    // Strokes, packed as in the font; an empty arena still needs an element
+    fprintf(file, "static const stroke_t strokes[] = {");
+    for (size_t i = 0; i < table->numStrokes; i++)
+        fprintf(file, "%s{%d, %d},", i % COMPILER_STROKES_PER_LINE ? " " : "\n    ", table->strokes[i].x,
+                table->strokes[i].y);
+    fprintf(file, table->numStrokes ? "\n};\n\n" : "\n    {0, 0},\n};\n\n");
+
+    // Table
+    fprintf(file, "const fontTable_t fontEmbedded = {directory, %lu, pages, %lu, strokes, %lu};\n",
+            (unsigned long)table->numBlocks, (unsigned long)table->numPages, (unsigned long)table->numStrokes);
+
+    const bool failed = ferror(file) != 0;
+    if (fclose(file) != 0 || failed)
+        return ErrorHandler(ERROR_FONT_WRITE);
+    return SUCCESS;
+}
@@ -0,0 +1,853 @@
+/**
+ * @file grblEmulator.c
+ * @brief Implementation of the GRBL controller timing model.
+ * @details
+ * The model is a small discrete event simulation. Three kinds of event move it forward: a byte
+ * arriving from the serial line, the executing motion block finishing, and a reply finishing its
+ * transmission. Between events the model takes lines out of the receive buffer whenever the
+ * planner can accept them, exactly like GRBL's protocol loop, so back pressure from a full
+ * planner shows up as missing "ok" replies and a filling receive buffer.
+ *
+ * Only the G-code GRBL needs to plan a move is understood: G0-G3, G4, distance and unit modes,
+ * feed rate and the M codes that synchronise the planner. Anything else is answered with the
+ * same error code GRBL would use.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "grblEmulator.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define GRBL_EMU_PI 3.14159265358979323846 /**< Pi, math.h only provides M_PI as an extension. */
+
+/**
+ * @brief A parsed line, ready to be applied to the modal state.
+ */
+typedef struct grblEmulatorCommand_s
+{
+    int status;          /**< 0 for a valid line, otherwise the GRBL error code. */
+    bool sync;           /**< true if the planner must be empty before the line runs. */
+    bool block;          /**< true if the line adds a block to the planner. */
+    double duration;     /**< Execution time of the block in seconds. */
+    double target[2];    /**< Machine position after the line, in mm. */
+    double feedRate;     /**< Modal feed rate after the line, in mm/min. */
+    int motionMode;      /**< Modal motion command after the line. */
+    bool relative;       /**< Distance mode after the line. */
+    double unitScale;    /**< Unit mode after the line, in mm per unit. */
+    const char *message; /**< Text sent before the "ok", or NULL. */
+} grblEmulatorCommand_t;
+
+/**
+ * @brief Clears every buffer and queues the startup banner.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] now Current time in seconds.
+ */
+static void _reset(grblEmulator_t *const self, const double now);
+
+/**
+ * @brief Puts host bytes on the serial line.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] data Bytes written by the host.
+ * @param[in] size Number of bytes.
+ * @param[in] now Current time in seconds.
+ * @return Number of bytes accepted.
+ */
+static size_t _receive(grblEmulator_t *const self, const unsigned char *const data, const size_t size, const double now);
+
+/**
+ * @brief Processes every event up to the given time.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] now Current time in seconds.
+ */
+static void _advance(grblEmulator_t *const self, const double now);
+
+/**
+ * @brief Copies the replies that have been transmitted by the given time.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] now Current time in seconds.
+ * @param[out] buffer Destination for the reply bytes.
+ * @param[in] size Size of the destination in bytes.
+ * @return Number of bytes copied.
+ */
+static size_t _output(grblEmulator_t *const self, const double now, char *const buffer, const size_t size);
+
+/**
+ * @brief Finds the time of the next event.
+ * @param[in] self Pointer to the grblEmulator_t structure.
+ * @return Time in seconds, or a negative value when nothing is scheduled.
+ */
+static double _nextEvent(const grblEmulator_t *const self);
+
+/**
+ * @brief Prints the session counters.
+ * @param[in] self Pointer to the grblEmulator_t structure.
+ * @param[in] file Stream to print to.
+ */
+static void _report(const grblEmulator_t *const self, FILE *const file);
+
+/**
+ * @brief Frees the emulator.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ */
+static void _free(grblEmulator_t *self);
+
+/**
+ * @brief Moves the byte at the head of the serial line into the receive buffer.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ */
+static void _deliverByte(grblEmulator_t *const self);
+
+/**
+ * @brief Retires the executing planner block and starts the next one.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ */
+static void _finishBlock(grblEmulator_t *const self);
+
+/**
+ * @brief Takes complete lines out of the receive buffer while the planner can accept them.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ */
+static void _consumeLines(grblEmulator_t *const self);
+
+/**
+ * @brief Parses a line against the current modal state without changing it.
+ * @param[in] self Pointer to the grblEmulator_t structure.
+ * @param[in] text The line as received, without its end of line.
+ * @param[out] command The parsed command.
+ */
+static void _parse(const grblEmulator_t *const self, const char *const text, grblEmulatorCommand_t *const command);
+
+/**
+ * @brief Reads a G-code number: an optional sign, digits and at most one decimal point.
+ * @param[in] text Text starting at the number.
+ * @param[out] value The number read.
+ * @return Number of characters used, 0 if the text does not start with a number.
+ */
+static size_t _number(const char *const text, double *const value);
+
+/**
+ * @brief Applies a valid command to the modal state and the planner.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] command The parsed command.
+ */
+static void _execute(grblEmulator_t *const self, const grblEmulatorCommand_t *const command);
+
+/**
+ * @brief Queues a reply behind the ones already waiting for the serial line.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @param[in] text Reply text including "\r\n".
+ * @param[in] ready Time the controller produces the reply.
+ * @param[in] lineTime Time the line being answered was complete, negative if none.
+ */
+static void _reply(grblEmulator_t *const self, const char *const text, const double ready, const double lineTime);
+
+/**
+ * @brief Draws the next number of the fault injection sequence.
+ * @param[in,out] self Pointer to the grblEmulator_t structure.
+ * @return A number in [0, 1).
+ */
+static double _random(grblEmulator_t *const self);
+
+/**
+ * @brief Time one byte takes on the serial line (start bit, 8 data bits, stop bit).
+ * @param[in] self Pointer to the grblEmulator_t structure.
+ * @return Time in seconds.
+ */
+static inline double _byteTime(const grblEmulator_t *const self);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Allocates the emulator, clamps the buffer sizes to what the model can hold and sets the
+ * function pointers. The receive buffer must at least hold one full-length line, otherwise no
+ * line could ever be completed. The emulator starts in the reset state at time 0.
+ */
+grblEmulator_t *grblEmulatorConstructor(const grblEmulatorConfig_t *const config)
+{
+    if (!config) // Check if config is NULL
+        return NULL;
+
+    grblEmulator_t *emulator = malloc(sizeof(grblEmulator_t)); // Allocate memory for grblEmulator_t
+    if (!emulator)                                             // Check if memory allocation failed
+        return NULL;                                           // Return NULL
+
+    emulator->config = *config; // Copy settings
+
+    if (emulator->config.rxBufferSize < GRBL_EMU_LINE_LENGTH + 1) // Must hold one full line
+        emulator->config.rxBufferSize = GRBL_EMU_LINE_LENGTH + 1;
+    if (emulator->config.rxBufferSize > GRBL_EMU_MAX_RX_BUFFER) // Must fit the ring
+        emulator->config.rxBufferSize = GRBL_EMU_MAX_RX_BUFFER;
+    if (emulator->config.plannerBlocks < 1) // Must hold one block
+        emulator->config.plannerBlocks = 1;
+    if (emulator->config.plannerBlocks > GRBL_EMU_MAX_PLANNER_BLOCKS) // Must fit the ring
+        emulator->config.plannerBlocks = GRBL_EMU_MAX_PLANNER_BLOCKS;
+    if (emulator->config.rapidRate <= 0) // G0 needs a rate
+        emulator->config.rapidRate = GRBL_EMU_DEFAULT_RAPID_RATE;
+
+    emulator->reset = _reset;         // Function pointer to reset the controller
+    emulator->receive = _receive;     // Function pointer to accept host bytes
+    emulator->advance = _advance;     // Function pointer to run the model
+    emulator->output = _output;       // Function pointer to collect replies
+    emulator->nextEvent = _nextEvent; // Function pointer to find the next event
+    emulator->report = _report;       // Function pointer to print the counters
+    emulator->free = _free;           // Function pointer to free the emulator
+
+    _reset(emulator, 0.0); // Start in the reset state
+    return emulator;       // Return grblEmulator_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Behaves like a power cycle: buffered bytes, planned moves and unsent replies are lost, the
+ * modal state returns to its defaults and the session counters restart. The fault injection
+ * sequence restarts from the seed so that every session sees the same faults.
+ */
+static void _reset(grblEmulator_t *const self, const double now)
+{
+    memset(&self->stats, 0, sizeof(self->stats)); // Restart the counters
+    self->stats.firstLineTime = -1.0;             // No line yet
+    self->clock = now;                            // Start the clock
+    self->random = self->config.seed ? self->config.seed : 0x9E3779B9u; // xorshift must not start at 0
+
+    self->wireHead = 0;     // Nothing on the line
+    self->wireCount = 0;    // Nothing on the line
+    self->wireNext = now;   // Line is free
+    self->rxHead = 0;       // Empty receive buffer
+    self->rxCount = 0;      // Empty receive buffer
+    self->rxPartial = 0;    // No partial line
+    self->rxOverlong = false; // No partial line
+    self->rxLineHead = 0;   // No complete line
+    self->rxLines = 0;      // No complete line
+
+    self->plannerHead = 0;   // Empty planner
+    self->plannerCount = 0;  // Empty planner
+    self->blockEnd = now;    // Nothing executing
+    self->idleSince = -1.0;  // No motion yet
+    self->replyHead = 0;     // No replies
+    self->replyCount = 0;    // No replies
+    self->lineFree = now;    // Outgoing line is free
+
+    self->position[0] = 0.0;  // Machine at the origin
+    self->position[1] = 0.0;  // Machine at the origin
+    self->feedRate = 0.0;     // Feed rate undefined
+    self->motionMode = 0;     // G0
+    self->relative = false;   // G90
+    self->unitScale = 1.0;    // G21
+
+    _reply(self, "\r\n" GRBL_EMU_BANNER "\r\n", now, -1.0); // Announce the controller
+}
+
+/**
+ * @details
+ * Accepts as many bytes as fit on the modelled line. If the line is idle the first byte
+ * arrives one byte time from now, otherwise the bytes queue up behind those in transit.
+ */
+static size_t _receive(grblEmulator_t *const self, const unsigned char *const data, const size_t size, const double now)
+{
+    _advance(self, now); // Bring the model up to date
+
+    if (self->wireCount == 0)                        // Line idle
+        self->wireNext = now + _byteTime(self);      // First byte arrives one byte time from now
+
+    size_t accepted = 0;                                                      // Bytes taken
+    while (accepted < size && self->wireCount < GRBL_EMU_WIRE_SIZE)         // Until the line is full
+    {
+        self->wire[(self->wireHead + self->wireCount) % GRBL_EMU_WIRE_SIZE] = data[accepted++]; // Put byte on the line
+        self->wireCount++;                                                                       // One more byte in transit
+    }
+    return accepted; // Return bytes taken
+}
+
+/**
+ * @details
+ * Repeatedly lets the protocol loop take lines, then jumps to the earliest pending event until
+ * that event lies beyond `now`. A block finishing and a byte arriving at the same instant are
+ * handled block first, which frees the planner slot the byte's line may need.
+ */
+static void _advance(grblEmulator_t *const self, const double now)
+{
+    while (1)
+    {
+        _consumeLines(self); // Let the protocol loop run
+
+        const double byteAt = self->wireCount ? self->wireNext : HUGE_VAL;     // Next byte arrival
+        const double blockAt = self->plannerCount ? self->blockEnd : HUGE_VAL; // Next block end
+        const double next = byteAt < blockAt ? byteAt : blockAt;              // Earliest event
+        if (next > now)                                                       // Nothing more before now
+            break;
+
+        self->clock = next; // Jump to the event
+        if (blockAt <= byteAt)
+            _finishBlock(self); // Retire the block
+        else
+            _deliverByte(self); // Receive the byte
+    }
+
+    if (now > self->clock) // Catch up with the caller
+        self->clock = now;
+}
+
+/**
+ * @details
+ * Replies leave in order, a reply whose last byte is still on the line holds back the ones
+ * behind it. Replies that do not fit in the buffer stay queued for the next call.
+ */
+static size_t _output(grblEmulator_t *const self, const double now, char *const buffer, const size_t size)
+{
+    size_t used = 0; // Bytes copied
+
+    while (self->replyCount > 0) // While replies are waiting
+    {
+        const grblEmulatorReply_t *const reply = &self->replies[self->replyHead]; // Oldest reply
+        if (reply->due > now || used + reply->length > size)                      // Not sent yet or no room
+            break;
+
+        memcpy(buffer + used, reply->text, reply->length);                  // Copy reply
+        used += reply->length;                                              // Advance output
+        self->stats.lastReplyTime = reply->due;                             // Remember when it went out
+        self->replyHead = (self->replyHead + 1) % GRBL_EMU_MAX_REPLIES;     // Retire reply
+        self->replyCount--;                                                 // One less reply
+    }
+    return used; // Return bytes copied
+}
+
+/**
+ * @details
+ * Considers the next byte arrival, the end of the executing block and the next reply; lines
+ * waiting for the planner are taken care of by the block end that frees their slot.
+ */
+static double _nextEvent(const grblEmulator_t *const self)
+{
+    double next = HUGE_VAL; // Earliest event
+
+    if (self->wireCount && self->wireNext < next) // Byte on the line
+        next = self->wireNext;
+    if (self->plannerCount && self->blockEnd < next) // Block executing
+        next = self->blockEnd;
+    if (self->replyCount && self->replies[self->replyHead].due < next) // Reply on the line
+        next = self->replies[self->replyHead].due;
+
+    return next == HUGE_VAL ? -1.0 : next; // Return event time
+}
+
+/**
+ * @details
+ * The job time runs from the first complete line to whichever finished last, the final reply or
+ * the final move, counting moves still queued when the host disconnects. Starvation is the time
+ * the planner sat empty while the job still had moves to make, which is time a faster host would
+ * have saved. Latency is measured from the moment a line's last byte reached the controller to
+ * the moment its reply had been transmitted.
+ */
+static void _report(const grblEmulator_t *const self, FILE *const file)
+{
+    const grblEmulatorStats_t *const stats = &self->stats; // Session counters
+    const unsigned long replies = stats->linesReceived - stats->acksDropped; // Lines that were answered
+    double end = stats->lastReplyTime > stats->motionEndTime ? stats->lastReplyTime : stats->motionEndTime; // Job end
+
+    if (self->plannerCount > 0) // Moves still queued when the host left
+    {
+        double planned = self->blockEnd; // End of the executing block
+        for (size_t i = 1; i < self->plannerCount; i++)
+            planned += self->planner[(self->plannerHead + i) % GRBL_EMU_MAX_PLANNER_BLOCKS]; // Queued blocks follow
+        if (planned > end)
+            end = planned;
+    }
+    const double job = stats->firstLineTime >= 0 ? end - stats->firstLineTime : 0.0;                             // Job time
+
+    fprintf(file, "Lines:    %lu received (%lu ok, %lu error), %lu bytes\n",
+            stats->linesReceived, stats->linesOk, stats->linesError, stats->bytesReceived);
+    fprintf(file, "Faults:   %lu injected errors, %lu dropped acks, %lu receive overflows\n",
+            stats->errorsInjected, stats->acksDropped, stats->rxOverflows);
+    fprintf(file, "Buffers:  receive high water %zu/%zu bytes, planner high water %zu/%zu blocks\n",
+            stats->rxHighWater, self->config.rxBufferSize, stats->plannerHighWater, self->config.plannerBlocks);
+    fprintf(file, "Timing:   job %.3f s, motion %.3f s (%lu blocks), planner starved %.3f s, %.1f lines/s\n",
+            job, stats->motionTime, stats->motionBlocks, stats->starvedTime,
+            job > 0 ? stats->linesReceived / job : 0.0);
+    fprintf(file, "Latency:  mean %.3f ms, max %.3f ms from line received to reply sent\n",
+            replies ? stats->latencyTotal / replies * 1000.0 : 0.0, stats->latencyMax * 1000.0);
+}
+
+/**
+ * @details
+ * Releases the memory held by the emulator.
+ */
+static void _free(grblEmulator_t *self)
+{
+    free(self); // Free grblEmulator_t
+}
+
+/**
+ * @details
+ * Realtime commands are picked out of the byte stream on arrival and never reach the receive
+ * buffer, as in GRBL: '?' asks for a status report and Ctrl-X resets the controller. Feed hold
+ * and cycle start are accepted but not modelled.
+ *
+ * A byte that finds the receive buffer full is lost and counted as an overflow; a correct
+ * character-counting host never causes one. GRBL moves bytes of the line it is assembling out
+ * of the receive buffer, so a line longer than the whole buffer does not stall it. The model
+ * mirrors this by discarding the partial line and answering it with error:11 once it ends.
+ */
+static void _deliverByte(grblEmulator_t *const self)
+{
+    const unsigned char c = self->wire[self->wireHead];              // Byte arriving
+    self->wireHead = (self->wireHead + 1) % GRBL_EMU_WIRE_SIZE;      // Take it off the line
+    self->wireCount--;                                               // One less byte in transit
+    self->wireNext += _byteTime(self);                               // Next byte follows one byte time later
+
+    if (c == '?') // Status report request
+    {
+        char status[GRBL_EMU_REPLY_LENGTH]; // Report text
+        snprintf(status, sizeof(status), "<%s|MPos:%.3f,%.3f,0.000|Bf:%zu,%zu|FS:%.0f,0>\r\n",
+                 self->plannerCount ? "Run" : "Idle", self->position[0], self->position[1],
+                 self->config.plannerBlocks - self->plannerCount, self->config.rxBufferSize - self->rxCount,
+                 self->feedRate);
+        _reply(self, status, self->clock, -1.0); // Report straight away
+        return;
+    }
+    if (c == 0x18) // Ctrl-X soft reset
+    {
+        const grblEmulatorStats_t stats = self->stats; // A reset does not end the session
+        _reset(self, self->clock);                     // Reset the controller
+        self->stats = stats;                           // Keep the counters
+        return;
+    }
+    if (c == '!' || c == '~') // Feed hold and cycle start
+        return;
+
+    if (self->rxCount == self->config.rxBufferSize && self->rxLines == 0) // Line longer than the buffer
+    {
+        self->rxCount = 0;        // GRBL has moved these bytes to its line buffer
+        self->rxPartial = 0;      // and dropped what did not fit
+        self->rxOverlong = true;  // Answer the line with an overflow error
+    }
+    if (self->rxCount == self->config.rxBufferSize) // Buffer full
+    {
+        self->stats.rxOverflows++; // Byte lost
+        return;
+    }
+
+    self->rx[(self->rxHead + self->rxCount) % GRBL_EMU_MAX_RX_BUFFER] = c; // Store byte
+    self->rxCount++;                                                      // One more byte buffered
+    self->stats.bytesReceived++;                                          // Count byte
+    if (self->rxCount > self->stats.rxHighWater)                          // Track fill level
+        self->stats.rxHighWater = self->rxCount;
+
+    if (c != '\n' && c != '\r') // Line continues
+    {
+        self->rxPartial++; // One more byte in the partial line
+        return;
+    }
+
+    self->rxLineTime[(self->rxLineHead + self->rxLines) % GRBL_EMU_MAX_RX_BUFFER] = self->clock; // Line complete now
+    self->rxLines++;                                                                            // One more complete line
+    self->rxPartial = 0;                                                                        // Next line starts
+    if (self->stats.firstLineTime < 0)                                                          // First line of the session
+        self->stats.firstLineTime = self->clock;
+}
+
+/**
+ * @details
+ * Starts the next queued block straight away. When the planner runs dry the time is recorded
+ * so that the gap until the next block can be counted as starvation.
+ */
+static void _finishBlock(grblEmulator_t *const self)
+{
+    self->plannerHead = (self->plannerHead + 1) % GRBL_EMU_MAX_PLANNER_BLOCKS; // Retire block
+    self->plannerCount--;                                                      // One less block
+    self->stats.motionEndTime = self->clock;                                   // Motion finished now
+
+    if (self->plannerCount > 0)                                       // More blocks queued
+        self->blockEnd = self->clock + self->planner[self->plannerHead]; // Start the next one
+    else
+        self->idleSince = self->clock; // Planner ran dry
+}
+
+/**
+ * @details
+ * A line stays in the receive buffer, still occupying its bytes, until GRBL can act on it: a
+ * move needs a free planner block, and a synchronising command needs the planner to be empty.
+ * Replies are produced as soon as the line has been acted on, plus the configured jitter, which
+ * matches GRBL answering "ok" once a move has been planned rather than executed.
+ */
+static void _consumeLines(grblEmulator_t *const self)
+{
+    while (self->rxLines > 0) // While a complete line is buffered
+    {
+        char text[GRBL_EMU_MAX_RX_BUFFER + 1]; // Line text
+        size_t length = 0;                     // Line length without the end of line
+        while (1)
+        {
+            const char c = (char)self->rx[(self->rxHead + length) % GRBL_EMU_MAX_RX_BUFFER]; // Next byte
+            if (c == '\n' || c == '\r')                                                      // End of line
+                break;
+            text[length++] = c; // Copy byte
+        }
+        text[length] = '\0'; // Terminate line
+
+        grblEmulatorCommand_t command; // Parsed line
+        _parse(self, text, &command);  // Parse against the modal state
+        if (self->rxOverlong)          // Line lost bytes on the way in
+            command.status = 11;       // Max characters per line exceeded
+
+        if (command.status == 0 && command.sync && self->plannerCount > 0) // Must wait for motion to stop
+            break;
+        if (command.status == 0 && command.block && self->plannerCount == self->config.plannerBlocks) // Planner full
+            break;
+
+        self->rxHead = (self->rxHead + length + 1) % GRBL_EMU_MAX_RX_BUFFER;          // Free the line's bytes
+        self->rxCount -= length + 1;                                                   // Buffer space released
+        const double lineTime = self->rxLineTime[self->rxLineHead];                    // When the line was complete
+        self->rxLineHead = (self->rxLineHead + 1) % GRBL_EMU_MAX_RX_BUFFER;            // Retire the line
+        self->rxLines--;                                                               // One less complete line
+        self->rxOverlong = false;                                                      // Only the first line can be overlong
+        self->stats.linesReceived++;                                                   // Count line
+
+        if (command.status == 0 && self->config.errorRate > 0 && _random(self) < self->config.errorRate) // Inject error
+        {
+            command.status = GRBL_EMU_INJECTED_ERROR; // Reject the line
+            self->stats.errorsInjected++;             // Count fault
+        }
+
+        const double ready = self->clock + (self->config.jitterMs > 0 ? _random(self) * self->config.jitterMs / 1000.0 : 0.0); // Reply time
+        if (command.status != 0) // Line rejected
+        {
+            char reply[GRBL_EMU_REPLY_LENGTH];                              // Error reply
+            snprintf(reply, sizeof(reply), "error:%d\r\n", command.status); // Construct reply
+            _reply(self, reply, ready, lineTime);                           // Send it
+            self->stats.linesError++;                                       // Count error
+            continue;
+        }
+
+        _execute(self, &command); // Apply the line
+        self->stats.linesOk++;    // Count acknowledgement
+
+        if (command.message) // Line asked for information
+            _reply(self, command.message, ready, -1.0);
+
+        if (self->config.dropRate > 0 && _random(self) < self->config.dropRate) // Drop the acknowledgement
+            self->stats.acksDropped++;                                          // Count fault
+        else
+            _reply(self, "ok\r\n", ready, lineTime); // Acknowledge the line
+    }
+}
+
+/**
+ * @details
+ * Spaces, control characters and comments are removed and letters are upper-cased before the
+ * length check, as GRBL does while it assembles a line. System commands starting with '$' are
+ * accepted without being interpreted, except for '$' itself which prints the help message.
+ *
+ * Error codes follow GRBL 1.1: 1 expected command letter, 2 bad number format, 4 negative
+ * value, 11 line too long, 20 unsupported command, 22 undefined feed rate and 33 invalid arc.
+ */
+static void _parse(const grblEmulator_t *const self, const char *const text, grblEmulatorCommand_t *const command)
+{
+    command->status = 0;                        // Assume the line is valid
+    command->sync = false;                      // No synchronisation
+    command->block = false;                     // No planner block
+    command->duration = 0.0;                    // No execution time
+    command->target[0] = self->position[0];     // Stay where we are
+    command->target[1] = self->position[1];     // Stay where we are
+    command->feedRate = self->feedRate;         // Keep modal state
+    command->motionMode = self->motionMode;     // Keep modal state
+    command->relative = self->relative;         // Keep modal state
+    command->unitScale = self->unitScale;       // Keep modal state
+    command->message = NULL;                    // Nothing to report
+
+    char line[GRBL_EMU_MAX_RX_BUFFER + 1]; // Cleaned line
+    size_t length = 0;                     // Cleaned length
+    bool comment = false;                  // Inside a (...) comment
+    for (const char *p = text; *p && *p != ';'; p++) // ';' comments run to the end of the line
+    {
+        if (comment)
+            comment = *p != ')'; // Comment ends at ')'
+        else if (*p == '(')
+            comment = true; // Comment starts
+        else if ((unsigned char)*p > ' ')
+            line[length++] = (char)toupper((unsigned char)*p); // Keep the character
+    }
+    line[length] = '\0'; // Terminate cleaned line
+
+    if (length >= GRBL_EMU_LINE_LENGTH) // Too long for GRBL's line buffer
+    {
+        command->status = 11; // Max characters per line exceeded
+        return;
+    }
+    if (line[0] == '$') // System command
+    {
+        if (line[1] == '\0') // Help request
+            command->message = "[HLP:$$ $# $G $I $N $x=val $Nx=line $J=line $SLP $C $X $H ~ ! ? ctrl-x]\r\n";
+        return;
+    }
+
+    bool hasAxis = false;    // Line names a target
+    bool hasCentre = false;  // Line names an arc centre
+    bool dwell = false;      // Line is a G4 dwell
+    double axis[2] = {0, 0}; // X and Y words
+    bool given[2] = {false, false}; // Which axis words were present
+    double centre[2] = {0, 0}; // I and J words
+    double pause = 0.0;        // P word
+
+    for (const char *p = line; *p;)
+    {
+        const char letter = *p++; // Command letter
+        if (letter < 'A' || letter > 'Z')
+        {
+            command->status = 1; // Expected command letter
+            return;
+        }
+
+        double value;                     // Number after the letter
+        const size_t used = _number(p, &value); // Read it
+        if (used == 0)
+        {
+            command->status = 2; // Bad number format
+            return;
+        }
+        p += used; // Continue after the number
+
+        switch (letter)
+        {
+        case 'G':
+            if (value != floor(value)) // G38.2 and friends
+                command->status = 20;
+            else if (value >= 0 && value <= 3)
+                command->motionMode = (int)value; // Motion mode
+            else if (value == 4)
+                dwell = true; // Dwell
+            else if (value == 20 || value == 21)
+                command->unitScale = value == 20 ? 25.4 : 1.0; // Unit mode
+            else if (value == 90 || value == 91)
+                command->relative = value == 91; // Distance mode
+            else if (value != 17 && value != 54 && value != 94)
+                command->status = 20; // Unsupported G code
+            break;
+        case 'M':
+            if (value == 0 || value == 1 || value == 2 || value == 30 || // Program flow
+                value == 3 || value == 4 || value == 5 ||                // Spindle
+                value == 8 || value == 9)                                // Coolant
+                command->sync = true;                                    // All of them wait for motion to stop
+            else
+                command->status = 20; // Unsupported M code
+            break;
+        case 'X':
+        case 'Y':
+            axis[letter - 'X'] = value;   // Axis word
+            given[letter - 'X'] = true;   // Axis present
+            hasAxis = true;               // Line names a target
+            break;
+        case 'I':
+        case 'J':
+            centre[letter - 'I'] = value; // Arc centre offset
+            hasCentre = true;             // Line names an arc centre
+            break;
+        case 'F':
+            if (value < 0)
+                command->status = 4; // Negative value
+            command->feedRate = value; // Feed rate, converted to mm below
+            break;
+        case 'P':
+            pause = value; // Dwell time
+            break;
+        case 'Z':
+        case 'S':
+        case 'N':
+        case 'T':
+            break; // Accepted, not modelled
+        default:
+            command->status = 20; // Unsupported command
+            break;
+        }
+
+        if (command->status != 0) // Stop at the first error
+            return;
+    }
+
+    if (strchr(line, 'F')) // Feed rate word uses this line's units
+        command->feedRate *= command->unitScale;
+
+    if (dwell) // G4 waits for motion to stop, then pauses
+    {
+        command->sync = true;                                // Wait for motion to stop
+        command->block = pause > 0;                          // Pause occupies the planner
+        command->duration = pause * self->config.timeScale; // Pause length
+        return;
+    }
+    if (!hasAxis) // Modal changes only
+        return;
+
+    for (int i = 0; i < 2; i++) // Resolve the target
+        if (given[i])
+            command->target[i] = (command->relative ? self->position[i] : 0.0) + axis[i] * command->unitScale;
+
+    const double dx = command->target[0] - self->position[0]; // Move along X
+    const double dy = command->target[1] - self->position[1]; // Move along Y
+    double distance = sqrt(dx * dx + dy * dy);                 // Straight-line length
+
+    if (command->motionMode != 0 && command->feedRate <= 0) // Feed moves need a feed rate
+    {
+        command->status = 22; // Feed rate undefined
+        return;
+    }
+
+    if (command->motionMode >= 2) // Arc: length along the circle
+    {
+        if (!hasCentre)
+        {
+            command->status = 33; // Invalid target for an arc
+            return;
+        }
+        const double cx = self->position[0] + centre[0] * command->unitScale;           // Centre X
+        const double cy = self->position[1] + centre[1] * command->unitScale;           // Centre Y
+        const double radius = hypot(self->position[0] - cx, self->position[1] - cy);    // Start radius
+        const double start = atan2(self->position[1] - cy, self->position[0] - cx);     // Start angle
+        double sweep = atan2(command->target[1] - cy, command->target[0] - cx) - start; // Swept angle
+        if (command->motionMode == 2 && sweep >= 0) // Clockwise
+            sweep -= 2 * GRBL_EMU_PI;
+        if (command->motionMode == 3 && sweep <= 0) // Counter-clockwise
+            sweep += 2 * GRBL_EMU_PI;
+        distance = radius * fabs(sweep); // Arc length
+    }
+
+    if (distance <= 0) // GRBL drops zero-length moves
+        return;
+
+    const double rate = command->motionMode == 0 ? self->config.rapidRate : command->feedRate; // mm/min
+    command->block = true;                                                                       // Move occupies the planner
+    command->duration = distance / rate * 60.0 * self->config.timeScale;                           // Time at constant speed
+}
+
+/**
+ * @details
+ * strtod() cannot be used on its own: it also accepts exponents, "inf" and hexadecimal numbers,
+ * so "S0X1" would read as the hexadecimal 0X1. The number is delimited first, as GRBL does, and
+ * only the delimited characters are converted.
+ */
+static size_t _number(const char *const text, double *const value)
+{
+    size_t length = 0;   // Characters used
+    size_t digits = 0;   // Digits seen
+    bool point = false;  // Decimal point seen
+
+    if (text[length] == '-' || text[length] == '+') // Optional sign
+        length++;
+    while (isdigit((unsigned char)text[length]) || (text[length] == '.' && !point))
+    {
+        if (text[length] == '.')
+            point = true; // Only one decimal point
+        else
+            digits++; // One more digit
+        length++;
+    }
+    if (digits == 0) // Sign or point alone
+        return 0;
+
+    char number[GRBL_EMU_LINE_LENGTH + 1];  // Delimited copy
+    if (length > GRBL_EMU_LINE_LENGTH)      // Cannot happen for a line that passed the length check
+        return 0;
+    memcpy(number, text, length);           // Copy the number
+    number[length] = '\0';                  // Terminate it
+    *value = strtod(number, NULL);          // Convert it
+    return length;                          // Return characters used
+}
+
+/**
+ * @details
+ * Commits the modal changes and, for moves and dwells, queues the block. A block reaching an
+ * idle planner starts at once; the idle gap since the previous block is counted as starvation.
+ */
+static void _execute(grblEmulator_t *const self, const grblEmulatorCommand_t *const command)
+{
+    self->position[0] = command->target[0];   // New position
+    self->position[1] = command->target[1];   // New position
+    self->feedRate = command->feedRate;       // New modal state
+    self->motionMode = command->motionMode;   // New modal state
+    self->relative = command->relative;       // New modal state
+    self->unitScale = command->unitScale;     // New modal state
+
+    if (!command->block) // Nothing to plan
+        return;
+
+    const size_t slot = (self->plannerHead + self->plannerCount) % GRBL_EMU_MAX_PLANNER_BLOCKS; // Free slot
+    self->planner[slot] = command->duration;                                                      // Queue block
+    self->plannerCount++;                                                                         // One more block
+    self->stats.motionBlocks++;                                                                   // Count block
+    self->stats.motionTime += command->duration;                                                  // Count motion time
+    if (self->plannerCount > self->stats.plannerHighWater)                                        // Track fill level
+        self->stats.plannerHighWater = self->plannerCount;
+
+    if (self->plannerCount == 1) // Planner was idle
+    {
+        self->blockEnd = self->clock + command->duration; // Start the block now
+        if (self->idleSince >= 0)                         // Motion happened before
+            self->stats.starvedTime += self->clock - self->idleSince;
+    }
+}
+
+/**
+ * @details
+ * Replies share one serial line, so each starts once both the controller has produced it and
+ * the previous reply has been transmitted. If too many replies are waiting the new one is lost,
+ * which only happens when the host never reads.
+ */
+static void _reply(grblEmulator_t *const self, const char *const text, const double ready, const double lineTime)
+{
+    if (self->replyCount == GRBL_EMU_MAX_REPLIES) // No room
+        return;
+
+    grblEmulatorReply_t *const reply = &self->replies[(self->replyHead + self->replyCount) % GRBL_EMU_MAX_REPLIES]; // Free slot
+    strncpy(reply->text, text, GRBL_EMU_REPLY_LENGTH - 1);                     // Copy text
+    reply->text[GRBL_EMU_REPLY_LENGTH - 1] = '\0';                             // Ensure termination
+    reply->length = strlen(reply->text);                                       // Record length
+
+    const double start = ready > self->lineFree ? ready : self->lineFree; // Wait for the line
+    reply->due = start + reply->length * _byteTime(self);                 // Last byte sent
+    self->lineFree = reply->due;                                          // Line busy until then
+    self->replyCount++;                                                   // One more reply
+
+    if (lineTime >= 0) // Reply answers a line
+    {
+        const double latency = reply->due - lineTime; // Line complete to reply sent
+        self->stats.latencyTotal += latency;         // Sum latency
+        if (latency > self->stats.latencyMax)         // Track worst latency
+            self->stats.latencyMax = latency;
+    }
+}
+
+/**
+ * @details
+ * A 32-bit xorshift generator. It is not the C library's rand() so that a seed produces the
+ * same faults on every platform.
+ */
+static double _random(grblEmulator_t *const self)
+{
+    uint32_t x = self->random; // Current state
+    x ^= x << 13;              // Shift and mix
+    x ^= x >> 17;              // Shift and mix
+    x ^= x << 5;               // Shift and mix
+    self->random = x;          // Store state
+    return x / 4294967296.0;   // Scale to [0, 1)
+}
+
+/**
+ * @details
+ * Ten bit times per byte for 8N1 framing; an unset baud rate makes the line infinitely fast.
+ */
+static inline double _byteTime(const grblEmulator_t *const self)
+{
+    return self->config.baudRate > 0 ? 10.0 / self->config.baudRate : 0.0; // Seconds per byte
+}
@@ -0,0 +1,200 @@
+/**
+ * @file grblEmulator.h
+ * @brief Declaration of the grblEmulator_t structure, a timing model of a GRBL controller.
+ * @details
+ * The emulator reproduces the parts of GRBL that decide how fast a host can stream G-code:
+ * the serial line (bytes take ten bit times each way), the fixed-size receive buffer, and the
+ * planner queue that only accepts a new line once a block slot is free. Motion blocks take the
+ * time their length needs at the programmed feed rate. Replies can be delayed, dropped or
+ * replaced by errors to exercise the host's error handling.
+ *
+ * The model is driven purely by the timestamps passed in, it never reads the clock or touches a
+ * file descriptor itself; the pseudo-terminal front end lives in emulator/main.c.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define GRBL_EMU_BANNER "Grbl 1.1h ['$' for help]" /**< Startup banner printed after a reset. */
+#define GRBL_EMU_MAX_RX_BUFFER 1024                 /**< Largest receive buffer that can be modelled. */
+#define GRBL_EMU_MAX_PLANNER_BLOCKS 64              /**< Largest planner queue that can be modelled. */
+#define GRBL_EMU_LINE_LENGTH 80                     /**< Longest line GRBL accepts (LINE_BUFFER_SIZE). */
+#define GRBL_EMU_WIRE_SIZE 65536                    /**< Bytes that can be in transit towards the controller. */
+#define GRBL_EMU_MAX_REPLIES 1024                   /**< Replies that can be waiting to be sent. */
+#define GRBL_EMU_REPLY_LENGTH 128                   /**< Longest reply, including "\r\n". */
+#define GRBL_EMU_INJECTED_ERROR 20                  /**< Error code used for injected error replies. */
+
+#define GRBL_EMU_DEFAULT_BAUD 115200      /**< Default baud rate. */
+#define GRBL_EMU_DEFAULT_RX_BUFFER 127    /**< Default receive buffer size (GRBL on an ATmega328p). */
+#define GRBL_EMU_DEFAULT_PLANNER_BLOCKS 15 /**< Default usable planner blocks (16 slots, one kept free). */
+#define GRBL_EMU_DEFAULT_RAPID_RATE 1000.0 /**< Default G0 rate in mm/min. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Settings of the emulated controller and of the faults it injects.
+ */
+typedef struct grblEmulatorConfig_s
+{
+    long baudRate;        /**< Serial line speed in bit/s, 0 for an infinitely fast line. */
+    size_t rxBufferSize;  /**< Receive buffer size in bytes. */
+    size_t plannerBlocks; /**< Number of motion blocks the planner can hold. */
+    double timeScale;     /**< Multiplier applied to motion time, 0 to make motion instantaneous. */
+    double rapidRate;     /**< Feed rate used for G0 moves in mm/min. */
+    double jitterMs;      /**< Upper bound of the random delay added to each reply, in milliseconds. */
+    double dropRate;      /**< Probability that an "ok" is never sent. */
+    double errorRate;     /**< Probability that a valid line is rejected with an error reply. */
+    unsigned int seed;    /**< Seed of the fault injection random sequence. */
+} grblEmulatorConfig_t;
+
+/**
+ * @brief Counters collected over one host session.
+ */
+typedef struct grblEmulatorStats_s
+{
+    unsigned long bytesReceived;   /**< Bytes that reached the receive buffer. */
+    unsigned long linesReceived;   /**< Lines taken out of the receive buffer. */
+    unsigned long linesOk;         /**< Lines answered with "ok" (including dropped ones). */
+    unsigned long linesError;      /**< Lines answered with "error:N" (including injected ones). */
+    unsigned long errorsInjected;  /**< Error replies caused by fault injection. */
+    unsigned long acksDropped;     /**< "ok" replies swallowed by fault injection. */
+    unsigned long rxOverflows;     /**< Bytes lost because the receive buffer was full. */
+    unsigned long motionBlocks;    /**< Motion blocks executed. */
+    size_t rxHighWater;            /**< Largest receive buffer fill seen, in bytes. */
+    size_t plannerHighWater;       /**< Largest planner fill seen, in blocks. */
+    double firstLineTime;          /**< Time the first line was complete, negative if none. */
+    double lastReplyTime;          /**< Time the last reply finished transmitting. */
+    double motionEndTime;          /**< Time the last motion block finished. */
+    double motionTime;             /**< Total time spent executing motion. */
+    double starvedTime;            /**< Time the planner ran dry between two motion blocks. */
+    double latencyTotal;           /**< Sum over all lines of line complete to reply sent. */
+    double latencyMax;             /**< Longest line complete to reply sent. */
+} grblEmulatorStats_t;
+
+/**
+ * @brief One reply waiting for its turn on the serial line.
+ */
+typedef struct grblEmulatorReply_s
+{
+    char text[GRBL_EMU_REPLY_LENGTH]; /**< Reply text including "\r\n". */
+    size_t length;                    /**< Length of the reply in bytes. */
+    double due;                       /**< Time the last byte of the reply has been transmitted. */
+} grblEmulatorReply_t;
+
+/**
+ * @brief Structure holding the state of the emulated controller.
+ * @details
+ * Time flows only through advance(); every method takes the current time in seconds on any
+ * monotonic clock. Bytes handed to receive() travel over the modelled serial line, land in the
+ * receive buffer and are taken out one line at a time when the planner has room for them.
+ */
+typedef struct grblEmulator_s
+{
+    grblEmulatorConfig_t config; /**< Controller settings. */
+    grblEmulatorStats_t stats;   /**< Session counters. */
+    double clock;                /**< Time the model has been advanced to. */
+    uint32_t random;             /**< State of the fault injection random sequence. */
+
+    unsigned char wire[GRBL_EMU_WIRE_SIZE]; /**< Bytes on their way to the receive buffer. */
+    size_t wireHead;                        /**< Index of the next byte to arrive. */
+    size_t wireCount;                       /**< Number of bytes on the line. */
+    double wireNext;                        /**< Arrival time of the next byte. */
+
+    unsigned char rx[GRBL_EMU_MAX_RX_BUFFER]; /**< Receive buffer ring. */
+    size_t rxHead;                            /**< Index of the oldest unread byte. */
+    size_t rxCount;                           /**< Bytes in the receive buffer. */
+    size_t rxPartial;                         /**< Bytes received after the last end of line. */
+    bool rxOverlong;                          /**< true if the first line overflowed and lost bytes. */
+    double rxLineTime[GRBL_EMU_MAX_RX_BUFFER]; /**< Arrival time of each complete line. */
+    size_t rxLineHead;                        /**< Index of the oldest complete line in rxLineTime. */
+    size_t rxLines;                           /**< Complete lines in the receive buffer. */
+
+    double planner[GRBL_EMU_MAX_PLANNER_BLOCKS]; /**< Duration of each queued block, executing block first. */
+    size_t plannerHead;                          /**< Index of the executing block. */
+    size_t plannerCount;                         /**< Queued blocks. */
+    double blockEnd;                             /**< Time the executing block finishes. */
+    double idleSince;                            /**< Time the planner ran dry, negative before the first block. */
+
+    grblEmulatorReply_t replies[GRBL_EMU_MAX_REPLIES]; /**< Replies waiting to be sent. */
+    size_t replyHead;                                  /**< Index of the oldest reply. */
+    size_t replyCount;                                 /**< Number of waiting replies. */
+    double lineFree;                                   /**< Time the outgoing line is free again. */
+
+    double position[2]; /**< Machine position after the last planned block, in mm. */
+    double feedRate;    /**< Modal feed rate in mm/min, 0 until set. */
+    int motionMode;     /**< Modal motion command (0, 1, 2 or 3). */
+    bool relative;      /**< true after G91, false after G90. */
+    double unitScale;   /**< Millimetres per programmed unit (1 or 25.4). */
+
+    /**
+     * @brief Simulates a controller reset: clears every buffer and queues the startup banner.
+     * @param[in,out] self Pointer to the grblEmulator_t structure.
+     * @param[in] now Current time in seconds.
+     */
+    void (*reset)(struct grblEmulator_s *const self, const double now);
+
+    /**
+     * @brief Puts bytes written by the host on the serial line.
+     * @param[in,out] self Pointer to the grblEmulator_t structure.
+     * @param[in] data Bytes written by the host.
+     * @param[in] size Number of bytes.
+     * @param[in] now Current time in seconds.
+     * @return Number of bytes accepted; the rest does not fit on the line yet.
+     */
+    size_t (*receive)(struct grblEmulator_s *const self, const unsigned char *const data, const size_t size, const double now);
+
+    /**
+     * @brief Runs the model up to the given time.
+     * @param[in,out] self Pointer to the grblEmulator_t structure.
+     * @param[in] now Current time in seconds.
+     */
+    void (*advance)(struct grblEmulator_s *const self, const double now);
+
+    /**
+     * @brief Copies the replies whose transmission has finished by the given time.
+     * @param[in,out] self Pointer to the grblEmulator_t structure.
+     * @param[in] now Current time in seconds.
+     * @param[out] buffer Destination for the reply bytes.
+     * @param[in] size Size of the destination in bytes.
+     * @return Number of bytes copied.
+     */
+    size_t (*output)(struct grblEmulator_s *const self, const double now, char *const buffer, const size_t size);
+
+    /**
+     * @brief Time of the next thing that will happen without further input.
+     * @param[in] self Pointer to the grblEmulator_t structure.
+     * @return Time in seconds, or a negative value when the model is idle.
+     */
+    double (*nextEvent)(const struct grblEmulator_s *const self);
+
+    /**
+     * @brief Prints the session counters.
+     * @param[in] self Pointer to the grblEmulator_t structure.
+     * @param[in] file Stream to print to.
+     */
+    void (*report)(const struct grblEmulator_s *const self, FILE *const file);
+
+    /**
+     * @brief Frees the emulator.
+     * @param[in,out] self Pointer to the grblEmulator_t structure.
+     */
+    void (*free)(struct grblEmulator_s *self);
+} grblEmulator_t;
+
+/**
+ * @brief Constructs a new grblEmulator_t object in its reset state.
+ * @param[in] config Controller settings; sizes beyond the modelled limits are clamped.
+ * @return A pointer to the newly created grblEmulator_t object, or NULL if allocation fails.
+ */
+grblEmulator_t *grblEmulatorConstructor(const grblEmulatorConfig_t *const config);
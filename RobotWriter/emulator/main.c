@@ -0,0 +1,358 @@
+/**
+ * @file main.c
+ * @brief Entry point of the GRBL emulator used to test RobotWriter without a robot.
+ * @details
+ * The emulator opens a pseudo-terminal and plays the controller on its master side, so
+ * RobotWriter talks to it through the normal RS232_OpenComport() path. Point RobotWriter at the
+ * slave side with the ROBOTWRITER_PORT environment variable, or give the emulator a link path
+ * such as /dev/tty.usbmodem1101 to stand in for the real port.
+ *
+ * A session starts when the host opens the port and ends when it closes it; the emulator then
+ * prints the session counters to stderr. Everything that decides the timing (baud rate, buffer
+ * sizes, motion time, faults) is handled by the grblEmulator_t model.
+ *
+ * Usage: GrblEmulator [-b baud] [-r rx bytes] [-p planner blocks] [-t time scale] [-R rapid rate]
+ *                     [-j jitter ms] [-d drop probability] [-e error probability] [-s seed]
+ *                     [-l link path] [-1] [-v]
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700 /**< posix_openpt(), grantpt(), unlockpt(), ptsname() and symlink(). */
+#endif
+
+#include "grblEmulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define EMULATOR_POLL_MS 100  /**< Longest sleep between two looks at the port. */
+#define EMULATOR_HANGUP_MS 10 /**< Sleep while no host has the port open. */
+#define EMULATOR_IO_SIZE 4096 /**< Bytes moved per read or write. */
+
+static volatile sig_atomic_t stopRequested = 0; /**< Set by SIGINT and SIGTERM. */
+
+/**
+ * @brief Prints the command line options.
+ * @param[in] name Program name.
+ */
+static void Usage(const char *const name);
+
+/**
+ * @brief Opens the pseudo-terminal master and puts the slave side into raw mode.
+ * @param[out] slaveName Buffer receiving the slave device path.
+ * @param[in] size Size of slaveName.
+ * @return The master file descriptor, or -1 on failure.
+ */
+static int OpenPseudoTerminal(char *const slaveName, const size_t size);
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Time in seconds.
+ */
+static double Now(void);
+
+/**
+ * @brief Sleeps for the given number of milliseconds.
+ * @param[in] ms Time to sleep.
+ */
+static void SleepMs(const int ms);
+
+/**
+ * @brief Signal handler asking the main loop to stop.
+ * @param[in] signal Signal number (unused).
+ */
+static void RequestStop(int signal);
+
+///////////////////////////////////////////////////////////////////////
+//                       MAIN PROGRAM ENTRY                          //
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    grblEmulatorConfig_t config = {
+        .baudRate = GRBL_EMU_DEFAULT_BAUD,
+        .rxBufferSize = GRBL_EMU_DEFAULT_RX_BUFFER,
+        .plannerBlocks = GRBL_EMU_DEFAULT_PLANNER_BLOCKS,
+        .timeScale = 1.0,
+        .rapidRate = GRBL_EMU_DEFAULT_RAPID_RATE,
+        .jitterMs = 0.0,
+        .dropRate = 0.0,
+        .errorRate = 0.0,
+        .seed = 1,
+    };
+    const char *linkPath = NULL; // Optional link to the slave device
+    bool once = false;           // Exit after the first session
+    bool verbose = false;        // Echo the traffic
+
+    int option;
+    while ((option = getopt(argc, argv, "b:r:p:t:R:j:d:e:s:l:1vh")) != -1)
+    {
+        switch (option)
+        {
+        case 'b':
+            config.baudRate = atol(optarg);
+            break;
+        case 'r':
+            config.rxBufferSize = (size_t)atol(optarg);
+            break;
+        case 'p':
+            config.plannerBlocks = (size_t)atol(optarg);
+            break;
+        case 't':
+            config.timeScale = atof(optarg);
+            break;
+        case 'R':
+            config.rapidRate = atof(optarg);
+            break;
+        case 'j':
+            config.jitterMs = atof(optarg);
+            break;
+        case 'd':
+            config.dropRate = atof(optarg);
+            break;
+        case 'e':
+            config.errorRate = atof(optarg);
+            break;
+        case 's':
+            config.seed = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            linkPath = optarg;
+            break;
+        case '1':
+            once = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            Usage(argv[0]);
+            return (option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    char slaveName[256];
+    const int master = OpenPseudoTerminal(slaveName, sizeof(slaveName));
+    if (master < 0)
+        return EXIT_FAILURE;
+
+    if (linkPath)
+    {
+        unlink(linkPath); // Replace a stale link
+        if (symlink(slaveName, linkPath) != 0)
+        {
+            perror("Unable to create port link ");
+            close(master);
+            return EXIT_FAILURE;
+        }
+    }
+
+    grblEmulator_t *emulator = grblEmulatorConstructor(&config);
+    if (!emulator)
+    {
+        perror("Memory allocation failed ");
+        close(master);
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, RequestStop);
+    signal(SIGTERM, RequestStop);
+
+    printf("GRBL emulator on %s%s%s\n", slaveName, linkPath ? " linked from " : "", linkPath ? linkPath : "");
+    printf("Run RobotWriter with ROBOTWRITER_PORT=%s\n", linkPath ? linkPath : slaveName);
+    printf("baud %ld, rx %zu bytes, planner %zu blocks, time scale %g, jitter %g ms, drop %g, error %g, seed %u\n",
+           emulator->config.baudRate, emulator->config.rxBufferSize, emulator->config.plannerBlocks,
+           emulator->config.timeScale, emulator->config.jitterMs, emulator->config.dropRate,
+           emulator->config.errorRate, emulator->config.seed);
+    fflush(stdout);
+
+    bool connected = false;             // A host has the port open
+    char out[EMULATOR_IO_SIZE];         // Replies not yet written
+    size_t outLen = 0;                  // Bytes in out
+    unsigned char in[EMULATOR_IO_SIZE]; // Bytes read from the host
+    size_t inLen = 0;                   // Bytes in not yet on the wire
+
+    while (!stopRequested)
+    {
+        double now = Now();
+        const double next = emulator->nextEvent(emulator);
+        int timeout = EMULATOR_POLL_MS;
+        if (next >= 0)
+        {
+            const double wait = (next - now) * 1000.0;
+            timeout = wait <= 0 ? 0 : wait < EMULATOR_POLL_MS ? (int)wait + 1 : EMULATOR_POLL_MS;
+        }
+        if (outLen > 0 || inLen > 0)
+            timeout = 0;
+
+        struct pollfd pfd = {.fd = master, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, timeout) < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+        now = Now();
+
+        if (pfd.revents & POLLHUP) // No host has the port open
+        {
+            if (connected)
+            {
+                connected = false;
+                fprintf(stderr, "Host disconnected\n");
+                emulator->advance(emulator, now);
+                emulator->report(emulator, stderr);
+                if (once)
+                    break;
+            }
+            SleepMs(EMULATOR_HANGUP_MS);
+            continue;
+        }
+
+        if (!connected) // A host opened the port: power up the controller
+        {
+            connected = true;
+            outLen = inLen = 0;
+            emulator->reset(emulator, now);
+            fprintf(stderr, "Host connected\n");
+        }
+
+        if ((pfd.revents & POLLIN) && inLen == 0)
+        {
+            const ssize_t n = read(master, in, sizeof(in));
+            if (n > 0)
+                inLen = (size_t)n;
+            if (verbose && n > 0)
+                printf("> %.*s", (int)n, (const char *)in);
+        }
+        if (inLen > 0)
+        {
+            const size_t taken = emulator->receive(emulator, in, inLen, now);
+            memmove(in, in + taken, inLen - taken);
+            inLen -= taken;
+        }
+
+        emulator->advance(emulator, now);
+        outLen += emulator->output(emulator, now, out + outLen, sizeof(out) - outLen);
+        if (outLen > 0)
+        {
+            const ssize_t n = write(master, out, outLen);
+            if (n > 0)
+            {
+                if (verbose)
+                    printf("< %.*s", (int)n, out);
+                memmove(out, out + n, outLen - (size_t)n);
+                outLen -= (size_t)n;
+            }
+        }
+        if (verbose)
+            fflush(stdout);
+    }
+
+    if (connected)
+    {
+        emulator->advance(emulator, Now());
+        emulator->report(emulator, stderr);
+    }
+    if (linkPath)
+        unlink(linkPath);
+    emulator->free(emulator);
+    close(master);
+    return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static void Usage(const char *const name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -b baud     serial line speed, 0 for no transfer time (default %d)\n"
+            "  -r bytes    receive buffer size (default %d)\n"
+            "  -p blocks   planner blocks (default %d)\n"
+            "  -t scale    motion time multiplier, 0 for instant moves (default 1)\n"
+            "  -R rate     G0 rate in mm/min (default %.0f)\n"
+            "  -j ms       random extra delay of up to ms per reply\n"
+            "  -d p        probability that an ok is dropped\n"
+            "  -e p        probability that a line is rejected with error:%d\n"
+            "  -s seed     fault injection seed (default 1)\n"
+            "  -l path     create a link to the port at path, e.g. /dev/tty.usbmodem1101\n"
+            "  -1          exit when the first host disconnects\n"
+            "  -v          echo the traffic\n",
+            name, GRBL_EMU_DEFAULT_BAUD, GRBL_EMU_DEFAULT_RX_BUFFER, GRBL_EMU_DEFAULT_PLANNER_BLOCKS,
+            GRBL_EMU_DEFAULT_RAPID_RATE, GRBL_EMU_INJECTED_ERROR);
+}
+
+// The slave is opened once to set raw mode, the setting stays with the pseudo-terminal while
+// the master is open. Closing it again lets POLLHUP on the master tell whether a host is attached.
+static int OpenPseudoTerminal(char *const slaveName, const size_t size)
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("Unable to open pseudo-terminal ");
+        return -1;
+    }
+
+    const char *name = ptsname(master);
+    if (!name || strlen(name) >= size)
+    {
+        perror("Unable to name pseudo-terminal ");
+        close(master);
+        return -1;
+    }
+    strcpy(slaveName, name);
+
+    const int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    struct termios settings;
+    if (slave < 0 || tcgetattr(slave, &settings) != 0)
+    {
+        perror("Unable to configure pseudo-terminal ");
+        close(master);
+        return -1;
+    }
+    settings.c_iflag = 0;
+    settings.c_oflag = 0;
+    settings.c_lflag = 0;
+    settings.c_cflag = CS8 | CREAD | CLOCAL;
+    settings.c_cc[VMIN] = 1;
+    settings.c_cc[VTIME] = 0;
+    tcsetattr(slave, TCSANOW, &settings);
+    close(slave);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void SleepMs(const int ms)
+{
+    struct timespec delay = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+static void RequestStop(int signal)
+{
+    (void)signal;
+    stopRequested = 1;
+}
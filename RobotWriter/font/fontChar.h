@@ -1,12 +1,11 @@
 /**
  * @file fontChar.h
- * @brief Declarations and definitions related to the fontCharacter_t structure and its operations.
+ * @brief Declarations of the stroke_t and fontCharacter_t structures.
  * @details
- * This header file provides the declarations for the fontCharacter_t structure and its associated
- * functions. The fontCharacter_t represents a font character defined by a sequence of strokes.
- * Each stroke indicates a movement of the pen (with pen up or pen down states) to draw the character.
- * The file also declares the fontCharConstructor function which creates and initializes a
- * fontCharacter_t instance.
+ * A font character is a sequence of strokes. Each stroke moves the pen by a vector, with the pen
+ * either up or down, to draw the character. The strokes of every character of a font are kept
+ * back to back in one stroke arena owned by the fontData_t, and a fontCharacter_t only records
+ * where its strokes start in that arena and how many there are.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 #pragma once
@@ -15,6 +14,7 @@
 #include "../misc/coord.h"
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DECLARATIONS                      //
@@ -25,57 +25,80 @@
  */
 typedef Coord2D_t Vect2d_t;
 
+#define STROKE_STEPS_PER_UNIT 32                  /**< Fixed-point steps per font unit. */
+#define STROKE_STEP (1.0 / STROKE_STEPS_PER_UNIT) /**< Font units per fixed-point step. */
+#define STROKE_MAX_X_STEPS (INT16_MAX / 2)        /**< Largest x component a stroke holds, in steps. */
+#define STROKE_MIN_X_STEPS (INT16_MIN / 2)        /**< Smallest x component a stroke holds, in steps. */
+
 /**
  * @brief Structure representing a single stroke of a character.
  * @details A stroke consists of a vector (defining direction and length) and a pen state.
  * The pen state indicates whether the pen is down (drawing) or up (not drawing) as it moves
  * along the specified vector.
+ *
+ * The vector is kept unscaled, in fixed-point steps of 1/STROKE_STEPS_PER_UNIT font unit, and
+ * the pen state in the lowest bit of x, so a stroke takes four bytes. StrokeVector() scales it
+ * to the size it is drawn at. A step is exact in binary, so a font given in
+ * whole or binary-fraction units draws exactly as it would from doubles.
  */
 typedef struct stroke_s
 {
-    Vect2d_t vec;   /**< 2D vector representing the direction and length of the stroke. */
-    bool pen_state; /**< Pen state: true = pen down (drawing), false = pen up (moving without drawing). */
+    int16_t x; /**< X component in steps, times two, plus one if the pen is down. */
+    int16_t y; /**< Y component in steps. */
 } stroke_t;
 
 /**
  * @brief Structure representing a font character.
- * @details This structure stores all the strokes that form a single character. It keeps track of:
- * - The ASCII character it represents.
- * - The total number of strokes.
- * - The current stroke index (to which new strokes can be appended).
- * - A dynamically allocated array of strokes.
- *
- * It also provides function pointers to:
- * - Append a new stroke to the character.
- * - Free all associated resources when the character is no longer needed.
+ * @details The strokes of the character are `strokes[first]` to `strokes[first + numStrokes - 1]`
+ * of the stroke arena of the font it belongs to.
  */
 typedef struct fontCharacter_s
 {
-    char asciiKey;      /**< ASCII character this font character represents. */
+    uint32_t first;     /**< Index of the first stroke of the character in the stroke arena. */
     uint8_t numStrokes; /**< Total number of strokes that define the character. */
-    uint8_t strokeIdx;  /**< Current stroke index, indicating how many strokes have been appended. */
-    stroke_t *strokes;  /**< Dynamically allocated array of strokes defining the character. */
+    bool defined;       /**< true if the font defines the character, which may have no strokes. */
+} fontCharacter_t;
 
-    /**
-     * @brief Function pointer to append a stroke to the font character.
-     * @param[in,out] self   Pointer to the fontCharacter_t structure.
-     * @param[in]     stroke The stroke to be appended.
-     * @return SUCCESS on success, or an appropriate error code.
-     */
-    errorCode_t (*appendStroke)(struct fontCharacter_s *const self, const stroke_t stroke);
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
 
-    /**
-     * @brief Function pointer to free the font character and its resources.
-     * @param[in,out] self Pointer to the fontCharacter_t structure.
-     * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
-     */
-    errorCode_t (*free)(struct fontCharacter_s *self);
-} fontCharacter_t;
+/**
+ * @brief Packs a stroke.
+ * @param[in] x X component in steps, from INT16_MIN / 2 to INT16_MAX / 2.
+ * @param[in] y Y component in steps.
+ * @param[in] penDown true if the pen is down.
+ * @return The stroke.
+ */
+static inline stroke_t StrokePack(const int16_t x, const int16_t y, const bool penDown)
+{
+    stroke_t result;
+    result.x = (int16_t)(x * 2 + penDown);
+    result.y = y;
+    return result;
+}
 
 /**
- * @brief Constructs and initializes a new fontCharacter_t object.
- * @param[in] asciiKey    The ASCII character key that this font character represents.
- * @param[in] numStrokes  The number of strokes that will be associated with this font character.
- * @return A pointer to the newly created fontCharacter_t object, or NULL if allocation fails.
+ * @brief Tells whether the pen is down during a stroke.
+ * @param[in] stroke The stroke.
+ * @return true if the pen is down, false if it is up.
  */
-fontCharacter_t *fontCharConstuctor(const char asciiKey, const uint8_t numStrokes);
+static inline bool StrokePenDown(const stroke_t stroke)
+{
+    return stroke.x & 1;
+}
+
+/**
+ * @brief Gives the vector of a stroke, scaled.
+ * @param[in] stroke The stroke.
+ * @param[in] scale The scale factor of the font.
+ * @return The vector in millimetres.
+ */
+static inline Vect2d_t StrokeVector(const stroke_t stroke, const double scale)
+{
+    const double unit = STROKE_STEP * scale;
+    Vect2d_t result;
+    result.x = (stroke.x - StrokePenDown(stroke)) * (unit / 2);
+    result.y = stroke.y * unit;
+    return result;
+}
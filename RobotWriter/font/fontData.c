@@ -1,85 +1,287 @@
 /**
  * @file fontData.c
- * @brief Implementation of font data handling, including hashing, insertion, lookup, scaling, and parsing.
+ * @brief Implementation of font data handling, including lookup, parsing, loading and saving.
  * @details
- * This file provides the functionality to store and manage font characters inside a hash table.
- * Each font character is associated with an ASCII key and is stored as a series of strokes.
- * The hash table uses chaining to handle collisions, allowing multiple font characters with
- * the same hash to be stored as a linked list of nodes.
+ * This file provides the functionality to store and manage font characters. Each font character
+ * is associated with a Unicode code point and is stored as a run of strokes in one stroke arena;
+ * the entry for the code point in the page table holds the index of the first stroke and the
+ * number of strokes. The directory, the pages and the arena lie one after the other in a single
+ * font image.
  *
- * Functions are provided to insert and look up font characters, scale the strokes of all font
- * characters by a given factor, parse a font file to populate the hash table, and free all
- * allocated resources.
+ * A text font is read into memory in one piece and parsed in a single pass. Every stroke and
+ * every character takes a line of the font file, so the lines are counted first and the strokes
+ * and character definitions are parsed into a scratch buffer with room for that many of each.
+ * The pages the characters need are then known, and the image is allocated in one piece and
+ * filled. Loading a text font therefore leaves a single allocation for the font however many
+ * characters it has, and freeing it takes a single free. The parser reads the numbers itself,
+ * without scanf(), and reports the number of any malformed line. The strokes are packed into
+ * fixed-point as they are read and never change after that.
+ *
+ * A binary font file is a header followed by such an image. It is mapped read-only into memory
+ * and its header and page table are checked, but nothing is parsed: the table and the strokes
+ * are used where they lie in the mapping. Where mmap() is not available the file is read into one
+ * allocation instead. A font compiled into the program is attached the same way, with its table
+ * and strokes used where they lie in the program's read-only data.
+ *
+ * Once a font is in place its characters are measured in one pass over the pages, into a metrics
+ * table allocated alongside the image, so the only allocation a mapped or attached font makes is
+ * that table.
+ *
+ * Functions are provided to look up font characters, load a font file to populate the table,
+ * attach a font held in memory, save the font as a binary font file, and free all allocated
+ * resources.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 
+#if defined(__unix__) || defined(__APPLE__)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L /**< open(), fstat() and mmap(). */
+#endif
+#define FONT_MMAP /**< Binary fonts are mapped rather than read. */
+#endif
+
 #include "fontData.h"
 
+#include <math.h>
+#include <string.h>
+
+#ifdef FONT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////
 //                        PRIVATE   DECLARATIONS                     //
 ///////////////////////////////////////////////////////////////////////
 
-/**
- * @brief Node in the hash table for storing font characters.
- * @details Each hash node contains:
- * - A character key (ASCII key for the font character).
- * - A pointer to a fontCharacter_t object.
- * - A pointer to the next node in the chain (for handling collisions).
- */
-typedef struct hashNode_s
-{
-    char key;                   /**< ASCII key for the character. */
-    fontCharacter_t *character; /**< Pointer to the font character. */
-    struct hashNode_s *next;    /**< Pointer to the next node in the chain. */
-} hashNode_t;
+#define FONT_MAX_DIGITS 9 /**< Most digits of an integer in a text font, so it fits a long. */
+
+static const fontCharacter_t noCharacters[FONT_PAGE_SIZE]; /**< Empty page, the only page of a font data without a font. */
+static const fontMetrics_t noMetrics[FONT_PAGE_SIZE];      /**< Metrics of the empty page. */
 
 /**
- * @brief Inserts a font character into the hash table.
- * @param[in,out] self       Pointer to the fontData_t instance.
- * @param[in]     character  Pointer to the font character to insert.
- * @return SUCCESS on success, or an appropriate error code:
- *         - ERROR_NULL_POINTER if `self` or `character` is NULL.
- *         - ERROR_MEMORY_ALLOCATION_FAILED if memory allocation for the node fails.
+ * @brief A character definition read from a text font, before the page table is built.
  */
-static errorCode_t _insert(fontData_t *const self, fontCharacter_t *const character);
+typedef struct fontDefinition_s
+{
+    uint32_t codePoint;  /**< Code point of the character. */
+    uint32_t first;      /**< Index of its first stroke in the stroke arena. */
+    uint8_t numStrokes;  /**< Number of strokes. */
+} fontDefinition_t;
 
 /**
- * @brief Looks up a font character in the hash table by ASCII key.
+ * @brief Looks up a font character in the page table by code point.
  * @param[in] self      Pointer to the fontData_t instance.
- * @param[in] asciiKey  ASCII key of the font character to retrieve.
+ * @param[in] codePoint Code point of the font character to retrieve.
  * @return Pointer to the corresponding fontCharacter_t on success, or NULL if not found or
  *         if `self` is NULL.
  */
-static const fontCharacter_t *_lookup(const fontData_t *const self, const char asciiKey);
-
-/**
- * @brief Scales all strokes in the font data by a given factor.
- * @param[in,out] fontData Pointer to the fontData_t instance.
- * @param[in]     scale    The factor by which to scale the font strokes.
- * @return SUCCESS on success, or ERROR_NULL_POINTER if `fontData` is NULL.
- */
-static errorCode_t _scale(fontData_t *const self, double scale);
+static const fontCharacter_t *_lookup(const fontData_t *const self, const uint32_t codePoint);
 
 /**
- * @brief Hash function for converting a character key into an index.
- * @param[in] key The ASCII character key to hash.
- * @return An unsigned integer in [0,127] representing the hash table index.
+ * @brief Gives the metrics of a font character by code point.
+ * @param[in] self      Pointer to the fontData_t instance.
+ * @param[in] codePoint Code point of the font character.
+ * @return Pointer to its metrics, or NULL if the character is not defined or `self` is NULL.
  */
-static inline unsigned int _hash_function(char key);
+static const fontMetrics_t *_measure(const fontData_t *const self, const uint32_t codePoint);
 
 /**
- * @brief Parses the font file and populates the hash table with font characters.
+ * @brief Loads a text or binary font file into the table and the stroke arena.
  * @param[in,out] fontData Pointer to the fontData_t instance to populate.
- * @param[in]     filename Name of the font file to parse.
+ * @param[in]     filename Name of the font file to load.
  * @return SUCCESS on success, or an appropriate error code:
  *         - ERROR_NULL_POINTER if `fontData` or `filename` is NULL.
- *         - ERROR_OPEN_FILE if the file cannot be opened.
- *         - ERROR_MEMORY_ALLOCATION_FAILED if memory allocation for font characters fails.
+ *         - ERROR_NO_FONT_DATA if the file cannot be opened or mapped.
+ *         - ERROR_INVALID_FONT_FILE if a binary font file is damaged or of another version.
+ *         - ERROR_PARSE_CHARACTER, ERROR_PARSE_STROKE or ERROR_UNEXPECTED_EOF if a text font file
+ *           is malformed, after its name and the line are printed.
+ *         - ERROR_INVALID_FONT_CHARACTER if a character has more strokes than a fontCharacter_t holds.
+ *         - ERROR_INVALID_FONT_STROKE_VEC if a stroke is too long for a stroke_t.
+ *         - ERROR_MEMORY_ALLOCATION_FAILED if memory allocation for the font image or its metrics fails.
  */
 static errorCode_t _parse(fontData_t *const self, const char *const filename);
 
 /**
- * @brief Frees all memory allocated for the font data, including the hash table and its contents.
+ * @brief Uses a table held in memory, such as that of the embedded font.
+ * @param[in,out] self  Pointer to the fontData_t instance.
+ * @param[in]     table The table.
+ * @return SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_FONT_FILE if the table is not
+ *         consistent, or ERROR_MEMORY_ALLOCATION_FAILED if it cannot be measured.
+ */
+static errorCode_t _attach(fontData_t *const self, const fontTable_t *const table);
+
+/**
+ * @brief Writes the font as a binary font file.
+ * @param[in] self     Pointer to the fontData_t instance.
+ * @param[in] filename Name of the file to create.
+ * @return SUCCESS, ERROR_NULL_POINTER, ERROR_NO_FONT_DATA, ERROR_OPEN_FILE or ERROR_FONT_WRITE.
+ */
+static errorCode_t _save(const fontData_t *const self, const char *const filename);
+
+/**
+ * @brief Parses a text font file into a newly allocated font image.
+ * @param[in,out] self     Pointer to the fontData_t instance, without a font.
+ * @param[in]     file     Font file, read from its start.
+ * @param[in]     filename Name of the font file, for the error message.
+ * @return SUCCESS, or the errors of _read() and _index(), ERROR_INVALID_FONT_FILE if the file is
+ *         too large, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _parseText(fontData_t *const self, FILE *const file, const char *const filename);
+
+/**
+ * @brief Reads a whole file into a buffer that ends in a newline.
+ * @param[in]  file File, read from its start.
+ * @param[out] size Bytes in the buffer, the newline included.
+ * @return The buffer, to be freed, or NULL if memory allocation failed.
+ */
+static char *_readFile(FILE *const file, size_t *const size);
+
+/**
+ * @brief Parses the character definitions of a text font into definitions and a stroke arena.
+ * @param[in]  text           Text of the font file, ending in a newline.
+ * @param[in]  end            End of the text.
+ * @param[out] definitions    Definitions to fill, with room for one per line of the text.
+ * @param[out] numDefinitions Number of definitions read.
+ * @param[out] strokes        Stroke arena to fill, with room for a stroke per line of the text.
+ * @param[out] numStrokes     Number of strokes read.
+ * @param[out] line           Number of the line an error was found on.
+ * @return SUCCESS, or an appropriate error code:
+ *         - ERROR_PARSE_CHARACTER if a line is neither a character header nor blank.
+ *         - ERROR_PARSE_STROKE if a stroke line is malformed.
+ *         - ERROR_UNEXPECTED_EOF if the file ends before the strokes of a character.
+ *         - ERROR_INVALID_FONT_CHARACTER if a character has more strokes than a fontCharacter_t holds.
+ *         - ERROR_INVALID_FONT_STROKE_VEC if a stroke is too long for a stroke_t.
+ */
+static errorCode_t _read(const char *text, const char *const end, fontDefinition_t *const definitions,
+                         size_t *const numDefinitions, stroke_t *const strokes, size_t *const numStrokes,
+                         size_t *const line);
+
+/**
+ * @brief Builds the font image of a text font from its definitions and strokes.
+ * @param[in,out] self           Pointer to the fontData_t instance, without a font.
+ * @param[in]     definitions    Character definitions, in the order of the file.
+ * @param[in]     numDefinitions Number of definitions.
+ * @param[in]     strokes        Stroke arena.
+ * @param[in]     numStrokes     Number of strokes.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _index(fontData_t *const self, const fontDefinition_t *const definitions,
+                          const size_t numDefinitions, const stroke_t *const strokes, const size_t numStrokes);
+
+/**
+ * @brief Lays out the directory, the pages and the strokes one after the other.
+ * @param[in]  numBlocks    Entries of the directory, which starts at `start`.
+ * @param[in]  numPages     Number of pages.
+ * @param[in]  numStrokes   Number of strokes.
+ * @param[in]  start        Offset of the directory.
+ * @param[out] pageOffset   Offset of the pages, aligned for a fontCharacter_t.
+ * @param[out] strokeOffset Offset of the strokes.
+ * @return Offset of the end of the strokes.
+ */
+static size_t _layout(const size_t numBlocks, const size_t numPages, const size_t numStrokes, const size_t start,
+                      size_t *const pageOffset, size_t *const strokeOffset);
+
+/**
+ * @brief Reads an integer after any blanks.
+ * @param[in,out] cursor Position in the text, moved past the integer.
+ * @param[out]    value  The integer.
+ * @return true if there was an integer of at most FONT_MAX_DIGITS digits.
+ */
+static bool _integer(const char **const cursor, long *const value);
+
+/**
+ * @brief Reads a stroke component, a whole or decimal number of font units, after any blanks.
+ * @param[in,out] cursor Position in the text, moved past the number.
+ * @param[out]    steps  The number in fixed-point steps, rounded to the nearest.
+ * @return true if there was a number with at most FONT_MAX_DIGITS digits before the point.
+ */
+static bool _steps(const char **const cursor, int64_t *const steps);
+
+/**
+ * @brief Moves past the blanks at the end of a line and its newline.
+ * @param[in,out] cursor Position in the text, moved to the next line.
+ * @return true if the rest of the line was blank.
+ */
+static bool _endOfLine(const char **const cursor);
+
+/**
+ * @brief Counts the lines of a text.
+ * @param[in] text The text, ending in a newline.
+ * @param[in] end  End of the text.
+ * @return Number of lines.
+ */
+static size_t _countLines(const char *text, const char *const end);
+
+/**
+ * @brief Maps a binary font file into memory, or reads it where mmap() is not available.
+ * @param[in,out] self     Pointer to the fontData_t instance, without a font.
+ * @param[in]     filename Name of the binary font file.
+ * @return SUCCESS, ERROR_NO_FONT_DATA if the file cannot be opened or mapped,
+ *         ERROR_INVALID_FONT_FILE if it is damaged, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _map(fontData_t *const self, const char *const filename);
+
+/**
+ * @brief Checks the header and table of a binary font file and points the font data into it.
+ * @param[in,out] self Pointer to the fontData_t instance holding the image.
+ * @return SUCCESS, or ERROR_INVALID_FONT_FILE if the image is damaged, of another version, or
+ *         written by a machine of another byte order.
+ */
+static errorCode_t _check(fontData_t *const self);
+
+/**
+ * @brief Tells whether an array lies inside a binary font file, after its header.
+ * @param[in] offset      Offset of the array.
+ * @param[in] count       Number of elements.
+ * @param[in] elementSize Size of an element.
+ * @param[in] alignment   Alignment of an element.
+ * @param[in] size        Size of the file.
+ * @return true if the array fits and is aligned.
+ */
+static bool _fits(const size_t offset, const size_t count, const size_t elementSize, const size_t alignment,
+                  const size_t size);
+
+/**
+ * @brief Checks that a page table only refers to pages and strokes it has.
+ * @param[in] table The table.
+ * @return SUCCESS, or ERROR_INVALID_FONT_FILE if the directory refers to a page past the last,
+ *         page 0 defines a character, or a character has strokes past the arena.
+ */
+static errorCode_t _validate(const fontTable_t *const table);
+
+/**
+ * @brief Measures every character of the table in place into a newly allocated metrics table.
+ * @param[in,out] self Pointer to the fontData_t instance, with the metrics of the empty page.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _measureTable(fontData_t *const self);
+
+/**
+ * @brief Measures the strokes of one character.
+ * @param[in]  strokes    The strokes.
+ * @param[in]  numStrokes Number of strokes.
+ * @param[out] metrics    Metrics to fill, cleared.
+ */
+static void _measureCharacter(const stroke_t *const strokes, const uint8_t numStrokes, fontMetrics_t *const metrics);
+
+/**
+ * @brief Grows the ink box of a character to hold a point.
+ * @param[in,out] metrics Metrics of the character.
+ * @param[in]     point   The point, in font units.
+ */
+static void _ink(fontMetrics_t *const metrics, const Vect2d_t point);
+
+/**
+ * @brief Releases the font image and the metrics and leaves an empty table.
+ * @param[in,out] self Pointer to the fontData_t instance.
+ */
+static void _clear(fontData_t *const self);
+
+/**
+ * @brief Frees all memory allocated for the font data, including the font image.
  * @param[in,out] self Pointer to the fontData_t instance to free.
  * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
  */
@@ -91,8 +293,8 @@ static errorCode_t _free(fontData_t *self);
 
 /**
  @details Allocates memory for the fontData_t structure, sets the function pointers, and
- * initializes the hash table to NULL. This structure can then be used to insert, lookup,
- * scale, and parse font characters, and finally be freed when no longer needed.
+ * initializes an empty table with no font image. This structure can then be used to load, look
+ * up and save font characters, and finally be freed when no longer needed.
  */
 fontData_t *fontDataConstructor(void)
 {
@@ -103,17 +305,18 @@ fontData_t *fontDataConstructor(void)
         return NULL;                                  // Return NULL
     }
 
-    fontData->free = _free;     // Function pointer to free the font data
-    fontData->lookup = _lookup; // Function pointer to look up a font character
-    fontData->insert = _insert; // Function pointer to insert a font character
-    fontData->scale = _scale;   // Function pointer to scale the font data
-    fontData->parse = _parse;   // Function pointer to parse a font file
+    fontData->free = _free;       // Function pointer to free the font data
+    fontData->lookup = _lookup;   // Function pointer to look up a font character
+    fontData->measure = _measure; // Function pointer to give the metrics of a font character
+    fontData->parse = _parse;     // Function pointer to load a font file
+    fontData->attach = _attach;   // Function pointer to use a font held in memory
+    fontData->save = _save;       // Function pointer to save a binary font file
 
-    for (int i = 0; i < ASCII_CHARACTERS; i++) // Initialize hash table to NULL
-    {
-        fontData->table[i] = NULL; // Set each element to NULL
-    }
-    return fontData; // Return the fontData_t structure
+    fontData->image = NULL;        // No font image yet
+    fontData->mapped = false;      // Nothing mapped
+    fontData->metrics = noMetrics; // No metrics yet
+    _clear(fontData);              // Initialize table to the empty page
+    return fontData;               // Return the fontData_t structure
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -122,165 +325,702 @@ fontData_t *fontDataConstructor(void)
 
 /**
  * @details
- * Allocates a new hash node and places it in the hash table at the index computed by
- * the hash function. In the event of a collision, the new node is linked into the existing chain.
+ * The code point selects a page through the directory and the character within it, without
+ * any search. Code points without a page land on the empty page, so they give NULL like
+ * characters the font does not define.
+ */
+static const fontCharacter_t *_lookup(const fontData_t *const self, const uint32_t codePoint)
+{
+    if (!self)       // Check if self is NULL
+        return NULL; // Return NULL
+
+    const fontCharacter_t *const fontChar = &self->table.pages[FontDataIndex(self, codePoint)]; // Entry of the code point
+    return fontChar->defined ? fontChar : NULL;                                                 // Return character if defined
+}
+
+/**
+ * @details
+ * The metrics sit at the index of the character in the pages, so this is the same two indexes as
+ * a lookup.
+ */
+static const fontMetrics_t *_measure(const fontData_t *const self, const uint32_t codePoint)
+{
+    if (!self)       // Check if self is NULL
+        return NULL; // Return NULL
+
+    const size_t index = FontDataIndex(self, codePoint);                     // Entry of the code point
+    return self->table.pages[index].defined ? &self->metrics[index] : NULL; // Return metrics if defined
+}
+
+/**
+ * @details
+ * Opens the specified file and reads its first bytes. A file that starts with FONT_BINARY_MAGIC
+ * is mapped as a binary font; any other is parsed as a text font. A font loaded before is
+ * dropped first, and so is a font that turns out to be invalid.
  */
-static errorCode_t _insert(fontData_t *const self, fontCharacter_t *const character)
+static errorCode_t _parse(fontData_t *const self, const char *const filename)
 {
-    if (!character)                              // Check if character is NULL
+    if (!self)                                   // Check if fontData is NULL
         return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    if (!self)                                   // Check if self is NULL
+    if (!filename)                               // Check if filename is NULL
         return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    unsigned int index = _hash_function(character->asciiKey); // Compute hash index
-    hashNode_t *new_node = malloc(sizeof(hashNode_t));        // Allocate memory for new node
-    if (!new_node)                                            // Check if memory allocation failed
-        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED);  // Handle error
+    FILE *file = fopen(filename, "rb");          // Open file
+    if (!file)                                   // Check if file cannot be opened
+        return ErrorHandler(ERROR_NO_FONT_DATA); // Handle error
+
+    char magic[sizeof(FONT_BINARY_MAGIC) - 1];                                   // First bytes of the file
+    const bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && // Read them
+                        memcmp(magic, FONT_BINARY_MAGIC, sizeof(magic)) == 0;    // Check if it is a binary font
 
-    new_node->key = character->asciiKey; // Set key to ASCII key
-    new_node->character = character;     // Set character to font character
-    new_node->next = self->table[index]; // Set next to current node at index
-    self->table[index] = new_node;       // Set current node at index to new node
+    _clear(self);      // Drop the previous font
+    errorCode_t error; // Result of loading
+    if (binary)        // Binary font
+    {
+        fclose(file);                 // Close file
+        error = _map(self, filename); // Map it
+    }
+    else // Text font
+    {
+        rewind(file);                             // Read it from the start
+        error = _parseText(self, file, filename); // Parse it
+        fclose(file);                             // Close file
+    }
 
+    if (error == SUCCESS)            // Check if the file is valid
+        error = _measureTable(self); // Measure its characters
+    if (error != SUCCESS)            // Check if the font is ready
+    {
+        _clear(self);               // Drop what was loaded
+        return ErrorHandler(error); // Handle error
+    }
     return SUCCESS; // Return success
 }
 
 /**
  * @details
- * Computes the hash index for the given ASCII key and searches the chain at that index.
- * If the character is found, returns a pointer to the corresponding fontCharacter_t.
+ * The directory, the pages and the strokes are not copied: they must stay in place, unchanged,
+ * until the font is freed or another one loaded. Only the page table is checked, as any value is
+ * a valid stroke.
  */
-static const fontCharacter_t *_lookup(const fontData_t *const self, const char asciiKey)
+static errorCode_t _attach(fontData_t *const self, const fontTable_t *const table)
 {
-    if (!self)       // Check if self is NULL
-        return NULL; // Return NULL
+    if (!self || !table || !table->pages || // Check if self or the table is NULL
+        (!table->directory && table->numBlocks > 0) || (!table->strokes && table->numStrokes > 0))
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    unsigned int index = _hash_function(asciiKey); // Compute hash index
-    hashNode_t *node = self->table[index];         // Get node at index
-    while (node != NULL)                           // Iterate through chain
+    const errorCode_t error = _validate(table); // Check the table
+    if (error != SUCCESS)                       // Check if it is consistent
+        return ErrorHandler(error);             // Handle error
+
+    _clear(self);                                     // Drop the previous font
+    self->table = *table;                             // Use the table in place
+    const errorCode_t measured = _measureTable(self); // Measure its characters
+    if (measured != SUCCESS)                          // Check if it could be measured
     {
-        if (node->key == asciiKey) // Check if key matches
-        {
-            return node->character; // Return character
-        }
-        node = node->next; // Move to next node
+        _clear(self);                  // Drop the table
+        return ErrorHandler(measured); // Handle error
     }
-    return NULL; // Return NULL if not found
+    return SUCCESS; // Return success
 }
 
 /**
  * @details
- * Iterates through each font character in the hash table and multiplies the x and y
- * components of each stroke by the given scale factor.
+ * The header is made up from the font, so a font parsed, mapped or attached is saved the same
+ * way, and is followed by the directory, the pages and the strokes up to the last one, laid out
+ * as _layout() does. The padding after the directory is written as zeros, the padding of the
+ * pages is cleared when a text font is parsed and is zero in a table compiled into the program,
+ * so the same font always gives the same file.
  */
-static errorCode_t _scale(fontData_t *const self, double scale)
+static errorCode_t _save(const fontData_t *const self, const char *const filename)
 {
-    if (!self)                               // Check if fontData is NULL
+    if (!self || !filename)                      // Check if self or filename is NULL
         return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    self->fontScale = scale; // Set font scale to given scale
+    const fontTable_t *const table = &self->table; // Table of the font
+    if (table->pages == noCharacters)              // Check if a font is loaded
+        return ErrorHandler(ERROR_NO_FONT_DATA);   // Handle error
+
+    if (table->numBlocks > FONT_MAX_BLOCKS || table->numPages > FONT_MAX_BLOCKS + 1 || // Check if the size fits the header
+        table->numStrokes > UINT32_MAX / sizeof(stroke_t))
+        return ErrorHandler(ERROR_FONT_WRITE); // Handle error
+    size_t pageOffset, strokeOffset;           // Offsets of the pages and the strokes
+    const size_t size = _layout(table->numBlocks, table->numPages, table->numStrokes, sizeof(fontHeader_t), &pageOffset,
+                                &strokeOffset); // Size up to the last stroke
+    if (size > UINT32_MAX)                      // Check if the size fits the header
+        return ErrorHandler(ERROR_FONT_WRITE);  // Handle error
+
+    fontHeader_t header;                                           // Header of the file
+    memset(&header, 0, sizeof(header));                            // Clear it, padding included
+    memcpy(header.magic, FONT_BINARY_MAGIC, sizeof(header.magic)); // Set magic
+    header.version = FONT_BINARY_VERSION;                          // Set version
+    header.byteOrder = FONT_BINARY_BYTE_ORDER;                     // Set byte order
+    header.stepsPerUnit = STROKE_STEPS_PER_UNIT;                   // Set stroke format
+    header.pageSize = FONT_PAGE_SIZE;                              // Set page size
+    header.numBlocks = (uint32_t)table->numBlocks;                 // Set directory size
+    header.directoryOffset = (uint32_t)sizeof(fontHeader_t);       // Directory follows the header
+    header.numPages = (uint32_t)table->numPages;                   // Set number of pages
+    header.pageOffset = (uint32_t)pageOffset;                      // Set page offset
+    header.numStrokes = (uint32_t)table->numStrokes;               // Set number of strokes
+    header.strokeOffset = (uint32_t)strokeOffset;                  // Set stroke offset
+    header.size = (uint32_t)size;                                  // Set size up to the last stroke
+
+    FILE *file = fopen(filename, "wb");       // Create file
+    if (!file)                                // Check if file cannot be created
+        return ErrorHandler(ERROR_OPEN_FILE); // Handle error
+
+    static const unsigned char padding[_Alignof(fontCharacter_t)];                                               // Zeros after the directory
+    const size_t numPadding = pageOffset - sizeof(fontHeader_t) - table->numBlocks * sizeof(uint16_t);           // Bytes of padding
+    const size_t numEntries = table->numPages * FONT_PAGE_SIZE;                                                  // Entries of the pages
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;                                                // Write the header
+    written = written && fwrite(table->directory, sizeof(uint16_t), table->numBlocks, file) == table->numBlocks; // Write the directory
+    written = written && fwrite(padding, 1, numPadding, file) == numPadding;                                     // Write the padding
+    written = written && fwrite(table->pages, sizeof(fontCharacter_t), numEntries, file) == numEntries;          // Write the pages
+    written = written && fwrite(table->strokes, sizeof(stroke_t), table->numStrokes, file) == table->numStrokes; // Write the strokes
+    if (fclose(file) != 0 || !written)                                                                           // Check if the file is complete
+        return ErrorHandler(ERROR_FONT_WRITE);                                                                   // Handle error
+    return SUCCESS;                                                                                              // Return success
+}
+
+/**
+ * @details
+ * The file is read into memory in one piece, and a scratch buffer with room for a stroke and a
+ * definition per line is allocated before the text is parsed into it. The image is then built
+ * from the scratch buffer, which is freed. A malformed line is reported with its number.
+ */
+static errorCode_t _parseText(fontData_t *const self, FILE *const file, const char *const filename)
+{
+    size_t length;                               // Bytes of the text
+    char *const text = _readFile(file, &length); // Read the whole file
+    if (!text)                                   // Check if memory allocation failed
+        return ERROR_MEMORY_ALLOCATION_FAILED;   // Return error
+
+    const size_t lines = _countLines(text, text + length);                // Most strokes and definitions the file can hold
+    if (lines > SIZE_MAX / (sizeof(fontDefinition_t) + sizeof(stroke_t))) // Check if the scratch size fits a size_t
+    {
+        free(text);                     // Free the text
+        return ERROR_INVALID_FONT_FILE; // Return error
+    }
 
-    for (int i = 0; i < ASCII_CHARACTERS; i++) // Iterate through hash table
+    fontDefinition_t *const definitions = malloc(lines * (sizeof(fontDefinition_t) + sizeof(stroke_t)) + 1); // Allocate scratch buffer
+    if (!definitions)                                                                                        // Check if memory allocation failed
     {
-        hashNode_t *node = self->table[i]; // Get node at index
-        while (node != NULL)                   // Iterate through chain
+        free(text);                            // Free the text
+        return ERROR_MEMORY_ALLOCATION_FAILED; // Return error
+    }
+    stroke_t *const strokes = (stroke_t *)(definitions + lines); // Stroke arena after the definitions
+
+    size_t numDefinitions = 0;                                                                                 // Definitions read
+    size_t numStrokes = 0;                                                                                     // Strokes read
+    size_t line = 0;                                                                                           // Line of an error
+    errorCode_t error = _read(text, text + length, definitions, &numDefinitions, strokes, &numStrokes, &line); // Parse the text
+    free(text);                                                                                                // Free the text
+    if (error != SUCCESS)                                                                                      // Check if the file is valid
+        fprintf(stderr, "%s, line %lu: ", filename, (unsigned long)line);                                      // Report where
+    else // File is valid
+        error = _index(self, definitions, numDefinitions, strokes, numStrokes); // Build the image
+    free(definitions);                                                          // Free the scratch buffer
+    return error;                                                               // Return result
+}
+
+/**
+ * @details
+ * The buffer doubles until the file fits, so files that cannot be sized, such as pipes, are
+ * read the same way. A newline is added after a last line without one.
+ */
+static char *_readFile(FILE *const file, size_t *const size)
+{
+    size_t capacity = 65536; // Bytes the buffer holds
+    size_t length = 0;       // Bytes read
+    char *text = NULL;       // Buffer
+    for (;;)                 // Read until the end of the file
+    {
+        char *const grown = realloc(text, capacity + 1); // Grow the buffer, with room for a newline
+        if (!grown)                                      // Check if memory allocation failed
         {
-            fontCharacter_t *fontChar = node->character;       // Get font character
-            for (uint8_t j = 0; j < fontChar->numStrokes; j++) // Iterate through strokes
-            {
-                fontChar->strokes[j].vec.x *= scale; // Scale x component
-                fontChar->strokes[j].vec.y *= scale; // Scale y component
-            }
-            node = node->next; // Move to next node
+            free(text);  // Free the buffer
+            return NULL; // Return NULL
+        }
+        text = grown;                                               // Use the larger buffer
+        length += fread(text + length, 1, capacity - length, file); // Fill it
+        if (length < capacity)                                      // Check if the file ended
+            break;                                                  // Stop reading
+        if (capacity > SIZE_MAX / 2 - 1)                            // Check if the buffer can double
+        {
+            free(text);  // Free the buffer
+            return NULL; // Return NULL
         }
+        capacity *= 2; // Double the buffer
     }
 
-    return SUCCESS; // Return success
+    if (length == 0 || text[length - 1] != '\n') // Check if the last line has no newline
+        text[length++] = '\n';                   // Add one
+    *size = length;                              // Bytes in the buffer
+    return text;                                 // Return the buffer
 }
 
 /**
  * @details
- * Returns the modulo of the ASCII value of the character by 128, ensuring an index in [0,127].
+ * Each character starts with a "999 <id> <strokes>" line followed by one "<x> <y> <pen>" line
+ * per stroke. Blank lines may separate characters, and blanks and a carriage return may end any
+ * line; anything else that does not fit is an error on its line, as is a file that ends before
+ * the last character's strokes. The id is the code point of the character; one that is not a
+ * Unicode code point is read but not kept. Components may be whole or decimal numbers and are
+ * rounded to the nearest fixed-point step; a stroke too long for a stroke_t is an error. Every
+ * stroke and every definition takes a line, so neither array fills.
  */
-static inline unsigned int _hash_function(char key)
+static errorCode_t _read(const char *text, const char *const end, fontDefinition_t *const definitions,
+                         size_t *const numDefinitions, stroke_t *const strokes, size_t *const numStrokes,
+                         size_t *const line)
 {
-    return (unsigned int)key % ASCII_CHARACTERS; // Return modulo of key by 128
+    while (text < end) // Read lines until the end of the text
+    {
+        ++*line;               // Count the line
+        if (_endOfLine(&text)) // Check if the line is blank
+            continue;          // Skip it
+
+        long marker, id, count;                                                    // Header fields
+        if (!_integer(&text, &marker) || marker != 999 || !_integer(&text, &id) || // Parse header
+            !_integer(&text, &count) || !_endOfLine(&text))
+            return ERROR_PARSE_CHARACTER;        // Return error
+        if (count < 0 || count > UINT8_MAX)      // Check if the strokes fit a fontCharacter_t
+            return ERROR_INVALID_FONT_CHARACTER; // Return error
+
+        const size_t first = *numStrokes; // Character starts at the end of the arena
+        for (long i = 0; i < count; i++)  // Iterate through strokes
+        {
+            if (text == end)                 // Check if the file ended
+                return ERROR_UNEXPECTED_EOF; // Return error
+            ++*line;                         // Count the line
+
+            int64_t x, y;                                                                                 // Stroke vector in steps
+            long pen;                                                                                     // Pen state
+            if (!_steps(&text, &x) || !_steps(&text, &y) || !_integer(&text, &pen) || !_endOfLine(&text)) // Parse stroke
+                return ERROR_PARSE_STROKE;                                                                // Return error
+            if (x < STROKE_MIN_X_STEPS || x > STROKE_MAX_X_STEPS)                                         // Check if x fits a stroke_t
+                return ERROR_INVALID_FONT_STROKE_VEC;                                                     // Return error
+            if (y < INT16_MIN || y > INT16_MAX)                                                           // Check if y fits a stroke_t
+                return ERROR_INVALID_FONT_STROKE_VEC;                                                     // Return error
+
+            strokes[(*numStrokes)++] = StrokePack((int16_t)x, (int16_t)y, pen != 0); // Append stroke to the arena
+        }
+
+        if (id >= 0 && id <= FONT_MAX_CODE_POINT)                                                                 // Check if the id is a code point
+            definitions[(*numDefinitions)++] = (fontDefinition_t){(uint32_t)id, (uint32_t)first, (uint8_t)count}; // Keep it
+    }
+    return SUCCESS; // Return success
 }
 
 /**
  * @details
- * Opens the specified file, reads font character definitions, constructs
- * fontCharacter_t objects, and inserts them into the hash table.
+ * The blocks with a character are numbered in order from page 1, as page 0 is the empty page,
+ * and the directory spans up to the last of them. The image is laid out as _layout() does and
+ * its pages cleared, padding included, before the definitions are entered field by field in the
+ * order they were read, so a character defined again replaces the earlier definition.
  */
-static errorCode_t _parse(fontData_t *const self, const char *const filename)
+static errorCode_t _index(fontData_t *const self, const fontDefinition_t *const definitions,
+                          const size_t numDefinitions, const stroke_t *const strokes, const size_t numStrokes)
 {
-    if (!self)                               // Check if fontData is NULL
-        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    uint16_t directory[FONT_MAX_BLOCKS];        // Page of each block
+    size_t numBlocks = 0;                       // Entries of the directory
+    for (size_t i = 0; i < numDefinitions; i++) // Iterate through definitions
+    {
+        const size_t block = definitions[i].codePoint >> FONT_PAGE_BITS; // Block of the character
+        if (block >= numBlocks)                                          // Check if it is past the directory
+            numBlocks = block + 1;                                       // Extend the directory
+    }
 
-    if (!filename)                               // Check if filename is NULL
-        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    memset(directory, 0, numBlocks * sizeof(uint16_t));            // No block has a page yet
+    for (size_t i = 0; i < numDefinitions; i++)                    // Iterate through definitions
+        directory[definitions[i].codePoint >> FONT_PAGE_BITS] = 1; // Mark its block
+    size_t numPages = 1;                                           // The empty page
+    for (size_t block = 0; block < numBlocks; block++)             // Iterate through blocks
+        if (directory[block])                                      // Check if it has a character
+            directory[block] = (uint16_t)numPages++;               // Give it the next page
 
-    FILE *file = fopen(filename, "r");        // Open file
-    if (!file)                                // Check if file cannot be opened
-        return ErrorHandler(ERROR_NO_FONT_DATA); // Handle error
+    size_t pageOffset, strokeOffset;                                                             // Offsets in the image
+    const size_t size = _layout(numBlocks, numPages, numStrokes, 0, &pageOffset, &strokeOffset); // Size of the image
+    unsigned char *const image = malloc(size ? size : 1);                                        // Allocate the font image
+    if (!image)                                                                                  // Check if memory allocation failed
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                                   // Return error
+
+    memcpy(image, directory, numBlocks * sizeof(uint16_t));                                       // Copy the directory
+    memset(image + numBlocks * sizeof(uint16_t), 0, strokeOffset - numBlocks * sizeof(uint16_t)); // Clear the pages, padding included
+    memcpy(image + strokeOffset, strokes, numStrokes * sizeof(stroke_t));                         // Copy the strokes
 
-    char line[256];                         // Buffer for reading lines
-    while (fgets(line, sizeof(line), file)) // Read lines from file
+    fontCharacter_t *const pages = (fontCharacter_t *)(image + pageOffset); // Pages, every entry undefined
+    for (size_t i = 0; i < numDefinitions; i++)                             // Iterate through definitions
     {
-        int id, numStrokes;                                   // Variables for ID and number of strokes
-        if (sscanf(line, "999 %d %d", &id, &numStrokes) != 2) // Parse ID and number of strokes
-            break;
+        const uint32_t codePoint = definitions[i].codePoint;                                               // Code point of the character
+        fontCharacter_t *const fontChar = &pages[directory[codePoint >> FONT_PAGE_BITS] * FONT_PAGE_SIZE + // Its entry
+                                                 (codePoint & (FONT_PAGE_SIZE - 1))];
+        fontChar->first = definitions[i].first;           // Set first stroke
+        fontChar->numStrokes = definitions[i].numStrokes; // Set number of strokes
+        fontChar->defined = true;                         // Mark it defined
+    }
+
+    self->image = image;                                            // Keep the image
+    self->imageSize = size;                                         // Remember its size
+    self->table.directory = (const uint16_t *)image;                // Use the directory
+    self->table.numBlocks = numBlocks;                              // Entries of the directory
+    self->table.pages = pages;                                      // Use the pages
+    self->table.numPages = numPages;                                // Number of pages
+    self->table.strokes = (const stroke_t *)(image + strokeOffset); // Use the arena
+    self->table.numStrokes = numStrokes;                            // Number of strokes
+    return SUCCESS;                                                 // Return success
+}
+
+/**
+ * @details
+ * The pages are aligned for a fontCharacter_t, which also aligns the strokes that follow them.
+ */
+static size_t _layout(const size_t numBlocks, const size_t numPages, const size_t numStrokes, const size_t start,
+                      size_t *const pageOffset, size_t *const strokeOffset)
+{
+    const size_t alignment = _Alignof(fontCharacter_t);               // Alignment of the pages
+    const size_t directoryEnd = start + numBlocks * sizeof(uint16_t); // End of the directory
+    *pageOffset = (directoryEnd + alignment - 1) / alignment * alignment; // Pages after the directory
+    *strokeOffset = *pageOffset + numPages * FONT_PAGE_SIZE * sizeof(fontCharacter_t); // Strokes after the pages
+    return *strokeOffset + numStrokes * sizeof(stroke_t); // End of the strokes
+}
+
+/**
+ * @details
+ * The digits are accumulated directly, and an optional sign may come before them. The number of
+ * digits is limited so the value fits a long of 32 bits.
+ */
+static bool _integer(const char **const cursor, long *const value)
+{
+    const char *p = *cursor;        // Position in the text
+    while (*p == ' ' || *p == '\t') // Skip blanks
+        p++;
 
-        fontCharacter_t *fontChar = fontCharConstuctor((char)id, (uint8_t)numStrokes); // Construct font character
-        if (!fontChar)                                                        // Check if font character is NULL
+    const bool negative = *p == '-'; // Sign
+    if (*p == '-' || *p == '+')      // Check if there is a sign
+        p++;                         // Skip it
+
+    const char *const digits = p;                       // First digit
+    unsigned long result = 0;                           // Value of the digits, wrapping if there are too many
+    for (unsigned digit; (digit = (unsigned)(*p - '0')) < 10; p++) // Accumulate digits
+        result = result * 10 + digit;
+    if (p == digits || p - digits > FONT_MAX_DIGITS) // Check if there were digits, and not too many
+        return false;                                // Not an integer
+
+    *value = negative ? -(long)result : (long)result; // Set value
+    *cursor = p;                          // Move past it
+    return true;                          // Integer read
+}
+
+/**
+ * @details
+ * The whole units are read as an integer and the fraction, if any, as a decimal numerator of up
+ * to FONT_MAX_DIGITS digits over a power of ten; later digits are skipped. The fraction is
+ * rounded to the nearest step with halves rounded away from zero, as round() does.
+ */
+static bool _steps(const char **const cursor, int64_t *const steps)
+{
+    const char *p = *cursor;        // Position in the text
+    while (*p == ' ' || *p == '\t') // Skip blanks
+        p++;
+
+    const bool negative = *p == '-'; // Sign
+    if (*p == '-' || *p == '+')      // Check if there is a sign
+        p++;                         // Skip it
+
+    long units = 0;                            // Whole units
+    const bool whole = *p >= '0' && *p <= '9'; // Check if there are whole units
+    if (whole && !_integer(&p, &units))        // Read them
+        return false;                          // Not a number
+
+    int64_t numerator = 0;   // Fraction
+    int64_t denominator = 1; // Power of ten under it
+    if (*p == '.')           // Check if there is a fraction
+    {
+        const char *const digits = ++p;     // First digit of the fraction
+        for (; *p >= '0' && *p <= '9'; p++) // Iterate through its digits
         {
-            fclose(file);                                        // Close file
-            return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+            if (p - digits < FONT_MAX_DIGITS) // Check if the digit counts
+            {
+                numerator = numerator * 10 + (*p - '0'); // Add it
+                denominator *= 10;                       // Shift the fraction
+            }
         }
+        if (!whole && p == digits) // Check if there was any digit at all
+            return false;          // Not a number
+    }
+    else if (!whole)  // Check if there were no digits at all
+        return false; // Not a number
 
-        for (int i = 0; i < numStrokes; i++) // Iterate through strokes
-        {
-            if (!fgets(line, sizeof(line), file)) // Read line
-                break;                            // Break if line cannot be read
+    const int64_t fraction = (2 * numerator * STROKE_STEPS_PER_UNIT + denominator) / (2 * denominator); // Fraction in steps
+    const int64_t magnitude = (int64_t)units * STROKE_STEPS_PER_UNIT + fraction;                        // Number in steps
+    *steps = negative ? -magnitude : magnitude;                                                         // Set steps
+    *cursor = p;                                                                                        // Move past it
+    return true;                                                                                        // Number read
+}
 
-            stroke_t stroke;                                                                             // Stroke structure
-            if (sscanf(line, "%lf %lf %i", &stroke.vec.x, &stroke.vec.y, (int *)&stroke.pen_state) == 3) // Parse stroke
-                fontChar->appendStroke(fontChar, stroke);                                                // Append stroke to font character
-        }
-        self->insert(self, fontChar); // Insert font character into hash table
+/**
+ * @details
+ * Blanks are spaces, tabs and the carriage return of a file with Windows line endings.
+ */
+static bool _endOfLine(const char **const cursor)
+{
+    const char *p = *cursor;                      // Position in the text
+    while (*p == ' ' || *p == '\t' || *p == '\r') // Skip blanks
+        p++;
+    if (*p != '\n')                               // Check if the line ends here
+        return false;                             // Something else on the line
+
+    *cursor = p + 1; // Move to the next line
+    return true;     // Line ended
+}
+
+/**
+ * @details
+ * The newlines are found with memchr(), which scans many bytes at a time.
+ */
+static size_t _countLines(const char *text, const char *const end)
+{
+    size_t lines = 0;                                                 // Lines counted
+    while ((text = memchr(text, '\n', (size_t)(end - text))) != NULL) // Find the next newline
+    {
+        lines++; // Count it
+        text++;  // Move past it
+    }
+    return lines; // Return lines
+}
+
+/**
+ * @details
+ * The mapping is shared and read-only, so every process that maps the same file uses the same
+ * pages of the page cache, and the file descriptor is closed as soon as the mapping exists.
+ */
+static errorCode_t _map(fontData_t *const self, const char *const filename)
+{
+#ifdef FONT_MMAP
+    const int fd = open(filename, O_RDONLY); // Open file
+    if (fd < 0)                              // Check if file cannot be opened
+        return ERROR_NO_FONT_DATA;           // Return error
+
+    struct stat status;                                                          // Size of the file
+    if (fstat(fd, &status) != 0 || status.st_size < (off_t)sizeof(fontHeader_t)) // Check if it holds a header
+    {
+        close(fd);                      // Close file
+        return ERROR_INVALID_FONT_FILE; // Return error
     }
 
-    fclose(file);   // Close file
+    void *image = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0); // Map the file
+    close(fd);                                                                      // The mapping stays without it
+    if (image == MAP_FAILED)                                                        // Check if mapping failed
+        return ERROR_NO_FONT_DATA;                                                  // Return error
+
+    self->image = image;                      // Keep the image
+    self->imageSize = (size_t)status.st_size; // Remember its size
+    self->mapped = true;                      // Unmap it when done
+#else
+    FILE *file = fopen(filename, "rb"); // Open file
+    if (!file)                          // Check if file cannot be opened
+        return ERROR_NO_FONT_DATA;      // Return error
+
+    long size = -1;                                                         // Size of the file
+    if (fseek(file, 0, SEEK_END) == 0)                                      // Go to its end
+        size = ftell(file);                                                 // Read the size
+    if (size < (long)sizeof(fontHeader_t) || fseek(file, 0, SEEK_SET) != 0) // Check if it holds a header
+    {
+        fclose(file);                   // Close file
+        return ERROR_INVALID_FONT_FILE; // Return error
+    }
+
+    self->image = malloc((size_t)size); // Allocate the image
+    if (!self->image)                   // Check if memory allocation failed
+    {
+        fclose(file);                          // Close file
+        return ERROR_MEMORY_ALLOCATION_FAILED; // Return error
+    }
+    self->imageSize = (size_t)size;                                              // Remember its size
+    const bool read = fread(self->image, 1, (size_t)size, file) == (size_t)size; // Read the file
+    fclose(file);                                                                // Close file
+    if (!read)                                                                   // Check if it was read
+        return ERROR_INVALID_FONT_FILE;                                          // Return error
+#endif
+    return _check(self); // Check the image
+}
+
+/**
+ * @details
+ * The header must match this build: magic, version, byte order, page size and stroke format.
+ * The directory, the pages and the strokes must lie inside the image and be aligned for their
+ * types, and the table must pass _validate(). The entries of the pages are checked as bytes
+ * first, so a damaged `defined` flag is found before it is read as a bool. The strokes need no
+ * check, as any value is a valid stroke.
+ */
+static errorCode_t _check(fontData_t *const self)
+{
+    const unsigned char *const image = self->image;                             // Bytes of the image
+    const fontHeader_t *const header = self->image;                             // Header of the image
+    if (memcmp(header->magic, FONT_BINARY_MAGIC, sizeof(header->magic)) != 0 || // Check the header
+        header->version != FONT_BINARY_VERSION || header->byteOrder != FONT_BINARY_BYTE_ORDER ||
+        header->stepsPerUnit != STROKE_STEPS_PER_UNIT || header->pageSize != FONT_PAGE_SIZE ||
+        header->numBlocks > FONT_MAX_BLOCKS || header->size > self->imageSize)
+        return ERROR_INVALID_FONT_FILE; // Return error
+
+    if (!_fits(header->directoryOffset, header->numBlocks, sizeof(uint16_t), _Alignof(uint16_t), header->size) || // Check if the arrays lie in the image
+        !_fits(header->pageOffset, header->numPages, FONT_PAGE_SIZE * sizeof(fontCharacter_t), _Alignof(fontCharacter_t),
+               header->size) ||
+        !_fits(header->strokeOffset, header->numStrokes, sizeof(stroke_t), _Alignof(stroke_t), header->size))
+        return ERROR_INVALID_FONT_FILE; // Return error
+
+    const size_t numEntries = (size_t)header->numPages * FONT_PAGE_SIZE;                                      // Entries of the pages
+    for (size_t i = 0; i < numEntries; i++)                                                                   // Iterate through entries
+        if (image[header->pageOffset + i * sizeof(fontCharacter_t) + offsetof(fontCharacter_t, defined)] > 1) // Check the defined flag
+            return ERROR_INVALID_FONT_FILE;                                                                   // Return error
+
+    const fontTable_t table = {(const uint16_t *)&image[header->directoryOffset], header->numBlocks, // Table in place
+                               (const fontCharacter_t *)&image[header->pageOffset], header->numPages,
+                               (const stroke_t *)&image[header->strokeOffset], header->numStrokes};
+    if (_validate(&table) != SUCCESS)   // Check if it is consistent
+        return ERROR_INVALID_FONT_FILE; // Return error
+
+    self->table = table; // Use the table in place
+    return SUCCESS;      // Return success
+}
+
+static bool _fits(const size_t offset, const size_t count, const size_t elementSize, const size_t alignment,
+                  const size_t size)
+{
+    return offset >= sizeof(fontHeader_t) && offset <= size && count <= (size - offset) / elementSize && // Check if it lies in the image
+           offset % alignment == 0;                                                                      // Check if it is aligned
+}
+
+/**
+ * @details
+ * Every entry of every page is visited, which for the fonts the robot draws is a few thousand.
+ */
+static errorCode_t _validate(const fontTable_t *const table)
+{
+    if (table->numPages == 0)           // Check if there is the empty page
+        return ERROR_INVALID_FONT_FILE; // Return error
+
+    for (size_t block = 0; block < table->numBlocks; block++) // Iterate through directory
+        if (table->directory[block] >= table->numPages)       // Check if its page exists
+            return ERROR_INVALID_FONT_FILE;                   // Return error
+
+    for (size_t i = 0; i < table->numPages * FONT_PAGE_SIZE; i++) // Iterate through entries
+    {
+        const fontCharacter_t *const fontChar = &table->pages[i];                                        // The entry
+        if (fontChar->defined && (i < FONT_PAGE_SIZE ||                                                  // Check if it is on the empty page
+                                  (uint64_t)fontChar->first + fontChar->numStrokes > table->numStrokes)) // or past the arena
+            return ERROR_INVALID_FONT_FILE;                                                              // Return error
+    }
     return SUCCESS; // Return success
 }
 
 /**
  * @details
- * Iterates over the hash table, frees all font characters and hash nodes, and then frees
- * the fontData_t structure itself.
+ * Every entry after the empty page is visited once. The entries of the empty page, and those of
+ * the code points a page does not define, are left cleared. Every loaded font is measured, so the
+ * start of its first block is kept here too.
  */
-static errorCode_t _free(fontData_t *self)
+static errorCode_t _measureTable(fontData_t *const self)
 {
-    if (!self)                                   // Check if self is NULL
-        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    const size_t numEntries = self->table.numPages * FONT_PAGE_SIZE;          // Entries of the pages
+    fontMetrics_t *const metrics = calloc(numEntries, sizeof(fontMetrics_t)); // Allocate cleared metrics
+    if (!metrics)                                                             // Check if memory allocation failed
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                // Return error
 
-    for (int i = 0; i < ASCII_CHARACTERS; i++) // Iterate through hash table
+    for (size_t i = FONT_PAGE_SIZE; i < numEntries; i++) // Iterate through entries after the empty page
     {
-        hashNode_t *node = self->table[i]; // Get node at index
-        while (node != NULL)               // Iterate through chain
-        {
-            hashNode_t *next_node = node->next;         // Get next node
-            if (node->character)                        // Check if character is not NULL
-                node->character->free(node->character); // Free character
+        const fontCharacter_t *const fontChar = &self->table.pages[i];                                   // The entry
+        if (fontChar->defined)                                                                           // Check if it is a character
+            _measureCharacter(&self->table.strokes[fontChar->first], fontChar->numStrokes, &metrics[i]); // Measure it
+    }
+    self->metrics = metrics;                       // Use the metrics
+    self->firstBlock = FontIndex(&self->table, 0); // Start of the first block
+    return SUCCESS;                                // Return success
+}
 
-            free(node);       // Free node
-            node = next_node; // Move to next node
+/**
+ * @details
+ * The pen is followed from the origin. A pen-down stroke adds both of its ends to the ink box, so
+ * a dot drawn in place has ink too. A character whose last stroke is not a pen-up move has no
+ * advance of its own and is given the right of its ink, or 0 if it draws nothing.
+ */
+static void _measureCharacter(const stroke_t *const strokes, const uint8_t numStrokes, fontMetrics_t *const metrics)
+{
+    Vect2d_t pen = {0.0, 0.0};               // Pen starts at the origin
+    for (uint8_t i = 0; i < numStrokes; i++) // Iterate through strokes
+    {
+        const Vect2d_t point = StrokeVector(strokes[i], 1.0);                // Point the stroke goes to, in font units
+        const float length = (float)hypot(point.x - pen.x, point.y - pen.y); // Length of the stroke
+        if (StrokePenDown(strokes[i]))                                       // Check if it draws
+        {
+            metrics->penDown += length; // Count it as drawn
+            _ink(metrics, pen);         // Ink from where it starts
+            _ink(metrics, point);       // to where it ends
         }
-        self->table[i] = NULL; // Set node at index to NULL
+        else                          // Pen-up move
+            metrics->penUp += length; // Count it as moved
+        pen = point;                  // Pen is now at the point
+    }
+
+    if (numStrokes > 0 && !StrokePenDown(strokes[numStrokes - 1])) // Check if it closes with a pen-up move
+        metrics->advance = (float)pen.x;                           // Next character starts there
+    else                                                           // No advance of its own
+        metrics->advance = metrics->inked ? metrics->right : 0.0f; // Next character starts after the ink
+}
+
+static void _ink(fontMetrics_t *const metrics, const Vect2d_t point)
+{
+    const float x = (float)point.x; // X of the point
+    const float y = (float)point.y; // Y of the point
+    if (!metrics->inked)            // Check if it is the first ink
+    {
+        metrics->left = metrics->right = x; // Box holds the point alone
+        metrics->bottom = metrics->top = y; // Box holds the point alone
+        metrics->inked = true;              // Character draws
+        return;                             // Done
     }
+    metrics->left = fminf(metrics->left, x);     // Grow left
+    metrics->right = fmaxf(metrics->right, x);   // Grow right
+    metrics->bottom = fminf(metrics->bottom, y); // Grow down
+    metrics->top = fmaxf(metrics->top, y);       // Grow up
+}
+
+/**
+ * @details
+ * Unmaps or frees the font image, frees the metrics and points the table at the empty page alone,
+ * leaving the structure as the constructor made it.
+ */
+static void _clear(fontData_t *const self)
+{
+#ifdef FONT_MMAP
+    if (self->mapped)                         // Check if the image is a mapping
+        munmap(self->image, self->imageSize); // Unmap it
+    else
+#endif
+        free(self->image);                                          // Free font image
+    if (self->metrics != noMetrics)                                 // Check if the font was measured
+        free((void *)self->metrics);                                // Free metrics
+    self->metrics = noMetrics;                                      // Metrics of the empty page alone
+    self->image = NULL;                                             // Forget it
+    self->imageSize = 0;                                            // No image
+    self->mapped = false;                                           // Nothing mapped
+    self->table = (fontTable_t){NULL, 0, noCharacters, 1, NULL, 0}; // Empty page alone
+    self->firstBlock = 0;                                           // First block on the empty page
+}
+
+/**
+ * @details
+ * Releases the font image, which holds the page table and the strokes of every character, and then
+ * frees the fontData_t structure itself.
+ */
+static errorCode_t _free(fontData_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    free(self); // Free fontData_t
+    _clear(self); // Release font image
+    free(self);   // Free fontData_t
 
     return SUCCESS; // Return success
 }
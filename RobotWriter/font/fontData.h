@@ -1,84 +1,177 @@
 /**
  * @file fontData.h
- * @brief Declarations for managing font data, including a hash table for storing font characters.
+ * @brief Declarations for managing font data, a page table of font characters over one stroke arena.
  * @details
- * This header defines the fontData_t structure and related components for storing and managing
- * font characters in a hash table. Each entry in the hash table corresponds to an ASCII character
- * and its associated fontCharacter_t object. The fontData_t structure provides function pointers
- * for operations such as inserting, looking up, scaling, parsing from a file, and freeing the entire
- * font data structure.
+ * This header defines the fontData_t structure for storing and managing font characters. The
+ * strokes of every character are kept back to back in a single stroke arena, and a two-level
+ * page table keyed by Unicode code point records where each character's strokes start and how
+ * many there are. The directory maps each block of FONT_PAGE_SIZE code points to a page of
+ * characters; blocks without characters share the empty page 0, so looking a character up is two
+ * indexes and no search, however many characters the font has, and a font only takes pages for
+ * the blocks it uses. The strokes are unscaled and the font is not changed after it is loaded; a
+ * glyphCache_t scales the characters to the sizes they are drawn at. The fontData_t structure
+ * provides function pointers for operations such as looking up, parsing from a file, saving as a
+ * binary font, and freeing the entire font data structure.
+ *
+ * A binary font file is a header followed by the directory, the pages and the strokes. A text
+ * font is parsed into an allocated image of the directory, the pages and the strokes; a binary
+ * font is mapped into memory and used as it is, without parsing or allocating, so processes that
+ * load the same binary font share its pages. A table and strokes compiled into the program, such
+ * as those of the embedded font, are attached and used in place the same way.
+ *
+ * However a font is loaded, its characters are measured once as it is: the advance, the box
+ * their ink fills and the length drawn and moved of each are kept in a metrics table laid out
+ * like the pages, so the width of a character is one index away when text is laid out.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "../misc/error.h"
 #include "fontChar.h"
 
-#define ASCII_CHARACTERS 128
+#define FONT_PAGE_BITS 8                                              /**< Bits of a code point that index a page. */
+#define FONT_PAGE_SIZE (1u << FONT_PAGE_BITS)                         /**< Characters in a page. */
+#define FONT_MAX_CODE_POINT 0x10FFFF                                  /**< Largest Unicode code point. */
+#define FONT_MAX_BLOCKS ((FONT_MAX_CODE_POINT >> FONT_PAGE_BITS) + 1) /**< Blocks of FONT_PAGE_SIZE code points in Unicode. */
+
+#define FONT_BINARY_MAGIC "RWFB"      /**< First four bytes of a binary font file. */
+#define FONT_BINARY_VERSION 2         /**< Version of the binary font format written. */
+#define FONT_BINARY_BYTE_ORDER 0x0102 /**< Written in the byte order of the machine, to detect another one. */
 
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DECLARATIONS                      //
 ///////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief Header of a binary font file.
+ * @details The directory follows at `directoryOffset`, the pages at `pageOffset` and the strokes
+ *          at `strokeOffset`; all numbers are in the byte order of the machine that wrote the file.
+ */
+typedef struct fontHeader_s
+{
+    char magic[4];            /**< FONT_BINARY_MAGIC, without a terminator. */
+    uint16_t version;         /**< FONT_BINARY_VERSION. */
+    uint16_t byteOrder;       /**< FONT_BINARY_BYTE_ORDER. */
+    uint32_t stepsPerUnit;    /**< Fixed-point steps per font unit of the strokes, STROKE_STEPS_PER_UNIT. */
+    uint32_t pageSize;        /**< Characters in a page, FONT_PAGE_SIZE. */
+    uint32_t numBlocks;       /**< Entries of the directory. */
+    uint32_t directoryOffset; /**< Offset of the directory from the start of the file. */
+    uint32_t numPages;        /**< Number of pages, the empty page 0 included. */
+    uint32_t pageOffset;      /**< Offset of the pages from the start of the file. */
+    uint32_t numStrokes;      /**< Number of strokes. */
+    uint32_t strokeOffset;    /**< Offset of the strokes from the start of the file. */
+    uint32_t size;            /**< Size of the file in bytes. */
+} fontHeader_t;
 
 /**
- * @brief Opaque structure representing a hash node for storing font characters.
+ * @brief The characters of a font: a page table keyed by code point over a stroke arena.
+ * @details The character of code point `c` is entry `c % FONT_PAGE_SIZE` of page
+ *          `directory[c / FONT_PAGE_SIZE]`, or of page 0 for code points past the directory.
+ *          Page 0 defines no character.
  */
-typedef struct hashNode_s hashNode_t;
+typedef struct fontTable_s
+{
+    const uint16_t *directory;    /**< Page of each block of FONT_PAGE_SIZE code points, 0 if it has none. */
+    size_t numBlocks;             /**< Entries of the directory. */
+    const fontCharacter_t *pages; /**< Pages of FONT_PAGE_SIZE characters, one after the other. */
+    size_t numPages;              /**< Number of pages, the empty page 0 included. */
+    const stroke_t *strokes;      /**< Stroke arena holding the strokes of every character. */
+    size_t numStrokes;            /**< Number of strokes in the arena. */
+} fontTable_t;
 
 /**
- * @brief Structure representing font data, including a hash table.
+ * @brief Metrics of a character in font units, measured when its font is loaded.
+ * @details The pen starts a character at its origin and goes to the point of each stroke in turn.
+ *          The ink box holds both ends of every pen-down stroke, and is only meaningful if
+ *          `inked` is set.
+ */
+typedef struct fontMetrics_s
+{
+    float advance; /**< Where the next character starts: x of the closing pen-up stroke, or the right of the ink without one. */
+    float left;    /**< Left of the ink. */
+    float right;   /**< Right of the ink. */
+    float bottom;  /**< Bottom of the ink. */
+    float top;     /**< Top of the ink. */
+    float penDown; /**< Length drawn with the pen down. */
+    float penUp;   /**< Length moved with the pen up, the closing advance included. */
+    bool inked;    /**< true if the character draws anything. */
+} fontMetrics_t;
+
+/**
+ * @brief Structure representing font data, a character page table over a stroke arena.
  * @details
  * The fontData_t structure stores:
- * - A hash table of font characters indexed by ASCII code.
- * - A font scaling factor used to scale all character strokes.
- * - Function pointers for managing the font data, including insertion, lookup, scaling, parsing,
- *   and freeing resources.
+ * - The page table of the font characters and the stroke arena holding their strokes.
+ * - The font image both are part of, allocated in one piece or mapped from a binary font file,
+ *   or none if they are attached.
+ * - The metrics of every character, indexed like the pages.
+ * - Function pointers for managing the font data, including lookup, parsing, and freeing
+ *   resources.
  */
 typedef struct fontData_s
 {
-    double fontScale;                    /**< Scaling factor for the font. */
-    hashNode_t *table[ASCII_CHARACTERS]; /**< Hash table for storing font characters, indexed by ASCII value. */
+    fontTable_t table;            /**< Characters and strokes of the font. */
+    void *image;                  /**< Allocated or mapped memory holding the table and strokes, NULL if none. */
+    size_t imageSize;             /**< Bytes allocated or mapped for the image. */
+    bool mapped;                  /**< true if the image is a mapping of a binary font file. */
+    const fontMetrics_t *metrics; /**< Metrics of the characters, indexed like `table.pages`. */
+    size_t firstBlock;            /**< Index in `table.pages` of code point 0, where the first block starts. */
 
     /**
-     * @brief Frees all memory associated with the font data, including the hash table and its characters.
+     * @brief Frees all memory associated with the font data, including the stroke arena.
      * @param[in,out] self Pointer to the fontData_t instance.
      * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
      */
     errorCode_t (*free)(struct fontData_s *self);
 
     /**
-     * @brief Looks up a font character in the hash table by ASCII key.
+     * @brief Looks up a font character by code point.
      * @param[in] self Pointer to the fontData_t instance.
-     * @param[in] ascii_key The ASCII key of the character to look up.
+     * @param[in] codePoint The Unicode code point of the character to look up.
      * @return Pointer to the corresponding fontCharacter_t, or NULL if not found.
      */
-    const fontCharacter_t *(*lookup)(const struct fontData_s *const self, const char ascii_key);
+    const fontCharacter_t *(*lookup)(const struct fontData_s *const self, const uint32_t codePoint);
 
     /**
-     * @brief Scales all the font characters by the given factor.
-     * @param[in,out] self Pointer to the fontData_t instance.
-     * @param[in] scale The factor by which to scale the font.
-     * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
+     * @brief Gives the metrics of a character by code point.
+     * @param[in] self Pointer to the fontData_t instance.
+     * @param[in] codePoint The Unicode code point of the character.
+     * @return Pointer to the metrics of the character, or NULL if the font does not define it.
      */
-    errorCode_t (*scale)(struct fontData_s *const self, double scale);
+    const fontMetrics_t *(*measure)(const struct fontData_s *const self, const uint32_t codePoint);
 
     /**
-     * @brief Inserts a font character into the hash table.
+     * @brief Loads a text or binary font file, replacing any font loaded before.
+     * @details A file starting with FONT_BINARY_MAGIC is mapped as a binary font; any other is
+     *          parsed as a text font.
      * @param[in,out] self Pointer to the fontData_t instance.
-     * @param[in] character Pointer to the font character to insert.
-     * @return SUCCESS on success, or an appropriate error code on failure.
+     * @param[in] filename The name of the font file to load.
+     * @return SUCCESS on success, or an appropriate error code if loading fails.
      */
-    errorCode_t (*insert)(struct fontData_s *const self, fontCharacter_t *const character);
+    errorCode_t (*parse)(struct fontData_s *const self, const char *filename);
 
     /**
-     * @brief Parses a font file and populates the hash table with font characters.
+     * @brief Uses a table held in memory, such as that of the embedded font, in place.
      * @param[in,out] self Pointer to the fontData_t instance.
-     * @param[in] filename The name of the font file to parse.
-     * @return SUCCESS on success, or an appropriate error code if parsing fails.
+     * @param[in] table The table; its arrays must outlive the font data.
+     * @return SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_FONT_FILE if the table is not
+     *         consistent, or ERROR_MEMORY_ALLOCATION_FAILED if it cannot be measured.
      */
-    errorCode_t (*parse)(struct fontData_s *const self, const char *filename);
+    errorCode_t (*attach)(struct fontData_s *const self, const fontTable_t *const table);
+
+    /**
+     * @brief Writes the font as a binary font file.
+     * @param[in] self Pointer to the fontData_t instance.
+     * @param[in] filename The name of the binary font file to create.
+     * @return SUCCESS, ERROR_NO_FONT_DATA if no font is loaded, ERROR_OPEN_FILE if the file
+     *         cannot be created, or ERROR_FONT_WRITE if it cannot be written.
+     */
+    errorCode_t (*save)(const struct fontData_s *const self, const char *filename);
 } fontData_t;
 
 /**
@@ -86,3 +179,37 @@ typedef struct fontData_s
  * @return A pointer to the newly created fontData_t object, or NULL if allocation fails.
  */
 fontData_t *fontDataConstructor(void);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Gives the index of a code point's character in the pages of a table.
+ * @details Code points the font has no page for land on the empty page 0, so the entry at the
+ *          index always exists and is undefined for them.
+ * @param[in] table The table.
+ * @param[in] codePoint The code point, any value.
+ * @return Index into `table->pages`.
+ */
+static inline size_t FontIndex(const fontTable_t *const table, const uint32_t codePoint)
+{
+    const uint32_t block = codePoint >> FONT_PAGE_BITS;
+    const size_t page = block < table->numBlocks ? table->directory[block] : 0;
+    return page * FONT_PAGE_SIZE + (codePoint & (FONT_PAGE_SIZE - 1));
+}
+
+/**
+ * @brief Gives the index of a code point's character in the pages of a font.
+ * @details The first block, which holds ASCII, starts at an index kept with the font, so most
+ *          text is indexed without reading the directory. Other code points go through FontIndex().
+ * @param[in] fontData The font.
+ * @param[in] codePoint The code point, any value.
+ * @return Index into `fontData->table.pages`.
+ */
+static inline size_t FontDataIndex(const fontData_t *const fontData, const uint32_t codePoint)
+{
+    if (codePoint < FONT_PAGE_SIZE)
+        return fontData->firstBlock + codePoint;
+    return FontIndex(&fontData->table, codePoint);
+}
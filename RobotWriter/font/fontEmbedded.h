@@ -0,0 +1,21 @@
+/**
+ * @file fontEmbedded.h
+ * @brief Declarations of the font compiled into RobotWriter.
+ * @details
+ * The build compiles SingleStrokeFont.txt with FontCompiler into a C source file defining the
+ * directory, the pages and the strokes of its table as arrays, statically initialised and const,
+ * so they sit in the read-only data of the program. fontData_t::attach() uses the table in place,
+ * which loads the font without reading a file, parsing or allocating.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include "fontData.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+extern const fontTable_t fontEmbedded;  /**< Characters and strokes of the embedded font. */
+extern const char fontEmbeddedSource[]; /**< Name of the text font it was compiled from. */
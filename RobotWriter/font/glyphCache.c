@@ -0,0 +1,279 @@
+/**
+ * @file glyphCache.c
+ * @brief Implementation of the glyph cache.
+ * @details
+ * Each size has an entry for every page of the font, and a page gets its table of characters the
+ * first time one of them is looked up. Looking a character up scales its strokes onto the end of
+ * the stroke arena of the size if they are not there yet, so a size holds what has been drawn at
+ * it and no more. Consecutive lookups at the same size, which is what a job makes, only compare
+ * the scale with that of the size used last.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "glyphCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Looks up a character at a size, scaling it if it has not been drawn at that size.
+ * @param[in,out] self Pointer to the glyphCache_t structure.
+ * @param[in] codePoint Code point of the character.
+ * @param[in] scale Scale factor of the size.
+ * @return The scaled character, or NULL if the font does not define it or `self` is NULL.
+ */
+static const glyph_t *_lookup(glyphCache_t *const self, const uint32_t codePoint, const double scale);
+
+/**
+ * @brief Makes a size the current one, adding it to the cache if it is not held.
+ * @param[in,out] self Pointer to the glyphCache_t structure.
+ * @param[in] scale Scale factor of the size.
+ * @return The size, or NULL if its page entries cannot be allocated.
+ */
+static glyphSize_t *_size(glyphCache_t *const self, const double scale);
+
+/**
+ * @brief Allocates the table of a page of a size, with no character scaled.
+ * @param[in,out] self Pointer to the glyphCache_t structure.
+ * @param[in,out] size The size.
+ * @param[in] page The page of the font.
+ * @return The table, or NULL if it cannot be allocated.
+ */
+static glyph_t *_page(glyphCache_t *const self, glyphSize_t *const size, const size_t page);
+
+/**
+ * @brief Scales the strokes of a character onto the end of the stroke arena of a size.
+ * @param[in,out] self Pointer to the glyphCache_t structure.
+ * @param[in,out] size The size.
+ * @param[in] fontChar The character in the font.
+ * @param[out] glyph The table entry of the character at the size.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED if a new chunk cannot be allocated.
+ */
+static errorCode_t _build(glyphCache_t *const self, glyphSize_t *const size, const fontCharacter_t *const fontChar,
+                          glyph_t *const glyph);
+
+/**
+ * @brief Frees the page tables and stroke arenas of every size and the cache itself.
+ * @param[in,out] self Pointer to the glyphCache_t structure.
+ * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+ */
+static errorCode_t _free(glyphCache_t *self);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * No size is allocated until a character is looked up.
+ */
+glyphCache_t *glyphCacheConstructor(const fontData_t *const fontData)
+{
+    if (!fontData) // Check if fontData is NULL
+    {
+        ErrorHandler(ERROR_NO_FONT_DATA); // Handle error
+        return NULL;                      // Return NULL
+    }
+
+    glyphCache_t *cache = calloc(1, sizeof(glyphCache_t)); // Allocate cleared memory for glyphCache_t
+    if (!cache)                                            // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    cache->fontData = fontData; // Set font
+    cache->lookup = _lookup;    // Function pointer to look up a character
+    cache->free = _free;        // Function pointer to free the cache
+    return cache;               // Return glyphCache_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * A character that has been scaled at the size is returned straight from the table of its page;
+ * the font is only asked for characters that have not been, including those it does not define.
+ * The first block, where ASCII text is, is indexed by code point without going through the font.
+ */
+static const glyph_t *_lookup(glyphCache_t *const self, const uint32_t codePoint, const double scale)
+{
+    if (!self)       // Check if self is NULL
+        return NULL; // Return NULL
+
+    glyphSize_t *size = &self->sizes[self->current]; // Size used last
+    if (self->numSizes == 0 || size->scale != scale) // Check if another size is wanted
+        size = _size(self, scale);                   // Switch to it
+    if (!size)                                       // Check if the size could not be added
+        return NULL;                                 // Return NULL
+
+    glyph_t *glyph;                                     // Character at the size
+    if (codePoint < FONT_PAGE_SIZE && size->firstBlock) // Check if it is in the first block, which has a table
+        glyph = &size->firstBlock[codePoint];           // Index it directly
+    else                                                // Any other character
+    {
+        const size_t index = FontDataIndex(self->fontData, codePoint);      // Entry of the code point
+        glyph_t *table = size->pages[index / FONT_PAGE_SIZE];               // Table of its page
+        if (!table && !(table = _page(self, size, index / FONT_PAGE_SIZE))) // Check if the table could be added
+            return NULL;                                                    // Return NULL
+        glyph = &table[index % FONT_PAGE_SIZE];                             // Character at the size
+    }
+    if (glyph->built) // Check if it is scaled already
+        return glyph; // Return character
+
+    const fontCharacter_t *const fontChar = self->fontData->lookup(self->fontData, codePoint); // Character in the font
+    if (!fontChar || _build(self, size, fontChar, glyph) != SUCCESS)                           // Check if it is defined and scaled
+        return NULL;                                                                           // Return NULL
+    return glyph;                                                                              // Return character
+}
+
+/**
+ * @details
+ * A size that is held becomes the current one. A new size takes a free slot with a new entry for
+ * each page, or, once every slot is taken, the slot of the least recently used size. Its page
+ * tables and chunks are kept for the new size: only the pages it had touched are cleared, and the
+ * chunks are filled again from the first.
+ */
+static glyphSize_t *_size(glyphCache_t *const self, const double scale)
+{
+    self->clock++; // Count the change of size
+
+    for (int i = 0; i < self->numSizes; i++) // Sizes held
+    {
+        if (self->sizes[i].scale == scale) // Check if it is the size wanted
+        {
+            self->current = i;                     // Make it current
+            self->sizes[i].lastUsed = self->clock; // Mark its use
+            return &self->sizes[i];                // Return size
+        }
+    }
+
+    const size_t numPages = self->fontData->table.numPages; // Pages of the font
+    int slot = self->numSizes;                              // Slot for the new size
+    if (slot < GLYPH_CACHE_SIZES)                           // Check if a slot is free
+    {
+        glyphSize_t *const size = &self->sizes[slot];                       // The free slot
+        size->pages = calloc(numPages, sizeof(glyph_t *) + sizeof(size_t)); // Allocate page entries and touched list
+        if (!size->pages)                                                   // Check if memory allocation failed
+        {
+            ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+            return NULL;                                  // Return NULL
+        }
+        size->touched = (size_t *)(size->pages + numPages);             // Touched list after the entries
+        size->numTouched = 0;                                           // No page touched yet
+        size->chunks = NULL;                                            // No strokes yet
+        size->firstBlock = NULL;                                        // No table for the first block yet
+        self->bytes += numPages * (sizeof(glyph_t *) + sizeof(size_t)); // Count the entries
+        self->numSizes++;                                               // Count the slot
+    }
+    else // Every slot is taken
+    {
+        slot = 0;                                                     // Least recently used slot
+        for (int i = 1; i < GLYPH_CACHE_SIZES; i++)                   // Every other slot
+            if (self->sizes[i].lastUsed < self->sizes[slot].lastUsed) // Check if it was used longer ago
+                slot = i;                                             // Remember it
+        glyphSize_t *const size = &self->sizes[slot];                                   // The slot
+        for (size_t i = 0; i < size->numTouched; i++)                                   // Pages it touched
+            memset(size->pages[size->touched[i]], 0, FONT_PAGE_SIZE * sizeof(glyph_t)); // Nothing scaled
+    }
+
+    glyphSize_t *const size = &self->sizes[slot]; // The new size
+    size->scale = scale;                          // Set scale
+    size->lastUsed = self->clock;                 // Mark its use
+    size->chunk = NULL;                           // Fill the chunks from the first
+    self->current = slot;                         // Make it current
+    return size;                                  // Return size
+}
+
+/**
+ * @details
+ * The table stays with the slot of the size until the cache is freed, and is listed as touched
+ * so that reusing the slot only clears the tables in use.
+ */
+static glyph_t *_page(glyphCache_t *const self, glyphSize_t *const size, const size_t page)
+{
+    glyph_t *const table = calloc(FONT_PAGE_SIZE, sizeof(glyph_t)); // Allocate cleared table
+    if (!table)                                                      // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+    size->pages[page] = table;                               // Use it for the page
+    if (page == self->fontData->firstBlock / FONT_PAGE_SIZE) // Check if it is the page of the first block
+        size->firstBlock = table;                            // Use it for the first block
+    size->touched[size->numTouched++] = page;                // List it
+    self->bytes += FONT_PAGE_SIZE * sizeof(glyph_t);         // Count it
+    return table;                                            // Return table
+}
+
+/**
+ * @details
+ * The vectors are those StrokeVector() gives, so a character drawn from the cache lands exactly
+ * where it would if each stroke were scaled as it is drawn.
+ */
+static errorCode_t _build(glyphCache_t *const self, glyphSize_t *const size, const fontCharacter_t *const fontChar,
+                          glyph_t *const glyph)
+{
+    if (!size->chunk || size->chunk->used + fontChar->numStrokes > GLYPH_CHUNK_STROKES) // Check if the chunk is full
+    {
+        glyphChunk_t *next = size->chunk ? size->chunk->next : size->chunks; // Chunk after it, if kept
+        if (!next)                                                           // Check if there is none
+        {
+            next = malloc(sizeof(glyphChunk_t));                     // Allocate a chunk
+            if (!next)                                               // Check if memory allocation failed
+                return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+            next->next = NULL;                                       // Last chunk
+            if (size->chunk)                                         // Check if there is a chunk before it
+                size->chunk->next = next;                            // Append it
+            else                                                     // First chunk
+                size->chunks = next;                                 // Start the list
+            self->bytes += sizeof(glyphChunk_t);                     // Count it
+        }
+        next->used = 0;     // Fill it from the start
+        size->chunk = next; // Append to it
+    }
+
+    const stroke_t *const strokes = &self->fontData->table.strokes[fontChar->first]; // Strokes in the font
+    glyphStroke_t *const scaled = &size->chunk->strokes[size->chunk->used];          // Strokes at the size
+    for (uint8_t i = 0; i < fontChar->numStrokes; i++)                               // Iterate through strokes
+    {
+        scaled[i].vec = StrokeVector(strokes[i], size->scale); // Scale vector
+        scaled[i].penDown = StrokePenDown(strokes[i]);         // Copy pen state
+    }
+
+    glyph->strokes = scaled;                   // Set strokes
+    glyph->numStrokes = fontChar->numStrokes;  // Set number of strokes
+    glyph->built = true;                       // Mark it scaled
+    size->chunk->used += fontChar->numStrokes; // Take the strokes from the chunk
+    self->built++;                             // Count it
+    return SUCCESS;                            // Return success
+}
+
+static errorCode_t _free(glyphCache_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    for (int i = 0; i < self->numSizes; i++) // Sizes held
+    {
+        glyphSize_t *const size = &self->sizes[i];       // The size
+        for (size_t j = 0; j < size->numTouched; j++)    // Pages it touched
+            free(size->pages[size->touched[j]]);         // Free table
+        for (glyphChunk_t *chunk = size->chunks; chunk;) // Chunks of its stroke arena
+        {
+            glyphChunk_t *const next = chunk->next; // Chunk after it
+            free(chunk);                            // Free chunk
+            chunk = next;                           // Go to the next
+        }
+        free(size->pages); // Free page entries and touched list
+    }
+    free(self); // Free glyphCache_t
+
+    return SUCCESS; // Return success
+}
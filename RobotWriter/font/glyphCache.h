@@ -0,0 +1,124 @@
+/**
+ * @file glyphCache.h
+ * @brief Declaration of the glyphCache_t structure, the scaled strokes of a font at several sizes.
+ * @details
+ * The font data holds its strokes unscaled and is never changed after it is parsed. The glyph
+ * cache keeps, for each scale factor it is asked for, the strokes of the characters already drawn
+ * at that scale, ready to be added to the cursor position. A character is only scaled the first
+ * time it is drawn at a size, so drawing several sizes costs the same per character as drawing
+ * one once every size is warm.
+ *
+ * A size only holds the pages and strokes of the characters drawn at it, so a large font costs
+ * what the text uses of it. The cache holds up to GLYPH_CACHE_SIZES sizes; asking for another one
+ * drops the size that was used least recently, so a long-running process does not grow with every
+ * height it is given.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../misc/error.h"
+#include "fontData.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define GLYPH_CACHE_SIZES 8    /**< Most sizes the cache holds at once. */
+#define GLYPH_CHUNK_STROKES 256 /**< Scaled strokes in a chunk of a stroke arena, at least the most a character has. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A stroke of a character, scaled to the size it is drawn at.
+ */
+typedef struct glyphStroke_s
+{
+    Vect2d_t vec; /**< Vector of the stroke in millimetres. */
+    bool penDown; /**< true if the pen is down (drawing), false if it is up (moving). */
+} glyphStroke_t;
+
+/**
+ * @brief A character scaled to one size.
+ */
+typedef struct glyph_s
+{
+    const glyphStroke_t *strokes; /**< Scaled strokes, in the size's stroke arena. */
+    uint8_t numStrokes;           /**< Number of strokes. */
+    bool built;                   /**< true once the strokes have been scaled. */
+} glyph_t;
+
+/**
+ * @brief A chunk of the stroke arena of a size.
+ * @details The strokes of a character are appended to the chunk in use and never move, so a
+ *          glyph can point at them; a character that does not fit starts the next chunk.
+ */
+typedef struct glyphChunk_s
+{
+    struct glyphChunk_s *next;                  /**< Next chunk of the arena, NULL for the last. */
+    size_t used;                                /**< Strokes of the chunk in use. */
+    glyphStroke_t strokes[GLYPH_CHUNK_STROKES]; /**< Scaled strokes. */
+} glyphChunk_t;
+
+/**
+ * @brief The characters of the font scaled to one size.
+ * @details `pages` has an entry for each page of the font, and the table of a page is allocated
+ *          the first time one of its characters is looked up, so a character sits at the index
+ *          FontDataIndex() gives in the pages. The strokes are appended to a list of chunks as
+ *          the characters are built. When the slot is reused for another size, only the pages
+ *          in `touched` are cleared and the chunks are filled again from the first.
+ */
+typedef struct glyphSize_s
+{
+    double scale;           /**< Scale factor of the size. */
+    glyph_t **pages;        /**< Table of each page of the font, NULL until one of its characters is looked up. */
+    size_t *touched;        /**< Pages whose table has been allocated, in the order they were. */
+    size_t numTouched;      /**< Number of pages whose table has been allocated. */
+    glyph_t *firstBlock;    /**< Table of the page of the first block, which holds ASCII, NULL until allocated. */
+    glyphChunk_t *chunks;   /**< First chunk of the stroke arena, NULL until a character is built. */
+    glyphChunk_t *chunk;    /**< Chunk the strokes are appended to. */
+    unsigned long lastUsed; /**< Value of the cache's clock when the size was last used. */
+} glyphSize_t;
+
+/**
+ * @brief Structure caching the scaled characters of a font at several sizes.
+ */
+typedef struct glyphCache_s
+{
+    const fontData_t *fontData;           /**< Font the characters come from, not owned. */
+    glyphSize_t sizes[GLYPH_CACHE_SIZES]; /**< Sizes held. */
+    int numSizes;                         /**< Number of sizes held. */
+    int current;                          /**< Index of the size used last. */
+    unsigned long clock;                  /**< Counts the size changes, to find the least recently used size. */
+    unsigned long built;                  /**< Characters scaled since the cache was made. */
+    size_t bytes;                         /**< Bytes allocated for the sizes, their page tables and chunks. */
+
+    /**
+     * @brief Looks up a character at a size, scaling it if it has not been drawn at that size.
+     * @param[in,out] self Pointer to the glyphCache_t structure.
+     * @param[in] codePoint Code point of the character.
+     * @param[in] scale Scale factor of the size.
+     * @return The scaled character, or NULL if the font does not define it or memory for the size,
+     *         the table of its page or its strokes cannot be allocated.
+     */
+    const glyph_t *(*lookup)(struct glyphCache_s *const self, const uint32_t codePoint, const double scale);
+
+    /**
+     * @brief Frees the cache; the font is left alone.
+     * @param[in,out] self Pointer to the glyphCache_t structure.
+     * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct glyphCache_s *self);
+} glyphCache_t;
+
+/**
+ * @brief Constructs an empty glyph cache for a font.
+ * @param[in] fontData The parsed font; it must outlive the cache and not be parsed again.
+ * @return A pointer to the newly created glyphCache_t object, or NULL if allocation fails.
+ */
+glyphCache_t *glyphCacheConstructor(const fontData_t *const fontData);
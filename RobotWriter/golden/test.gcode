@@ -0,0 +1,276 @@
+S0 G0 X0.00 Y0.00 ; Home
+S0 G0 X1.33 Y-4.00
+S1000 G1 X1.33 Y0.00
+S0 G0 X0.00 Y0.00
+S1000 G1 X2.67 Y0.00
+S0 G0 X4.00 Y-4.00
+S0 G0 X4.00 Y-4.00
+S1000 G1 X4.00 Y0.00
+S0 G0 X4.00 Y-2.00
+S1000 G1 X5.33 Y-1.56
+S1000 G1 X6.67 Y-2.00
+S1000 G1 X6.67 Y-4.00
+S0 G0 X8.00 Y-4.00
+S0 G0 X8.00 Y-2.67
+S1000 G1 X10.67 Y-2.44
+S1000 G1 X10.00 Y-1.33
+S1000 G1 X8.67 Y-1.33
+S1000 G1 X8.00 Y-2.00
+S1000 G1 X8.00 Y-3.56
+S1000 G1 X8.67 Y-4.00
+S1000 G1 X10.00 Y-4.00
+S1000 G1 X10.67 Y-3.56
+S0 G0 X12.00 Y-4.00
+S0 G0 X18.44 Y-3.56
+S1000 G1 X17.33 Y-4.00
+S1000 G1 X16.00 Y-3.56
+S1000 G1 X16.00 Y-2.00
+S1000 G1 X17.33 Y-1.56
+S1000 G1 X18.44 Y-2.00
+S0 G0 X18.44 Y-1.56
+S1000 G1 X18.44 Y-5.33
+S1000 G1 X18.89 Y-5.78
+S0 G0 X20.00 Y-4.00
+S0 G0 X20.00 Y-1.56
+S1000 G1 X20.00 Y-3.56
+S1000 G1 X21.33 Y-4.00
+S1000 G1 X22.67 Y-3.56
+S1000 G1 X22.67 Y-1.56
+S0 G0 X24.00 Y-4.00
+S0 G0 X25.56 Y-4.00
+S1000 G1 X25.56 Y-1.56
+S1000 G1 X24.89 Y-1.56
+S0 G0 X25.56 Y0.00
+S1000 G1 X25.56 Y0.00
+S0 G0 X28.00 Y-4.00
+S0 G0 X30.44 Y-2.00
+S1000 G1 X29.33 Y-1.56
+S1000 G1 X28.00 Y-2.00
+S1000 G1 X28.00 Y-3.56
+S1000 G1 X29.33 Y-4.00
+S1000 G1 X30.44 Y-3.56
+S0 G0 X32.00 Y-4.00
+S0 G0 X32.00 Y-4.00
+S1000 G1 X32.00 Y0.00
+S0 G0 X32.00 Y-2.89
+S1000 G1 X34.67 Y-1.56
+S0 G0 X32.89 Y-2.44
+S1000 G1 X34.67 Y-4.00
+S0 G0 X36.00 Y-4.00
+S0 G0 X40.00 Y-4.00
+S1000 G1 X40.00 Y0.00
+S0 G0 X40.00 Y-2.00
+S1000 G1 X41.33 Y-1.56
+S1000 G1 X42.67 Y-2.00
+S1000 G1 X42.67 Y-3.56
+S1000 G1 X41.33 Y-4.00
+S1000 G1 X40.00 Y-3.56
+S0 G0 X44.00 Y-4.00
+S0 G0 X44.00 Y-4.00
+S1000 G1 X44.00 Y-1.56
+S0 G0 X44.00 Y-2.22
+S1000 G1 X45.33 Y-1.56
+S1000 G1 X46.67 Y-2.22
+S0 G0 X48.00 Y-4.00
+S0 G0 X49.33 Y-4.00
+S1000 G1 X48.00 Y-3.56
+S1000 G1 X48.00 Y-2.00
+S1000 G1 X49.33 Y-1.56
+S1000 G1 X50.67 Y-2.00
+S1000 G1 X50.67 Y-3.56
+S1000 G1 X49.33 Y-4.00
+S0 G0 X52.00 Y-4.00
+S0 G0 X52.00 Y-1.56
+S1000 G1 X52.67 Y-4.00
+S1000 G1 X53.33 Y-2.22
+S1000 G1 X54.00 Y-4.00
+S1000 G1 X54.67 Y-1.56
+S0 G0 X56.00 Y-4.00
+S0 G0 X56.00 Y-4.00
+S1000 G1 X56.00 Y-1.56
+S0 G0 X56.00 Y-2.22
+S1000 G1 X57.33 Y-1.56
+S1000 G1 X58.67 Y-2.22
+S1000 G1 X58.67 Y-4.00
+S0 G0 X60.00 Y-4.00
+S0 G0 X64.89 Y-4.00
+S1000 G1 X64.89 Y-0.44
+S1000 G1 X65.78 Y0.00
+S1000 G1 X66.67 Y-0.44
+S0 G0 X64.00 Y-2.00
+S1000 G1 X65.78 Y-2.00
+S0 G0 X68.00 Y-4.00
+S0 G0 X69.33 Y-4.00
+S1000 G1 X68.00 Y-3.56
+S1000 G1 X68.00 Y-2.00
+S1000 G1 X69.33 Y-1.56
+S1000 G1 X70.67 Y-2.00
+S1000 G1 X70.67 Y-3.56
+S1000 G1 X69.33 Y-4.00
+S0 G0 X72.00 Y-4.00
+S0 G0 X72.00 Y-4.00
+S1000 G1 X74.44 Y-1.56
+S0 G0 X72.00 Y-1.56
+S1000 G1 X74.44 Y-4.00
+S0 G0 X76.00 Y-4.00
+S0 G0 X0.00 Y-14.11
+S1000 G1 X0.89 Y-14.56
+S1000 G1 X1.78 Y-14.11
+S1000 G1 X1.78 Y-10.56
+S0 G0 X1.78 Y-9.00
+S1000 G1 X1.78 Y-9.00
+S0 G0 X4.00 Y-13.00
+S0 G0 X4.00 Y-10.56
+S1000 G1 X4.00 Y-12.56
+S1000 G1 X5.33 Y-13.00
+S1000 G1 X6.67 Y-12.56
+S1000 G1 X6.67 Y-10.56
+S0 G0 X8.00 Y-13.00
+S0 G0 X8.00 Y-13.00
+S1000 G1 X8.00 Y-10.33
+S0 G0 X8.00 Y-11.00
+S1000 G1 X8.89 Y-10.33
+S1000 G1 X9.33 Y-11.00
+S1000 G1 X9.33 Y-13.00
+S0 G0 X9.33 Y-11.00
+S1000 G1 X10.22 Y-10.33
+S1000 G1 X10.67 Y-11.00
+S1000 G1 X10.67 Y-13.00
+S0 G0 X12.00 Y-13.00
+S0 G0 X12.00 Y-14.56
+S1000 G1 X12.00 Y-10.56
+S0 G0 X12.00 Y-11.00
+S1000 G1 X13.33 Y-10.56
+S1000 G1 X14.67 Y-11.00
+S1000 G1 X14.67 Y-12.56
+S1000 G1 X13.33 Y-13.00
+S1000 G1 X12.00 Y-12.56
+S0 G0 X16.00 Y-13.00
+S0 G0 X16.00 Y-11.67
+S1000 G1 X18.67 Y-11.44
+S1000 G1 X18.00 Y-10.33
+S1000 G1 X16.67 Y-10.33
+S1000 G1 X16.00 Y-11.00
+S1000 G1 X16.00 Y-12.56
+S1000 G1 X16.67 Y-13.00
+S1000 G1 X18.00 Y-13.00
+S1000 G1 X18.67 Y-12.56
+S0 G0 X20.00 Y-13.00
+S0 G0 X22.67 Y-12.56
+S1000 G1 X21.33 Y-13.00
+S1000 G1 X20.00 Y-12.56
+S1000 G1 X20.00 Y-11.00
+S1000 G1 X21.33 Y-10.56
+S1000 G1 X22.67 Y-11.00
+S0 G0 X22.67 Y-9.00
+S1000 G1 X22.67 Y-13.00
+S0 G0 X24.00 Y-13.00
+S0 G0 X29.33 Y-13.00
+S1000 G1 X28.00 Y-12.56
+S1000 G1 X28.00 Y-11.00
+S1000 G1 X29.33 Y-10.56
+S1000 G1 X30.67 Y-11.00
+S1000 G1 X30.67 Y-12.56
+S1000 G1 X29.33 Y-13.00
+S0 G0 X32.00 Y-13.00
+S0 G0 X32.00 Y-10.56
+S1000 G1 X33.33 Y-13.00
+S1000 G1 X34.67 Y-10.56
+S0 G0 X36.00 Y-13.00
+S0 G0 X36.00 Y-11.67
+S1000 G1 X38.67 Y-11.44
+S1000 G1 X38.00 Y-10.33
+S1000 G1 X36.67 Y-10.33
+S1000 G1 X36.00 Y-11.00
+S1000 G1 X36.00 Y-12.56
+S1000 G1 X36.67 Y-13.00
+S1000 G1 X38.00 Y-13.00
+S1000 G1 X38.67 Y-12.56
+S0 G0 X40.00 Y-13.00
+S0 G0 X40.00 Y-13.00
+S1000 G1 X40.00 Y-10.56
+S0 G0 X40.00 Y-11.22
+S1000 G1 X41.33 Y-10.56
+S1000 G1 X42.67 Y-11.22
+S0 G0 X44.00 Y-13.00
+S0 G0 X50.67 Y-12.56
+S1000 G1 X49.78 Y-13.00
+S1000 G1 X48.89 Y-12.56
+S1000 G1 X48.89 Y-9.00
+S0 G0 X48.00 Y-10.56
+S1000 G1 X49.78 Y-10.56
+S0 G0 X52.00 Y-13.00
+S0 G0 X52.00 Y-13.00
+S1000 G1 X52.00 Y-9.00
+S0 G0 X52.00 Y-11.00
+S1000 G1 X53.33 Y-10.56
+S1000 G1 X54.67 Y-11.00
+S1000 G1 X54.67 Y-13.00
+S0 G0 X56.00 Y-13.00
+S0 G0 X56.00 Y-11.67
+S1000 G1 X58.67 Y-11.44
+S1000 G1 X58.00 Y-10.33
+S1000 G1 X56.67 Y-10.33
+S1000 G1 X56.00 Y-11.00
+S1000 G1 X56.00 Y-12.56
+S1000 G1 X56.67 Y-13.00
+S1000 G1 X58.00 Y-13.00
+S1000 G1 X58.67 Y-12.56
+S0 G0 X60.00 Y-13.00
+S0 G0 X64.67 Y-13.00
+S1000 G1 X66.00 Y-13.00
+S0 G0 X65.33 Y-13.00
+S1000 G1 X65.33 Y-9.00
+S1000 G1 X64.67 Y-9.00
+S0 G0 X68.00 Y-13.00
+S0 G0 X68.00 Y-10.78
+S1000 G1 X69.11 Y-10.33
+S1000 G1 X70.44 Y-10.78
+S1000 G1 X70.44 Y-12.56
+S1000 G1 X69.78 Y-13.00
+S1000 G1 X68.89 Y-13.00
+S1000 G1 X68.00 Y-12.56
+S1000 G1 X68.00 Y-11.89
+S1000 G1 X70.44 Y-11.67
+S0 G0 X70.44 Y-12.56
+S1000 G1 X70.89 Y-13.00
+S0 G0 X72.00 Y-13.00
+S0 G0 X72.00 Y-10.56
+S1000 G1 X74.67 Y-10.56
+S1000 G1 X72.00 Y-13.00
+S1000 G1 X74.67 Y-13.00
+S0 G0 X76.00 Y-13.00
+S0 G0 X76.00 Y-10.56
+S1000 G1 X77.56 Y-12.78
+S0 G0 X76.67 Y-14.56
+S1000 G1 X78.67 Y-10.56
+S0 G0 X80.00 Y-13.00
+S0 G0 X86.67 Y-12.56
+S1000 G1 X85.33 Y-13.00
+S1000 G1 X84.00 Y-12.56
+S1000 G1 X84.00 Y-11.00
+S1000 G1 X85.33 Y-10.56
+S1000 G1 X86.67 Y-11.00
+S0 G0 X86.67 Y-9.00
+S1000 G1 X86.67 Y-13.00
+S0 G0 X88.00 Y-13.00
+S0 G0 X89.33 Y-13.00
+S1000 G1 X88.00 Y-12.56
+S1000 G1 X88.00 Y-11.00
+S1000 G1 X89.33 Y-10.56
+S1000 G1 X90.67 Y-11.00
+S1000 G1 X90.67 Y-12.56
+S1000 G1 X89.33 Y-13.00
+S0 G0 X92.00 Y-13.00
+S0 G0 X94.44 Y-12.56
+S1000 G1 X93.33 Y-13.00
+S1000 G1 X92.00 Y-12.56
+S1000 G1 X92.00 Y-11.00
+S1000 G1 X93.33 Y-10.56
+S1000 G1 X94.44 Y-11.00
+S0 G0 X94.44 Y-10.56
+S1000 G1 X94.44 Y-14.11
+S1000 G1 X93.33 Y-14.56
+S1000 G1 X92.00 Y-14.11
+S0 G0 X96.00 Y-13.00
+S0 G0 X0.00 Y0.00 ; Home
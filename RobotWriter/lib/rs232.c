@@ -29,6 +29,10 @@
 /* Solved a problem related to FreeBSD and some baudrates not recognized. */
 /* For more info and how to use this library, visit: http://www.teuniz.net/RS-232/ */
 
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE /* CRTSCTS */
+#endif
+
 #include "rs232.h"
 
 #if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__) /* Linux & FreeBSD */
@@ -57,7 +61,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if ((comport_number >= RS232_PORTNR) || (comport_number < 0))
   {
-    printf("illegal comport number\n");
+    fprintf(stderr, "illegal comport number\n");
     return (1);
   }
 
@@ -156,7 +160,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     break;
 #endif
   default:
-    printf("invalid baudrate\n");
+    fprintf(stderr, "invalid baudrate\n");
     return (1);
     break;
   }
@@ -168,7 +172,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (strlen(mode) != 3)
   {
-    printf("invalid mode \"%s\"\n", mode);
+    fprintf(stderr, "invalid mode \"%s\"\n", mode);
     return (1);
   }
 
@@ -187,7 +191,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     cbits = CS5;
     break;
   default:
-    printf("invalid number of data-bits '%c'\n", mode[0]);
+    fprintf(stderr, "invalid number of data-bits '%c'\n", mode[0]);
     return (1);
     break;
   }
@@ -210,7 +214,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     ipar = INPCK;
     break;
   default:
-    printf("invalid parity '%c'\n", mode[1]);
+    fprintf(stderr, "invalid parity '%c'\n", mode[1]);
     return (1);
     break;
   }
@@ -224,7 +228,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     bstop = CSTOPB;
     break;
   default:
-    printf("invalid number of stop bits '%c'\n", mode[2]);
+    fprintf(stderr, "invalid number of stop bits '%c'\n", mode[2]);
     return (1);
     break;
   }
@@ -234,7 +238,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   http://man7.org/linux/man-pages/man3/termios.3.html
   */
-  printf("comport_number = %s\n", comports[comport_number]);
+  fprintf(stderr, "comport_number = %s\n", comports[comport_number]);
   Cport[comport_number] = open(comports[comport_number], O_RDWR | O_NOCTTY | O_NDELAY);
   if (Cport[comport_number] == -1)
   {
@@ -288,6 +292,9 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (ioctl(Cport[comport_number], TIOCMGET, &status) == -1)
   {
+    if (errno == ENOTTY || errno == EINVAL) /* pseudo-terminals have no modem lines */
+      return (0);
+
     tcsetattr(Cport[comport_number], TCSANOW, old_port_settings + comport_number);
     flock(Cport[comport_number], LOCK_UN); /* free the port so that others can use it. */
     perror("unable to get portstatus");
@@ -323,6 +330,34 @@ int RS232_PollComport(int comport_number, unsigned char *buf, int size)
   return (n);
 }
 
+/* waits until data can be read, returns 1 when readable, 0 on timeout, -1 on error */
+/* a negative timeout waits forever */
+int RS232_WaitForData(int comport_number, int timeout_ms)
+{
+  struct pollfd pfd;
+  int n;
+
+  pfd.fd = Cport[comport_number];
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  do
+  {
+    n = poll(&pfd, 1, timeout_ms);
+  } while ((n < 0) && (errno == EINTR));
+
+  if (n < 0)
+    return (-1);
+
+  if (n == 0)
+    return (0);
+
+  if (pfd.revents & (POLLERR | POLLNVAL))
+    return (-1);
+
+  return (1); /* POLLIN, or POLLHUP which the next read reports */
+}
+
 int RS232_SendByte(int comport_number, unsigned char byte)
 {
   int n = write(Cport[comport_number], &byte, 1);
@@ -359,21 +394,65 @@ int RS232_SendBuf(int comport_number, unsigned char *buf, int size)
   return (n);
 }
 
+/* sends the whole buffer, continuing after partial writes and waiting while */
+/* the port cannot take more data, returns the number of bytes sent, which is */
+/* less than size only if the port failed or stayed blocked for RS232_TX_TIMEOUT_MS */
+int RS232_SendBufAll(int comport_number, const unsigned char *buf, int size)
+{
+  struct pollfd pfd;
+  int n,
+      sent = 0;
+
+  while (sent < size)
+  {
+    n = write(Cport[comport_number], buf + sent, size - sent);
+
+    if (n > 0)
+    {
+      sent += n;
+      continue;
+    }
+
+    if ((n < 0) && (errno == EINTR))
+      continue;
+
+    if ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+      break;
+
+    pfd.fd = Cport[comport_number];
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+
+    do
+    {
+      n = poll(&pfd, 1, RS232_TX_TIMEOUT_MS);
+    } while ((n < 0) && (errno == EINTR));
+
+    if (n <= 0)
+      break;
+  }
+
+  return (sent);
+}
+
 void RS232_CloseComport(int comport_number)
 {
   int status;
 
   if (ioctl(Cport[comport_number], TIOCMGET, &status) == -1)
   {
-    perror("unable to get portstatus");
+    if (errno != ENOTTY && errno != EINVAL) /* pseudo-terminals have no modem lines */
+      perror("unable to get portstatus");
   }
-
-  status &= ~TIOCM_DTR; /* turn off DTR */
-  status &= ~TIOCM_RTS; /* turn off RTS */
-
-  if (ioctl(Cport[comport_number], TIOCMSET, &status) == -1)
+  else
   {
-    perror("unable to set portstatus");
+    status &= ~TIOCM_DTR; /* turn off DTR */
+    status &= ~TIOCM_RTS; /* turn off RTS */
+
+    if (ioctl(Cport[comport_number], TIOCMSET, &status) == -1)
+    {
+      perror("unable to set portstatus");
+    }
   }
 
   tcsetattr(Cport[comport_number], TCSANOW, old_port_settings + comport_number);
@@ -551,7 +630,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 {
   if ((comport_number >= RS232_PORTNR) || (comport_number < 0))
   {
-    printf("illegal comport number\n");
+    fprintf(stderr, "illegal comport number\n");
     return (1);
   }
 
@@ -615,14 +694,14 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     strcpy(mode_str, "baud=3000000");
     break;
   default:
-    printf("invalid baudrate\n");
+    fprintf(stderr, "invalid baudrate\n");
     return (1);
     break;
   }
 
   if (strlen(mode) != 3)
   {
-    printf("invalid mode \"%s\"\n", mode);
+    fprintf(stderr, "invalid mode \"%s\"\n", mode);
     return (1);
   }
 
@@ -641,7 +720,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     strcat(mode_str, " data=5");
     break;
   default:
-    printf("invalid number of data-bits '%c'\n", mode[0]);
+    fprintf(stderr, "invalid number of data-bits '%c'\n", mode[0]);
     return (1);
     break;
   }
@@ -661,7 +740,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     strcat(mode_str, " parity=o");
     break;
   default:
-    printf("invalid parity '%c'\n", mode[1]);
+    fprintf(stderr, "invalid parity '%c'\n", mode[1]);
     return (1);
     break;
   }
@@ -675,7 +754,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
     strcat(mode_str, " stop=2");
     break;
   default:
-    printf("invalid number of stop bits '%c'\n", mode[2]);
+    fprintf(stderr, "invalid number of stop bits '%c'\n", mode[2]);
     return (1);
     break;
   }
@@ -707,7 +786,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (Cport[comport_number] == INVALID_HANDLE_VALUE)
   {
-    printf("unable to open comport\n");
+    fprintf(stderr, "unable to open comport\n");
     return (1);
   }
 
@@ -717,7 +796,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (!BuildCommDCBA(mode_str, &port_settings))
   {
-    printf("unable to set comport dcb settings\n");
+    fprintf(stderr, "unable to set comport dcb settings\n");
     CloseHandle(Cport[comport_number]);
     return (1);
   }
@@ -730,7 +809,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (!SetCommState(Cport[comport_number], &port_settings))
   {
-    printf("unable to set comport cfg settings\n");
+    fprintf(stderr, "unable to set comport cfg settings\n");
     CloseHandle(Cport[comport_number]);
     return (1);
   }
@@ -745,7 +824,7 @@ int RS232_OpenComport(int comport_number, int baudrate, const char *mode, int fl
 
   if (!SetCommTimeouts(Cport[comport_number], &Cptimeouts))
   {
-    printf("unable to set comport time-out settings\n");
+    fprintf(stderr, "unable to set comport time-out settings\n");
     CloseHandle(Cport[comport_number]);
     return (1);
   }
@@ -765,6 +844,29 @@ int RS232_PollComport(int comport_number, unsigned char *buf, int size)
   return (n);
 }
 
+/* waits until data can be read, returns 1 when readable, 0 on timeout, -1 on error */
+/* a negative timeout waits forever */
+int RS232_WaitForData(int comport_number, int timeout_ms)
+{
+  COMSTAT status;
+  DWORD errors;
+  DWORD start = GetTickCount();
+
+  while (1)
+  {
+    if (!ClearCommError(Cport[comport_number], &errors, &status))
+      return (-1);
+
+    if (status.cbInQue > 0)
+      return (1);
+
+    if ((timeout_ms >= 0) && ((int)(GetTickCount() - start) >= timeout_ms))
+      return (0);
+
+    Sleep(1);
+  }
+}
+
 int RS232_SendByte(int comport_number, unsigned char byte)
 {
   int n;
@@ -792,6 +894,27 @@ int RS232_SendBuf(int comport_number, unsigned char *buf, int size)
   return (-1);
 }
 
+/* sends the whole buffer, continuing after partial writes, returns the number */
+/* of bytes sent, which is less than size only if the port failed */
+int RS232_SendBufAll(int comport_number, const unsigned char *buf, int size)
+{
+  int n,
+      sent = 0;
+
+  while (sent < size)
+  {
+    if (!WriteFile(Cport[comport_number], buf + sent, size - sent, (LPDWORD)((void *)&n), NULL))
+      break;
+
+    if (n <= 0)
+      break;
+
+    sent += n;
+  }
+
+  return (sent);
+}
+
 void RS232_CloseComport(int comport_number)
 {
   CloseHandle(Cport[comport_number]);
@@ -893,8 +1016,21 @@ void RS232_flushRXTX(int comport_number)
 
 void RS232_cputs(int comport_number, const char *text) /* sends a string to serial port */
 {
-  while (*text != 0)
-    RS232_SendByte(comport_number, *(text++));
+  RS232_SendBufAll(comport_number, (const unsigned char *)text, strlen(text));
+}
+
+/* use devname instead of the built-in device for comport_number, returns -1 if out of range */
+int RS232_SetPortName(int comport_number, const char *devname)
+{
+  if ((comport_number >= RS232_PORTNR) || (comport_number < 0) || (devname == NULL))
+  {
+    fprintf(stderr, "illegal comport number\n");
+    return (-1);
+  }
+
+  comports[comport_number] = devname;
+
+  return (0);
 }
 
 /* return index in comports matching to device name or -1 if not found */
@@ -37,6 +37,8 @@ extern "C"
 {
 #endif
 
+#define RS232_TX_TIMEOUT_MS 5000 /* longest wait for the port to accept more data */
+
 #include <stdio.h>
 #include <string.h>
 
@@ -51,6 +53,7 @@ extern "C"
 #include <limits.h>
 #include <sys/file.h>
 #include <errno.h>
+#include <poll.h>
 
 #else
 #include <windows.h>
@@ -58,8 +61,10 @@ extern "C"
 
     int RS232_OpenComport(int, int, const char *, int);
     int RS232_PollComport(int, unsigned char *, int);
+    int RS232_WaitForData(int, int);
     int RS232_SendByte(int, unsigned char);
     int RS232_SendBuf(int, unsigned char *, int);
+    int RS232_SendBufAll(int, const unsigned char *, int);
     void RS232_CloseComport(int);
     void RS232_cputs(int, const char *);
     int RS232_IsDCDEnabled(int);
@@ -74,6 +79,7 @@ extern "C"
     void RS232_flushTX(int);
     void RS232_flushRXTX(int);
     int RS232_GetPortnr(const char *);
+    int RS232_SetPortName(int, const char *);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -1,3 +1,7 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // clock_gettime() and nanosleep()
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -12,11 +16,15 @@
 
 #if defined(__linux__) || defined(__APPLE__)
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 
 unsigned int Sleep(unsigned int ms)
 {
-    return usleep(ms * 1000); // Convert milliseconds to microseconds
+    struct timespec delay;                       // Time to sleep
+    delay.tv_sec = ms / 1000;                    // Whole seconds
+    delay.tv_nsec = (long)(ms % 1000) * 1000000; // Rest in nanoseconds
+    return nanosleep(&delay, NULL);              // Sleep
 }
 
 #endif
@@ -25,10 +33,22 @@ unsigned int Sleep(unsigned int ms)
 
 #ifdef Serial_Mode // Code for running with robot
 
-// Open port with checking
+static const char *portName = NULL; // Device chosen with SetSerialPort(), NULL if none
+
+// Choose the device to open, it takes precedence over SERIAL_PORT_ENV
+void SetSerialPort(const char *port)
+{
+    portName = port;
+}
+
+// Open port with checking, SetSerialPort() or SERIAL_PORT_ENV can name another device (e.g. the emulator's pty)
 int CanRS232PortBeOpened(void)
 {
     char mode[] = {'8', 'N', '1', 0};
+    const char *port = portName != NULL ? portName : getenv(SERIAL_PORT_ENV);
+    if (port != NULL && port[0] != 0)
+        RS232_SetPortName(cport_nr, port);
+
     if (RS232_OpenComport(cport_nr, bdrate, mode, 0))
     {
 #ifdef DEBUG_MODE
@@ -45,110 +65,225 @@ void CloseRS232Port(void)
     RS232_CloseComport(cport_nr);
 }
 
-// Write text out via the serial port
-int PrintBuffer(char *buffer)
+static char txBuf[SERIAL_TX_BUFFER_SIZE]; // Text queued for the port
+static int txLen = 0;                     // Number of bytes queued
+
+// Append text to the transmit buffer, it goes out with the next FlushBuffer()
+int QueueBuffer(const char *buffer)
+{
+    int n = strlen(buffer);
+
+    if (txLen + n > SERIAL_TX_BUFFER_SIZE && FlushBuffer() != 0)
+        return (-1);
+
+    if (n > SERIAL_TX_BUFFER_SIZE) // Too big to queue, send it straight away
+        return (RS232_SendBufAll(cport_nr, (const unsigned char *)buffer, n) == n ? 0 : -1);
+
+    memcpy(txBuf + txLen, buffer, n);
+    txLen += n;
+    return (0);
+}
+
+// Send everything queued in as few write() calls as the port allows
+int FlushBuffer(void)
 {
-    RS232_cputs(cport_nr, buffer);
+    if (txLen == 0)
+        return (0);
+
+    int sent = RS232_SendBufAll(cport_nr, (const unsigned char *)txBuf, txLen);
 #ifdef DEBUG_MODE
-    printf("sent: %s\n", buffer);
+    printf("sent: %.*s\n", sent, txBuf);
 #endif
-    return (0);
+
+    int queued = txLen;
+    txLen = 0;
+    return (sent == queued ? 0 : -1);
 }
 
-int WaitForDollar(void)
+// Write text out via the serial port
+int PrintBuffer(char *buffer)
 {
-    int i, n;
+    if (QueueBuffer(buffer) != 0)
+        return (-1);
+    return (FlushBuffer());
+}
 
-    unsigned char buf[4096];
+static unsigned char rxBuf[4096];        // Bytes read from the port but not yet consumed
+static int rxPos = 0, rxLen = 0;         // Read position and fill level of rxBuf
+static char partial[SERIAL_LINE_LENGTH]; // Line being assembled
+static int partialLen = 0;               // Length of the line being assembled
+static int timeoutMs = SERIAL_TIMEOUT_MS; // How long to wait for a reply
+
+// Milliseconds from a monotonic clock, used to track reply deadlines
+static long long MonotonicMs(void)
+{
+#if defined(__WINDOWS__)
+    return (long long)GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+// Assemble reply lines from whatever the port has delivered so far. Bytes of a
+// partially received line are kept between calls, so "ok" split across two
+// reads is still seen as one line. Empty lines (GRBL ends lines with "\r\n")
+// are skipped.
+int ReadReplyLine(char *line, int size)
+{
+    if (size <= 0)
+        return (-1);
 
     while (1)
     {
-#ifdef DEBUG_MODE
-        printf(".");
-#endif
-        n = RS232_PollComport(cport_nr, buf, 4095);
+        if (rxPos == rxLen)
+        {
+            rxLen = RS232_PollComport(cport_nr, rxBuf, sizeof(rxBuf));
+            rxPos = 0;
+            if (rxLen < 0)
+            {
+                rxLen = 0;
+                return (-1);
+            }
+            if (rxLen == 0)
+                return (0);
+        }
 
-        if (n > 0)
+        while (rxPos < rxLen)
         {
-#ifdef DEBUG_MODE
-            printf("RCVD: N = %d ", n);
-#endif
-            buf[n] = 0; /* always put a "null" at the end of a string! */
+            char c = (char)rxBuf[rxPos++];
 
-            for (i = 0; i < n; i++)
+            if (c == '\n')
             {
-                if (buf[i] == '$') /* replace unreadable control-codes by dots */
+                int n = partialLen < size - 1 ? partialLen : size - 1;
+                memcpy(line, partial, n);
+                line[n] = 0;
+                partialLen = 0;
+
+                if (n > 0)
                 {
 #ifdef DEBUG_MODE
-                    printf("received %i bytes: %s \n", n, (char *)buf);
-                    printf("\nSaw the Dollar\n");
+                    printf("received line: %s\n", line);
 #endif
-                    return 0;
+                    return (1);
                 }
             }
+            else if (c != '\r' && partialLen < SERIAL_LINE_LENGTH - 1)
+            {
+                partial[partialLen++] = c;
+            }
+        }
+    }
+}
 
-#ifdef DEBUG_MODE
-            printf("received %i bytes: %s \n", n, (char *)buf);
-#endif
+// Sleep in poll() until the port has data, so a reply is handled as soon as
+// it arrives. Gives up after timeout_ms (negative waits forever).
+int WaitForReplyLine(char *line, int size, int timeout_ms)
+{
+    const long long deadline = MonotonicMs() + timeout_ms;
 
-            if ((buf[0] == 'o') && (buf[1] == 'k'))
-                return 0;
+    while (1)
+    {
+        int n = ReadReplyLine(line, size);
+        if (n != 0)
+            return (n);
+
+        int remaining = -1;
+        if (timeout_ms >= 0)
+        {
+            long long left = deadline - MonotonicMs();
+            if (left <= 0)
+                return (0);
+            remaining = (int)left;
         }
 
-        Sleep(100);
+        n = RS232_WaitForData(cport_nr, remaining);
+        if (n < 0)
+            return (-1);
+        if (n == 0)
+            return (0);
     }
+}
 
-    return (0);
+// Throw away everything received so far, including a partly assembled line
+void FlushReplyLines(void)
+{
+    RS232_flushRX(cport_nr);
+    rxPos = rxLen = 0;
+    partialLen = 0;
 }
 
-int WaitForReply(void)
+void SetSerialTimeout(int timeout_ms)
 {
-    int i, n;
+    timeoutMs = timeout_ms;
+}
 
-    unsigned char buf[4096];
+int GetSerialTimeout(void)
+{
+    return (timeoutMs);
+}
 
-#ifdef DEBUG_MODE
-    printf("Waiting for reply\n");
-#endif
+// Wait for the startup banner ("Grbl 1.1h ['$' for help]") or an "ok"
+int WaitForDollar(void)
+{
+    char line[SERIAL_LINE_LENGTH];
 
     while (1)
     {
+        int n = WaitForReplyLine(line, sizeof(line), timeoutMs);
+        if (n <= 0)
+        {
 #ifdef DEBUG_MODE
-        printf(".");
+            printf("No banner from controller\n");
 #endif
-        n = RS232_PollComport(cport_nr, buf, 4095);
+            return (-1);
+        }
 
-        if (n > 0)
+        if (strchr(line, '$') != NULL)
         {
 #ifdef DEBUG_MODE
-            printf("RCVD: N = %d ", n);
+            printf("\nSaw the Dollar\n");
 #endif
-            buf[n] = 0; /* always put a "null" at the end of a string! */
+            return (0);
+        }
 
-            for (i = 0; i < n; i++)
-            {
-                if (buf[i] < 32) /* replace unreadable control-codes by dots */
-                {
-                    buf[i] = '.';
-                }
-            }
+        if ((line[0] == 'o') && (line[1] == 'k'))
+            return (0);
+    }
+}
+
+// Wait for "ok" (returns 0) or "error:N" (returns 1); -1 on timeout or port error
+int WaitForReply(void)
+{
+    char line[SERIAL_LINE_LENGTH];
 
 #ifdef DEBUG_MODE
-            printf("received %i bytes: %s\n", n, (char *)buf);
+    printf("Waiting for reply\n");
 #endif
 
-            if ((buf[0] == 'o') && (buf[1] == 'k'))
-                return 0;
-        }
+    while (1)
+    {
+        int n = WaitForReplyLine(line, sizeof(line), timeoutMs);
+        if (n <= 0)
+            return (-1);
 
-        Sleep(100);
-    }
+        if ((line[0] == 'o') && (line[1] == 'k'))
+            return (0);
 
-    return (0);
+        if (strncmp(line, "error", 5) == 0)
+            return (1);
+    }
 }
 
 #else // Code for testing with emulator
 
+// No port is opened, so there is nothing to choose
+void SetSerialPort(const char *port)
+{
+    (void)port;
+}
+
 // Open port with checking
 int CanRS232PortBeOpened(void)
 {
@@ -170,6 +305,55 @@ int PrintBuffer(char *buffer)
     return (0);
 }
 
+// Nothing to queue for, print the buffer contents to the terminal
+int QueueBuffer(const char *buffer)
+{
+#ifdef DEBUG_MODE
+    printf("%s \n", buffer);
+#else
+    (void)buffer;
+#endif
+    return (0);
+}
+
+// Nothing is ever queued
+int FlushBuffer(void)
+{
+    return (0);
+}
+
+// No controller is attached, so every line is acknowledged straight away
+int ReadReplyLine(char *line, int size)
+{
+    if (size < 3)
+        return (-1);
+    strcpy(line, "ok");
+    return (1);
+}
+
+// No controller is attached, so every line is acknowledged straight away
+int WaitForReplyLine(char *line, int size, int timeout_ms)
+{
+    (void)timeout_ms;
+    return ReadReplyLine(line, size);
+}
+
+// Nothing is ever received
+void FlushReplyLines(void)
+{
+    return;
+}
+
+void SetSerialTimeout(int timeout_ms)
+{
+    (void)timeout_ms;
+}
+
+int GetSerialTimeout(void)
+{
+    return (SERIAL_TIMEOUT_MS);
+}
+
 // Dummy function, will wait for key press
 int WaitForReply(void)
 {
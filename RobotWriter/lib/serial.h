@@ -12,13 +12,26 @@
 extern unsigned int Sleep(unsigned int ms);
 #endif
 
+#define SERIAL_LINE_LENGTH 256             /* Longest reply line kept, the rest of a longer line is dropped */
+#define SERIAL_TIMEOUT_MS 60000            /* Default time to wait for a reply before giving up */
+#define SERIAL_TX_BUFFER_SIZE 4096         /* Bytes queued by QueueBuffer() before a flush is forced */
+#define SERIAL_PORT_ENV "ROBOTWRITER_PORT" /* Environment variable naming a port to use instead of the default */
+
 #define Serial_Mode
 // #define DEBUG_MODE
 
-int PrintBuffer(char *buffer);  // JIB: Needed to match the function
-int WaitForReply(void);         // Wait for OK function
-int WaitForDollar(void);        // Wait for '$' function (for startup)
-int CanRS232PortBeOpened(void); // Port open check
+int PrintBuffer(char *buffer);                               // JIB: Needed to match the function
+int QueueBuffer(const char *buffer);                         // Queue text for the port without sending it yet
+int FlushBuffer(void);                                       // Send all queued text (0 = sent, -1 = port error)
+int WaitForReply(void);                                      // Wait for OK function (0 = ok, 1 = error reply, -1 = timeout or port error)
+int WaitForDollar(void);                                     // Wait for '$' function (for startup, -1 = timeout or port error)
+int ReadReplyLine(char *line, int size);                     // Fetch one complete reply line if available (1 = line, 0 = none yet, -1 = error)
+int WaitForReplyLine(char *line, int size, int timeout_ms);  // Wait for a reply line (1 = line, 0 = timeout, -1 = error)
+void FlushReplyLines(void);                                  // Discard received data and any partial line
+void SetSerialTimeout(int timeout_ms);                       // Reply timeout in ms used by the wait functions (negative = forever)
+int GetSerialTimeout(void);                                  // Current reply timeout in ms
+void SetSerialPort(const char *port);                        // Device to open instead of the default (NULL = default or SERIAL_PORT_ENV)
+int CanRS232PortBeOpened(void);                              // Port open check
 void CloseRS232Port(void);
 
 #endif // SERIAL_H_INCLUDED
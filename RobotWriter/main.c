@@ -2,50 +2,372 @@
  * @file main.c
  * @brief Entry point for the robot text drawing application.
  * @details
- * This program initializes the robot, parses font data from a specified font file,
- * and allows the user to specify a text height and input file containing the text to be drawn.
+ * This program initializes the robot, loads the font compiled into it or one from a specified
+ * font file, and allows the user to specify a text height and input file containing the text to be drawn.
  * It then processes the input text, converts it into G-code, and sends the commands to the robot
  * to draw the text. Finally, it frees allocated resources and concludes the operation.
+ *
+ * The font, text height, text files, outputs, port and the drawing options can all be given
+ * on the command line; only what is missing is asked for. Every text file given is drawn as a
+ * job of its own, one after the other, with the font parsed and the robot started only once.
+ * Each job may have a height of its own; the characters of every height are scaled once, the
+ * first time they are drawn at it, and kept in a glyph cache for the jobs that follow.
+ * With the ROBOTWRITER_DRY_RUN environment variable set, no port is opened and the job is only
+ * estimated, as with --dry-run. The G-code goes to stdout unless other outputs are given; a dry
+ * run with --quiet writes it nowhere, which times the generation of the G-code alone.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 
 #include "main.h"
 
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+static const char *const valueOptions[] = {"-f", "--font", "-o", "--output", "-p", "--port", "-H", "--height",
+                                           "--decimals", "--simplify", "--arcs", "--feed", "--max-rate",
+                                           "--acceleration", "--junction-deviation", "--pen-delay",
+                                           "--page-gcode", "--page-pause", "--bounds-tolerance"}; /**< Options followed by a value. */
+
+/**
+ * @brief Checks whether an option is followed by a value.
+ * @param[in] option The option.
+ * @return true if the option is one of valueOptions.
+ */
+static bool _takesValue(const char *option);
+
+/**
+ * @brief Reads a number that must make up the whole argument.
+ * @param[in] text The argument.
+ * @param[out] value The number.
+ * @return true if the argument is a number.
+ */
+static bool _readNumber(const char *text, double *const value);
+
+/**
+ * @brief Reports a wrong option on stderr.
+ * @param[in] program Name the program was started with.
+ * @param[in] option The option.
+ * @param[in] problem What is wrong with it.
+ * @return ERROR_INVALID_INPUT.
+ */
+static errorCode_t _badOption(const char *program, const char *option, const char *problem);
+
+/**
+ * @brief Checks whether an error means the robot or the output can no longer be relied on.
+ * @param[in] error The error code.
+ * @return true for serial read, write and timeout errors, a lost controller state, and output
+ *         write errors.
+ */
+static inline bool _isFatal(const errorCode_t error);
+
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DEFINITIONS                       //
 ///////////////////////////////////////////////////////////////////////
 
 /**
  * @details
- * This function flushes the standard input, requests a text height from the user,
- * and validates that it falls within the permitted range. If valid, the height is
- * converted into a scale factor based on the default character space.
+ * Arguments that do not start with '-' are text files. They are moved to the front of `argv`,
+ * which is safe because an argument is only ever moved to a position that has been read already.
+ * Options that take a value read it from the next argument. Each file is given the height in
+ * force when it is read; the first height given is also set for the files read before it.
+ */
+errorCode_t ParseArguments(const int argc, char *argv[], options_t *const options)
+{
+    options->fontFile = NULL;                           // Embedded font
+    options->height = 0.0;                              // Ask for the height
+    options->numOutputs = 0;                            // Write to stdout
+    options->quiet = false;                             // Unless asked not to
+    options->port = NULL;                               // Default port
+    options->files = &argv[1];                          // Text files are collected here
+    options->heights = calloc(argc, sizeof(double));    // Heights of the files
+    options->numFiles = 0;                              // Ask for a file
+    options->help = false;                              // Run
+    options->dryRun = getenv(DRY_RUN_ENV) != NULL;      // Drive the robot unless asked not to
+    options->streaming = STREAMING_MODE;                // Default transfer mode
+    options->compact = GCODE_COMPACT;                   // Default writer mode
+    options->decimals = GCODE_DECIMALS;                 // Default precision
+    options->optimise = PATH_OPTIMISE;                  // Default stroke order
+    options->serpentine = SERPENTINE_MODE;              // Default line order
+    options->proportional = PROPORTIONAL_MODE;          // Default spacing
+    options->balance = BALANCE_MODE;                    // Default line breaking
+    options->simplify = SIMPLIFY_MODE;                  // Default simplification
+    options->simplifyTolerance = SIMPLIFY_TOLERANCE_MM; // Default simplification tolerance
+    options->arcs = ARC_FIT_MODE;                       // Default arc fitting
+    options->arcTolerance = ARC_TOLERANCE_MM;           // Default arc tolerance
+    options->model = DefaultMotionModel();              // Default machine
+    options->numPageCommands = 0;                       // Default page change, unless
+    options->pagePause = PAGE_PAUSE_S;                  // a dwell replaces it
+    options->boundsTolerance = PREFLIGHT_TOLERANCE_MM;  // Default bounds tolerance
+
+    if (!options->heights)                     // Check if memory allocation failed
+        return ERROR_MEMORY_ALLOCATION_FAILED; // Return error
+
+    const char *program = argv[0]; // Name for messages
+    bool optionsDone = false;      // true after "--"
+    for (int i = 1; i < argc; i++) // Every argument
+    {
+        const char *arg = argv[i];                   // Argument
+        if (optionsDone || arg[0] != '-' || !arg[1]) // Check if it is a text file ("-" is one too)
+        {
+            options->heights[options->numFiles] = options->height; // Height in force
+            options->files[options->numFiles++] = argv[i];         // Collect it
+            continue;                                              // Next argument
+        }
+
+        // Options without a value
+        if (strcmp(arg, "--") == 0)                                       // End of options
+            optionsDone = true;                                           // Rest are files
+        else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)    // Usage
+            options->help = true;                                         // Print it
+        else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--dry-run") == 0) // Dry run
+            options->dryRun = true;                                       // Open no port
+        else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0)   // No G-code on stdout
+            options->quiet = true;                                        // Write to a null sink
+        else if (strcmp(arg, "--no-streaming") == 0)                      // Wait for each reply
+            options->streaming = false;                                   // Set transfer mode
+        else if (strcmp(arg, "--compact") == 0)                           // Modal compression
+            options->compact = true;                                      // Set writer mode
+        else if (strcmp(arg, "--optimise") == 0)                          // Reordered strokes
+            options->optimise = true;                                     // Set stroke order
+        else if (strcmp(arg, "--no-optimise") == 0)                       // Font order
+            options->optimise = false;                                    // Set stroke order
+        else if (strcmp(arg, "--serpentine") == 0)                        // Serpentine lines
+            options->serpentine = true;                                   // Set line order
+        else if (strcmp(arg, "--proportional") == 0)                      // Proportional spacing
+            options->proportional = true;                                 // Set spacing
+        else if (strcmp(arg, "--balance") == 0)                           // Balanced lines
+            options->balance = true;                                      // Set line breaking
+        else if (strcmp(arg, "--no-simplify") == 0)                       // Every stroke
+            options->simplify = false;                                    // Set simplification
+        else if (!_takesValue(arg))                                       // Unknown option
+            return _badOption(program, arg, "is not an option");          // Report it
+        else                                                              // Option with a value
+        {
+            if (i + 1 >= argc)                                    // Check if the value is missing
+                return _badOption(program, arg, "needs a value"); // Report it
+            const char *value = argv[++i];                        // Value
+            double number = 0.0;                                  // Value as a number
+            const bool isNumber = _readNumber(value, &number);    // Read it
+            const bool isPositive = isNumber && number > 0.0;     // Rates and limits must be positive
+            const bool isDistance = isNumber && number >= 0.0;    // Tolerances and delays may be 0
+
+            if (strcmp(arg, "-f") == 0 || strcmp(arg, "--font") == 0)         // Font file
+                options->fontFile = value;                                    // Set font
+            else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) // Output file
+            {
+                if (options->numOutputs == MAX_OUTPUTS)                         // Check if there is room
+                    return _badOption(program, arg, "is given too many times"); // Report it
+                options->outputs[options->numOutputs++] = value;                // Add output, "-" for stdout
+            }
+            else if (strcmp(arg, "--page-gcode") == 0)                        // Page command
+            {
+                if (options->numPageCommands == MAX_PAGE_COMMANDS)              // Check if there is room
+                    return _badOption(program, arg, "is given too many times"); // Report it
+                if (strlen(value) + 1 > PAGE_COMMAND_LENGTH)                    // Check if it fits a line
+                    return _badOption(program, arg, "is too long for a line");  // Report it
+                options->pageCommands[options->numPageCommands++] = value;      // Add command
+            }
+            else if (strcmp(arg, "-p") == 0 || strcmp(arg, "--port") == 0)    // Serial device
+                options->port = value;                                        // Set port
+            else if (strcmp(arg, "-H") == 0 || strcmp(arg, "--height") == 0)  // Text height
+            {
+                double scale;                                                       // Scale it gives
+                if (!isNumber || HeightToScale(number, &scale) != SUCCESS)          // Check if the height is allowed
+                    return _badOption(program, arg, "must be between 4 and 10 mm"); // Report it
+                for (int file = 0; file < options->numFiles; file++)                // Files read so far
+                    if (options->heights[file] == 0.0)                              // Check if they have no height yet
+                        options->heights[file] = number;                            // Give them this one
+                options->height = number;                                           // Set height
+            }
+            else if (strcmp(arg, "--decimals") == 0) // Precision
+            {
+                if (!isNumber || number < 0 || number > GCODE_MAX_DECIMALS || number != (int)number) // Check if the count is allowed
+                    return _badOption(program, arg, "must be a whole number from 0 to 6");           // Report it
+                options->decimals = (int)number;                                                     // Set precision
+            }
+            else if (strcmp(arg, "--simplify") == 0 && isDistance) // Simplification tolerance
+            {
+                options->simplify = true;            // Simplify
+                options->simplifyTolerance = number; // Set tolerance
+            }
+            else if (strcmp(arg, "--arcs") == 0 && isDistance) // Arc fitting tolerance
+            {
+                options->arcs = true;           // Fit arcs
+                options->arcTolerance = number; // Set tolerance
+            }
+            else if (strcmp(arg, "--feed") == 0 && isPositive)                                      // Feed rate
+                options->model.feedRate = number;                                                   // Set feed rate
+            else if (strcmp(arg, "--max-rate") == 0 && isPositive)                                  // Maximum rate
+                options->model.maxRate = number;                                                    // Set maximum rate
+            else if (strcmp(arg, "--acceleration") == 0 && isPositive)                              // Acceleration
+                options->model.acceleration = number;                                               // Set acceleration
+            else if (strcmp(arg, "--junction-deviation") == 0 && isDistance)                        // Junction deviation
+                options->model.junctionDeviation = number;                                          // Set junction deviation
+            else if (strcmp(arg, "--pen-delay") == 0 && isDistance)                                 // Pen delay
+                options->model.penDelay = number;                                                   // Set pen delay
+            else if (strcmp(arg, "--page-pause") == 0 && isDistance)                                // Page dwell
+                options->pagePause = number;                                                        // Set dwell
+            else if (strcmp(arg, "--bounds-tolerance") == 0 && isDistance)                          // Bounds tolerance
+                options->boundsTolerance = number;                                                  // Set tolerance
+            else                                                                                    // Number out of range
+                return _badOption(program, arg, "needs a number, at least 0 or above 0 for rates"); // Report it
+        }
+    }
+
+    if (options->numPageCommands == 0 && options->pagePause <= 0.0)            // Check if nothing replaces the default
+        options->pageCommands[options->numPageCommands++] = PAGE_CHANGE_GCODE; // Pause for the paper
+    return SUCCESS;                                                            // Return success
+}
+
+void PrintUsage(FILE *const file, const char *program)
+{
+    fprintf(file,
+            "Usage: %s [options] [text file...]\n"
+            "Draws each text file as a job of its own; asks for the height and a file if they are not given.\n"
+            "\n"
+            "  -f, --font FILE            text or binary font file instead of the embedded %s\n"
+            "  -H, --height MM            text height, 4 to 10 mm, of the files after it;\n"
+            "                             the first height also sets the files before it\n"
+            "  -o, --output FILE          write the G-code to FILE instead of stdout, \"-\" for stdout;\n"
+            "                             up to 4 outputs may be given\n"
+            "  -q, --quiet                write the G-code nowhere unless -o is given\n"
+            "  -p, --port DEVICE          serial device of the robot\n"
+            "  -n, --dry-run              estimate the jobs without opening the port\n"
+            "      --no-streaming         wait for each reply instead of streaming\n"
+            "      --compact              leave out words the controller already holds\n"
+            "      --decimals N           decimals of the coordinates, 0 to 6 (default 2)\n"
+            "      --optimise             reorder the strokes of each page to cut pen-up travel\n"
+            "      --no-optimise          draw the strokes in font order (default)\n"
+            "      --serpentine           draw line by line, every second line right to left\n"
+            "      --proportional         space letters by their width instead of a fixed space\n"
+            "      --balance              break each paragraph into lines of even length\n"
+            "      --no-simplify          send every stroke as it is (default)\n"
+            "      --simplify MM          merge collinear strokes and simplify with this tolerance,\n"
+            "                             0 for the exact merge only\n"
+            "      --arcs MM              send curved strokes as arcs with this tolerance\n"
+            "      --feed MM/MIN          feed rate for the estimate (default 1000)\n"
+            "      --max-rate MM/MIN      maximum rate of each axis for the estimate (default 1000)\n"
+            "      --acceleration MM/S2   acceleration of each axis for the estimate (default 10)\n"
+            "      --junction-deviation MM  junction deviation for the estimate (default 0.01)\n"
+            "      --pen-delay S          time the pen takes to go up or down (default 0)\n"
+            "      --page-gcode LINE      G-code to send between pages instead of M0;\n"
+            "                             up to 4 lines may be given\n"
+            "      --page-pause S         dwell between pages instead of M0, after any --page-gcode\n"
+            "      --bounds-tolerance MM  reject a job whose strokes leave the page by more (default 2)\n"
+            "  -h, --help                 print this help\n",
+            program, fontEmbeddedSource);
+}
+
+/**
+ * @details
+ * Outputs are opened in the order given, and each one is teed behind the ones before it, so the
+ * first output given is written first. If one cannot be opened the ones already open are freed.
+ */
+errorCode_t OpenOutput(const options_t *const options, gcodeSink_t **sink)
+{
+    if (options->numOutputs == 0) // Check if no output was given
+    {
+        *sink = options->quiet ? gcodeNullSinkConstructor() : gcodeFileSinkConstructor(stdout, false); // Default output
+        return *sink ? SUCCESS : ERROR_MEMORY_ALLOCATION_FAILED;                                       // Return result
+    }
+
+    *sink = NULL;                                 // Nothing open yet
+    for (int i = 0; i < options->numOutputs; i++) // Every output
+    {
+        const char *name = options->outputs[i];               // File name
+        gcodeSink_t *target = NULL;                           // Sink of the output
+        if (strcmp(name, "-") == 0)                           // Check if it is stdout
+            target = gcodeFileSinkConstructor(stdout, false); // Write to stdout
+        else                                                  // Output file
+        {
+            FILE *file = fopen(name, "w"); // Create file
+            if (!file)                     // Check if file cannot be created
+            {
+                perror(name);             // Report it
+                if (*sink)                // Check if outputs are open
+                    (*sink)->free(*sink); // Free them
+                *sink = NULL;             // Forget them
+                return ERROR_OPEN_FILE;   // Return error
+            }
+            target = gcodeFileSinkConstructor(file, true); // Write to the file
+            if (!target)                                   // Check if sink is NULL
+                fclose(file);                              // Close file
+        }
+
+        *sink = *sink ? gcodeTeeSinkConstructor(*sink, target) : target; // Join it to the others
+        if (!*sink)                                                      // Check if joining failed
+            return ERROR_MEMORY_ALLOCATION_FAILED;                       // Return error
+    }
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * The height is checked against the permitted range and converted into a scale factor based on
+ * the default character space.
+ */
+errorCode_t HeightToScale(const double height, double *scale)
+{
+    if (height < MINIMUM_TEXT_HEIGHT_MM || height > MAXIMUM_TEXT_HEIGHT_MM) // Check if height is valid
+        return ERROR_INVALID_SCALE_INPUT;                                   // Report it to the caller
+
+    *scale = height / CHARACTER_SPACE_MM; // Calculate scale factor
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * This function requests a text height from the user and validates that it falls within the
+ * permitted range. If valid, the height is converted into a scale factor. The rest of the line
+ * is discarded either way, so a wrong answer is not read again.
  */
 errorCode_t GetUserScale(double *scale)
 {
     double height;                                       // Desired text height in millimeters
-    fflush(stdin);                                       // Flush standard input
     printf("Enter the desired text height (4-10 mm): "); // Prompt user for text height
 
-    if (scanf("%lf", &height) != 1 || height < MINIMUM_TEXT_HEIGHT_MM || height > MAXIMUM_TEXT_HEIGHT_MM) // Check if input is valid
-        return ErrorHandler(ERROR_INVALID_SCALE_INPUT);                                                   // Handle error
+    const int read = scanf("%lf", &height);       // Read height
+    int ch;                                       // Rest of the line
+    while ((ch = getchar()) != '\n' && ch != EOF) // Discard it
+        ;
+    if (read == EOF)                               // Check if the input has ended
+        return ErrorHandler(ERROR_UNEXPECTED_EOF); // Handle error
 
-    *scale = height / CHARACTER_SPACE_MM; // Calculate scale factor
-    return SUCCESS;                       // Return success
+    if (read != 1 || HeightToScale(height, scale) != SUCCESS) // Check if input is valid
+        return ErrorHandler(ERROR_INVALID_SCALE_INPUT);       // Handle error
+    return SUCCESS;                                           // Return success
 }
 
 /**
  * @details
- * This function flushes the standard input, requests a file name from the user, and
- * tries to open the specified file in read mode. If successful, it returns a pointer
- * to the opened file.
+ * This function requests a file name from the user, skipping empty lines, and tries to open the
+ * specified file in read mode. If successful, it returns a pointer to the opened file. Characters
+ * beyond FILE_NAME_LENGTH - 1 are discarded with the rest of the line.
  */
 errorCode_t GetUserFile(FILE **file)
 {
-    char filename[100];                  // Buffer to hold file name
-    fflush(stdin);                       // Flush standard input
+    char filename[FILE_NAME_LENGTH];     // Buffer to hold file name
     printf("Enter file name to read: "); // Prompt user for file name
-    scanf("%s", filename);               // Read file name
+
+    int ch;                                        // Character read
+    while ((ch = getchar()) != EOF && isspace(ch)) // Skip the end of the previous answer
+        ;
+    if (ch == EOF)                                 // Check if the input has ended
+        return ErrorHandler(ERROR_UNEXPECTED_EOF); // Handle error
+
+    size_t length = 0;                            // Characters kept
+    while (ch != '\n' && ch != '\r' && ch != EOF) // Until the end of the line
+    {
+        if (length < sizeof(filename) - 1) // Check if there is room
+            filename[length++] = (char)ch; // Keep the character
+        ch = getchar();                    // Next character
+    }
+    filename[length] = '\0'; // Terminate file name
 
     *file = fopen(filename, "r");             // Open file
     if (!*file)                               // Check if file cannot be opened
@@ -54,13 +376,98 @@ errorCode_t GetUserFile(FILE **file)
     return SUCCESS; // Return success
 }
 
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static bool _takesValue(const char *option)
+{
+    for (size_t i = 0; i < sizeof(valueOptions) / sizeof(valueOptions[0]); i++) // Every option with a value
+        if (strcmp(option, valueOptions[i]) == 0)                               // Check if it matches
+            return true;                                                        // Takes a value
+    return false;                                                               // Does not
+}
+
+static bool _readNumber(const char *text, double *const value)
+{
+    char *end; // First character not read
+    *value = strtod(text, &end);          // Read number
+    return end != text && *end == '\0'; // Whole argument read
+}
+
+static errorCode_t _badOption(const char *program, const char *option, const char *problem)
+{
+    fprintf(stderr, "%s: %s %s\n", program, option, problem); // Report option
+    PrintUsage(stderr, program);                              // Show usage
+    return ERROR_INVALID_INPUT;                               // Return error
+}
+
+static inline bool _isFatal(const errorCode_t error)
+{
+    return error == ERROR_SERIAL_READ || error == ERROR_SERIAL_WRITE || error == ERROR_SERIAL_TIMEOUT || // Robot lost
+           error == ERROR_CONTROLLER_STATE || error == ERROR_OUTPUT_WRITE;                              // or its state, or output
+}
+
 ///////////////////////////////////////////////////////////////////////
 //                       MAIN PROGRAM ENTRY                          //
 ///////////////////////////////////////////////////////////////////////
 
-int main(void)
+int main(int argc, char *argv[])
 {
+    // Read the command line
+    options_t options;
+    if (ParseArguments(argc, argv, &options) != SUCCESS)
+        exit(EXIT_FAILURE);
+    if (options.help)
+    {
+        PrintUsage(stdout, argv[0]);
+        return 0;
+    }
+
+    // Load the font once for every job, and scale its characters as they are drawn
     fontData_t *fontData = fontDataConstructor();
+    if (!fontData)
+        exit(EXIT_FAILURE);
+    if (options.fontFile ? fontData->parse(fontData, options.fontFile) != SUCCESS
+                         : fontData->attach(fontData, &fontEmbedded) != SUCCESS)
+        exit(EXIT_FAILURE);
+    glyphCache_t *glyphs = glyphCacheConstructor(fontData);
+    if (!glyphs)
+        exit(EXIT_FAILURE);
+
+    // Ask the user for the desired text height unless it was given
+    double scale;
+    if (options.height > 0.0)
+        HeightToScale(options.height, &scale);
+    else
+    {
+        errorCode_t error;
+        while ((error = GetUserScale(&scale)) == ERROR_INVALID_SCALE_INPUT)
+            ;
+        if (error != SUCCESS)
+            exit(EXIT_FAILURE);
+    }
+
+    // Open the outputs
+    gcodeSink_t *output = NULL;
+    if (OpenOutput(&options, &output) != SUCCESS)
+        exit(EXIT_FAILURE);
+    SetOutput(output);
+
+    // Apply the drawing options
+    SetDryRun(options.dryRun);
+    SetSerialPort(options.port);
+    SetStreamingMode(options.streaming);
+    SetGcodeFormat(options.compact, options.decimals);
+    SetPathOptimise(options.optimise);
+    SetSerpentine(options.serpentine);
+    SetProportional(options.proportional);
+    SetBalance(options.balance);
+    SetSimplify(options.simplify, options.simplifyTolerance);
+    SetArcFitting(options.arcs, options.arcTolerance);
+    SetMotionModel(options.model);
+    SetPageChange(options.pageCommands, options.numPageCommands, options.pagePause);
+    SetBoundsTolerance(options.boundsTolerance);
 
 #ifdef Serial_Mode
     // Start up the robot
@@ -68,33 +475,79 @@ int main(void)
         exit(EXIT_FAILURE);
 #endif
 
-    // Parse the font file
-    if (fontData->parse(fontData, FONT_FILE) != SUCCESS)
-        exit(EXIT_FAILURE);
+    // Ask the user for a text file unless files were given
+    FILE *file = NULL;
+    if (options.numFiles == 0)
+    {
+        errorCode_t error;
+        while ((error = GetUserFile(&file)) == ERROR_OPEN_FILE)
+            ;
+        if (error != SUCCESS)
+            exit(EXIT_FAILURE);
+    }
 
-    // Ask the user for the desired text height
-    double scale;
-    while (GetUserScale(&scale) != SUCCESS)
-        ;
+    // Draw every text file as a job of its own
+    int failed = 0;
+    const int jobs = options.numFiles > 0 ? options.numFiles : 1;
+    for (int job = 0; job < jobs; job++)
+    {
+        const char *name = options.numFiles > 0 ? options.files[job] : NULL;
+        if (name)
+        {
+            file = strcmp(name, "-") == 0 ? stdin : fopen(name, "r");
+            if (!file)
+            {
+                perror(name);
+                failed++;
+                continue;
+            }
+        }
 
-    // Scale the font data
-    if (fontData->scale(fontData, scale) != SUCCESS)
-        exit(EXIT_FAILURE);
+        // Draw at the height of the file, or the one asked for
+        double jobScale = scale;
+        if (name && options.heights[job] > 0.0)
+            HeightToScale(options.heights[job], &jobScale);
 
-    // Process the text file
-    FILE *file = NULL;
-    while (GetUserFile(&file) != SUCCESS)
-        ;
+        if (name && jobs > 1)
+            fprintf(stderr, "Job %s:\n", name);
+        ResetJobStats();
+        const errorCode_t error = process_text_file(glyphs, file, jobScale);
+        if (file == stdin)
+            clearerr(stdin); // Let a later "-" or prompt read on after the end of this text
+        else
+            fclose(file);
+        file = NULL;
+        if (error != SUCCESS && !_isFatal(error))
+            HomeRobot(); // Start the next job at home
+        PrintJobStats(stderr);
 
-    // Process the text file
-    if (process_text_file(fontData, file) != SUCCESS)
-        exit(EXIT_FAILURE);
+        if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY)
+            failed++;
+        if (_isFatal(error))
+        {
+            failed += jobs - job - 1; // The jobs after it never ran
+            break;
+        }
+    }
+    if (jobs > 1)
+        fprintf(stderr, "Batch: %d of %d jobs done\n", jobs - failed, jobs);
+
+#ifdef Serial_Mode
+    // Wait for the robot to finish and close the port
+    if (ShutDownRobot() != SUCCESS)
+        failed++;
+#endif
 
-    fclose(file);
+    // Close the outputs
+    SetOutput(NULL);
+    if (output->free(output) != SUCCESS)
+        failed++;
 
-    // Free the font data
+    // Free the glyph cache and the font data
+    glyphs->free(glyphs);
+    free(options.heights);
     if (fontData->free(fontData) != SUCCESS)
         exit(EXIT_FAILURE);
 
-    return 0;
+    return failed ? EXIT_FAILURE : 0;
 }
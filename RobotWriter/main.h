@@ -5,33 +5,128 @@
  * This header file consolidates the necessary includes and defines for controlling the robot and
  * processing font data. It includes references to the RS232 and serial communication libraries,
  * the font data structures and functions, the G-code generation utilities, and the robot control
- * functionality. It also defines the default baud rate for communication with the robot.
+ * functionality. It also declares the command-line options and the functions that read them.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 #pragma once
 
+#include <stdbool.h>
+
 #include "lib/rs232.h"
 #include "lib/serial.h"
 
 #include "font/fontData.h"
+#include "font/fontEmbedded.h"
 #include "robot/gcode.h"
 #include "robot/robot.h"
 #include "misc/error.h"
 
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define DRY_RUN_ENV "ROBOTWRITER_DRY_RUN" /**< Environment variable that selects a dry run when set. */
+#define FILE_NAME_LENGTH 256              /**< Longest file name read by GetUserFile(), including the terminator. */
+#define MAX_OUTPUTS 4                     /**< Most outputs the G-code can be written to at once. */
+
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DECLARATIONS                      //
 ///////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief Settings taken from the command line.
+ * @details Settings that are not given keep the defaults of robot.h, gcodeFormat.h and estimate.h.
+ */
+typedef struct options_s
+{
+    const char *fontFile;   /**< Font file to load, NULL for the embedded font. */
+    double height;          /**< Text height in mm given last, 0 to ask for it. */
+    const char *port;       /**< Serial device to open, NULL for the default. */
+    char **files;           /**< Text files to draw, one job each. */
+    double *heights;        /**< Text height of each file in mm, 0 to ask for it. */
+    int numFiles;           /**< Number of text files, 0 to ask for one. */
+    bool help;              /**< true to print the usage and stop. */
+
+    const char *outputs[MAX_OUTPUTS]; /**< Files the G-code is written to, "-" for stdout. */
+    int numOutputs;                   /**< Number of outputs, 0 for stdout alone. */
+    bool quiet;                       /**< true to write the G-code nowhere when no output is given. */
+
+    bool dryRun;              /**< true to estimate the jobs without opening the port. */
+    bool streaming;           /**< true to stream with character counting. */
+    bool compact;             /**< true for modal G-code compression. */
+    int decimals;             /**< Number of decimals for coordinates. */
+    bool optimise;            /**< true to reorder the strokes of a page. */
+    bool serpentine;          /**< true to draw line by line in serpentine order. */
+    bool proportional;        /**< true to space letters by the width of their ink. */
+    bool balance;             /**< true to balance the lines of each paragraph. */
+    bool simplify;            /**< true to simplify pen-down strokes. */
+    double simplifyTolerance; /**< Douglas-Peucker tolerance in mm. */
+    bool arcs;                /**< true to fit arcs. */
+    double arcTolerance;      /**< Arc fitting tolerance in mm. */
+    motionModel_t model;      /**< Machine settings for the estimate. */
+
+    const char *pageCommands[MAX_PAGE_COMMANDS]; /**< Commands sent between pages. */
+    int numPageCommands;                         /**< Number of commands sent between pages. */
+    double pagePause;                            /**< Dwell in s sent between pages, 0 for none. */
+    double boundsTolerance;                      /**< Distance in mm a stroke may leave the drawing area by. */
+} options_t;
+
+/**
+ * @brief Reads the command-line options.
+ * @details Options start with '-' and come before or between the text files; "--" ends them.
+ *          A height applies to the files after it, and the first height also to the files
+ *          before it. An option that is not known, or a value that is missing or cannot be
+ *          read, is reported on stderr together with the usage. Without page commands or a
+ *          dwell, PAGE_CHANGE_GCODE is sent between pages.
+ * @param[in] argc Number of arguments.
+ * @param[in,out] argv The arguments, starting with the program name; the text files are moved
+ *                  to the front, after the program name.
+ * @param[out] options The settings; `files` points into `argv`, and `heights` is allocated and
+ *                     must be freed by the caller.
+ * @return SUCCESS, ERROR_INVALID_INPUT if an option is wrong, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+errorCode_t ParseArguments(const int argc, char *argv[], options_t *const options);
+
+/**
+ * @brief Prints the command-line usage.
+ * @param[in] file Stream to print to.
+ * @param[in] program Name the program was started with.
+ */
+void PrintUsage(FILE *const file, const char *program);
+
+/**
+ * @brief Builds the sink the G-code is written to.
+ * @details Several outputs are joined with tees. Without outputs the G-code goes to stdout, or
+ *          to a null sink if `quiet` is set.
+ * @param[in] options The settings.
+ * @param[out] sink The sink; NULL if it could not be built.
+ * @return SUCCESS, ERROR_OPEN_FILE if an output file cannot be created, or
+ *         ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+errorCode_t OpenOutput(const options_t *const options, gcodeSink_t **sink);
+
+/**
+ * @brief Converts a text height into a scale factor.
+ * @param[in] height Text height in millimeters.
+ * @param[out] scale Pointer to a double where the computed scale factor will be stored.
+ * @return SUCCESS, or ERROR_INVALID_SCALE_INPUT if the height is outside the permitted range.
+ */
+errorCode_t HeightToScale(const double height, double *scale);
+
 /**
  * @brief Prompts the user to enter a desired text height and converts it into a scale factor.
  * @param[out] scale Pointer to a double where the computed scale factor will be stored.
- * @return SUCCESS if a valid scale is obtained, or ERROR_INVALID_SCALE_INPUT if the input is invalid.
+ * @return SUCCESS if a valid scale is obtained, ERROR_INVALID_SCALE_INPUT if the input is invalid,
+ *         or ERROR_UNEXPECTED_EOF if the input has ended.
  */
 errorCode_t GetUserScale(double *scale);
 
 /**
  * @brief Prompts the user for a file name and attempts to open it for reading.
+ * @details The whole line is read as the file name, so it may contain spaces, and at most
+ *          FILE_NAME_LENGTH - 1 characters of it are kept.
  * @param[out] file Pointer to a FILE* where the opened file pointer will be stored.
- * @return SUCCESS on successfully opening the file, or ERROR_OPEN_FILE if the file cannot be opened.
+ * @return SUCCESS on successfully opening the file, ERROR_OPEN_FILE if the file cannot be opened,
+ *         or ERROR_UNEXPECTED_EOF if the input has ended.
  */
 errorCode_t GetUserFile(FILE **file);
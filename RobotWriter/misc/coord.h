@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <math.h>
+
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DECLARATIONS                      //
 ///////////////////////////////////////////////////////////////////////
@@ -110,3 +112,41 @@ static inline Coord2D_t ScaleCoord2D(const Coord2D_t a, const double scale)
     result.y = a.y * scale;
     return result;
 }
+
+/**
+ * @brief Calculates the distance between two 2D coordinates.
+ *
+ * @param[in] a The first 2D coordinate.
+ * @param[in] b The second 2D coordinate.
+ * @return The Euclidean distance from a to b.
+ */
+static inline double DistanceCoord2D(const Coord2D_t a, const Coord2D_t b)
+{
+    const double dx = a.x - b.x;
+    const double dy = a.y - b.y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * @brief Calculates the dot product of two 2D vectors.
+ *
+ * @param[in] a The first 2D vector.
+ * @param[in] b The second 2D vector.
+ * @return a.x * b.x + a.y * b.y.
+ */
+static inline double DotCoord2D(const Coord2D_t a, const Coord2D_t b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+/**
+ * @brief Calculates the cross product of two 2D vectors.
+ *
+ * @param[in] a The first 2D vector.
+ * @param[in] b The second 2D vector.
+ * @return a.x * b.y - a.y * b.x, positive if b turns left from a.
+ */
+static inline double CrossCoord2D(const Coord2D_t a, const Coord2D_t b)
+{
+    return a.x * b.y - a.y * b.x;
+}
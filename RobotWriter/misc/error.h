@@ -90,6 +90,31 @@
  *
  * @var errorCode_e::ERROR_PARSE_CHARACTER
  * Indicates that parsing a character definition failed.
+ *
+ * @var errorCode_e::ERROR_SERIAL_READ
+ * Indicates that reading from the serial port failed.
+ *
+ * @var errorCode_e::ERROR_CONTROLLER_REPLY
+ * Indicates that the controller answered a command with an error.
+ *
+ * @var errorCode_e::ERROR_SERIAL_TIMEOUT
+ * Indicates that the controller did not reply within the serial timeout.
+ *
+ * @var errorCode_e::ERROR_SERIAL_WRITE
+ * Indicates that writing to the serial port failed.
+ *
+ * @var errorCode_e::ERROR_OUTPUT_WRITE
+ * Indicates that writing the G-code output failed.
+ *
+ * @var errorCode_e::ERROR_FONT_WRITE
+ * Indicates that writing a binary font file failed.
+ *
+ * @var errorCode_e::ERROR_TEXT_READ
+ * Indicates that reading a text file failed partway through.
+ *
+ * @var errorCode_e::ERROR_CONTROLLER_STATE
+ * Indicates that the controller rejected a command that sets up its state, or so many commands
+ * in a row that its state can no longer be relied on.
  */
 typedef enum errorCode_e
 {
@@ -115,7 +140,15 @@ typedef enum errorCode_e
     ERROR_APPEND_STROKE,            /**< Error appending stroke to character. */
     ERROR_PARSE_STROKE,             /**< Error parsing stroke definition. */
     ERROR_UNEXPECTED_EOF,           /**< Unexpected end-of-file encountered. */
-    ERROR_PARSE_CHARACTER           /**< Error parsing character definition. */
+    ERROR_PARSE_CHARACTER,          /**< Error parsing character definition. */
+    ERROR_SERIAL_READ,              /**< Error reading from the serial port. */
+    ERROR_CONTROLLER_REPLY,         /**< Controller answered a command with an error. */
+    ERROR_SERIAL_TIMEOUT,           /**< Controller did not reply in time. */
+    ERROR_SERIAL_WRITE,             /**< Error writing to the serial port. */
+    ERROR_OUTPUT_WRITE,             /**< Error writing the G-code output. */
+    ERROR_FONT_WRITE,               /**< Error writing a binary font file. */
+    ERROR_TEXT_READ,                /**< Error reading a text file. */
+    ERROR_CONTROLLER_STATE          /**< Controller rejected a command its state depends on. */
 } errorCode_t;
 
 ///////////////////////////////////////////////////////////////////////
@@ -203,6 +236,30 @@ static inline errorCode_t ErrorHandler(const errorCode_t error)
     case ERROR_PARSE_CHARACTER:
         perror("Error parsing character ");
         break;
+    case ERROR_SERIAL_READ:
+        perror("Error reading from serial port ");
+        break;
+    case ERROR_CONTROLLER_REPLY:
+        fputs("Controller reported an error\n", stderr);
+        break;
+    case ERROR_SERIAL_TIMEOUT:
+        fputs("Timed out waiting for controller\n", stderr);
+        break;
+    case ERROR_SERIAL_WRITE:
+        perror("Error writing to serial port ");
+        break;
+    case ERROR_OUTPUT_WRITE:
+        perror("Error writing G-code output ");
+        break;
+    case ERROR_FONT_WRITE:
+        perror("Error writing font file ");
+        break;
+    case ERROR_TEXT_READ:
+        perror("Error reading text file ");
+        break;
+    case ERROR_CONTROLLER_STATE:
+        fputs("Controller state lost\n", stderr);
+        break;
     default:
         /* No action for SUCCESS or unspecified errors. */
         break;
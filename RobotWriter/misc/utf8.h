@@ -0,0 +1,108 @@
+/**
+ * @file utf8.h
+ * @brief Provides inline functions for reading UTF-8 text one code point at a time.
+ * @details
+ * Text is read as UTF-8, of which ASCII is a part, so ASCII text reads exactly as it did. A byte
+ * sequence that is not valid UTF-8 — a stray continuation byte, a sequence cut short, an overlong
+ * form, a surrogate or a value past U+10FFFF — reads as UTF8_REPLACEMENT, and reading goes on
+ * after it, so damaged text is drawn with a placeholder rather than stopping the job.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UTF8_REPLACEMENT 0xFFFD /**< Code point read in place of an invalid sequence, U+FFFD. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Reads the code point of a multibyte UTF-8 sequence and moves past it.
+ * @details An invalid sequence is consumed up to the first byte that cannot continue it, or up to
+ *          the end of the text, and reads as UTF8_REPLACEMENT.
+ * @param[in,out] text Position in the text, at a byte of 0x80 or more, before its end.
+ * @param[in] end End of the text.
+ * @return The code point, or UTF8_REPLACEMENT.
+ */
+static inline uint32_t Utf8DecodeSequence(const char **const text, const char *const end)
+{
+    const unsigned char *p = (const unsigned char *)*text;
+    const unsigned char lead = *p++;
+
+    int length;
+    uint32_t codePoint;
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 1;
+        codePoint = lead & 0x1F;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 2;
+        codePoint = lead & 0x0F;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 3;
+        codePoint = lead & 0x07;
+    }
+    else
+    {
+        *text = (const char *)p;
+        return UTF8_REPLACEMENT;
+    }
+
+    for (int i = 0; i < length; i++, p++)
+    {
+        if (p == (const unsigned char *)end || (*p & 0xC0) != 0x80)
+        {
+            *text = (const char *)p;
+            return UTF8_REPLACEMENT;
+        }
+        codePoint = codePoint << 6 | (*p & 0x3F);
+    }
+    *text = (const char *)p;
+
+    const uint32_t minimum = length == 1 ? 0x80 : length == 2 ? 0x800 : 0x10000;
+    if (codePoint < minimum || (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+        return UTF8_REPLACEMENT;
+    return codePoint;
+}
+
+/**
+ * @brief Reads the code point at the start of UTF-8 text and moves past it.
+ * @details An ASCII byte is its own code point and is returned without decoding; anything else is
+ *          read by Utf8DecodeSequence().
+ * @param[in,out] text Position in the text, before its end.
+ * @param[in] end End of the text.
+ * @return The code point, or UTF8_REPLACEMENT.
+ */
+static inline uint32_t Utf8Decode(const char **const text, const char *const end)
+{
+    const unsigned char lead = (unsigned char)**text;
+    if (lead < 0x80)
+    {
+        ++*text;
+        return lead;
+    }
+    return Utf8DecodeSequence(text, end);
+}
+
+/**
+ * @brief Counts the characters of UTF-8 text, the bytes that are not continuation bytes.
+ * @details This is the number of code points Utf8Decode() reads from valid text.
+ * @param[in] text The text.
+ * @param[in] length Bytes of the text.
+ * @return The number of characters.
+ */
+static inline size_t Utf8Length(const char *const text, const size_t length)
+{
+    size_t characters = 0;
+    for (size_t i = 0; i < length; i++)
+        characters += ((unsigned char)text[i] & 0xC0) != 0x80;
+    return characters;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file arcFit.c
+ * @brief Implementation of the arc fitter.
+ * @details
+ * A candidate arc is the circle through the first, middle and last point of a run. The run is
+ * grown one point at a time for as long as the circle through its new first, middle and last
+ * point still fits every point and segment of it, and the longest run that fitted is returned.
+ * Glyph polylines are a few dozen points at most, so the quadratic cost of regrowing the fit
+ * does not matter.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "arcFit.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define ARC_PI 3.14159265358979323846 /**< Pi, math.h only provides M_PI as an extension. */
+#define ARC_MIN_SWEEP_GAP 1e-6        /**< Smallest angle in radians an arc must stay short of a full circle. */
+
+/**
+ * @brief Finds the circle through three points.
+ * @param[in] a First point.
+ * @param[in] b Second point.
+ * @param[in] c Third point.
+ * @param[out] arc Centre and radius of the circle, and the direction from a through b to c.
+ * @return false if the points lie on a straight line.
+ */
+static bool _circle(const Coord2D_t a, const Coord2D_t b, const Coord2D_t c, arc_t *const arc);
+
+/**
+ * @brief Checks whether a run of points lies on an arc.
+ * @param[in] points The points of the run.
+ * @param[in] last Index of the last point of the run.
+ * @param[in] tolerance Largest distance in mm between the run and the arc.
+ * @param[out] arc The arc through the first, middle and last point.
+ * @return true if the run fits the arc.
+ */
+static bool _fits(const Coord2D_t *const points, const size_t last, const double tolerance, arc_t *const arc);
+
+/**
+ * @brief Rounds a coordinate to the precision it is sent with.
+ * @param[in] value The coordinate.
+ * @param[in] scale Ten to the power of the number of decimals.
+ * @return The rounded coordinate.
+ */
+static inline Coord2D_t _round(const Coord2D_t value, const double scale);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The run is grown until it stops fitting; a longer run that would fit again after a point
+ * that does not is not looked for.
+ */
+size_t FitArc(const Coord2D_t *const points, const size_t count, const double tolerance, arc_t *const arc)
+{
+    size_t fitted = 0;                                           // Points on the best arc so far
+    for (size_t last = ARC_MIN_POINTS - 1; last < count; last++) // Grow the run
+    {
+        arc_t candidate;                                 // Arc through the run
+        if (!_fits(points, last, tolerance, &candidate)) // Check if the run still fits
+            break;                                       // Stop growing
+        *arc = candidate;                                // Keep the arc
+        fitted = last + 1;                               // and its length
+    }
+    return fitted; // Return number of points on the arc
+}
+
+/**
+ * @details
+ * The offset is rounded the same way as the coordinates, so the radii are compared exactly as
+ * GRBL will compare them.
+ */
+bool ArcCentreOffset(const Coord2D_t from, const Coord2D_t to, const Coord2D_t centre, const int decimals,
+                     Coord2D_t *const offset)
+{
+    const double scale = pow(10.0, decimals);           // Steps per mm
+    const Coord2D_t start = _round(from, scale);        // Position the controller holds
+    const Coord2D_t target = _round(to, scale);         // Target as sent
+    *offset = _round(SubCoord2D(centre, start), scale); // I and J as sent
+    if (start.x == target.x && start.y == target.y)     // Check if the target rounds onto the start
+        return false;                                   // Would be a full circle
+
+    const Coord2D_t origin = {0.0, 0.0};                                            // Start relative to itself
+    const double startRadius = DistanceCoord2D(origin, *offset);                    // Radius at the start
+    const double endRadius = DistanceCoord2D(target, AddCoord2D(start, *offset));   // Radius at the target
+    const double error = fabs(startRadius - endRadius);                             // Difference GRBL checks
+    return error <= ARC_RADIUS_ERROR_MM || error <= ARC_RADIUS_ERROR * startRadius; // Accepted if either holds
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The points are taken relative to a to keep the products small. The determinant is compared
+ * with the size of the triangle's sides, so nearly straight runs count as straight.
+ */
+static bool _circle(const Coord2D_t a, const Coord2D_t b, const Coord2D_t c, arc_t *const arc)
+{
+    const Coord2D_t ab = SubCoord2D(b, a);                        // b relative to a
+    const Coord2D_t ac = SubCoord2D(c, a);                        // c relative to a
+    const double d = 2.0 * CrossCoord2D(ab, ac);                  // Twice the signed area of the triangle
+    const double scale = DotCoord2D(ab, ab) + DotCoord2D(ac, ac); // Squared size of the triangle
+    if (fabs(d) <= 1e-12 * scale || scale == 0.0)                 // Check if the points are collinear
+        return false;                                             // No circle
+
+    const double ab2 = DotCoord2D(ab, ab);                   // Squared distance to b
+    const double ac2 = DotCoord2D(ac, ac);                   // Squared distance to c
+    const Coord2D_t centre = {(ac.y * ab2 - ab.y * ac2) / d, // Centre relative to a
+                              (ab.x * ac2 - ac.x * ab2) / d};
+    arc->centre = AddCoord2D(a, centre);           // Centre
+    arc->radius = DistanceCoord2D(a, arc->centre); // Radius
+    arc->clockwise = d < 0.0;                      // Turning right is clockwise
+    return true;                                   // Circle found
+}
+
+/**
+ * @details
+ * Every point must lie within the tolerance of the circle, every segment must advance around
+ * the centre in the arc's direction, and the bulge of the arc over each segment, its sagitta,
+ * must stay within the tolerance too. The angles are summed so that a run that closes on itself
+ * is not sent as an arc that the controller would read as a full circle.
+ */
+static bool _fits(const Coord2D_t *const points, const size_t last, const double tolerance, arc_t *const arc)
+{
+    if (!_circle(points[0], points[last / 2], points[last], arc)) // Circle through first, middle and last
+        return false;                                             // Straight run
+    if (arc->radius > ARC_MAX_RADIUS_MM)                          // Check if the run is nearly straight
+        return false;                                             // Better sent as straight moves
+
+    double sweep = 0.0;               // Angle swept so far
+    for (size_t i = 0; i < last; i++) // Every segment of the run
+    {
+        const Coord2D_t from = SubCoord2D(points[i], arc->centre);                       // Start relative to the centre
+        const Coord2D_t to = SubCoord2D(points[i + 1], arc->centre);                     // End relative to the centre
+        if (fabs(DistanceCoord2D(points[i + 1], arc->centre) - arc->radius) > tolerance) // Check if the point is off the circle
+            return false;                                                                // Does not fit
+
+        double angle = atan2(CrossCoord2D(from, to), DotCoord2D(from, to)); // Signed angle of the segment
+        if (arc->clockwise)                                                 // Clockwise arcs
+            angle = -angle;                                                 // turn the other way
+        if (angle <= 0.0)                                                   // Check if the segment turns back
+            return false;                                                   // Does not fit
+        sweep += angle;                                                     // Add it
+
+        const double half = DistanceCoord2D(points[i], points[i + 1]) / 2.0; // Half the chord
+        const double sagitta = half < arc->radius ? arc->radius - sqrt(arc->radius * arc->radius - half * half)
+                                                  : arc->radius; // Bulge of the arc over the chord
+        if (sagitta > tolerance)                                 // Check if the arc leaves the segment
+            return false;                                        // Does not fit
+    }
+    return sweep < 2.0 * ARC_PI - ARC_MIN_SWEEP_GAP; // Less than a full circle
+}
+
+/**
+ * @details
+ * round() matches the rounding of FormatFixed() except for values exactly half-way between two
+ * steps, where either result is within the tolerance GRBL allows.
+ */
+static inline Coord2D_t _round(const Coord2D_t value, const double scale)
+{
+    const Coord2D_t rounded = {round(value.x * scale) / scale, round(value.y * scale) / scale}; // Round both
+    return rounded;                                                                             // Return it
+}
@@ -0,0 +1,71 @@
+/**
+ * @file arcFit.h
+ * @brief Declarations of the arc fitter that replaces runs of G1 moves with G2/G3 arcs.
+ * @details
+ * The curves of the font, such as the bowls of 'O', 'S' and 'e', are drawn as polylines of
+ * short straight segments. Every segment is a G1 line that has to cross the serial line, and
+ * the controller may have to slow down at every junction between them. FitArc() looks for the
+ * longest run of points at the start of a polyline that lies on one circular arc within a
+ * tolerance, so the run can be sent as a single G2 or G3 move.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../misc/coord.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define ARC_MIN_POINTS 4          /**< Fewest points an arc must replace: three G1 moves become one. */
+#define ARC_MAX_RADIUS_MM 1000.0  /**< Largest radius fitted; flatter runs are left as straight moves. */
+#define ARC_RADIUS_ERROR_MM 0.005 /**< Difference between start and end radius GRBL accepts at any radius. */
+#define ARC_RADIUS_ERROR 0.001    /**< Difference between start and end radius GRBL accepts, relative to the radius. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A circular arc fitted through a run of points.
+ */
+typedef struct arc_s
+{
+    Coord2D_t centre; /**< Centre of the circle in mm. */
+    double radius;    /**< Radius of the circle in mm. */
+    bool clockwise;   /**< true for G2, false for G3. */
+} arc_t;
+
+/**
+ * @brief Finds the longest arc that starts at the first point of a polyline.
+ * @details The arc passes through the first and last point of the run. Every point of the run,
+ *          and every segment between two of them, stays within `tolerance` of the arc, the run
+ *          turns one way only and sweeps less than a full circle.
+ * @param[in] points The points of the polyline in drawing order.
+ * @param[in] count Number of points.
+ * @param[in] tolerance Largest distance in mm between the polyline and the arc.
+ * @param[out] arc The arc, valid if the return value is not 0.
+ * @return Number of points on the arc, including the first, or 0 if fewer than ARC_MIN_POINTS fit.
+ */
+size_t FitArc(const Coord2D_t *const points, const size_t count, const double tolerance, arc_t *const arc);
+
+/**
+ * @brief Calculates the centre offset of an arc as GRBL will read it, and checks that it is valid.
+ * @details The controller holds the start rounded to `decimals`, so the offset is taken from
+ *          there. GRBL computes the radius at both ends of the arc from the rounded start, target
+ *          and offset, and rejects the line with error 33 if they differ by more than
+ *          ARC_RADIUS_ERROR_MM and by more than ARC_RADIUS_ERROR of the radius. A target that
+ *          rounds onto the start would be read as a full circle, so it is rejected as well.
+ * @param[in] from Start of the arc.
+ * @param[in] to End of the arc.
+ * @param[in] centre Centre of the arc.
+ * @param[in] decimals Number of decimals the numbers are sent with.
+ * @param[out] offset I and J words: the centre relative to the rounded start.
+ * @return true if GRBL accepts the rounded arc.
+ */
+bool ArcCentreOffset(const Coord2D_t from, const Coord2D_t to, const Coord2D_t centre, const int decimals,
+                     Coord2D_t *const offset);
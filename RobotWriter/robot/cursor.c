@@ -17,10 +17,10 @@
 /**
  * @brief Checks if the given word would overflow the current cursor boundaries.
  * @param[in] self Pointer to the cursor structure.
- * @param[in] word The word to test for overflow.
+ * @param[in] width Width of the word up to its last character.
  * @return true if writing the word would cause overflow, false otherwise.
  */
-static inline bool _testWordOverflow(const cursor_t *const self, const char *const word);
+static inline bool _testWordOverflow(const cursor_t *const self, const double width);
 
 /**
  * @brief Checks if the current cursor position is within defined boundaries.
@@ -59,6 +59,14 @@ static errorCode_t _newline(cursor_t *const self);
  */
 static errorCode_t _update(cursor_t *const self);
 
+/**
+ * @brief Moves the cursor right by the width of a character.
+ * @param[in,out] self Pointer to the cursor structure.
+ * @param[in] width Width of the character.
+ * @return SUCCESS on success, or CURSOR_OUT_OF_BOUNDS if the new position is invalid.
+ */
+static errorCode_t _advance(cursor_t *const self, const double width);
+
 /**
  * @brief Moves the cursor to the start of the current line (carriage return).
  * @param[in,out] self Pointer to the cursor structure.
@@ -96,6 +104,8 @@ cursor_t cursorConstructor(double scale)
     cursor.minPosition.y = MIN_Y_VALUE_MM;                                       // Set minimum y position
     cursor.lineSpace = (CHARACTER_SPACE_MM * cursor.scale) + LINE_SPACE_MM;      // Set line space
     cursor.characterSpace = CHARACTER_SPACE_MM * cursor.scale;                   // Set character space
+    cursor.line = 0;                                                             // Start on the first line
+    cursor.page = 0;                                                             // Start on the first page
     cursor.init = true;                                                          // Set initialization state to true
 
     cursor.set = _set;                           // Set set function pointer
@@ -103,6 +113,7 @@ cursor_t cursorConstructor(double scale)
     cursor.newline = _newline;                   // Set newline function pointer
     cursor.carriagereturn = _carriagereturn;     // Set carriage return function pointer
     cursor.update = _update;                     // Set update function pointer
+    cursor.advance = _advance;                   // Set advance function pointer
     cursor.testWordOverflow = _testWordOverflow; // Set test word overflow function pointer
     return cursor;                               // Return cursor structure
 }
@@ -113,16 +124,15 @@ cursor_t cursorConstructor(double scale)
 
 /**
  * @details
- * This function checks the length of the given word, calculates how much horizontal
- * space it would require (based on character spacing and cursor scale), and determines
- * if adding this word would exceed the maximum allowed X position.
+ * The width is measured by the caller from the characters of the word, a character space each
+ * with fixed spacing or the metrics of each with proportional spacing. The word overflows if its
+ * last character, usually its delimiter, would start past the maximum allowed X position.
  */
-static inline bool _testWordOverflow(const cursor_t *const self, const char *const word)
+static inline bool _testWordOverflow(const cursor_t *const self, const double width)
 {
-    const int length = strlen(word) - 1;                                             // Get length of word
-    if ((self->posisiton.x + ((length)*self->characterSpace)) > self->maxPosition.x) // Check if word would overflow
-        return true;                                                                 // Return true if overflow
-    return false;                                                                    // Return false if no overflow
+    if ((self->posisiton.x + width) > self->maxPosition.x) // Check if word would overflow
+        return true;                                       // Return true if overflow
+    return false;                                          // Return false if no overflow
 }
 
 /**
@@ -182,15 +192,22 @@ static errorCode_t _move(cursor_t *const self, const Coord2D_t delta)
 /**
  * @details
  * Moves the cursor down one line. This involves setting the x-position to the minimum
- * x-bound and decreasing the y-position by the line spacing. If the new position is invalid,
- * it returns an error.
+ * x-bound and decreasing the y-position by the line spacing, and counting the line. A line that
+ * would start below the minimum y-bound starts at the top of a new page instead, which is counted
+ * too. If the new position is invalid, it returns an error.
  */
 static errorCode_t _newline(cursor_t *const self)
 {
     if (!self)
-        return ErrorHandler(ERROR_NULL_POINTER);                                      // Check if self is NULL
-    const Coord2D_t pos = {self->minPosition.x, self->posisiton.y - self->lineSpace}; // Set new position
-    return self->set(self, pos);                                                      // Return error
+        return ErrorHandler(ERROR_NULL_POINTER);                                // Check if self is NULL
+    self->line++;                                                               // Count the line
+    Coord2D_t pos = {self->minPosition.x, self->posisiton.y - self->lineSpace}; // Set new position
+    if (pos.y < self->minPosition.y)                                            // Check if the page is full
+    {
+        pos.y = self->maxPosition.y; // Top of the next page
+        self->page++;                // Count the page
+    }
+    return self->set(self, pos); // Return error
 }
 
 /**
@@ -218,3 +235,16 @@ static errorCode_t _update(cursor_t *const self)
     const Coord2D_t delta = {self->characterSpace, 0.0}; // Set delta to character space
     return self->move(self, delta);                      // Move cursor by delta
 }
+
+/**
+ * @details
+ * Moves the cursor right by the given width, with the same handling of the right edge as an
+ * update.
+ */
+static errorCode_t _advance(cursor_t *const self, const double width)
+{
+    if (!self)
+        return ErrorHandler(ERROR_NULL_POINTER); // Check if self is NULL
+    const Coord2D_t delta = {width, 0.0};        // Set delta to the width
+    return self->move(self, delta);              // Move cursor by delta
+}
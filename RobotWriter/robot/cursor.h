@@ -32,6 +32,8 @@ typedef struct cursor_s
     double scale;           /**< Scaling factor applied to cursor movements. */
     double lineSpace;       /**< The spacing between successive lines when newline is invoked. */
     double characterSpace;  /**< The spacing between successive characters. */
+    unsigned long line;     /**< Number of newlines since construction, i.e. the index of the current line. */
+    unsigned long page;     /**< Number of pages started since construction, i.e. the index of the current page. */
 
     /**
      * @brief Set the cursor position.
@@ -51,6 +53,7 @@ typedef struct cursor_s
 
     /**
      * @brief Move the cursor to a new line position.
+     * @details A line that would start below the page starts at the top of the next page.
      * @param[in,out] self Pointer to the cursor structure.
      * @return SUCCESS on success, or an appropriate error code on failure.
      */
@@ -70,13 +73,22 @@ typedef struct cursor_s
      */
     errorCode_t (*update)(struct cursor_s *const self);
 
+    /**
+     * @brief Move the cursor right by the width of a character, for proportional spacing.
+     * @param[in,out] self Pointer to the cursor structure.
+     * @param[in] width Width of the character in millimetres.
+     * @return SUCCESS on success, or an appropriate error code on failure.
+     */
+    errorCode_t (*advance)(struct cursor_s *const self, const double width);
+
     /**
      * @brief Check if writing a given word would overflow the allowed cursor area.
      * @param[in] self Pointer to the cursor structure.
-     * @param[in] word Pointer to the word to test for overflow.
+     * @param[in] width Width of the word in millimetres up to its last character, which is
+     *                  usually its delimiter.
      * @return true if writing the word would cause overflow, false otherwise.
      */
-    bool (*testWordOverflow)(const struct cursor_s *const self, const char *const word);
+    bool (*testWordOverflow)(const struct cursor_s *const self, const double width);
 } cursor_t;
 
 /**
@@ -0,0 +1,360 @@
+/**
+ * @file estimate.c
+ * @brief Implementation of the plot-time estimator.
+ * @details
+ * The planner follows GRBL 1.1 (planner.c): speeds are handled as squares, the junction speed
+ * comes from the junction deviation and the angle between two moves, and every change to the
+ * queue is followed by a reverse pass, which makes each move able to stop within the moves
+ * queued after it, and a forward pass, which limits each entry speed to what the move before
+ * can reach. Rates and accelerations are limited per axis the way GRBL limits them.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "estimate.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define ESTIMATE_PI 3.14159265358979323846 /**< Pi, math.h only provides M_PI as an extension. */
+#define ESTIMATE_MIN_LENGTH 1e-6           /**< Moves shorter than this in mm are dropped, as GRBL drops empty blocks. */
+#define ESTIMATE_STRAIGHT_COS 0.999999     /**< Cosine beyond which a junction counts as straight or as a reversal. */
+#define ESTIMATE_ARC_EPSILON 5e-7          /**< Angle in radians below which an arc counts as a full circle (ARC_ANGULAR_TRAVEL_EPSILON). */
+
+static const Coord2D_t origin = {0.0, 0.0}; /**< Zero vector, the direction while standing still. */
+
+/**
+ * @brief Adds a straight move, see plotEstimate_t::line().
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] penDown true for a G1 move, false for a G0 move.
+ */
+static void _line(plotEstimate_t *const self, const Coord2D_t pos, const bool penDown);
+
+/**
+ * @brief Adds an arc, see plotEstimate_t::arc().
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] offset Centre of the arc relative to its start, in millimetres.
+ * @param[in] clockwise true for G2, false for G3.
+ */
+static void _arc(plotEstimate_t *const self, const Coord2D_t pos, const Coord2D_t offset, const bool clockwise);
+
+/**
+ * @brief Times every move still being planned, ending at a standstill.
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ */
+static void _finish(plotEstimate_t *const self);
+
+/**
+ * @brief Adds a command that stops the machine, see plotEstimate_t::pause().
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ * @param[in] seconds Time the command holds the machine.
+ */
+static void _pause(plotEstimate_t *const self, const double seconds);
+
+/**
+ * @brief Resets the totals and empties the planner.
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ * @param[in] start Position of the machine.
+ */
+static void _reset(plotEstimate_t *const self, const Coord2D_t start);
+
+/**
+ * @brief Plans a move and adds its length to the pen-up or pen-down distance.
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] penDown true for a move at the feed rate, false for a rapid move.
+ */
+static void _plan(plotEstimate_t *const self, const Coord2D_t pos, const bool penDown);
+
+/**
+ * @brief Replans the entry speeds of the moves in the planner.
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ */
+static void _recalculate(plotEstimate_t *const self);
+
+/**
+ * @brief Times the oldest move in the planner and removes it.
+ * @param[in,out] self Pointer to the plotEstimate_t structure.
+ */
+static void _retire(plotEstimate_t *const self);
+
+/**
+ * @brief Limits a per-axis value along a direction, like limit_value_by_axis_maximum() in GRBL.
+ * @param[in] value The limit of each axis.
+ * @param[in] unit Unit vector of the direction.
+ * @return The largest value along the direction that keeps every axis within its limit.
+ */
+static inline double _limitByAxis(const double value, const Coord2D_t unit);
+
+/**
+ * @brief Calculates the time of a trapezoidal or triangular velocity profile.
+ * @param[in] block The move.
+ * @param[in] exitSqr Square of the speed at the end of the move.
+ * @return Time in s.
+ */
+static double _profileTime(const plotBlock_t *const block, const double exitSqr);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+motionModel_t DefaultMotionModel(void)
+{
+    motionModel_t model;                                   // Settings
+    model.feedRate = ESTIMATE_FEED_RATE;                   // Set feed rate
+    model.maxRate = ESTIMATE_MAX_RATE;                     // Set maximum rate
+    model.acceleration = ESTIMATE_ACCELERATION;            // Set acceleration
+    model.junctionDeviation = ESTIMATE_JUNCTION_DEVIATION; // Set junction deviation
+    model.arcTolerance = ESTIMATE_ARC_TOLERANCE;           // Set arc tolerance
+    model.penDelay = ESTIMATE_PEN_DELAY;                   // Set pen delay
+    return model;                                          // Return settings
+}
+
+/**
+ * @details
+ * A junction deviation, arc tolerance or pen delay below 0 is treated as 0.
+ */
+plotEstimate_t plotEstimateConstructor(const motionModel_t model, const Coord2D_t start)
+{
+    plotEstimate_t estimate; // Estimator
+    estimate.init = true;    // Set initialization state to true
+
+    const motionModel_t defaults = DefaultMotionModel();                                                 // Fallback settings
+    estimate.model.feedRate = model.feedRate > 0.0 ? model.feedRate : defaults.feedRate;                 // Set feed rate
+    estimate.model.maxRate = model.maxRate > 0.0 ? model.maxRate : defaults.maxRate;                     // Set maximum rate
+    estimate.model.acceleration = model.acceleration > 0.0 ? model.acceleration : defaults.acceleration; // Set acceleration
+    estimate.model.junctionDeviation = model.junctionDeviation > 0.0 ? model.junctionDeviation : 0.0;    // Set junction deviation
+    estimate.model.arcTolerance = model.arcTolerance > 0.0 ? model.arcTolerance : 0.0;                   // Set arc tolerance
+    estimate.model.penDelay = model.penDelay > 0.0 ? model.penDelay : 0.0;                               // Set pen delay
+
+    estimate.line = _line;     // Set line function pointer
+    estimate.arc = _arc;       // Set arc function pointer
+    estimate.finish = _finish; // Set finish function pointer
+    estimate.pause = _pause;   // Set pause function pointer
+    estimate.reset = _reset;   // Set reset function pointer
+
+    _reset(&estimate, start); // Start empty
+    return estimate;          // Return estimator
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The machine starts with the pen up, as StartUpRobot() leaves it, so the first pen-down move
+ * counts as a pen change.
+ */
+static void _reset(plotEstimate_t *const self, const Coord2D_t start)
+{
+    self->position = start;      // Machine position
+    self->direction = origin;    // Standing still
+    self->lastSpeed = 0.0;       // No move before
+    self->penDown = false;       // Pen up
+    self->head = 0;              // Empty
+    self->count = 0;             // planner
+    self->time = 0.0;            // Clear time
+    self->penDownDistance = 0.0; // Clear distance drawn
+    self->penUpDistance = 0.0;   // Clear distance travelled
+    self->commands = 0;          // Clear commands
+    self->penLifts = 0;          // Clear pen changes
+}
+
+static void _line(plotEstimate_t *const self, const Coord2D_t pos, const bool penDown)
+{
+    self->commands++;          // Count command
+    _plan(self, pos, penDown); // Plan the move
+}
+
+/**
+ * @details
+ * Follows mc_arc() in GRBL: the arc is split into chords that stay within the arc tolerance of
+ * it, and every chord is planned like a straight move. The chord points are calculated exactly
+ * rather than with GRBL's small-angle approximation.
+ */
+static void _arc(plotEstimate_t *const self, const Coord2D_t pos, const Coord2D_t offset, const bool clockwise)
+{
+    self->commands++; // Count command
+
+    const Coord2D_t centre = AddCoord2D(self->position, offset);         // Centre of the arc
+    const Coord2D_t from = ScaleCoord2D(offset, -1.0);                   // Start relative to the centre
+    const Coord2D_t to = SubCoord2D(pos, centre);                        // Target relative to the centre
+    const double radius = DistanceCoord2D(origin, offset);               // Radius
+    double travel = atan2(CrossCoord2D(from, to), DotCoord2D(from, to)); // Angle from start to target
+    if (clockwise && travel >= -ESTIMATE_ARC_EPSILON)                    // Clockwise arcs
+        travel -= 2.0 * ESTIMATE_PI;                                     // turn negative
+    else if (!clockwise && travel <= ESTIMATE_ARC_EPSILON)               // Counter-clockwise arcs
+        travel += 2.0 * ESTIMATE_PI;                                     // turn positive
+
+    const double tolerance = self->model.arcTolerance;                                            // Arc tolerance
+    const double chord = sqrt(tolerance * (2.0 * radius - tolerance));                            // Half chord within tolerance
+    const size_t segments = chord > 0.0 ? (size_t)floor(fabs(0.5 * travel * radius) / chord) : 0; // Chords GRBL uses
+    for (size_t i = 1; i < segments; i++)                                                         // Every chord but the last
+    {
+        const double angle = travel * (double)i / (double)segments;         // Angle of its end
+        const Coord2D_t point = {from.x * cos(angle) - from.y * sin(angle), // Rotate the start
+                                 from.x * sin(angle) + from.y * cos(angle)};
+        _plan(self, AddCoord2D(centre, point), true); // Plan the chord
+    }
+    _plan(self, pos, true); // Last chord ends on the target
+}
+
+static void _finish(plotEstimate_t *const self)
+{
+    while (self->count > 0)   // Until the planner is empty
+        _retire(self);        // Time the oldest move
+    self->direction = origin; // Standing still
+    self->lastSpeed = 0.0;    // Next move starts from rest
+}
+
+/**
+ * @details
+ * GRBL finishes every queued move before a dwell or a program pause, so the machine stops first.
+ * A time that is not positive, such as the unknown wait for a program pause, adds nothing.
+ */
+static void _pause(plotEstimate_t *const self, const double seconds)
+{
+    self->commands++;          // Count command
+    _finish(self);             // Machine stops first
+    if (seconds > 0.0)         // Check if the hold is known
+        self->time += seconds; // Hold it
+}
+
+/**
+ * @details
+ * The junction speed follows from a circle that touches both moves and deviates from the corner
+ * by the junction deviation, with the acceleration along the bisector as centripetal limit. After
+ * a stop the entry speed is 0. Like GRBL, an empty move is dropped.
+ */
+static void _plan(plotEstimate_t *const self, const Coord2D_t pos, const bool penDown)
+{
+    const Coord2D_t delta = SubCoord2D(pos, self->position);    // Move
+    const double length = DistanceCoord2D(self->position, pos); // Its length
+    if (length < ESTIMATE_MIN_LENGTH)                           // Check if the move is empty
+        return;                                                 // Nothing to plan
+    self->position = pos;                                       // Machine goes there
+
+    if (penDown)                         // Drawing
+        self->penDownDistance += length; // Count distance drawn
+    else                                 // Travelling
+        self->penUpDistance += length;   // Count distance travelled
+    if (penDown != self->penDown)        // Check if the pen changes
+    {
+        _finish(self);                      // GRBL completes every move first
+        self->time += self->model.penDelay; // Pen goes up or down
+        self->penDown = penDown;            // New pen state
+        self->penLifts++;                   // Count pen change
+    }
+
+    const Coord2D_t unit = ScaleCoord2D(delta, 1.0 / length);            // Direction of the move
+    plotBlock_t block;                                                   // New planner move
+    block.length = length;                                               // Set length
+    block.acceleration = _limitByAxis(self->model.acceleration, unit);   // Set acceleration
+    const double rapid = _limitByAxis(self->model.maxRate, unit) / 60.0; // Fastest speed along the move
+    const double feed = self->model.feedRate / 60.0;                     // Programmed speed
+    block.nominalSpeed = penDown && feed < rapid ? feed : rapid;         // Set nominal speed
+
+    double junctionSqr = 0.0;                                       // Square of the junction speed, 0 from rest
+    const double cosTheta = -DotCoord2D(self->direction, unit);     // Cosine of the angle between the moves
+    if (self->lastSpeed == 0.0 || cosTheta > ESTIMATE_STRAIGHT_COS) // Check if starting or reversing
+        junctionSqr = 0.0;                                          // Stop at the junction
+    else if (cosTheta < -ESTIMATE_STRAIGHT_COS)                     // Check if the moves are in line
+        junctionSqr = HUGE_VAL;                                     // No junction limit
+    else                                                            // Corner
+    {
+        Coord2D_t bisector = SubCoord2D(unit, self->direction);                                 // Direction of the speed change
+        bisector = ScaleCoord2D(bisector, 1.0 / DistanceCoord2D(origin, bisector));             // Normalise it
+        const double acceleration = _limitByAxis(self->model.acceleration, bisector);           // Centripetal limit
+        const double sinHalf = sqrt(0.5 * (1.0 - cosTheta));                                    // Sine of half the angle
+        junctionSqr = acceleration * self->model.junctionDeviation * sinHalf / (1.0 - sinHalf); // Junction speed squared
+    }
+
+    const double nominalSqr = block.nominalSpeed * block.nominalSpeed;                            // This move's limit
+    const double lastSqr = self->lastSpeed * self->lastSpeed;                                     // Previous move's limit
+    block.maxEntrySpeedSqr = junctionSqr < nominalSqr ? junctionSqr : nominalSqr;                 // Limit by this move
+    block.maxEntrySpeedSqr = block.maxEntrySpeedSqr < lastSqr ? block.maxEntrySpeedSqr : lastSqr; // and the previous one
+    block.entrySpeedSqr = self->count > 0 ? block.maxEntrySpeedSqr : 0.0;                         // Entry from rest if the planner is empty
+
+    if (self->count == ESTIMATE_PLANNER_BLOCKS)                                   // Check if the planner is full
+        _retire(self);                                                            // Execute the oldest move
+    self->blocks[(self->head + self->count++) % ESTIMATE_PLANNER_BLOCKS] = block; // Queue the move
+    self->direction = unit;                                                       // Remember direction
+    self->lastSpeed = block.nominalSpeed;                                         // Remember speed
+    _recalculate(self);                                                           // Replan
+}
+
+/**
+ * @details
+ * The newest move has to be able to stop at its end. The entry speed of the oldest move is fixed:
+ * it is the exit speed of the move that was timed before it, or 0 after a stop.
+ */
+static void _recalculate(plotEstimate_t *const self)
+{
+    double exitSqr = 0.0;                        // Square of the exit speed of the move
+    for (size_t k = self->count - 1; k > 0; k--) // From the newest back to the second oldest
+    {
+        plotBlock_t *const block = &self->blocks[(self->head + k) % ESTIMATE_PLANNER_BLOCKS];             // Move
+        const double reachable = exitSqr + 2.0 * block->acceleration * block->length;                     // Fastest entry that can still slow down
+        block->entrySpeedSqr = reachable < block->maxEntrySpeedSqr ? reachable : block->maxEntrySpeedSqr; // Limit entry
+        exitSqr = block->entrySpeedSqr;                                                                   // Exit of the move before
+    }
+
+    for (size_t k = 0; k + 1 < self->count; k++) // From the oldest forwards
+    {
+        const plotBlock_t *const block = &self->blocks[(self->head + k) % ESTIMATE_PLANNER_BLOCKS]; // Move
+        plotBlock_t *const next = &self->blocks[(self->head + k + 1) % ESTIMATE_PLANNER_BLOCKS];    // Move after it
+        const double reachable = block->entrySpeedSqr + 2.0 * block->acceleration * block->length;  // Fastest exit
+        if (next->entrySpeedSqr > reachable)                                                        // Check if it cannot get there
+            next->entrySpeedSqr = reachable;                                                        // Limit entry
+    }
+}
+
+static void _retire(plotEstimate_t *const self)
+{
+    const plotBlock_t *const block = &self->blocks[self->head];                                         // Oldest move
+    const double exitSqr = self->count > 1                                                              // Check if a move follows
+                               ? self->blocks[(self->head + 1) % ESTIMATE_PLANNER_BLOCKS].entrySpeedSqr // Exit into it
+                               : 0.0;                                                                   // Stop
+    self->time += _profileTime(block, exitSqr);                                                         // Time the move
+    self->head = (self->head + 1) % ESTIMATE_PLANNER_BLOCKS;                                            // Remove
+    self->count--;                                                                                      // it
+}
+
+static inline double _limitByAxis(const double value, const Coord2D_t unit)
+{
+    double limit = HUGE_VAL;                       // No limit yet
+    if (unit.x != 0.0)                             // Check if X moves
+        limit = fmin(limit, value / fabs(unit.x)); // Limit by X
+    if (unit.y != 0.0)                             // Check if Y moves
+        limit = fmin(limit, value / fabs(unit.y)); // Limit by Y
+    return limit;                                  // Return limit
+}
+
+/**
+ * @details
+ * The move accelerates from its entry speed, cruises at its nominal speed and decelerates to its
+ * exit speed. If it is too short to reach the nominal speed, the profile is a triangle that peaks
+ * where the acceleration and deceleration meet.
+ */
+static double _profileTime(const plotBlock_t *const block, const double exitSqr)
+{
+    const double a = block->acceleration;            // Acceleration
+    const double entry = sqrt(block->entrySpeedSqr); // Entry speed
+    const double exit = sqrt(exitSqr);               // Exit speed
+    const double nominal = block->nominalSpeed;      // Cruise speed
+    const double nominalSqr = nominal * nominal;     // Its square
+
+    const double accelerate = (nominalSqr - block->entrySpeedSqr) / (2.0 * a); // Distance to reach cruise speed
+    const double decelerate = (nominalSqr - exitSqr) / (2.0 * a);              // Distance to slow down again
+    if (accelerate + decelerate <= block->length)                              // Check if the move cruises
+        return (nominal - entry) / a + (nominal - exit) / a                    // Ramps
+               + (block->length - accelerate - decelerate) / nominal;          // and cruise
+
+    double peakSqr = a * block->length + 0.5 * (block->entrySpeedSqr + exitSqr); // Square of the peak speed
+    peakSqr = fmax(peakSqr, fmax(block->entrySpeedSqr, exitSqr));                // Never below either end
+    const double peak = sqrt(peakSqr);                                           // Peak speed
+    return (peak - entry) / a + (peak - exit) / a;                               // Ramps only
+}
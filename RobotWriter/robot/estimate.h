@@ -0,0 +1,145 @@
+/**
+ * @file estimate.h
+ * @brief Declaration of the plotEstimate_t structure, which estimates how long the robot takes for a job.
+ * @details
+ * GRBL does not move at the programmed feed rate all the time. It plans the queued moves with a
+ * trapezoidal velocity profile: every move accelerates from its entry speed towards its nominal
+ * speed and decelerates to the entry speed of the next move, and the speed allowed through the
+ * junction between two moves depends on the angle between them (junction deviation). Short moves
+ * around sharp corners, which is most of a glyph, never get close to the feed rate.
+ *
+ * The estimator runs the same planner over the moves that are sent, with a look-ahead of as many
+ * moves as the controller's planner holds, and adds up the time of each profile. It assumes the
+ * serial line keeps the planner full.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../misc/coord.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define ESTIMATE_FEED_RATE 1000.0        /**< Default G1 feed rate in mm/min, as set by StartUpRobot(). */
+#define ESTIMATE_MAX_RATE 1000.0         /**< Default maximum rate of each axis in mm/min ($110, $111), used for G0. */
+#define ESTIMATE_ACCELERATION 10.0       /**< Default acceleration of each axis in mm/s^2 ($120, $121). */
+#define ESTIMATE_JUNCTION_DEVIATION 0.01 /**< Default junction deviation in mm ($11). */
+#define ESTIMATE_ARC_TOLERANCE 0.002     /**< Default arc tolerance in mm ($12), sets the segments of an arc. */
+#define ESTIMATE_PEN_DELAY 0.0           /**< Default time in s the pen takes to go up or down. */
+#define ESTIMATE_PLANNER_BLOCKS 15       /**< Moves GRBL plans ahead: 16 slots, one kept free. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Settings of the machine the estimate is made for.
+ * @details The rates and accelerations apply to each axis, like the GRBL settings they mirror, so
+ *          a diagonal move may go faster than either limit.
+ */
+typedef struct motionModel_s
+{
+    double feedRate;          /**< Feed rate of pen-down moves in mm/min. */
+    double maxRate;           /**< Maximum rate of each axis in mm/min; pen-up moves go as fast as this allows. */
+    double acceleration;      /**< Acceleration of each axis in mm/s^2. */
+    double junctionDeviation; /**< Junction deviation in mm. */
+    double arcTolerance;      /**< Largest distance in mm between an arc and the segments it is split into. */
+    double penDelay;          /**< Time in s added each time the pen goes up or down. */
+} motionModel_t;
+
+/**
+ * @brief A move waiting in the planner.
+ */
+typedef struct plotBlock_s
+{
+    double length;           /**< Length of the move in mm. */
+    double acceleration;     /**< Acceleration along the move in mm/s^2. */
+    double nominalSpeed;     /**< Speed the move is programmed at in mm/s. */
+    double maxEntrySpeedSqr; /**< Square of the fastest speed through the junction into the move. */
+    double entrySpeedSqr;    /**< Square of the planned speed at the start of the move. */
+} plotBlock_t;
+
+/**
+ * @brief Structure that estimates the time, distances and commands of a job.
+ * @details
+ * Moves are handed to line() or arc() as they are sent. The oldest move is timed once the planner
+ * is full, as its entry speed can no longer change; finish() times the rest with the machine
+ * coming to a stop. A change between pen-up and pen-down moves changes the spindle word, which
+ * makes GRBL finish every queued move first, so the machine stops there too.
+ */
+typedef struct plotEstimate_s
+{
+    bool init;           /**< true once the estimator has been constructed. */
+    motionModel_t model; /**< Machine settings. */
+
+    Coord2D_t position;  /**< End of the last move. */
+    Coord2D_t direction; /**< Unit vector of the last move, zero after a stop. */
+    double lastSpeed;    /**< Nominal speed of the last move in mm/s. */
+    bool penDown;        /**< Pen state of the last move. */
+
+    plotBlock_t blocks[ESTIMATE_PLANNER_BLOCKS]; /**< Ring of moves still being planned. */
+    size_t head;                                 /**< Index of the oldest move. */
+    size_t count;                                /**< Number of moves being planned. */
+
+    double time;            /**< Estimated time in s of the moves timed so far. */
+    double penDownDistance; /**< Distance drawn in mm. */
+    double penUpDistance;   /**< Distance travelled with the pen up in mm. */
+    unsigned long commands; /**< Commands added. */
+    unsigned long penLifts; /**< Changes between pen up and pen down. */
+
+    /**
+     * @brief Adds a straight move.
+     * @param[in,out] self Pointer to the plotEstimate_t structure.
+     * @param[in] pos Target position in millimetres.
+     * @param[in] penDown true for a G1 move at the feed rate, false for a G0 move.
+     */
+    void (*line)(struct plotEstimate_s *const self, const Coord2D_t pos, const bool penDown);
+
+    /**
+     * @brief Adds a pen-down arc, split into segments the way GRBL does.
+     * @param[in,out] self Pointer to the plotEstimate_t structure.
+     * @param[in] pos Target position in millimetres.
+     * @param[in] offset Centre of the arc relative to its start, in millimetres.
+     * @param[in] clockwise true for G2, false for G3.
+     */
+    void (*arc)(struct plotEstimate_s *const self, const Coord2D_t pos, const Coord2D_t offset, const bool clockwise);
+
+    /**
+     * @brief Times the moves still being planned, ending at a standstill.
+     * @param[in,out] self Pointer to the plotEstimate_t structure.
+     */
+    void (*finish)(struct plotEstimate_s *const self);
+
+    /**
+     * @brief Adds a command that waits for the machine to stop, such as a dwell or a pause.
+     * @param[in,out] self Pointer to the plotEstimate_t structure.
+     * @param[in] seconds Time the command holds the machine once it has stopped, 0 if unknown.
+     */
+    void (*pause)(struct plotEstimate_s *const self, const double seconds);
+
+    /**
+     * @brief Resets the totals and empties the planner.
+     * @param[in,out] self Pointer to the plotEstimate_t structure.
+     * @param[in] start Position of the machine.
+     */
+    void (*reset)(struct plotEstimate_s *const self, const Coord2D_t start);
+} plotEstimate_t;
+
+/**
+ * @brief Returns the default machine settings.
+ * @return A motionModel_t holding the ESTIMATE_ defaults.
+ */
+motionModel_t DefaultMotionModel(void);
+
+/**
+ * @brief Constructs and initializes a new plotEstimate_t object.
+ * @param[in] model Machine settings; rates and accelerations that are not positive are replaced by the defaults.
+ * @param[in] start Position of the machine.
+ * @return The newly created plotEstimate_t object.
+ */
+plotEstimate_t plotEstimateConstructor(const motionModel_t model, const Coord2D_t start);
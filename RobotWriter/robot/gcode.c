@@ -1,124 +1,159 @@
 /**
  * @file gcode.c
  * @brief Implementation of text processing functions that generate G-code from text using font data.
- * @details This file provides functions to process text from a file and to generate G-code
- *       instructions using a given font data set.
+ * @details This file provides functions to lay out the text of a file and to generate G-code
+ *       instructions from the layout, using the characters of a font scaled by a glyph cache.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 
 #include "gcode.h"
+#include "textReader.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+static bool proportional = PROPORTIONAL_MODE;           /**< Space characters by the width of their ink. */
+static bool balance = BALANCE_MODE;                     /**< Balance the lines of each paragraph. */
+static double boundsTolerance = PREFLIGHT_TOLERANCE_MM; /**< Distance in mm a stroke may leave the drawing area by. */
 
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DEFINITIONS                       //
 ///////////////////////////////////////////////////////////////////////
 
+void SetProportional(const bool enabled)
+{
+    proportional = enabled; // Set spacing
+}
+
+void SetBalance(const bool enabled)
+{
+    balance = enabled; // Set line breaking
+}
+
+void SetBoundsTolerance(const double tolerance)
+{
+    boundsTolerance = tolerance; // Set tolerance
+}
+
 /**
  * @details
- * This function uses a static cursor to track the current drawing position. If the cursor
- * isn't initialized, it constructs a new cursor using the font data's scale factor. Before
- * processing the text, it checks if the word would overflow the current cursor line. If so,
- * it moves to a new line.
- *
- * It then iterates through the text:
- * - Spaces cause a cursor update.
- * - Newline ('\n') and carriage return ('\r') characters cause the cursor to adjust its position
- *   accordingly.
- * - Other characters are looked up in the font data. If found, their strokes are sent to the
- *   robot using `SendStoke()`. After drawing each character, the cursor is updated.
+ * This function draws the glyphs of the layout line by line, from the top of the page, and
+ * changes the paper with `ChangePage()` before the first line of every page after the first. A
+ * cursor of the scale of the layout is put at each glyph in turn, on its line, and the glyph is
+ * looked up in the glyph cache by code point at that scale, which scales it the first time it is
+ * drawn at that scale. Its strokes are then sent to the robot using `SendStoke()`, from the cursor.
+ * With proportional spacing the strokes are shifted left to put the ink of the character at
+ * the cursor. A rejected command is reported and skipped, but losing contact with the robot
+ * aborts the job.
  */
-errorCode_t generate_gcode(const fontData_t *const fontData, const char *text)
+errorCode_t generate_gcode(glyphCache_t *const cache, const layout_t *const layout)
 {
-    static cursor_t cursor;                              // Static cursor to track position
-    if (!cursor.init)                                    // Check if cursor is initialized
-        cursor = cursorConstructor(fontData->fontScale); // Initialize cursor
-
-    if (cursor.testWordOverflow(&cursor, text)) // Check if word would overflow
-        cursor.newline(&cursor);                // Move to new line
+    if (!cache || !layout)                       // Check if cache or layout is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
 
-    while (*text != '\0') // Iterate through text
+    const fontData_t *const fontData = layout->fontData;   // Font of the layout
+    cursor_t cursor = layout->cursor;                      // Cursor of the scale of the layout
+    size_t page = 0;                                       // Page being drawn
+    for (size_t line = 0; line < layout->numLines; line++) // Iterate through lines
     {
-        switch (*text) // Check character
+        if (page + 1 < layout->numPages && layout->pages[page + 1].first == line) // Check if the line starts a page
         {
-        case ' ':                                  // Space
-            if (cursor.update(&cursor) != SUCCESS) // Update cursor
-                return CURSOR_OUT_OF_BOUNDS;       // Handle error
-            break;
-        case '\n':                                  // Newline
-            if (cursor.newline(&cursor) != SUCCESS) // Move to new line
-                return CURSOR_OUT_OF_BOUNDS;        // Handle error
-            break;
-        case '\r':                                         // Carriage return
-            if (cursor.carriagereturn(&cursor) != SUCCESS) // Move to start of line
-                return CURSOR_OUT_OF_BOUNDS;               // Handle error
-            break;
-        default:
+            const errorCode_t error = ChangePage();                  // Finish the page and change the paper
+            if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY) // Check if the robot is unreachable
+                return error;                                        // Abort the job
+            page++;                                                  // Next page
+        }
+        const size_t end = line + 1 < layout->numLines ? layout->lines[line + 1].first // End of the line
+                                                       : layout->numGlyphs;
+        cursor.line = line;                                      // Put the cursor on the line
+        cursor.posisiton.y = layout->lines[line].y;              // at its height
+        for (size_t i = layout->lines[line].first; i < end; i++) // Iterate through its glyphs
         {
-            const fontCharacter_t *const fontChar = fontData->lookup(fontData, *text); // Look up character
-            if (!fontChar)                                                             // if no charater was found
+            const layoutGlyph_t *const placed = &layout->glyphs[i];                             // Glyph placed
+            const glyph_t *const glyph = cache->lookup(cache, placed->codePoint, cursor.scale); // Look up character
+            if (!glyph)                                                                         // Check if memory for the size ran out
+                return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED);                            // Handle error
+
+            const fontMetrics_t *const metrics = layout->proportional ? fontData->measure(fontData, placed->codePoint) : NULL; // Metrics for proportional spacing
+            const double shift = metrics && metrics->inked ? metrics->left * cursor.scale : 0.0;                               // Ink to the cursor
+            cursor.posisiton.x = placed->x;                                                                                    // Put the cursor at the glyph
+            for (uint8_t k = 0; k < glyph->numStrokes; k++)                                                                    // Iterate through strokes
             {
-                ErrorHandler(FONT_CHARACTER_NOT_FOUND); // Handle error
-                break;                                  // Break
+                glyphStroke_t stroke = glyph->strokes[k];                // Stroke to send
+                stroke.vec.x -= shift;                                   // Shift it to the cursor
+                const errorCode_t error = SendStoke(&cursor, stroke);    // Send stroke to robot
+                if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY) // Check if the robot is unreachable
+                    return error;                                        // Abort the job
             }
-
-            for (uint8_t i = 0; i < fontChar->numStrokes; i++) // Iterate through strokes
-                SendStoke(&cursor, fontChar->strokes[i]);      // Send stroke to robot
-
-            if (cursor.update(&cursor) != SUCCESS) // Update cursor
-                return CURSOR_OUT_OF_BOUNDS;       // Handle error
-            break;
-        }
         }
-        text++; // Move to next character
     }
     return SUCCESS; // Return success
 }
 
 /**
  * @details
- * This function reads the text file character by character and accumulates characters into a buffer.
- * Once it encounters a space, newline, or carriage return, it treats the accumulated characters as
- * a complete "word" and calls `generate_gcode()` to generate G-code for that word.
+ * This function reads the text file a word at a time through a textReader_t, which reads it in
+ * large blocks and ends each word at a space, newline, or carriage return. Each word is added to
+ * a layout_t where it lies in the reader's buffer, so a word has no length limit. Once the whole
+ * file is placed, and only then, the layout is checked with `CheckLayout()` and drawn with
+ * `generate_gcode()`, so the pages of a file longer than one page are known before anything is
+ * sent, and a file that would leave the drawing area is rejected before the robot moves.
+ *
+ * After processing the file, it sends the robot to its home position. The file is left open, as
+ * it belongs to the caller, which may have passed stdin.
  *
- * If the file ends and there are still accumulated characters, it processes those as the final word.
- * After processing the file, it closes the file and sends the robot to its home position.
+ * Every file is a job of its own, laid out from the top left of the page, so several files can
+ * be drawn one after the other with the same glyph cache, each at a scale of its own.
  */
-errorCode_t process_text_file(const fontData_t *const fontData, FILE *const file)
+errorCode_t process_text_file(glyphCache_t *const cache, FILE *const file, const double scale)
 {
 
-    if (!fontData)                               // Check if fontData is NULL
+    if (!cache)                                  // Check if cache is NULL
         return ErrorHandler(ERROR_NO_FONT_DATA); // Handle error
 
     if (!file)                                   // Check if file is NULL
         return ErrorHandler(ERROR_NO_TEXT_FILE); // Handle error
 
-    char buff[256]; // Buffer to hold each word
-    int ch;         // Current character
-    int index = 0;  // Index in buffer
-
-    while ((ch = fgetc(file)) != EOF) // Read characters until end of file
+    textReader_t *reader = textReaderConstructor(file);                                  // Reader of the file
+    layout_t *layout = layoutConstructor(cache->fontData, scale, proportional, balance); // Layout of this job
+    if (!reader || !layout)                                                              // Check if they could be made
     {
-        buff[index++] = ch; // Add character to buffer
-
-        if (ch == ' ' || ch == '\n' || ch == '\r') // Check if character is space, newline, or carriage return
-        {
-            buff[index] = '\0';                                 // Null-terminate buffer
-            errorCode_t error = generate_gcode(fontData, buff); // Generate G-code for word
-            if (error != SUCCESS)                               // Check if error
-                return ErrorHandler(error);                     // Handle error
-            index = 0;                                          // Reset index
-        }
+        if (reader)                                          // Check if the reader was made
+            reader->free(reader);                            // Free it
+        if (layout)                                          // Check if the layout was made
+            layout->free(layout);                            // Free it
+        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
     }
 
-    if (index > 0) // Check if there are remaining characters
+    textView_t word;                                                            // Current word
+    errorCode_t error;                                                          // Result of each step
+    while ((error = reader->read(reader, &word)) == SUCCESS && word.length > 0) // Read words until end of file
     {
-        buff[index] = '\0';                                 // Null-terminate buffer
-        errorCode_t error = generate_gcode(fontData, buff); // Generate G-code for word
-        if (error != SUCCESS)                               // Check if error
-            return ErrorHandler(error);                     // Handle error
+        error = layout->add(layout, word.text, word.length); // Place word
+        if (error != SUCCESS)                                // Check if error
+            break;                                           // Stop the job
     }
+    if (error == SUCCESS)               // Check if the whole file was read
+        error = layout->finish(layout); // Place the last paragraph
+    reader->free(reader);               // Free reader
 
-    fclose(file); // Close file
-    HomeRobot();  // Send robot to home position
+    if (error == SUCCESS) // Check if the whole file was placed
+    {
+        const preflight_t report = CheckLayout(layout, boundsTolerance); // Check the job
+        PrintPreflight(stderr, &report);                                 // Report it
+        if (report.outOfBounds > 0)                                      // Check if strokes leave the area
+            error = ERROR_OUT_OF_BOUNDS;                                 // Reject the job
+    }
+    if (error == SUCCESS)                      // Check if the job may be drawn
+        error = generate_gcode(cache, layout); // Draw it
+    layout->free(layout);                      // Free layout
+    if (error != SUCCESS)                      // Check if the job failed
+        return ErrorHandler(error);            // Handle error
+
+    error = HomeRobot();                                     // Send robot to home position
+    if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+        return ErrorHandler(error);                          // Handle error
 
     return SUCCESS; // Return success
 }
@@ -1,15 +1,17 @@
 /**
  * @file gcode.h
  * @brief Declarations for text processing functions that utilize font data and robot movement.
- * @details This file provides functions to process text from a file and to generate G-code
- *       instructions using a given font data set.
+ * @details This file provides functions to lay out the text of a file and to generate G-code
+ *       instructions from the layout using a given font data set.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 
 #pragma once
 
+#include "layout.h"
+#include "preflight.h"
 #include "robot.h"
-#include "../font/fontData.h"
+#include "../font/glyphCache.h"
 #include "../misc/error.h"
 
 ///////////////////////////////////////////////////////////////////////
@@ -17,17 +19,54 @@
 ///////////////////////////////////////////////////////////////////////
 
 /**
- * @brief Processes a text file using the provided font data.
- * @param[in] fontData Pointer to the fontData_t structure containing font information.
+ * @brief Processes a text file using the characters of the glyph cache.
+ * @details The whole file is laid out from the top left of the page and checked with
+ *          CheckLayout(), whose result is printed to stderr, before it is drawn as one job, on as
+ *          many pages as it takes. A job with strokes out of bounds is rejected before anything is
+ *          sent. The file is read to its end but left open: the caller owns it, and closes it unless
+ *          it is stdin.
+ * @param[in,out] cache Pointer to the glyphCache_t structure holding the scaled characters.
  * @param[in,out] file Pointer to the file from which text will be read and processed.
- * @return SUCCESS on successful processing, or an appropriate error code if processing fails.
+ * @param[in] scale Scale factor of the text of the job.
+ * @return SUCCESS on successful processing, ERROR_OUT_OF_BOUNDS if the job leaves the drawing
+ *         area, or an appropriate error code if processing fails.
  */
-errorCode_t process_text_file(const fontData_t *const fontData, FILE *const file);
+errorCode_t process_text_file(glyphCache_t *const cache, FILE *const file, const double scale);
 
 /**
- * @brief Generates G-code commands based on the provided text using the given font data.
- * @param[in] fontData Pointer to the fontData_t structure containing font information.
- * @param[in] text     Pointer to the text string for which G-code will be generated.
+ * @brief Selects how far apart the characters of the jobs after it are drawn.
+ * @details
+ * With fixed spacing every character takes a character space. With proportional spacing each
+ * letter takes the width of its ink and a gap of LETTER_GAP_UNITS, read from the metrics of the
+ * font, so narrow letters such as 'i' and 'l' take less of the line; a character that draws
+ * nothing, such as the space, takes its advance.
+ * @param[in] enabled true for proportional spacing, false for fixed spacing.
+ */
+void SetProportional(const bool enabled);
+
+/**
+ * @brief Selects how the lines of the jobs after it are broken.
+ * @details
+ * Greedy breaking moves a word to the next line when it does not fit. Balanced breaking chooses
+ * the breaks of each paragraph together so that its lines come out of even length, leaving the
+ * least squared space at the end of each line but the last.
+ * @param[in] enabled true to balance the lines of each paragraph, false to break them greedily.
+ */
+void SetBalance(const bool enabled);
+
+/**
+ * @brief Sets how far a stroke of the jobs after it may leave the drawing area.
+ * @details A job with a pen-down stroke that leaves the drawing area by more is rejected before
+ *          the robot moves.
+ * @param[in] tolerance Distance in mm, PREFLIGHT_TOLERANCE_MM by default.
+ */
+void SetBoundsTolerance(const double tolerance);
+
+/**
+ * @brief Generates G-code commands for a laid out document using the given glyph cache.
+ * @details The paper is changed with ChangePage() between the pages of the layout.
+ * @param[in,out] cache Pointer to the glyphCache_t structure holding the scaled characters.
+ * @param[in] layout The layout of the document; the scale of its cursor picks the size.
  * @return SUCCESS on successful G-code generation, or an appropriate error code if generation fails.
  */
-errorCode_t generate_gcode(const fontData_t *const fontData, const char *text);
+errorCode_t generate_gcode(glyphCache_t *const cache, const layout_t *const layout);
@@ -0,0 +1,405 @@
+/**
+ * @file gcodeFormat.c
+ * @brief Implementation of the fixed-point G-code number formatter and the G-code line writer.
+ * @details
+ * A number is scaled by a power of ten and rounded to an integer, whose digits are written with a
+ * decimal point in the right place. printf() rounds the exact binary value of the double, while
+ * the scaled value carries a rounding error of its own, so the two can only disagree when the
+ * number lies almost exactly half-way between two steps of the last decimal. Those rare numbers,
+ * and numbers too large for the integer path, are handed to snprintf() so the output never
+ * differs from it.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "gcodeFormat.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define FIXED_FAST_LIMIT 1e11 /**< Scaled magnitudes below this use the integer path. */
+#define FIXED_TIE_BAND 1e-4   /**< Distance from a half step below which snprintf() decides. */
+
+/**
+ * @brief Builds a move line, see gcodeWriter_t::move().
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ * @param[out] out Destination for the line.
+ * @param[in] spindle Spindle word.
+ * @param[in] motion Motion word.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] comment Trailing comment, or NULL.
+ * @return Length of the line, or 0 if nothing had to be sent.
+ */
+static size_t _move(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                    const Coord2D_t pos, const char *comment);
+
+/**
+ * @brief Builds an arc line, see gcodeWriter_t::arc().
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ * @param[out] out Destination for the line.
+ * @param[in] spindle Spindle word.
+ * @param[in] motion Motion word.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] offset Centre relative to the start in millimetres.
+ * @return Length of the line.
+ */
+static size_t _arc(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                   const Coord2D_t pos, const Coord2D_t offset);
+
+/**
+ * @brief Builds a move or arc line.
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ * @param[out] out Destination for the line.
+ * @param[in] spindle Spindle word.
+ * @param[in] motion Motion word.
+ * @param[in] pos Target position in millimetres.
+ * @param[in] offset Arc centre relative to the start in millimetres, or NULL for a straight move.
+ * @param[in] comment Trailing comment, or NULL.
+ * @return Length of the line, or 0 if nothing had to be sent.
+ */
+static size_t _line(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                    const Coord2D_t pos, const Coord2D_t *const offset, const char *comment);
+
+/**
+ * @brief Forgets the controller's modal state.
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ */
+static void _forget(gcodeWriter_t *const self);
+
+/**
+ * @brief Records how far the controller has got with the lines streamed to it.
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ * @param[in] next Number the stream gives the next line.
+ * @param[in] answered Lines the controller has answered.
+ * @param[in] rejected Lines the controller has rejected.
+ */
+static void _track(gcodeWriter_t *const self, const unsigned long next, const unsigned long answered,
+                   const unsigned long rejected);
+
+/**
+ * @brief Resets the line and byte counters.
+ * @param[in,out] self Pointer to the gcodeWriter_t structure.
+ */
+static void _resetCounters(gcodeWriter_t *const self);
+
+/**
+ * @brief Removes trailing zeros and a trailing decimal point from a formatted number.
+ * @param[in,out] number Terminated number to shorten in place.
+ */
+static void _trimNumber(char *const number);
+
+/**
+ * @brief Copies a string without its terminator.
+ * @param[out] out Destination.
+ * @param[in] text String to copy.
+ * @return Pointer to the character after the last one written.
+ */
+static inline char *_append(char *out, const char *text);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The sign is taken from the value itself with signbit() rather than from the rounded result,
+ * because printf() writes "-0.00" for negative zero and for small negative numbers that round to zero.
+ *
+ * Below FIXED_FAST_LIMIT the rounding error of the scaled value stays below 1e-5 of a step, so
+ * any number further than FIXED_TIE_BAND from a half step rounds the same way as its exact value.
+ * The digits are produced back to front into a small scratch buffer and then copied out in order.
+ */
+char *FormatFixed(char *out, const double value, int decimals)
+{
+    static const double scale[GCODE_MAX_DECIMALS + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6}; // Exact powers of ten
+
+    if (decimals < 0)                  // Clamp precision
+        decimals = 0;                  // to no decimals
+    if (decimals > GCODE_MAX_DECIMALS) // Clamp precision
+        decimals = GCODE_MAX_DECIMALS; // to the most supported
+
+    const double magnitude = value < 0 ? -value : value; // Value without its sign
+    const double scaled = magnitude * scale[decimals];   // Value in steps of the last decimal
+    if (!(scaled < FIXED_FAST_LIMIT))                    // Too large, infinite or NaN
+    {
+        const int n = snprintf(out, GCODE_NUMBER_LENGTH, "%.*f", decimals, value); // Let the C library format it
+        return out + n;                                                            // Point past the text
+    }
+
+    const double whole = (double)(unsigned long long)scaled;                // Steps below the value
+    const double fraction = scaled - whole;                                 // Distance above them
+    if (fraction > 0.5 - FIXED_TIE_BAND && fraction < 0.5 + FIXED_TIE_BAND) // Too close to call
+    {
+        const int n = snprintf(out, GCODE_NUMBER_LENGTH, "%.*f", decimals, value); // Round the exact value
+        return out + n;                                                            // Point past the text
+    }
+
+    unsigned long long steps = (unsigned long long)whole + (fraction > 0.5); // Rounded steps
+
+    if (signbit(value)) // Negative, including -0.0
+        *out++ = '-';   // Sign
+
+    char digits[24]; // Digits, last one first
+    int count = 0;   // Digits produced
+    do               // Fraction digits, then at least one integer digit
+    {
+        digits[count++] = (char)('0' + steps % 10); // Next digit
+        steps /= 10;                                // Drop it
+    } while (steps > 0 || count <= decimals);
+
+    while (count > decimals)      // Integer digits
+        *out++ = digits[--count]; // Most significant first
+    if (decimals > 0)             // Fraction part
+        *out++ = '.';             // Decimal point
+    while (count > 0)             // Fraction digits
+        *out++ = digits[--count]; // Most significant first
+    return out;                   // Point past the text
+}
+
+/**
+ * @details
+ * The writer starts without knowledge of the controller's state, so its first line is always
+ * complete.
+ */
+gcodeWriter_t gcodeWriterConstructor(const bool compact, const int decimals)
+{
+    gcodeWriter_t writer;                          // Declare writer structure
+    writer.compact = compact;                      // Set mode
+    writer.decimals = decimals < 0 ? 0 : decimals; // Set precision
+    if (writer.decimals > GCODE_MAX_DECIMALS)      // Clamp precision
+        writer.decimals = GCODE_MAX_DECIMALS;      // to the most supported
+    writer.init = true;                            // Set initialization state to true
+
+    writer.move = _move;                   // Set move function pointer
+    writer.arc = _arc;                     // Set arc function pointer
+    writer.forget = _forget;               // Set forget function pointer
+    writer.track = _track;                 // Set track function pointer
+    writer.resetCounters = _resetCounters; // Set reset counters function pointer
+
+    writer.next = 0;             // Lines not numbered
+    writer.answered = ULONG_MAX; // until the writer is tracked,
+    writer.rejected = 0;         // so every line counts as answered
+    writer.spindleLine = 0;      // No word
+    writer.motionLine = 0;       // written
+    writer.xLine = 0;            // by any
+    writer.yLine = 0;            // line yet
+    _forget(&writer);            // Controller state unknown
+    _resetCounters(&writer);     // Nothing written yet
+    return writer;               // Return writer structure
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * A straight move is a line without centre offset.
+ */
+static size_t _move(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                    const Coord2D_t pos, const char *comment)
+{
+    return _line(self, out, spindle, motion, pos, NULL, comment); // Build the line
+}
+
+/**
+ * @details
+ * I and J are not modal, so an arc line always carries them, and it never comes out empty.
+ */
+static size_t _arc(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                   const Coord2D_t pos, const Coord2D_t offset)
+{
+    return _line(self, out, spindle, motion, pos, &offset, NULL); // Build the line
+}
+
+/**
+ * @details
+ * Both coordinates are always formatted at full length first, which gives the full-mode byte
+ * count for the statistics. In compact mode each number is then trimmed and compared with the
+ * value the controller holds; because the comparison is made on the text the controller would
+ * parse, a word is only left out when the controller would end up with the same value anyway.
+ * A word is also written again while the line that set it to its value is unanswered, so if that
+ * line is rejected, the lines streamed behind it still run with the state they were built for.
+ * Without tracking `next` stays 0 and `answered` ULONG_MAX, so only changed words are written.
+ * "-0" is written as "0" as the two mean the same position.
+ */
+static size_t _line(gcodeWriter_t *const self, char *const out, const char *spindle, const char *motion,
+                    const Coord2D_t pos, const Coord2D_t *const offset, const char *comment)
+{
+    char x[GCODE_NUMBER_LENGTH];                   // X value
+    char y[GCODE_NUMBER_LENGTH];                   // Y value
+    *FormatFixed(x, pos.x, self->decimals) = '\0'; // Format X
+    *FormatFixed(y, pos.y, self->decimals) = '\0'; // Format Y
+    char i[GCODE_NUMBER_LENGTH] = "";              // I value
+    char j[GCODE_NUMBER_LENGTH] = "";              // J value
+    if (offset)                                    // Arc
+    {
+        *FormatFixed(i, offset->x, self->decimals) = '\0'; // Format I
+        *FormatFixed(j, offset->y, self->decimals) = '\0'; // Format J
+    }
+
+    const size_t fullLength = strlen(spindle) + 1 + strlen(motion)           // "S1000 G1"
+                              + 2 + strlen(x) + 2 + strlen(y)                // " X.. Y.."
+                              + (offset ? 2 + strlen(i) + 2 + strlen(j) : 0) // " I.. J.."
+                              + (comment ? 3 + strlen(comment) : 0)          // " ; comment"
+                              + 1;                                           // Newline
+
+    char *p = out;      // Write position
+    if (!self->compact) // Every word on every line
+    {
+        p = _append(p, spindle); // Spindle word
+        *p++ = ' ';              // Separator
+        p = _append(p, motion);  // Motion word
+        p = _append(p, " X");    // X word
+        p = _append(p, x);       // X value
+        p = _append(p, " Y");    // Y word
+        p = _append(p, y);       // Y value
+        if (offset)              // Arc centre
+        {
+            p = _append(p, " I"); // I word
+            p = _append(p, i);    // I value
+            p = _append(p, " J"); // J word
+            p = _append(p, j);    // J value
+        }
+        if (comment)             // Optional comment
+        {
+            p = _append(p, " ; ");   // Comment separator
+            p = _append(p, comment); // Comment text
+        }
+    }
+    else // Only words that change the controller's state
+    {
+        _trimNumber(x);           // Shorten X
+        _trimNumber(y);           // Shorten Y
+        if (strcmp(x, "-0") == 0) // Same position as 0
+            strcpy(x, "0");       // Drop the sign
+        if (strcmp(y, "-0") == 0) // Same position as 0
+            strcpy(y, "0");       // Drop the sign
+
+        const bool spindleSet = !self->known || strcmp(spindle, self->spindle) != 0; // Spindle changed
+        const bool motionSet = !self->known || strcmp(motion, self->motion) != 0;    // Motion mode changed
+        const bool xSet = !self->known || strcmp(x, self->x) != 0;                   // X changed
+        const bool ySet = !self->known || strcmp(y, self->y) != 0;                   // Y changed
+        if (!spindleSet && !motionSet && !xSet && !ySet && !offset)                  // Nothing would change
+            return 0;                                                                // No line
+
+        self->spindleLine = spindleSet ? self->next : self->spindleLine; // Line that sets each word
+        self->motionLine = motionSet ? self->next : self->motionLine;    // to the value
+        self->xLine = xSet ? self->next : self->xLine;                   // the controller
+        self->yLine = ySet ? self->next : self->yLine;                   // will hold
+
+        if (spindleSet || self->spindleLine > self->answered) // Spindle set by this or an unanswered line
+            p = _append(p, spindle);                          // Spindle word
+        if (motionSet || self->motionLine > self->answered)   // Motion set by this or an unanswered line
+            p = _append(p, motion);                           // Motion word
+        if (xSet || self->xLine > self->answered)             // X set by this or an unanswered line
+        {
+            *p++ = 'X';        // X word
+            p = _append(p, x); // X value
+        }
+        if (ySet || self->yLine > self->answered) // Y set by this or an unanswered line
+        {
+            *p++ = 'Y';        // Y word
+            p = _append(p, y); // Y value
+        }
+        if (offset) // Arc centre, not modal
+        {
+            _trimNumber(i);    // Shorten I
+            _trimNumber(j);    // Shorten J
+            *p++ = 'I';        // I word
+            p = _append(p, i); // I value
+            *p++ = 'J';        // J word
+            p = _append(p, j); // J value
+        }
+
+        strncpy(self->spindle, spindle, GCODE_WORD_LENGTH - 1); // Remember spindle word
+        self->spindle[GCODE_WORD_LENGTH - 1] = '\0';            // Ensure termination
+        strncpy(self->motion, motion, GCODE_WORD_LENGTH - 1);   // Remember motion word
+        self->motion[GCODE_WORD_LENGTH - 1] = '\0';             // Ensure termination
+        strcpy(self->x, x);                                     // Remember X
+        strcpy(self->y, y);                                     // Remember Y
+        self->known = true;                                     // State now known
+    }
+
+    *p++ = '\n'; // End of line
+    *p = '\0';   // Terminate string
+
+    const size_t length = (size_t)(p - out); // Line length
+    self->lines++;                           // Count line
+    self->bytes += length;                   // Count bytes
+    self->bytesFull += fullLength;           // Count full-mode bytes
+    return length;                           // Return line length
+}
+
+/**
+ * @details
+ * The next line will carry every word again.
+ */
+static void _forget(gcodeWriter_t *const self)
+{
+    self->known = false;     // State unknown
+    self->spindle[0] = '\0'; // No spindle word
+    self->motion[0] = '\0';  // No motion word
+    self->x[0] = '\0';       // No X value
+    self->y[0] = '\0';       // No Y value
+}
+
+/**
+ * @details
+ * The stream answers its lines in order, so every line numbered up to `answered` has had its
+ * reply. A rejection since the last call means the controller may hold none of the words the
+ * writer remembers.
+ */
+static void _track(gcodeWriter_t *const self, const unsigned long next, const unsigned long answered,
+                   const unsigned long rejected)
+{
+    if (rejected != self->rejected) // Check if a line was rejected
+        _forget(self);              // Send every word again
+    self->next = next;              // Number of the next line
+    self->answered = answered;      // Lines answered
+    self->rejected = rejected;      // Lines rejected
+}
+
+/**
+ * @details
+ * Used at the start of each job so the counters describe that job only.
+ */
+static void _resetCounters(gcodeWriter_t *const self)
+{
+    self->lines = 0;     // No lines
+    self->bytes = 0;     // No bytes
+    self->bytesFull = 0; // No bytes
+}
+
+/**
+ * @details
+ * Numbers without a decimal point are left alone, so the zeros of "100" are kept.
+ */
+static void _trimNumber(char *const number)
+{
+    if (!strchr(number, '.')) // No fraction part
+        return;               // Nothing to trim
+
+    size_t length = strlen(number);   // Current length
+    while (number[length - 1] == '0') // Trailing zeros
+        length--;                     // Drop them
+    if (number[length - 1] == '.')    // Bare decimal point
+        length--;                     // Drop it
+    number[length] = '\0';            // Terminate shortened number
+}
+
+/**
+ * @details
+ * Used for the short strings of a command line, so a plain loop beats strlen() plus memcpy().
+ */
+static inline char *_append(char *out, const char *text)
+{
+    while (*text)         // Until the terminator
+        *out++ = *text++; // Copy character
+    return out;           // Point past the text
+}
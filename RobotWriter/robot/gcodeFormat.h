@@ -0,0 +1,149 @@
+/**
+ * @file gcodeFormat.h
+ * @brief Declarations of the fixed-point number formatter and the G-code line writer.
+ * @details
+ * Coordinates are sent as fixed-point decimals ("%.2f" by default). Formatting them with
+ * snprintf() goes through the general, locale-aware floating-point conversion for every number,
+ * which is the main CPU cost of turning text into G-code. FormatFixed() produces exactly the same
+ * bytes by rounding to an integer number of the last decimal and writing its digits directly.
+ *
+ * The gcodeWriter_t builds move lines from these numbers. In compact mode it tracks the modal
+ * state of the controller and leaves out every word that would not change it, which cuts the
+ * bytes that have to cross the serial line without changing the motion.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../misc/coord.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define GCODE_NUMBER_LENGTH 320 /**< Room FormatFixed() may need for one number: "%.6f" of -DBL_MAX plus a terminator. */
+#define GCODE_LINE_LENGTH 1408  /**< Room gcodeWriter_t::move() or arc() may need for a line with short words and comment. */
+#define GCODE_WORD_LENGTH 16    /**< Longest spindle or motion word kept by the writer, including the terminator. */
+#define GCODE_MAX_DECIMALS 6    /**< Most decimals FormatFixed() and the writer accept. */
+#define GCODE_DECIMALS 2        /**< Default number of decimals for coordinates. */
+#define GCODE_COMPACT false     /**< Default writer mode: true = modal compression, false = every word on every line. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Writes a number with a fixed number of decimals, byte-identical to printf("%.*f").
+ * @details The output is not terminated, so numbers can be written back to back.
+ * @param[out] out Destination with room for GCODE_NUMBER_LENGTH characters.
+ * @param[in] value The number to format.
+ * @param[in] decimals Number of decimals, 0 to GCODE_MAX_DECIMALS.
+ * @return Pointer to the character after the last one written.
+ */
+char *FormatFixed(char *out, const double value, const int decimals);
+
+/**
+ * @brief Structure that builds move lines and remembers what the controller has been told.
+ * @details
+ * In full mode every line reads "<spindle> <motion> X<x> Y<y>[ ; <comment>]\n", exactly what the
+ * robot has always been sent. In compact mode a word is only written when it differs from the
+ * value the controller already holds, numbers lose trailing zeros, spaces and comments are left
+ * out, and a line that would change nothing is not produced at all. Coordinates are compared
+ * after rounding, so the controller ends up with exactly the same targets in both modes.
+ *
+ * When lines are streamed, several are in the controller's buffer before the first is answered,
+ * and any of them may be rejected. Once tracked, the writer keeps writing a word until the line
+ * that set it has been answered, so a rejected line cannot leave a later one running with
+ * the wrong spindle, motion mode or target.
+ *
+ * The writer also counts the lines and bytes it produces, together with the bytes the same
+ * lines would take in full mode.
+ */
+typedef struct gcodeWriter_s
+{
+    bool init;    /**< true once the writer has been constructed. */
+    bool compact; /**< true to leave out words the controller already holds. */
+    int decimals; /**< Number of decimals written for coordinates. */
+
+    bool known;                         /**< true when the fields below match the controller's state. */
+    char spindle[GCODE_WORD_LENGTH];    /**< Last spindle word sent, e.g. "S1000". */
+    char motion[GCODE_WORD_LENGTH];     /**< Last motion word sent, e.g. "G1". */
+    char x[GCODE_NUMBER_LENGTH];        /**< Last X value sent, as written. */
+    char y[GCODE_NUMBER_LENGTH];        /**< Last Y value sent, as written. */
+    unsigned long spindleLine;          /**< Number of the line that set the spindle word. */
+    unsigned long motionLine;           /**< Number of the line that set the motion word. */
+    unsigned long xLine;                /**< Number of the line that set X. */
+    unsigned long yLine;                /**< Number of the line that set Y. */
+
+    unsigned long next;     /**< Number the controller's stream gives the next line. */
+    unsigned long answered; /**< Lines the controller has answered, ULONG_MAX until tracked. */
+    unsigned long rejected; /**< Lines the controller has rejected. */
+
+    unsigned long lines;     /**< Lines produced since the counters were reset. */
+    unsigned long bytes;     /**< Bytes produced since the counters were reset. */
+    unsigned long bytesFull; /**< Bytes the same lines take in full mode. */
+
+    /**
+     * @brief Builds a move line.
+     * @param[in,out] self Pointer to the gcodeWriter_t structure.
+     * @param[out] out Destination with room for GCODE_LINE_LENGTH characters.
+     * @param[in] spindle Spindle word, e.g. "S1000".
+     * @param[in] motion Motion word, e.g. "G1".
+     * @param[in] pos Target position in millimetres.
+     * @param[in] comment Text of a trailing comment, or NULL for none.
+     * @return Length of the terminated line, or 0 if in compact mode the move changes nothing.
+     */
+    size_t (*move)(struct gcodeWriter_s *const self, char *const out, const char *spindle, const char *motion,
+                   const Coord2D_t pos, const char *comment);
+
+    /**
+     * @brief Builds an arc line.
+     * @details Written like a move line, followed by the I and J words of the centre offset,
+     *          which are always written since they are not modal.
+     * @param[in,out] self Pointer to the gcodeWriter_t structure.
+     * @param[out] out Destination with room for GCODE_LINE_LENGTH characters.
+     * @param[in] spindle Spindle word, e.g. "S1000".
+     * @param[in] motion Motion word, "G2" or "G3".
+     * @param[in] pos Target position in millimetres.
+     * @param[in] offset Centre of the arc relative to its start, in millimetres.
+     * @return Length of the terminated line.
+     */
+    size_t (*arc)(struct gcodeWriter_s *const self, char *const out, const char *spindle, const char *motion,
+                  const Coord2D_t pos, const Coord2D_t offset);
+
+    /**
+     * @brief Forgets the controller's modal state, e.g. after commands were sent around the writer.
+     * @param[in,out] self Pointer to the gcodeWriter_t structure.
+     */
+    void (*forget)(struct gcodeWriter_s *const self);
+
+    /**
+     * @brief Tells the writer how far the controller has got with the lines streamed to it.
+     * @details Called before each line is built. In compact mode a word set by a line that has not
+     *          been answered is written again, and a new rejection makes the writer forget the
+     *          controller's state. A writer that is never tracked takes every line as answered.
+     * @param[in,out] self Pointer to the gcodeWriter_t structure.
+     * @param[in] next Number the stream gives the next line.
+     * @param[in] answered Lines the controller has answered; lines are answered in order.
+     * @param[in] rejected Lines the controller has rejected.
+     */
+    void (*track)(struct gcodeWriter_s *const self, const unsigned long next, const unsigned long answered,
+                  const unsigned long rejected);
+
+    /**
+     * @brief Resets the line and byte counters.
+     * @param[in,out] self Pointer to the gcodeWriter_t structure.
+     */
+    void (*resetCounters)(struct gcodeWriter_s *const self);
+} gcodeWriter_t;
+
+/**
+ * @brief Constructs and initializes a new gcodeWriter_t object.
+ * @param[in] compact true for modal compression, false to write every word on every line.
+ * @param[in] decimals Number of decimals for coordinates, clamped to 0 to GCODE_MAX_DECIMALS.
+ * @return The newly created gcodeWriter_t object.
+ */
+gcodeWriter_t gcodeWriterConstructor(const bool compact, const int decimals);
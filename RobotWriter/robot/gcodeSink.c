@@ -0,0 +1,365 @@
+/**
+ * @file gcodeSink.c
+ * @brief Implementation of the G-code sinks.
+ * @details
+ * Each kind of sink sets its own write() and flush() functions; one free() releases whatever a
+ * sink holds. A file sink copies lines into its buffer and hands the buffer to fwrite() once it
+ * is full, when it is flushed, or when a line would not fit, so stdio sees a few large writes
+ * instead of one per line.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "gcodeSink.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Allocates a sink with every field cleared and the free function set.
+ * @return A pointer to the new sink, or NULL if allocation fails.
+ */
+static gcodeSink_t *_allocate(void);
+
+/**
+ * @brief Copies a line into the buffer of a file sink, writing the buffer first if it is full.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @param[in] line The line.
+ * @param[in] length Length of the line.
+ * @return SUCCESS, ERROR_OUTPUT_WRITE, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _fileWrite(gcodeSink_t *const self, const char *const line, const size_t length);
+
+/**
+ * @brief Writes the buffer of a file sink and flushes the file.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return SUCCESS, ERROR_OUTPUT_WRITE, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _fileFlush(gcodeSink_t *const self);
+
+/**
+ * @brief Writes the buffer of a file sink to the file.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return SUCCESS, or ERROR_OUTPUT_WRITE if the file could not be written.
+ */
+static errorCode_t _fileDrain(gcodeSink_t *const self);
+
+/**
+ * @brief Drops a line.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @param[in] line The line.
+ * @param[in] length Length of the line.
+ * @return SUCCESS, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _nullWrite(gcodeSink_t *const self, const char *const line, const size_t length);
+
+/**
+ * @brief Does nothing, a null sink holds nothing.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return SUCCESS, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _nullFlush(gcodeSink_t *const self);
+
+/**
+ * @brief Sends a line to the controller.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @param[in] line The line.
+ * @param[in] length Length of the line.
+ * @return SUCCESS, ERROR_CONTROLLER_REPLY, a serial port error, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _serialWrite(gcodeSink_t *const self, const char *const line, const size_t length);
+
+/**
+ * @brief Waits until the controller has answered every line.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return SUCCESS, ERROR_CONTROLLER_REPLY, a serial port error, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _serialFlush(gcodeSink_t *const self);
+
+/**
+ * @brief Passes a line to both sinks of a tee.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @param[in] line The line.
+ * @param[in] length Length of the line.
+ * @return The worse of the two results, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _teeWrite(gcodeSink_t *const self, const char *const line, const size_t length);
+
+/**
+ * @brief Flushes both sinks of a tee.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return The worse of the two results, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _teeFlush(gcodeSink_t *const self);
+
+/**
+ * @brief Flushes and frees a sink and what it owns.
+ * @param[in,out] self Pointer to the gcodeSink_t structure.
+ * @return SUCCESS, the error of the final flush or close, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _free(gcodeSink_t *self);
+
+/**
+ * @brief Picks the result to report out of two.
+ * @param[in] a First result.
+ * @param[in] b Second result.
+ * @return An error over SUCCESS, and any other error over ERROR_CONTROLLER_REPLY, which only
+ *         concerns one line.
+ */
+static inline errorCode_t _worse(const errorCode_t a, const errorCode_t b);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Allocates the sink and its GCODE_SINK_BUFFER_SIZE byte buffer.
+ */
+gcodeSink_t *gcodeFileSinkConstructor(FILE *const file, const bool closeFile)
+{
+    if (!file) // Check if file is NULL
+    {
+        ErrorHandler(ERROR_NULL_POINTER); // Handle error
+        return NULL;                      // Return NULL
+    }
+
+    gcodeSink_t *sink = _allocate(); // Allocate sink
+    if (!sink)                       // Check if allocation failed
+        return NULL;                 // Return NULL
+
+    sink->buffer = malloc(GCODE_SINK_BUFFER_SIZE); // Allocate buffer
+    if (!sink->buffer)                             // Check if allocation failed
+    {
+        free(sink);                                   // Free sink
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    sink->file = file;                       // Set file
+    sink->closeFile = closeFile;             // Set ownership
+    sink->capacity = GCODE_SINK_BUFFER_SIZE; // Set buffer size
+    sink->write = _fileWrite;                // Function pointer to write a line
+    sink->flush = _fileFlush;                // Function pointer to flush the sink
+    return sink;                             // Return gcodeSink_t
+}
+
+gcodeSink_t *gcodeNullSinkConstructor(void)
+{
+    gcodeSink_t *sink = _allocate(); // Allocate sink
+    if (!sink)                       // Check if allocation failed
+        return NULL;                 // Return NULL
+
+    sink->write = _nullWrite; // Function pointer to write a line
+    sink->flush = _nullFlush; // Function pointer to flush the sink
+    return sink;              // Return gcodeSink_t
+}
+
+gcodeSink_t *gcodeSerialSinkConstructor(grblStream_t *const stream)
+{
+    if (!stream) // Check if stream is NULL
+    {
+        ErrorHandler(ERROR_NULL_POINTER); // Handle error
+        return NULL;                      // Return NULL
+    }
+
+    gcodeSink_t *sink = _allocate(); // Allocate sink
+    if (!sink)                       // Check if allocation failed
+    {
+        stream->free(stream); // Free stream
+        return NULL;          // Return NULL
+    }
+
+    sink->stream = stream;      // Set stream
+    sink->write = _serialWrite; // Function pointer to write a line
+    sink->flush = _serialFlush; // Function pointer to flush the sink
+    return sink;                // Return gcodeSink_t
+}
+
+gcodeSink_t *gcodeTeeSinkConstructor(gcodeSink_t *const first, gcodeSink_t *const second)
+{
+    gcodeSink_t *sink = first && second ? _allocate() : NULL; // Allocate sink if both targets exist
+    if (!sink)                                                // Check if construction failed
+    {
+        if (first)                // Check if first is created
+            first->free(first);   // Free it
+        if (second)               // Check if second is created
+            second->free(second); // Free it
+        return NULL;              // Return NULL
+    }
+
+    sink->first = first;     // Set first sink
+    sink->second = second;   // Set second sink
+    sink->write = _teeWrite; // Function pointer to write a line
+    sink->flush = _teeFlush; // Function pointer to flush the sink
+    return sink;             // Return gcodeSink_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static gcodeSink_t *_allocate(void)
+{
+    gcodeSink_t *sink = calloc(1, sizeof(gcodeSink_t)); // Allocate cleared memory for gcodeSink_t
+    if (!sink)                                          // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    sink->free = _free; // Function pointer to free the sink
+    return sink;        // Return gcodeSink_t
+}
+
+/**
+ * @details
+ * A line that does not fit in what is left of the buffer sends the buffer out first; a line
+ * longer than the whole buffer is then written straight to the file.
+ */
+static errorCode_t _fileWrite(gcodeSink_t *const self, const char *const line, const size_t length)
+{
+    if (!self || !line)                          // Check if self or line is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    if (self->used + length > self->capacity) // Check if the line does not fit
+    {
+        const errorCode_t error = _fileDrain(self); // Write the buffer
+        if (error != SUCCESS)                       // Check if writing failed
+            return error;                           // Return error
+    }
+
+    if (length > self->capacity)                             // Check if the line is longer than the buffer
+        return fwrite(line, 1, length, self->file) == length // Write it straight away
+                   ? SUCCESS
+                   : ErrorHandler(ERROR_OUTPUT_WRITE);
+
+    memcpy(&self->buffer[self->used], line, length); // Copy line into the buffer
+    self->used += length;                            // Count it
+    return SUCCESS;                                  // Return success
+}
+
+static errorCode_t _fileFlush(gcodeSink_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    const errorCode_t error = _fileDrain(self);  // Write the buffer
+    if (error != SUCCESS)                        // Check if writing failed
+        return error;                            // Return error
+    if (fflush(self->file) != 0)                 // Flush the file
+        return ErrorHandler(ERROR_OUTPUT_WRITE); // Handle error
+    return SUCCESS;                              // Return success
+}
+
+/**
+ * @details
+ * The buffer is emptied even if the write fails, so a full disk is reported once per buffer
+ * rather than for every line after it.
+ */
+static errorCode_t _fileDrain(gcodeSink_t *const self)
+{
+    const size_t used = self->used;                                    // Bytes waiting
+    self->used = 0;                                                    // Empty the buffer
+    if (used > 0 && fwrite(self->buffer, 1, used, self->file) != used) // Write them
+        return ErrorHandler(ERROR_OUTPUT_WRITE);                       // Handle error
+    return SUCCESS;                                                    // Return success
+}
+
+static errorCode_t _nullWrite(gcodeSink_t *const self, const char *const line, const size_t length)
+{
+    (void)length;                                // Nothing is written
+    if (!self || !line)                          // Check if self or line is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    return SUCCESS;                              // Return success
+}
+
+static errorCode_t _nullFlush(gcodeSink_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    return SUCCESS;                              // Return success
+}
+
+/**
+ * @details
+ * The stream measures the line itself, so only the null terminator is needed.
+ */
+static errorCode_t _serialWrite(gcodeSink_t *const self, const char *const line, const size_t length)
+{
+    (void)length;                                  // Stream measures the line
+    if (!self || !line)                            // Check if self or line is NULL
+        return ErrorHandler(ERROR_NULL_POINTER);   // Handle error
+    return self->stream->send(self->stream, line); // Send line
+}
+
+static errorCode_t _serialFlush(gcodeSink_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    return self->stream->sync(self->stream);     // Wait for every reply
+}
+
+/**
+ * @details
+ * The second sink gets the line even if the first one failed, so a file still records what
+ * was meant for a controller that stopped answering.
+ */
+static errorCode_t _teeWrite(gcodeSink_t *const self, const char *const line, const size_t length)
+{
+    if (!self || !line)                          // Check if self or line is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    const errorCode_t first = self->first->write(self->first, line, length);    // Write to the first sink
+    const errorCode_t second = self->second->write(self->second, line, length); // Write to the second sink
+    return _worse(first, second);                                               // Return worse result
+}
+
+static errorCode_t _teeFlush(gcodeSink_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    const errorCode_t first = self->first->flush(self->first);    // Flush the first sink
+    const errorCode_t second = self->second->flush(self->second); // Flush the second sink
+    return _worse(first, second);                                 // Return worse result
+}
+
+/**
+ * @details
+ * File sinks write what is left in their buffer before the file is closed; a serial sink does
+ * not wait for the controller, which is the caller's choice to make with flush().
+ */
+static errorCode_t _free(gcodeSink_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    errorCode_t error = SUCCESS; // Worst result
+    if (self->file)              // File sink
+    {
+        error = _fileFlush(self);                                    // Write what is left
+        if (self->closeFile && fclose(self->file) != 0)              // Close the file if owned
+            error = _worse(error, ErrorHandler(ERROR_OUTPUT_WRITE)); // Remember the error
+    }
+    if (self->stream)                                            // Serial sink
+        self->stream->free(self->stream);                        // Free the stream
+    if (self->first)                                             // Tee
+        error = _worse(error, self->first->free(self->first));   // Free the first sink
+    if (self->second)                                            // Tee
+        error = _worse(error, self->second->free(self->second)); // Free the second sink
+
+    free(self->buffer); // Free buffer
+    free(self);         // Free gcodeSink_t
+    return error;       // Return worst result
+}
+
+static inline errorCode_t _worse(const errorCode_t a, const errorCode_t b)
+{
+    if (a == SUCCESS || (a == ERROR_CONTROLLER_REPLY && b != SUCCESS)) // Check if b matters more
+        return b;                                                      // Return b
+    return a;                                                          // Return a
+}
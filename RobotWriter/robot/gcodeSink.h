@@ -0,0 +1,106 @@
+/**
+ * @file gcodeSink.h
+ * @brief Declaration of the gcodeSink_t structure, a destination for the G-code lines of a job.
+ * @details
+ * Every line the robot sends goes to a sink: the controller, a G-code file, stdout, nowhere at
+ * all, or several of these at once. The sinks share one interface, so the destinations of a run
+ * are picked when the program starts instead of when it is compiled.
+ *
+ * File sinks, which include stdout, collect the lines in a large buffer and write it in one go,
+ * so a terminal is not asked to show each short line on its own. The null sink drops the lines,
+ * which leaves only the cost of generating them, and the tee passes each line to two sinks.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "../misc/error.h"
+#include "grbl.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define GCODE_SINK_BUFFER_SIZE 65536 /**< Bytes a file sink collects before writing them. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Structure that takes G-code lines and passes them on to a destination.
+ * @details
+ * Only the fields of the sink's own kind are used; the others stay zero or NULL.
+ */
+typedef struct gcodeSink_s
+{
+    FILE *file;      /**< File written by a file sink. */
+    bool closeFile;  /**< true if freeing the sink closes the file. */
+    char *buffer;    /**< Bytes waiting to be written to the file. */
+    size_t capacity; /**< Size of the buffer. */
+    size_t used;     /**< Bytes in the buffer. */
+
+    grblStream_t *stream; /**< Stream to the controller of a serial sink, owned by the sink. */
+
+    struct gcodeSink_s *first;  /**< First sink of a tee, owned by the tee. */
+    struct gcodeSink_s *second; /**< Second sink of a tee, owned by the tee. */
+
+    /**
+     * @brief Passes a line on.
+     * @param[in,out] self Pointer to the gcodeSink_t structure.
+     * @param[in] line Newline-terminated G-code line, followed by a null terminator.
+     * @param[in] length Length of the line without the null terminator.
+     * @return SUCCESS, ERROR_CONTROLLER_REPLY or a serial port error from a serial sink,
+     *         ERROR_OUTPUT_WRITE if a file could not be written, or ERROR_NULL_POINTER.
+     */
+    errorCode_t (*write)(struct gcodeSink_s *const self, const char *const line, const size_t length);
+
+    /**
+     * @brief Passes on everything written so far.
+     * @details A file sink writes its buffer and flushes the file; a serial sink waits until the
+     *          controller has answered every line.
+     * @param[in,out] self Pointer to the gcodeSink_t structure.
+     * @return The same errors as write().
+     */
+    errorCode_t (*flush)(struct gcodeSink_s *const self);
+
+    /**
+     * @brief Flushes and frees the sink, together with the stream or sinks it owns.
+     * @param[in,out] self Pointer to the gcodeSink_t structure.
+     * @return SUCCESS, the error of the final flush or close, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct gcodeSink_s *self);
+} gcodeSink_t;
+
+/**
+ * @brief Constructs a sink that writes to a file, or to stdout.
+ * @param[in] file Open file to write to.
+ * @param[in] closeFile true to close the file when the sink is freed; false for stdout.
+ * @return A pointer to the newly created gcodeSink_t object, or NULL if allocation fails.
+ */
+gcodeSink_t *gcodeFileSinkConstructor(FILE *const file, const bool closeFile);
+
+/**
+ * @brief Constructs a sink that drops every line.
+ * @return A pointer to the newly created gcodeSink_t object, or NULL if allocation fails.
+ */
+gcodeSink_t *gcodeNullSinkConstructor(void);
+
+/**
+ * @brief Constructs a sink that sends the lines to the controller.
+ * @param[in] stream Stream to the controller; the sink frees it, also if construction fails.
+ * @return A pointer to the newly created gcodeSink_t object, or NULL if allocation fails.
+ */
+gcodeSink_t *gcodeSerialSinkConstructor(grblStream_t *const stream);
+
+/**
+ * @brief Constructs a sink that passes every line to two sinks, in order.
+ * @param[in] first Sink written first; the tee frees it, also if construction fails.
+ * @param[in] second Sink written second; the tee frees it, also if construction fails.
+ * @return A pointer to the newly created gcodeSink_t object, or NULL if allocation fails.
+ */
+gcodeSink_t *gcodeTeeSinkConstructor(gcodeSink_t *const first, gcodeSink_t *const second);
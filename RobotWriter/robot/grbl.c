@@ -0,0 +1,320 @@
+/**
+ * @file grbl.c
+ * @brief Implementation of the character-counting G-code stream for GRBL controllers.
+ * @details
+ * Lines are written to the serial port as soon as the controller's receive buffer has room for
+ * them, so the planner is kept fed while earlier lines are still being executed. Every "ok" or
+ * "error:N" reply retires the oldest unacknowledged line. Other controller output (the startup
+ * banner, "[MSG:...]" feedback, status reports) does not acknowledge anything and is ignored.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "grbl.h"
+#include "../lib/serial.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Queues a line for the controller once it fits in the receive buffer.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @param[in] line Newline-terminated G-code line.
+ * @return SUCCESS, ERROR_CONTROLLER_REPLY, ERROR_CONTROLLER_STATE, a serial port error, or
+ *         ERROR_NULL_POINTER.
+ */
+static errorCode_t _send(grblStream_t *const self, const char *const line);
+
+/**
+ * @brief Reads and handles controller replies.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @param[in] block true to wait until a pending line has been answered.
+ * @return SUCCESS, ERROR_CONTROLLER_REPLY if a reply was an error, ERROR_CONTROLLER_STATE if too
+ *         many in a row were, ERROR_SERIAL_READ or ERROR_SERIAL_WRITE, or ERROR_SERIAL_TIMEOUT if the
+ *         controller stayed silent.
+ */
+static errorCode_t _service(grblStream_t *const self, const bool block);
+
+/**
+ * @brief Waits until every line sent has been answered.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @return SUCCESS, ERROR_CONTROLLER_REPLY if a reply was an error, ERROR_CONTROLLER_STATE, or a
+ *         serial port error.
+ */
+static errorCode_t _sync(grblStream_t *const self);
+
+/**
+ * @brief Writes the queued lines to the port.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @return SUCCESS, ERROR_SERIAL_WRITE, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _push(grblStream_t *const self);
+
+/**
+ * @brief Retires the oldest pending line in response to a reply.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @param[in] reply The reply line received from the controller.
+ * @return SUCCESS for "ok", ERROR_CONTROLLER_REPLY for "error:N", or ERROR_CONTROLLER_STATE for
+ *         the last of GRBL_MAX_ERROR_RUN of them in a row.
+ */
+static errorCode_t _acknowledge(grblStream_t *const self, const char *const reply);
+
+/**
+ * @brief Frees the stream.
+ * @param[in,out] self Pointer to the grblStream_t structure.
+ * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
+ */
+static errorCode_t _free(grblStream_t *self);
+
+/**
+ * @brief Checks whether an error means the controller can no longer be reached.
+ * @param[in] error The error code to test.
+ * @return true for serial read, write and timeout errors and a lost controller state, false otherwise.
+ */
+static inline bool _portFailed(const errorCode_t error);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Allocates the stream with an empty pending ring and sets the function pointers. A receive
+ * buffer size of zero is treated as the GRBL default.
+ */
+grblStream_t *grblStreamConstructor(const size_t rxBufferSize, const bool streaming)
+{
+    grblStream_t *stream = malloc(sizeof(grblStream_t)); // Allocate memory for grblStream_t
+    if (!stream)                                         // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    stream->rxBufferSize = rxBufferSize ? rxBufferSize : GRBL_RX_BUFFER_SIZE; // Set receive buffer size
+    stream->bytesInFlight = 0;                                               // Nothing sent yet
+    stream->streaming = streaming;                                           // Set streaming mode
+    stream->pendingHead = 0;                                                 // Empty pending ring
+    stream->pendingCount = 0;                                                // Empty pending ring
+    stream->linesSent = 0;                                                   // Reset counters
+    stream->linesAcked = 0;                                                  // Reset counters
+    stream->linesError = 0;                                                  // Reset counters
+    stream->errorRun = 0;                                                    // Reset counters
+    stream->failure = SUCCESS;                                               // Port works
+
+    stream->send = _send;       // Function pointer to send a line
+    stream->service = _service; // Function pointer to process replies
+    stream->sync = _sync;       // Function pointer to wait for all replies
+    stream->push = _push;       // Function pointer to write the queued lines
+    stream->free = _free;       // Function pointer to free the stream
+    return stream;              // Return grblStream_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Waits for replies while the line would overflow the controller's receive buffer (or while
+ * the pending ring is full), then queues it for the port and records it as pending. A line
+ * longer than the whole buffer is sent once everything before it has been acknowledged.
+ *
+ * Queued lines are written in one batch when the stream next has to wait for a reply, or when
+ * push() is called, so a burst of short lines that fits in the controller's buffer costs a
+ * single write. In non-streaming mode the function waits for the line's own reply before
+ * returning.
+ */
+static errorCode_t _send(grblStream_t *const self, const char *const line)
+{
+    if (!self || !line)                          // Check if self or line is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    if (self->failure != SUCCESS)                // Check if the port failed before
+        return self->failure;                    // Already reported
+
+    errorCode_t result = SUCCESS;       // Worst reply seen while sending
+    const size_t length = strlen(line); // Bytes the line occupies in the receive buffer
+
+    while (self->pendingCount > 0 &&                             // Wait while something is pending and
+           (self->bytesInFlight + length > self->rxBufferSize || // the line does not fit in the buffer
+            self->pendingCount == GRBL_MAX_PENDING_LINES))       // or the pending ring is full
+    {
+        const errorCode_t error = _service(self, true); // Wait for a reply
+        if (_portFailed(error))                         // Check if the port failed
+            return error;                               // Give up
+        if (error != SUCCESS)                           // Check if the reply was an error
+            result = error;                             // Remember the error
+    }
+
+    const size_t slot = (self->pendingHead + self->pendingCount) % GRBL_MAX_PENDING_LINES; // Next free slot
+    strncpy(self->pendingText[slot], line, GRBL_MAX_LINE_LENGTH - 1);                      // Keep a copy for error reports
+    self->pendingText[slot][GRBL_MAX_LINE_LENGTH - 1] = '\0';                              // Ensure termination
+    self->pendingLength[slot] = length;                                                    // Record line length
+    self->pendingNumber[slot] = ++self->linesSent;                                         // Record line number
+    self->pendingCount++;                                                                  // One more pending line
+    self->bytesInFlight += length;                                                         // Bytes now in the buffer
+
+    if (QueueBuffer(line) != 0)                                   // Queue the line for the port
+        return self->failure = ErrorHandler(ERROR_SERIAL_WRITE); // Handle error and end the stream
+
+    if (!self->streaming) // Waiting for each reply
+    {
+        const errorCode_t error = _service(self, true); // Send the line and wait for its reply
+        if (error != SUCCESS)                           // Check if the reply was an error
+            result = error;                             // Remember the error
+    }
+
+    return result; // Return worst reply
+}
+
+/**
+ * @details
+ * Reads complete reply lines from the port. "ok" and "error:N" replies retire a pending line,
+ * anything else is controller chatter. When blocking, queued lines are sent first, then the
+ * function sleeps until data arrives and returns once a pending line has been answered, or fails
+ * if the controller stays silent for the serial timeout. Otherwise it returns as soon as no
+ * complete line is available.
+ */
+static errorCode_t _service(grblStream_t *const self, const bool block)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    if (self->failure != SUCCESS)                // Check if the port failed before
+        return self->failure;                    // Already reported
+
+    errorCode_t result = SUCCESS;   // Worst reply seen
+    char reply[SERIAL_LINE_LENGTH]; // Reply line buffer
+
+    if (block && FlushBuffer() != 0)                             // Lines waited on must have been sent
+        return self->failure = ErrorHandler(ERROR_SERIAL_WRITE); // Handle error and end the stream
+
+    while (self->pendingCount > 0) // Only replies to pending lines matter
+    {
+        const int status = block ? WaitForReplyLine(reply, sizeof(reply), GetSerialTimeout()) // Wait for a reply line
+                                 : ReadReplyLine(reply, sizeof(reply));                       // or take one if available
+        if (status < 0)                                                                       // Check for a port error
+            return self->failure = ErrorHandler(ERROR_SERIAL_READ);                           // Handle error and end the stream
+
+        if (status == 0) // No complete line
+        {
+            if (!block)        // Nothing to wait for
+                return result; // Return worst reply
+
+            const size_t slot = self->pendingHead;                      // Line still waiting for a reply
+            fprintf(stderr, "No reply from controller to line %lu: %s", // Report it
+                    self->pendingNumber[slot], self->pendingText[slot]);
+            return self->failure = ErrorHandler(ERROR_SERIAL_TIMEOUT); // Handle error and end the stream
+        }
+
+        if (strncmp(reply, "ok", 2) != 0 && strncmp(reply, "error", 5) != 0) // Not an acknowledgement
+            continue;                                                        // Ignore chatter
+
+        const errorCode_t error = _acknowledge(self, reply); // Retire the oldest pending line
+        if (error == ERROR_CONTROLLER_STATE)                 // Check if the controller's state is lost
+            return self->failure = error;                    // End the stream
+        if (error != SUCCESS)                                // Check if the reply was an error
+            result = error;                                  // Remember the error
+
+        if (block)         // One reply was all we waited for
+            return result; // Return worst reply
+    }
+
+    return result; // Return worst reply
+}
+
+/**
+ * @details
+ * Blocks on replies until the pending ring is empty, remembering whether any of them was an error.
+ * A stream whose port has failed returns that error without waiting, as its replies are lost.
+ */
+static errorCode_t _sync(grblStream_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    errorCode_t result = SUCCESS;  // Worst reply seen
+    while (self->pendingCount > 0) // Wait for every pending line
+    {
+        const errorCode_t error = _service(self, true); // Wait for a reply
+        if (_portFailed(error))                         // Check if the port failed
+            return error;                               // Give up
+        if (error != SUCCESS)                           // Check if the reply was an error
+            result = error;                             // Remember the error
+    }
+
+    return result; // Return worst reply
+}
+
+/**
+ * @details
+ * Only the port is written to; the lines stay pending until they are answered.
+ */
+static errorCode_t _push(grblStream_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    if (self->failure != SUCCESS)                                // Check if the port failed before
+        return self->failure;                                    // Already reported
+    if (FlushBuffer() != 0)                                      // Write the queued lines
+        return self->failure = ErrorHandler(ERROR_SERIAL_WRITE); // Handle error and end the stream
+    return SUCCESS;                                              // Return success
+}
+
+/**
+ * @details
+ * Replies arrive in the same order as the lines they answer, so the oldest pending line is the
+ * one being acknowledged. Its bytes have left the controller's receive buffer and are released.
+ * Error replies are reported together with the line number and text that caused them. A single
+ * rejected line is skipped, but when GRBL_MAX_ERROR_RUN lines in a row are rejected, the
+ * controller has most likely lost a state every line depends on, such as the feed rate, and
+ * the stream gives up instead of sending the rest of the job into errors.
+ */
+static errorCode_t _acknowledge(grblStream_t *const self, const char *const reply)
+{
+    const size_t slot = self->pendingHead;                               // Oldest pending line
+    self->pendingHead = (self->pendingHead + 1) % GRBL_MAX_PENDING_LINES; // Retire it
+    self->pendingCount--;                                                // One less pending line
+    self->bytesInFlight -= self->pendingLength[slot];                    // Release its bytes
+
+    if (reply[0] == 'o') // "ok"
+    {
+        self->linesAcked++;  // Count acknowledgement
+        self->errorRun = 0;  // The controller accepts lines again
+        return SUCCESS;      // Return success
+    }
+
+    self->linesError++;                                       // Count error
+    fprintf(stderr, "GRBL %s on line %lu: %s", reply,         // Report the reply
+            self->pendingNumber[slot], self->pendingText[slot]); // and the line that caused it
+    if (++self->errorRun >= GRBL_MAX_ERROR_RUN)               // Check if every line is rejected
+        return ErrorHandler(ERROR_CONTROLLER_STATE);          // Handle error
+    return ErrorHandler(ERROR_CONTROLLER_REPLY);              // Handle error
+}
+
+/**
+ * @details
+ * Releases the memory held by the stream. Lines still pending are not waited for.
+ */
+static errorCode_t _free(grblStream_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    free(self);     // Free grblStream_t
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * Controller error replies only concern one line, but a failed or silent port, or a controller
+ * that rejects every line, ends the stream.
+ */
+static inline bool _portFailed(const errorCode_t error)
+{
+    return error == ERROR_SERIAL_READ || error == ERROR_SERIAL_WRITE || error == ERROR_SERIAL_TIMEOUT || // Check port errors
+           error == ERROR_CONTROLLER_STATE;                                                             // and a lost state
+}
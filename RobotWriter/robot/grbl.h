@@ -0,0 +1,112 @@
+/**
+ * @file grbl.h
+ * @brief Declaration of the grblStream_t structure used to stream G-code to a GRBL controller.
+ * @details
+ * GRBL keeps a small receive buffer and answers every line it has consumed with "ok" or
+ * "error:N". Instead of waiting for each reply before sending the next line, the stream counts
+ * the bytes that are still unacknowledged and keeps sending as long as the next line fits in
+ * the controller's buffer (the "character counting" protocol). Replies are matched in order
+ * against the lines they answer, so errors can be reported against the offending line.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../misc/error.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define GRBL_RX_BUFFER_SIZE 127    /**< Size of the GRBL serial receive buffer in bytes. */
+#define GRBL_MAX_LINE_LENGTH 128   /**< Longest line (including the newline) kept for error reports. */
+#define GRBL_MAX_PENDING_LINES 128 /**< Most lines that can be unacknowledged at once (one byte each). */
+#define GRBL_MAX_ERROR_RUN 8       /**< Rejected lines in a row after which the controller's state is lost. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Structure tracking lines sent to the controller that have not been acknowledged yet.
+ * @details
+ * The pending lines form a ring buffer in send order. Each reply from the controller retires the
+ * oldest pending line and releases its bytes from `bytesInFlight`. Once the port has failed, every
+ * method returns that error at once, so a shutdown does not wait for the lost replies again.
+ */
+typedef struct grblStream_s
+{
+    size_t rxBufferSize;  /**< Capacity of the controller receive buffer in bytes. */
+    size_t bytesInFlight; /**< Bytes sent but not yet acknowledged. */
+    bool streaming;       /**< true = keep the buffer full, false = wait for each reply. */
+
+    char pendingText[GRBL_MAX_PENDING_LINES][GRBL_MAX_LINE_LENGTH]; /**< Copies of the unacknowledged lines. */
+    size_t pendingLength[GRBL_MAX_PENDING_LINES];                   /**< Byte count of each unacknowledged line. */
+    unsigned long pendingNumber[GRBL_MAX_PENDING_LINES];            /**< Sequence number of each unacknowledged line. */
+    size_t pendingHead;                                             /**< Index of the oldest unacknowledged line. */
+    size_t pendingCount;                                            /**< Number of unacknowledged lines. */
+
+    unsigned long linesSent;  /**< Total number of lines sent. */
+    unsigned long linesAcked; /**< Total number of lines answered with "ok". */
+    unsigned long linesError; /**< Total number of lines answered with "error:N". */
+    unsigned long errorRun;   /**< Lines answered with "error:N" since the last "ok". */
+    errorCode_t failure;      /**< Error that ended the stream, SUCCESS while the port works. */
+
+    /**
+     * @brief Queue a line for the controller, waiting only until it fits in the receive buffer.
+     * @details Queued lines are written to the port in batches; service() and sync() flush them.
+     * @param[in,out] self Pointer to the grblStream_t structure.
+     * @param[in] line Newline-terminated G-code line.
+     * @return SUCCESS on success, ERROR_CONTROLLER_REPLY if a reply processed meanwhile was an error,
+     *         ERROR_CONTROLLER_STATE if GRBL_MAX_ERROR_RUN lines in a row were rejected,
+     *         ERROR_SERIAL_READ, ERROR_SERIAL_WRITE or ERROR_SERIAL_TIMEOUT if the port failed or the
+     *         controller stayed silent, or ERROR_NULL_POINTER if `self` or `line` is NULL.
+     */
+    errorCode_t (*send)(struct grblStream_s *const self, const char *const line);
+
+    /**
+     * @brief Process controller replies.
+     * @param[in,out] self Pointer to the grblStream_t structure.
+     * @param[in] block true to wait until at least one pending line has been answered.
+     * @return SUCCESS, ERROR_CONTROLLER_REPLY if one of the replies was an error,
+     *         ERROR_CONTROLLER_STATE if GRBL_MAX_ERROR_RUN lines in a row were rejected, ERROR_SERIAL_READ,
+     *         ERROR_SERIAL_WRITE, or ERROR_SERIAL_TIMEOUT if no reply arrived within the serial timeout.
+     */
+    errorCode_t (*service)(struct grblStream_s *const self, const bool block);
+
+    /**
+     * @brief Wait until every line sent has been answered.
+     * @param[in,out] self Pointer to the grblStream_t structure.
+     * @return SUCCESS, ERROR_CONTROLLER_REPLY if one of the replies was an error,
+     *         ERROR_CONTROLLER_STATE if GRBL_MAX_ERROR_RUN lines in a row were rejected, ERROR_SERIAL_READ,
+     *         ERROR_SERIAL_WRITE, or ERROR_SERIAL_TIMEOUT if no reply arrived within the serial timeout.
+     */
+    errorCode_t (*sync)(struct grblStream_s *const self);
+
+    /**
+     * @brief Write the queued lines to the port without waiting for a reply.
+     * @details Called before the host spends time on something else, such as planning the next
+     *          strokes, so the controller is not left waiting for lines that were already produced.
+     * @param[in,out] self Pointer to the grblStream_t structure.
+     * @return SUCCESS, ERROR_SERIAL_WRITE if the port failed, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*push)(struct grblStream_s *const self);
+
+    /**
+     * @brief Frees the stream.
+     * @param[in,out] self Pointer to the grblStream_t structure.
+     * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct grblStream_s *self);
+} grblStream_t;
+
+/**
+ * @brief Constructs and initializes a new grblStream_t object.
+ * @param[in] rxBufferSize Capacity of the controller receive buffer in bytes.
+ * @param[in] streaming true to stream with character counting, false to wait for every reply.
+ * @return A pointer to the newly created grblStream_t object, or NULL if allocation fails.
+ */
+grblStream_t *grblStreamConstructor(const size_t rxBufferSize, const bool streaming);
@@ -0,0 +1,525 @@
+/**
+ * @file layout.c
+ * @brief Implementation of the layout, which places the characters of a document on lines.
+ * @details
+ * Characters are placed with a cursor_t exactly as they were when each word was drawn as soon as
+ * it was read: the cursor moves by a character space, or with proportional spacing by the width
+ * of the character, and moves to the next line when it passes the right of the page. Each glyph
+ * records where the cursor was, and each line the height the cursor moved to, so drawing the
+ * layout puts every stroke where drawing word by word did. When the cursor moves from the bottom
+ * of the page to the top of the next, the line it moves to starts a new page.
+ *
+ * With greedy breaking a word is placed as soon as it is added. With balanced breaking the words
+ * of a paragraph, the text up to a newline or carriage return, are copied and measured as they
+ * are added, and placed once the paragraph ends. The breaks are found by dynamic programming over
+ * the words: the least cost of the paragraph up to each word is the least, over the words the
+ * line ending there could start with, of the cost up to that word and the squared space the line
+ * leaves. The last line of a paragraph costs nothing, and a word too wide for any line is given a
+ * line of its own and wrapped like a greedy one.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "layout.h"
+#include "robot.h"
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../misc/utf8.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define LAYOUT_TOLERANCE 1e-9 /**< Room in mm a balanced line keeps, so rounding cannot wrap it. */
+
+/**
+ * @brief Places a word, or holds it back until its paragraph ends.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @param[in] text The word.
+ * @param[in] length Bytes of the word.
+ * @return SUCCESS, ERROR_NULL_POINTER, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _add(layout_t *const self, const char *const text, const size_t length);
+
+/**
+ * @brief Places the paragraph held back, if there is one.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @return SUCCESS, ERROR_NULL_POINTER, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _finish(layout_t *const self);
+
+/**
+ * @brief Frees the arrays of the layout and the layout itself.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+ */
+static errorCode_t _free(layout_t *self);
+
+/**
+ * @brief Copies and measures a word of the paragraph being balanced.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @param[in] text The word.
+ * @param[in] length Bytes of the word.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _hold(layout_t *const self, const char *const text, const size_t length);
+
+/**
+ * @brief Breaks the paragraph held back into balanced lines and places it.
+ * @param[in,out] self Pointer to the layout_t structure, holding at least one word.
+ * @return SUCCESS, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _balance(layout_t *const self);
+
+/**
+ * @brief Places the characters of a word.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @param[in] text The word.
+ * @param[in] length Bytes of the word.
+ * @param[in] newline true to move to a new line before the word.
+ * @return SUCCESS, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _placeWord(layout_t *const self, const char *text, const size_t length, const bool newline);
+
+/**
+ * @brief Places a character and moves the cursor past it.
+ * @details A character the font does not define is reported and takes no room.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @param[in] codePoint Code point of the character.
+ * @return SUCCESS, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _place(layout_t *const self, const uint32_t codePoint);
+
+/**
+ * @brief Counts a character the font does not define.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @param[in] codePoint Code point of the character.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _missing(layout_t *const self, const uint32_t codePoint);
+
+/**
+ * @brief Starts a new line in the list if the cursor has moved to one, and a new page if it is
+ *        on one.
+ * @param[in,out] self Pointer to the layout_t structure.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _line(layout_t *const self);
+
+/**
+ * @brief Measures a word up to its last character, the way the cursor has always tested it.
+ * @param[in] self Pointer to the layout_t structure.
+ * @param[in] text The word.
+ * @param[in] length Bytes of the word, at least one.
+ * @return The width in millimetres.
+ */
+static double _wordWidth(const layout_t *const self, const char *text, const size_t length);
+
+/**
+ * @brief Gives the distance the cursor moves past a character.
+ * @param[in] self Pointer to the layout_t structure.
+ * @param[in] codePoint Code point of the character.
+ * @return The width in millimetres: a character space or, with proportional spacing, that of the
+ *         ink and a letter gap, the advance for a character without ink, and 0 for a line break
+ *         or a character the font does not define.
+ */
+static double _advance(const layout_t *const self, const uint32_t codePoint);
+
+/**
+ * @brief Makes room for a number of elements in an array.
+ * @param[in,out] array The array, reallocated if it is too small.
+ * @param[in,out] capacity Elements allocated.
+ * @param[in] count Elements needed.
+ * @param[in] size Size of an element.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _reserve(void **const array, size_t *const capacity, const size_t count, const size_t size);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The cursor is the one a job has always started with, at the top left of the page, and the
+ * first line starts there. The arrays of a balanced paragraph are only allocated when one is held.
+ */
+layout_t *layoutConstructor(const fontData_t *const fontData, const double scale, const bool proportional,
+                            const bool balance)
+{
+    if (!fontData) // Check if fontData is NULL
+    {
+        ErrorHandler(ERROR_NO_FONT_DATA); // Handle error
+        return NULL;                      // Return NULL
+    }
+
+    layout_t *layout = calloc(1, sizeof(layout_t)); // Allocate cleared memory for layout_t
+    if (!layout)                                    // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    layout->fontData = fontData;               // Set font
+    layout->cursor = cursorConstructor(scale); // Cursor at the top left of the page
+    layout->proportional = proportional;       // Set spacing
+    layout->balance = balance;                 // Set line breaking
+    layout->add = _add;                        // Function pointer to add a word
+    layout->finish = _finish;                  // Function pointer to place the last paragraph
+    layout->free = _free;                      // Function pointer to free the layout
+
+    if (_reserve((void **)&layout->glyphs, &layout->glyphCapacity, LAYOUT_INITIAL_CAPACITY, sizeof(layoutGlyph_t)) != SUCCESS || // Allocate glyphs
+        _reserve((void **)&layout->lines, &layout->lineCapacity, LAYOUT_INITIAL_CAPACITY, sizeof(layoutLine_t)) != SUCCESS ||    // lines
+        _reserve((void **)&layout->pages, &layout->pageCapacity, LAYOUT_INITIAL_CAPACITY, sizeof(layoutPage_t)) != SUCCESS)      // and pages
+    {
+        _free(layout);                                // Avoid memory leak
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+    layout->lines[0] = (layoutLine_t){0, layout->cursor.posisiton.y}; // First line starts with the first glyph
+    layout->numLines = 1;                                             // One line
+    layout->pages[0] = (layoutPage_t){0};                             // First page starts with the first line
+    layout->numPages = 1;                                             // One page
+    return layout;                                                    // Return layout_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * A greedy word moves to a new line if it would overflow the line, as the cursor tests it, unless
+ * the cursor is already at the start of one: a word longer than the line starts where it is and
+ * wraps as it goes, so it does not leave an empty line before it. A balanced word is held back,
+ * and the paragraph placed once a word ends it with a newline or carriage return.
+ */
+static errorCode_t _add(layout_t *const self, const char *const text, const size_t length)
+{
+    if (!self || !text)                          // Check if self or text is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    if (length == 0)                             // Check if there is a word
+        return SUCCESS;                          // Nothing to place
+
+    if (!self->balance) // Greedy breaking
+    {
+        const bool overflow = self->cursor.testWordOverflow(&self->cursor, _wordWidth(self, text, length)); // Check if word would overflow
+        const bool lineStart = self->cursor.posisiton.x <= self->cursor.minPosition.x;                      // Check if the line is empty
+        return _placeWord(self, text, length, overflow && !lineStart);                                      // Place it
+    }
+
+    const errorCode_t error = _hold(self, text, length); // Hold it back
+    if (error != SUCCESS)                                // Check if it could be held
+        return error;                                    // Return error
+    const char last = text[length - 1];                  // Delimiter of the word
+    if (last == '\n' || last == '\r')                    // Check if it ends the paragraph
+        return _balance(self);                           // Place the paragraph
+    return SUCCESS;                                      // Wait for the rest of it
+}
+
+static errorCode_t _finish(layout_t *const self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+    if (self->numWords == 0)                     // Check if a paragraph is held back
+        return SUCCESS;                          // Nothing to place
+    return _balance(self);                       // Place it
+}
+
+static errorCode_t _free(layout_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    free(self->glyphs);  // Free glyphs
+    free(self->lines);   // Free lines
+    free(self->pages);   // Free pages
+    free(self->missing); // Free missing characters
+    free(self->text);    // Free paragraph text
+    free(self->words);   // Free paragraph words
+    free(self->breaks);  // Free breaks
+    free(self);          // Free layout_t
+    return SUCCESS;      // Return success
+}
+
+/**
+ * @details
+ * The word is measured with the widths the cursor will move by, so its place on a line of the
+ * paragraph is known before any character is placed.
+ */
+static errorCode_t _hold(layout_t *const self, const char *const text, const size_t length)
+{
+    if (_reserve((void **)&self->text, &self->textCapacity, self->textLength + length, sizeof(char)) != SUCCESS || // Room for the text
+        _reserve((void **)&self->words, &self->wordCapacity, self->numWords + 1, sizeof(layoutWord_t)) != SUCCESS) // and the word
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                                                     // Return error
+
+    layoutWord_t *const word = &self->words[self->numWords];                   // The word
+    const layoutWord_t *const previous = self->numWords > 0 ? word - 1 : NULL; // Word before it
+    word->first = self->textLength;                                            // Text of the word
+    word->length = length;                                                     // Bytes of the word
+    word->start = previous ? previous->start + previous->width : 0.0;          // After the word before it
+    word->box = 0.0;                                                           // Nothing measured yet
+    word->lineStart = false;                                                   // Not broken yet
+    memcpy(self->text + self->textLength, text, length);                       // Copy the text
+    self->textLength += length;                                                // Count it
+    self->numWords++;                                                          // Count the word
+
+    const char *next = text;               // Position in the word
+    const char *const end = text + length; // End of the word
+    double width = 0.0;                    // Width so far
+    while (next < end)                     // Iterate through word
+    {
+        word->box = width;                               // Width before the character read
+        width += _advance(self, Utf8Decode(&next, end)); // Add the character
+    }
+    word->width = width; // Width of the whole word
+    return SUCCESS;      // Return success
+}
+
+/**
+ * @details
+ * The line of the words `j` to `i` is as wide as the paragraph up to the end of word `i`, short of
+ * its delimiter, less the paragraph before word `j`. Looking back from word `i`, the line only
+ * gets wider, so the search stops at the first word that no longer fits; the first line has the
+ * room left after the cursor. The breaks are then read back from the last word, and the words
+ * placed, each line after a break starting on a new line unless the space that ended the line
+ * before has already wrapped the cursor.
+ */
+static errorCode_t _balance(layout_t *const self)
+{
+    const size_t n = self->numWords;                                                                     // Words of the paragraph
+    if (_reserve((void **)&self->breaks, &self->breakCapacity, n + 1, sizeof(layoutBreak_t)) != SUCCESS) // Room for the breaks
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                                           // Return error
+
+    const cursor_t *const cursor = &self->cursor;                         // Cursor at the start of the paragraph
+    const double room = cursor->maxPosition.x - cursor->minPosition.x;    // Room on a line
+    const double firstRoom = cursor->maxPosition.x - cursor->posisiton.x; // Room on the first line
+    self->breaks[0] = (layoutBreak_t){0.0, 0};                            // Nothing before the first word
+    for (size_t i = 0; i < n; i++)                                        // Line ending with each word
+    {
+        const layoutWord_t *const last = &self->words[i]; // Last word of the line
+        const double end = last->start + last->box;       // End of the line in the paragraph
+        double best = DBL_MAX;                            // Least cost found
+        size_t from = i;                                  // Word the line starts with
+        for (size_t j = i + 1; j-- > 0;)                  // Word the line could start with
+        {
+            const double width = end - self->words[j].start;                                    // Width of the line
+            const double slack = (j == 0 ? firstRoom : room) - width;                           // Room it leaves
+            if (slack < LAYOUT_TOLERANCE && j < i)                                              // Check if more than one word overflows
+                break;                                                                          // Wider lines overflow too
+            const double cost = self->breaks[j].cost +                                          // Cost before the line
+                                (i + 1 < n && slack >= LAYOUT_TOLERANCE ? slack * slack : 0.0); // and of the line
+            if (cost < best)                                                                    // Check if it is the least
+            {
+                best = cost; // Keep it
+                from = j;    // and its start
+            }
+        }
+        self->breaks[i + 1] = (layoutBreak_t){best, from}; // Best break after the word
+    }
+
+    for (size_t k = n; k > 0; k = self->breaks[k].from)     // Read the breaks back
+        self->words[self->breaks[k].from].lineStart = true; // Word starts a line
+
+    errorCode_t error = SUCCESS;                       // Result of placing
+    for (size_t k = 0; k < n && error == SUCCESS; k++) // Iterate through words
+    {
+        const layoutWord_t *const word = &self->words[k];                                             // The word
+        const bool newline = k > 0 && word->lineStart && cursor->posisiton.x > cursor->minPosition.x; // Check if it starts a new line
+        error = _placeWord(self, self->text + word->first, word->length, newline);                    // Place it
+    }
+    self->numWords = 0;   // Paragraph placed
+    self->textLength = 0; // Text no longer needed
+    return error;         // Return result
+}
+
+/**
+ * @details
+ * The word is decoded one UTF-8 character at a time and each character placed in turn.
+ */
+static errorCode_t _placeWord(layout_t *const self, const char *text, const size_t length, const bool newline)
+{
+    if (newline) // Check if the word starts a new line
+    {
+        if (self->cursor.newline(&self->cursor) != SUCCESS) // Move to new line
+            return CURSOR_OUT_OF_BOUNDS;                    // Return error
+        const errorCode_t error = _line(self);              // Start it in the list
+        if (error != SUCCESS)                               // Check if it could be started
+            return error;                                   // Return error
+    }
+
+    const char *const end = text + length; // End of the word
+    while (text < end)                     // Iterate through word
+    {
+        const errorCode_t error = _place(self, Utf8Decode(&text, end)); // Place character
+        if (error != SUCCESS)                                           // Check if it was placed
+            return error;                                               // Return error
+    }
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * Spaces, newlines and carriage returns only move the cursor. Any other character the font
+ * defines is added to the list at the cursor before the cursor moves past it, which may take it
+ * to a new line. A character it does not define is counted instead, and takes no room.
+ */
+static errorCode_t _place(layout_t *const self, const uint32_t codePoint)
+{
+    cursor_t *const cursor = &self->cursor; // Cursor of the layout
+    errorCode_t error;                      // Result of moving the cursor
+    switch (codePoint)                      // Check character
+    {
+    case ' ':                                                                     // Space
+        error = self->proportional ? cursor->advance(cursor, _advance(self, ' ')) // Advance cursor by the space
+                                   : cursor->update(cursor);                      // Update cursor
+        break;
+    case '\n':                           // Newline
+        error = cursor->newline(cursor); // Move to new line
+        break;
+    case '\r':                                  // Carriage return
+        error = cursor->carriagereturn(cursor); // Move to start of line
+        break;
+    default:
+    {
+        const fontMetrics_t *const metrics = self->fontData->measure(self->fontData, codePoint); // Metrics of the character
+        if (!metrics)                                                                            // Check if the font defines it
+            return _missing(self, codePoint);                                                    // Count it and skip it
+
+        if (_reserve((void **)&self->glyphs, &self->glyphCapacity, self->numGlyphs + 1, sizeof(layoutGlyph_t)) != SUCCESS) // Room for the glyph
+            return ERROR_MEMORY_ALLOCATION_FAILED;                                                                         // Return error
+        self->glyphs[self->numGlyphs++] = (layoutGlyph_t){codePoint, cursor->posisiton.x};                                 // Add glyph
+
+        error = self->proportional ? cursor->advance(cursor, _advance(self, codePoint)) // Advance cursor by the character
+                                   : cursor->update(cursor);                            // Update cursor
+        break;
+    }
+    }
+
+    if (error != SUCCESS)            // Check if the cursor moved
+        return CURSOR_OUT_OF_BOUNDS; // Return error
+    return _line(self);              // Start a new line in the list if it moved to one
+}
+
+/**
+ * @details
+ * The missing characters are kept in order of code point and found by binary search. A document
+ * only ever misses a few different characters, so inserting one is cheap, and each occurrence
+ * after the first only costs the search.
+ */
+static errorCode_t _missing(layout_t *const self, const uint32_t codePoint)
+{
+    size_t low = 0;                 // Range the character
+    size_t high = self->numMissing; // may be in
+    while (low < high)              // Until the range is empty
+    {
+        const size_t middle = low + (high - low) / 2;    // Middle of the range
+        if (self->missing[middle].codePoint < codePoint) // Check if it is after the middle
+            low = middle + 1;                            // Search above
+        else                                             // It is at or before the middle
+            high = middle;                               // Search below
+    }
+    if (low < self->numMissing && self->missing[low].codePoint == codePoint) // Check if it was found
+    {
+        self->missing[low].count++; // Count it
+        return SUCCESS;             // Return success
+    }
+
+    if (_reserve((void **)&self->missing, &self->missingCapacity, self->numMissing + 1, sizeof(layoutMissing_t)) != SUCCESS) // Room for it
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                                                               // Return error
+    memmove(&self->missing[low + 1], &self->missing[low], (self->numMissing - low) * sizeof(layoutMissing_t));               // Make room in order
+    self->missing[low] = (layoutMissing_t){codePoint, 1};                                                                    // Add it
+    self->numMissing++;                                                                                                      // Count it
+    return SUCCESS;                                                                                                          // Return success
+}
+
+/**
+ * @details
+ * The cursor counts its lines and pages, so a line is added whenever it is past the last line of
+ * the list, whichever way it got there, and a page with it when the cursor is past the last page.
+ * It moves at most one line at a time.
+ */
+static errorCode_t _line(layout_t *const self)
+{
+    if (self->cursor.line < self->numLines) // Check if the cursor is on the last line
+        return SUCCESS;                     // Nothing to add
+
+    if (self->cursor.page >= self->numPages) // Check if the line starts a page
+    {
+        if (_reserve((void **)&self->pages, &self->pageCapacity, self->numPages + 1, sizeof(layoutPage_t)) != SUCCESS) // Room for the page
+            return ERROR_MEMORY_ALLOCATION_FAILED;                                                                     // Return error
+        self->pages[self->numPages++] = (layoutPage_t){self->numLines};                                                // Page starts with the line
+    }
+
+    if (_reserve((void **)&self->lines, &self->lineCapacity, self->numLines + 1, sizeof(layoutLine_t)) != SUCCESS) // Room for the line
+        return ERROR_MEMORY_ALLOCATION_FAILED;                                                                     // Return error
+    self->lines[self->numLines++] = (layoutLine_t){self->numGlyphs, self->cursor.posisiton.y};                     // Line starts with the next glyph
+    return SUCCESS;                                                                                                // Return success
+}
+
+/**
+ * @details
+ * With fixed spacing every character before the last takes a character space, counted from the
+ * bytes as the cursor always has. With proportional spacing the characters before the last are
+ * decoded and their widths looked up in the metrics of the font, one index each.
+ */
+static double _wordWidth(const layout_t *const self, const char *text, const size_t length)
+{
+    if (!self->proportional)                                                      // Fixed spacing
+        return ((int)Utf8Length(text, length) - 1) * self->cursor.characterSpace; // A character space each
+
+    const char *const end = text + length; // End of the word
+    double width = 0.0;                    // Width of the characters before the last
+    double last = 0.0;                     // Width of the last character read
+    while (text < end)                     // Iterate through word
+    {
+        width += last;                                 // The character read is not the last
+        last = _advance(self, Utf8Decode(&text, end)); // Its width
+    }
+    return width; // Return width
+}
+
+/**
+ * @details
+ * The metrics are in font units, so the width is scaled like the strokes. A space the font does
+ * not define takes a character space either way.
+ */
+static double _advance(const layout_t *const self, const uint32_t codePoint)
+{
+    if (codePoint == '\n' || codePoint == '\r') // Check if it is a line break
+        return 0.0;                             // No room for it
+
+    const fontMetrics_t *const metrics = self->fontData->measure(self->fontData, codePoint); // Metrics of the character
+    if (!metrics)                                                                            // Check if the character is defined
+        return codePoint == ' ' ? self->cursor.characterSpace : 0.0;                         // Only a space takes room
+    if (!self->proportional)                                                                 // Fixed spacing
+        return self->cursor.characterSpace;                                                  // A character space
+    if (!metrics->inked)                                                                     // Check if it draws anything
+        return metrics->advance * self->cursor.scale;                                        // Its advance
+    return (metrics->right - metrics->left + LETTER_GAP_UNITS) * self->cursor.scale;         // Its ink and a gap
+}
+
+/**
+ * @details
+ * The capacity doubles until the request fits, so adding elements one by one costs amortised
+ * constant time.
+ */
+static errorCode_t _reserve(void **const array, size_t *const capacity, const size_t count, const size_t size)
+{
+    if (count <= *capacity && *array) // Check if it fits
+        return SUCCESS;               // Nothing to do
+
+    size_t grown = *capacity ? *capacity : LAYOUT_INITIAL_CAPACITY; // New capacity
+    while (grown < count)                                           // Until it fits
+        grown *= 2;                                                 // Double it
+    if (grown > SIZE_MAX / size)                                    // Check if the size fits a size_t
+        return ERROR_MEMORY_ALLOCATION_FAILED;                      // Report failure
+    void *const memory = realloc(*array, grown * size);             // Grow the array
+    if (!memory)                                                    // Check if memory allocation failed
+        return ERROR_MEMORY_ALLOCATION_FAILED;                      // Report failure
+    *array = memory;                                                // Use new storage
+    *capacity = grown;                                              // Record capacity
+    return SUCCESS;                                                 // Return success
+}
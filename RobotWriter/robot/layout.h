@@ -0,0 +1,177 @@
+/**
+ * @file layout.h
+ * @brief Declaration of the layout_t structure, which places every character of a document before any is drawn.
+ * @details
+ * The words of a document are added to the layout one after the other, as a textReader_t reads
+ * them, and the layout places each character of the document on a line, with the same cursor the
+ * job used to be drawn with. The result is a list of positioned glyphs, line by line and page by
+ * page, that generate_gcode() draws once the whole document is placed, so the number of lines
+ * and where each page starts are known before the first stroke is sent. A line that would start
+ * below the page starts at the top of the next page.
+ *
+ * Lines are broken in one of two ways:
+ * - Greedily, as RobotWriter always has: a word that does not fit on the line goes to the next.
+ * - Balanced: the words of each paragraph are held back until the paragraph ends, and the breaks
+ *   that minimise the sum of the squared space left at the end of each line but the last are
+ *   chosen, in the manner of Knuth and Plass, so the lines of a paragraph come out of even length.
+ *
+ * A character the font does not define takes no room; it is counted, so that a document can be
+ * checked for missing characters before it is drawn, and skipped.
+ *
+ * A glyph and a line take sixteen bytes each, and a page eight, so the layout of a document
+ * takes memory in proportion to its length, and placing it time in proportion to its length as
+ * well: a balanced break only looks back as many words as fit on a line.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../font/fontData.h"
+#include "../misc/error.h"
+#include "cursor.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define LAYOUT_INITIAL_CAPACITY 1024 /**< Glyphs, lines, pages, words and bytes allocated before the first growth. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A character placed on a line.
+ */
+typedef struct layoutGlyph_s
+{
+    uint32_t codePoint; /**< Code point of the character, defined by the font. */
+    double x;           /**< X of the cursor at the character, in mm. */
+} layoutGlyph_t;
+
+/**
+ * @brief A line of the layout.
+ * @details The glyphs of line `i` are `glyphs[lines[i].first]` up to the first glyph of line
+ *          `i + 1`, or up to the last glyph for the last line.
+ */
+typedef struct layoutLine_s
+{
+    size_t first; /**< Index of the first glyph of the line. */
+    double y;     /**< Y of the line in mm. */
+} layoutLine_t;
+
+/**
+ * @brief A page of the layout.
+ * @details The lines of page `i` are `lines[pages[i].first]` up to the first line of page `i + 1`,
+ *          or up to the last line for the last page.
+ */
+typedef struct layoutPage_s
+{
+    size_t first; /**< Index of the first line of the page. */
+} layoutPage_t;
+
+/**
+ * @brief A character of the document the font does not define.
+ */
+typedef struct layoutMissing_s
+{
+    uint32_t codePoint; /**< Code point of the character. */
+    size_t count;       /**< Times it occurs in the document. */
+} layoutMissing_t;
+
+/**
+ * @brief A word of a paragraph waiting to be broken into lines.
+ */
+typedef struct layoutWord_s
+{
+    size_t first;   /**< Offset of the word in the paragraph text. */
+    size_t length;  /**< Bytes of the word, its delimiter included. */
+    double start;   /**< Width of the paragraph before the word. */
+    double box;     /**< Width of the word up to its last character, which is usually its delimiter. */
+    double width;   /**< Width of the whole word, the advance to the next word. */
+    bool lineStart; /**< true if the word starts a line of the balanced paragraph. */
+} layoutWord_t;
+
+/**
+ * @brief The best way found to break a paragraph before one of its words.
+ */
+typedef struct layoutBreak_s
+{
+    double cost; /**< Least cost of the lines before the word. */
+    size_t from; /**< Word that starts the last of those lines. */
+} layoutBreak_t;
+
+/**
+ * @brief Structure placing the characters of a document on lines.
+ */
+typedef struct layout_s
+{
+    const fontData_t *fontData; /**< Font the document is drawn in, not owned. */
+    cursor_t cursor;            /**< Places the characters; its line and page are the index of the last ones. */
+    bool proportional;          /**< true to space characters by the width of their ink. */
+    bool balance;               /**< true to balance the lines of each paragraph. */
+
+    layoutGlyph_t *glyphs; /**< Glyphs placed, line after line. */
+    size_t numGlyphs;      /**< Number of glyphs. */
+    size_t glyphCapacity;  /**< Glyphs allocated. */
+    layoutLine_t *lines;   /**< Lines, from the top of the page. */
+    size_t numLines;       /**< Number of lines, at least one. */
+    size_t lineCapacity;   /**< Lines allocated. */
+    layoutPage_t *pages;   /**< Pages, in the order they are drawn. */
+    size_t numPages;       /**< Number of pages, at least one. */
+    size_t pageCapacity;   /**< Pages allocated. */
+
+    layoutMissing_t *missing; /**< Characters the font does not define, by code point. */
+    size_t numMissing;        /**< Number of different characters missing. */
+    size_t missingCapacity;   /**< Missing characters allocated. */
+
+    char *text;            /**< Text of the paragraph being balanced. */
+    size_t textLength;     /**< Bytes of the text. */
+    size_t textCapacity;   /**< Bytes allocated. */
+    layoutWord_t *words;   /**< Words of the paragraph being balanced. */
+    size_t numWords;       /**< Number of words. */
+    size_t wordCapacity;   /**< Words allocated. */
+    layoutBreak_t *breaks; /**< Best break before each word, and after the last, while balancing. */
+    size_t breakCapacity;  /**< Breaks allocated. */
+
+    /**
+     * @brief Places a word of the document after those added before it.
+     * @details A balanced paragraph is only placed once the word that ends it is added.
+     * @param[in,out] self Pointer to the layout_t structure.
+     * @param[in] text The word, as a textReader_t reads it, not NUL-terminated.
+     * @param[in] length Bytes of the word.
+     * @return SUCCESS, CURSOR_OUT_OF_BOUNDS if the cursor cannot be placed, or
+     *         ERROR_MEMORY_ALLOCATION_FAILED.
+     */
+    errorCode_t (*add)(struct layout_s *const self, const char *const text, const size_t length);
+
+    /**
+     * @brief Places the paragraph held back at the end of the document, if there is one.
+     * @param[in,out] self Pointer to the layout_t structure.
+     * @return SUCCESS, CURSOR_OUT_OF_BOUNDS or ERROR_MEMORY_ALLOCATION_FAILED.
+     */
+    errorCode_t (*finish)(struct layout_s *const self);
+
+    /**
+     * @brief Frees the layout and its glyphs; the font is left alone.
+     * @param[in,out] self Pointer to the layout_t structure.
+     * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct layout_s *self);
+} layout_t;
+
+/**
+ * @brief Constructs an empty layout that starts at the top left of the page.
+ * @param[in] fontData The font; it must outlive the layout.
+ * @param[in] scale Scale factor of the text.
+ * @param[in] proportional true to space characters by the width of their ink, false for a
+ *            character space each.
+ * @param[in] balance true to balance the lines of each paragraph, false to break them greedily.
+ * @return A pointer to the newly created layout_t object, or NULL if allocation fails.
+ */
+layout_t *layoutConstructor(const fontData_t *const fontData, const double scale, const bool proportional,
+                            const bool balance);
@@ -0,0 +1,969 @@
+/**
+ * @file pathPlan.c
+ * @brief Implementation of the pen-up travel optimiser for the polylines of a page.
+ * @details
+ * Every polyline has two end points and may be entered at either of them, so the tour is built
+ * over the end points: a nearest-neighbour walk from the pen position repeatedly enters the
+ * polyline whose nearest end point is closest to where the last one was left, and leaves it at
+ * its other end. 2-opt then looks for two pen-up moves that are shorter when the polylines
+ * between them are drawn in reverse order and direction, and Or-opt for runs of up to
+ * PATH_OROPT_LENGTH polylines that are better drawn somewhere else. Only moves towards one of the
+ * PATH_NEIGHBOURS nearest end points are tried, which keeps a pass close to linear in the
+ * number of polylines. When the pen has to go somewhere after the last polyline, such as home,
+ * that move is part of the tour too.
+ *
+ * Both steps find nearby end points through a uniform grid sized for about PATH_GRID_LOAD end
+ * points per cell. The grid is searched in square rings around the query point until no closer
+ * end point can be found in the next ring.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "pathPlan.h"
+#include "simplify.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define PATH_GRID_LOAD 2.0  /**< Average number of end points per grid cell. */
+#define PATH_MIN_GAIN 1e-9  /**< Smallest saving in mm that counts as an improvement. */
+#define PATH_NONE SIZE_MAX  /**< Marks a missing end point. */
+
+/**
+ * @brief Uniform grid over the end points of the polylines.
+ * @details The end points of each cell are stored next to each other in `entries`; the ones still
+ *          in the grid come first, so removing one swaps it behind the live ones of its cell.
+ */
+typedef struct pathGrid_s
+{
+    Coord2D_t origin; /**< Lower left corner of the grid. */
+    double cellSize;  /**< Width and height of a cell in mm. */
+    long cols;        /**< Number of cell columns. */
+    long rows;        /**< Number of cell rows. */
+    size_t *start;    /**< Index in entries of the first end point of each cell. */
+    size_t *live;     /**< Number of end points still in each cell. */
+    size_t *entries;  /**< End points grouped by cell. */
+    size_t *slot;     /**< Index in entries of each end point. */
+} pathGrid_t;
+
+/**
+ * @brief Working state of the improvement passes of one optimise() call.
+ */
+typedef struct pathTour_s
+{
+    pathPlan_t *plan;                        /**< Plan being ordered. */
+    const Coord2D_t *ends;                   /**< End point coordinates. */
+    const size_t *neighbours;                /**< PATH_NEIGHBOURS nearest end points of each end point. */
+    size_t startNeighbours[PATH_NEIGHBOURS]; /**< Nearest end points of the start. */
+    size_t *position;                        /**< Position in the order of each polyline. */
+    Coord2D_t start;                         /**< Pen position before the first polyline. */
+    Coord2D_t end;                           /**< Pen position after the last polyline, if closed. */
+    bool closed;                             /**< true if the pen goes to `end` after the last polyline. */
+} pathTour_t;
+
+/**
+ * @brief Adds a stroke, see pathPlan_t::add().
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in] from Start point of the stroke.
+ * @param[in] to End point of the stroke.
+ * @param[in] penDown true if the stroke draws.
+ * @return SUCCESS, ERROR_MEMORY_ALLOCATION_FAILED, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _add(pathPlan_t *const self, const Coord2D_t from, const Coord2D_t to, const bool penDown);
+
+/**
+ * @brief Simplifies the polylines, see pathPlan_t::simplify().
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in] tolerance Largest distance in mm between a removed point and the drawing.
+ * @return Number of points removed.
+ */
+static size_t _simplify(pathPlan_t *const self, const double tolerance);
+
+/**
+ * @brief Orders the polylines, see pathPlan_t::optimise().
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in] start Position of the pen before the first polyline.
+ * @param[in] end Position the pen goes to after the last polyline, or NULL.
+ * @return SUCCESS, ERROR_MEMORY_ALLOCATION_FAILED, or ERROR_NULL_POINTER.
+ */
+static errorCode_t _optimise(pathPlan_t *const self, const Coord2D_t start, const Coord2D_t *const end);
+
+/**
+ * @brief Reverses the tail of the drawing order, see pathPlan_t::reverse().
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in] first Position of the first polyline to reverse.
+ */
+static void _reverse(pathPlan_t *const self, const size_t first);
+
+/**
+ * @brief Calculates the pen-up travel, see pathPlan_t::travel().
+ * @param[in] self Pointer to the pathPlan_t structure.
+ * @param[in] start Position of the pen before the first polyline.
+ * @return Pen-up travel in mm.
+ */
+static double _travel(const pathPlan_t *const self, const Coord2D_t start);
+
+/**
+ * @brief Removes every polyline.
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ */
+static void _clear(pathPlan_t *const self);
+
+/**
+ * @brief Frees the plan.
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
+ */
+static errorCode_t _free(pathPlan_t *self);
+
+/**
+ * @brief Makes room for more points and polylines.
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in] points Number of points that must fit.
+ * @param[in] polylines Number of polylines that must fit.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _reserve(pathPlan_t *const self, const size_t points, const size_t polylines);
+
+/**
+ * @brief End point through which a polyline is entered.
+ * @param[in] self Pointer to the pathPlan_t structure.
+ * @param[in] line Index of the polyline.
+ * @return End point index: twice the polyline index, plus one for its last point.
+ */
+static inline size_t _entry(const pathPlan_t *const self, const size_t line);
+
+/**
+ * @brief End point through which a polyline is left.
+ * @param[in] self Pointer to the pathPlan_t structure.
+ * @param[in] line Index of the polyline.
+ * @return End point index: twice the polyline index, plus one for its last point.
+ */
+static inline size_t _exit(const pathPlan_t *const self, const size_t line);
+
+/**
+ * @brief Reverses the polylines at positions first to last, including their direction.
+ * @param[in,out] self Pointer to the pathPlan_t structure.
+ * @param[in,out] position Position in the order of each polyline, or NULL.
+ * @param[in] first First position to reverse.
+ * @param[in] last Last position to reverse.
+ */
+static void _reverseRun(pathPlan_t *const self, size_t *const position, size_t first, size_t last);
+
+/**
+ * @brief Pen position before a position in the order.
+ * @param[in] tour The tour.
+ * @param[in] p The position.
+ * @return Exit of the polyline at p-1, or the start.
+ */
+static inline Coord2D_t _before(const pathTour_t *const tour, const size_t p);
+
+/**
+ * @brief Where the pen goes when it leaves position p-1.
+ * @param[in] tour The tour.
+ * @param[in] p The position.
+ * @param[out] point Entry of the polyline at p, or the end of the tour.
+ * @return false if the pen goes nowhere, i.e. p is past the last polyline of an open tour.
+ */
+static inline bool _after(const pathTour_t *const tour, const size_t p, Coord2D_t *const point);
+
+/**
+ * @brief Makes one pass of 2-opt moves over the tour.
+ * @param[in,out] tour The tour.
+ * @return true if any move was made.
+ */
+static bool _twoOptPass(pathTour_t *const tour);
+
+/**
+ * @brief Makes one pass of Or-opt moves over the tour.
+ * @param[in,out] tour The tour.
+ * @return true if any move was made.
+ */
+static bool _orOptPass(pathTour_t *const tour);
+
+/**
+ * @brief Moves a run of polylines to another place in the order.
+ * @param[in,out] tour The tour.
+ * @param[in] p Position of the first polyline of the run.
+ * @param[in] length Number of polylines in the run, at most PATH_OROPT_LENGTH.
+ * @param[in] i Position before which the run is put, counted before the move.
+ * @param[in] reverse true to draw the run backwards.
+ */
+static void _moveRun(pathTour_t *const tour, const size_t p, const size_t length, const size_t i, const bool reverse);
+
+/**
+ * @brief Builds a grid holding every end point.
+ * @param[out] grid The grid.
+ * @param[in] ends End point coordinates.
+ * @param[in] count Number of end points.
+ * @return SUCCESS, or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _gridBuild(pathGrid_t *const grid, const Coord2D_t *const ends, const size_t count);
+
+/**
+ * @brief Frees the memory of a grid.
+ * @param[in,out] grid The grid.
+ */
+static void _gridFree(pathGrid_t *const grid);
+
+/**
+ * @brief Finds the cell of a point, clamped to the grid.
+ * @param[in] grid The grid.
+ * @param[in] point The point.
+ * @param[out] col Cell column.
+ * @param[out] row Cell row.
+ */
+static inline void _gridCell(const pathGrid_t *const grid, const Coord2D_t point, long *const col, long *const row);
+
+/**
+ * @brief Removes an end point from the grid.
+ * @param[in,out] grid The grid.
+ * @param[in] ends End point coordinates.
+ * @param[in] end The end point.
+ */
+static void _gridRemove(pathGrid_t *const grid, const Coord2D_t *const ends, const size_t end);
+
+/**
+ * @brief Finds the nearest end points still in the grid.
+ * @param[in] grid The grid.
+ * @param[in] ends End point coordinates.
+ * @param[in] point Query point.
+ * @param[in] skip End point to leave out, or PATH_NONE.
+ * @param[in] k Number of end points wanted.
+ * @param[out] found The nearest end points, closest first.
+ * @return Number of end points found, at most k.
+ */
+static size_t _gridNearest(const pathGrid_t *const grid, const Coord2D_t *const ends, const Coord2D_t point,
+                           const size_t skip, const size_t k, size_t *const found);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Allocates the plan with room for PATH_INITIAL_CAPACITY points and polylines; both grow as
+ * strokes are added.
+ */
+pathPlan_t *pathPlanConstructor(void)
+{
+    pathPlan_t *plan = malloc(sizeof(pathPlan_t)); // Allocate memory for pathPlan_t
+    if (!plan)                                     // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    plan->points = NULL;        // No points yet
+    plan->polylines = NULL;     // No polylines yet
+    plan->order = NULL;         // No order yet
+    plan->pointCapacity = 0;    // Nothing allocated
+    plan->polylineCapacity = 0; // Nothing allocated
+    _clear(plan);               // Empty plan
+
+    if (_reserve(plan, PATH_INITIAL_CAPACITY, PATH_INITIAL_CAPACITY) != SUCCESS) // Allocate storage
+    {
+        _free(plan); // Avoid memory leak
+        return NULL; // Return NULL
+    }
+
+    plan->add = _add;           // Function pointer to add a stroke
+    plan->simplify = _simplify; // Function pointer to simplify the polylines
+    plan->optimise = _optimise; // Function pointer to order the polylines
+    plan->reverse = _reverse;   // Function pointer to reverse the tail of the order
+    plan->travel = _travel;     // Function pointer to measure the pen-up travel
+    plan->clear = _clear;       // Function pointer to remove every polyline
+    plan->free = _free;         // Function pointer to free the plan
+    return plan;                // Return pathPlan_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Strokes arrive with the pen position they start from, so a pen-down stroke that continues the
+ * last one is recognised by its start point being exactly the last point of the open polyline.
+ */
+static errorCode_t _add(pathPlan_t *const self, const Coord2D_t from, const Coord2D_t to, const bool penDown)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    if (!penDown) // Pen-up stroke
+    {
+        self->open = false; // Next pen-down stroke starts a new polyline
+        return SUCCESS;     // Return success
+    }
+
+    if (_reserve(self, self->numPoints + 2, self->numPolylines + 1) != SUCCESS) // Make room
+        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED);                    // Handle error
+
+    const Coord2D_t last = self->numPoints ? self->points[self->numPoints - 1] : from; // End of the last polyline
+    if (!self->open || last.x != from.x || last.y != from.y)                           // Not a continuation
+    {
+        pathPolyline_t *const line = &self->polylines[self->numPolylines]; // New polyline
+        line->first = self->numPoints;                                     // Starts at the next point
+        line->count = 1;                                                   // with the start point
+        line->reversed = false;                                            // Drawn forwards
+        self->order[self->numPolylines] = self->numPolylines;              // Drawn in the order added
+        self->numPolylines++;                                              // One more polyline
+        self->points[self->numPoints++] = from;                            // Store the start point
+        self->open = true;                                                 // Can be extended
+    }
+
+    self->points[self->numPoints++] = to;            // Store the end point
+    self->polylines[self->numPolylines - 1].count++; // One more point in the polyline
+    return SUCCESS;                                  // Return success
+}
+
+/**
+ * @details
+ * The points are stored polyline after polyline in the order they were added, so each polyline
+ * is simplified where it lies and then moved down to close the gap left by the ones before it.
+ */
+static size_t _simplify(pathPlan_t *const self, const double tolerance)
+{
+    size_t longest = 0;                             // Most points in one polyline
+    for (size_t i = 0; i < self->numPolylines; i++) // Every polyline
+        if (self->polylines[i].count > longest)     // Longer than the others
+            longest = self->polylines[i].count;     // Remember its length
+
+    size_t *stack = NULL;               // Working memory of SimplifyPolyline()
+    if (tolerance > 0.0 && longest > 0) // Check if points may move
+    {
+        stack = malloc(longest * sizeof(size_t));         // One entry per point
+        if (!stack)                                       // Check if memory allocation failed
+            ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error, merge exactly only
+    }
+
+    size_t next = 0;                                // Where the next polyline goes
+    for (size_t i = 0; i < self->numPolylines; i++) // Every polyline
+    {
+        pathPolyline_t *const line = &self->polylines[i];                             // Polyline
+        Coord2D_t *const points = &self->points[next];                                // Its new place
+        memmove(points, &self->points[line->first], line->count * sizeof(Coord2D_t)); // Move it there
+        size_t count = MergeCollinear(points, line->count);                           // Merge straight runs
+        if (stack)                                                                    // Check if points may move
+            count = SimplifyPolyline(points, count, tolerance, stack);                // Simplify within tolerance
+        line->first = next;                                                           // Record new place
+        line->count = count;                                                          // Record new length
+        next += count;                                                                // Next polyline follows
+    }
+
+    const size_t removed = self->numPoints - next; // Points removed
+    self->numPoints = next;                        // Record new number of points
+    free(stack);                                   // Free working memory
+    return removed;                                // Return number removed
+}
+
+/**
+ * @details
+ * The grid, the neighbour lists and the positions are working memory that only lives for the
+ * duration of the call. The neighbour lists are built before the nearest-neighbour walk starts
+ * removing end points from the grid. The walk only looks one polyline ahead and strands the odd
+ * polyline far from the rest, so 2-opt and Or-opt passes take turns until neither finds a move.
+ */
+static errorCode_t _optimise(pathPlan_t *const self, const Coord2D_t start, const Coord2D_t *const end)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    const size_t n = self->numPolylines; // Number of polylines
+    if (n == 0)                          // Nothing to order
+        return SUCCESS;                  // Return success
+
+    Coord2D_t *ends = malloc(2 * n * sizeof(Coord2D_t));                   // End point coordinates
+    size_t *neighbours = malloc(2 * n * PATH_NEIGHBOURS * sizeof(size_t)); // Nearest end points of each end point
+    size_t *position = malloc(n * sizeof(size_t));                         // Position of each polyline
+    pathGrid_t grid = {0};                                                 // End point index
+    if (!ends || !neighbours || !position)                                 // Check if memory allocation failed
+    {
+        free(ends);                                          // Avoid memory leak
+        free(neighbours);                                    // Avoid memory leak
+        free(position);                                      // Avoid memory leak
+        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+    }
+
+    for (size_t i = 0; i < n; i++) // Collect the end points
+    {
+        const pathPolyline_t *const line = &self->polylines[i];        // Polyline
+        ends[2 * i] = self->points[line->first];                       // First point
+        ends[2 * i + 1] = self->points[line->first + line->count - 1]; // Last point
+    }
+
+    if (_gridBuild(&grid, ends, 2 * n) != SUCCESS) // Index the end points
+    {
+        free(ends);                                          // Avoid memory leak
+        free(neighbours);                                    // Avoid memory leak
+        free(position);                                      // Avoid memory leak
+        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+    }
+
+    pathTour_t tour;               // Working state of the improvement passes
+    tour.plan = self;              // Plan being ordered
+    tour.ends = ends;              // End point coordinates
+    tour.neighbours = neighbours;  // Neighbour lists
+    tour.position = position;      // Positions
+    tour.start = start;            // Pen position before the first polyline
+    tour.closed = end != NULL;     // Check if the pen must go somewhere afterwards
+    tour.end = end ? *end : start; // Where it goes
+
+    size_t found = _gridNearest(&grid, ends, start, PATH_NONE, PATH_NEIGHBOURS, tour.startNeighbours); // Search around the start
+    for (size_t j = found; j < PATH_NEIGHBOURS; j++)                                                   // Mark the unused entries
+        tour.startNeighbours[j] = PATH_NONE;                                                           // as missing
+    for (size_t e = 0; e < 2 * n; e++)                                                                 // Every end point
+    {
+        size_t *const list = &neighbours[e * PATH_NEIGHBOURS];                // Its neighbour list
+        found = _gridNearest(&grid, ends, ends[e], e, PATH_NEIGHBOURS, list); // Search around it
+        for (size_t j = found; j < PATH_NEIGHBOURS; j++)                      // Mark the unused entries
+            list[j] = PATH_NONE;                                              // as missing
+    }
+
+    Coord2D_t pen = start;         // Pen position during the walk
+    for (size_t k = 0; k < n; k++) // Nearest-neighbour walk
+    {
+        size_t next;                                         // Closest end point left
+        _gridNearest(&grid, ends, pen, PATH_NONE, 1, &next); // Find it
+        const size_t line = next / 2;                        // Its polyline
+        self->polylines[line].reversed = (next & 1) != 0;    // Enter at the last point
+        self->order[k] = line;                               // Draw it next
+        position[line] = k;                                  // Remember where
+        _gridRemove(&grid, ends, next);                      // Polyline is taken
+        _gridRemove(&grid, ends, next ^ 1);                  // at both ends
+        pen = ends[next ^ 1];                                // Pen leaves at the other end
+    }
+    _gridFree(&grid); // Grid no longer needed
+
+    for (int pass = 0; pass < PATH_IMPROVE_PASSES; pass++) // Improvement passes
+    {
+        const bool twoOpt = _twoOptPass(&tour); // Reverse runs
+        const bool orOpt = _orOptPass(&tour);   // Move short runs
+        if (!twoOpt && !orOpt)                  // Local optimum reached
+            break;                              // Stop early
+    }
+
+    free(ends);       // Free working memory
+    free(neighbours); // Free working memory
+    free(position);   // Free working memory
+    return SUCCESS;   // Return success
+}
+
+/**
+ * @details
+ * Reversing everything from the given position to the end draws that part of the page backwards,
+ * starting where it used to finish.
+ */
+static void _reverse(pathPlan_t *const self, const size_t first)
+{
+    if (first < self->numPolylines)                             // Check if there is anything to reverse
+        _reverseRun(self, NULL, first, self->numPolylines - 1); // Reverse up to the last polyline
+}
+
+/**
+ * @details
+ * Sums the pen-up moves from the start to the first polyline and from each polyline to the next.
+ */
+static double _travel(const pathPlan_t *const self, const Coord2D_t start)
+{
+    double travel = 0.0;                            // Pen-up travel
+    Coord2D_t pen = start;                          // Pen position
+    for (size_t k = 0; k < self->numPolylines; k++) // Every polyline in order
+    {
+        const pathPolyline_t *const line = &self->polylines[self->order[k]]; // Polyline
+        travel += DistanceCoord2D(pen, PathPoint(self, line, 0));            // Move to its start
+        pen = PathPoint(self, line, line->count - 1);                        // Pen leaves at its end
+    }
+    return travel; // Return pen-up travel
+}
+
+/**
+ * @details
+ * Keeps the allocated storage for the next page.
+ */
+static void _clear(pathPlan_t *const self)
+{
+    self->numPoints = 0;    // No points
+    self->numPolylines = 0; // No polylines
+    self->open = false;     // Nothing to extend
+}
+
+/**
+ * @details
+ * Releases the points, the polylines, the order and the plan itself.
+ */
+static errorCode_t _free(pathPlan_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    free(self->points);    // Free points
+    free(self->polylines); // Free polylines
+    free(self->order);     // Free order
+    free(self);            // Free pathPlan_t
+    return SUCCESS;        // Return success
+}
+
+/**
+ * @details
+ * Capacities double until the request fits, so adding strokes one by one costs amortised
+ * constant time.
+ */
+static errorCode_t _reserve(pathPlan_t *const self, const size_t points, const size_t polylines)
+{
+    if (points > self->pointCapacity) // More points needed
+    {
+        size_t capacity = self->pointCapacity ? self->pointCapacity : PATH_INITIAL_CAPACITY; // New capacity
+        while (capacity < points)                                                            // Until it fits
+            capacity *= 2;                                                                   // Double it
+        Coord2D_t *grown = realloc(self->points, capacity * sizeof(Coord2D_t));              // Grow points
+        if (!grown)                                                                          // Check if memory allocation failed
+            return ERROR_MEMORY_ALLOCATION_FAILED;                                           // Report failure
+        self->points = grown;                                                                // Use new storage
+        self->pointCapacity = capacity;                                                      // Record capacity
+    }
+
+    if (polylines > self->polylineCapacity) // More polylines needed
+    {
+        size_t capacity = self->polylineCapacity ? self->polylineCapacity : PATH_INITIAL_CAPACITY; // New capacity
+        while (capacity < polylines)                                                               // Until it fits
+            capacity *= 2;                                                                         // Double it
+        pathPolyline_t *grown = realloc(self->polylines, capacity * sizeof(pathPolyline_t));       // Grow polylines
+        if (!grown)                                                                                // Check if memory allocation failed
+            return ERROR_MEMORY_ALLOCATION_FAILED;                                                 // Report failure
+        self->polylines = grown;                                                                   // Use new storage
+        size_t *order = realloc(self->order, capacity * sizeof(size_t));                           // Grow order
+        if (!order)                                                                                // Check if memory allocation failed
+            return ERROR_MEMORY_ALLOCATION_FAILED;                                                 // Report failure
+        self->order = order;                                                                       // Use new storage
+        self->polylineCapacity = capacity;                                                         // Record capacity
+    }
+
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * A reversed polyline is entered at its last point.
+ */
+static inline size_t _entry(const pathPlan_t *const self, const size_t line)
+{
+    return 2 * line + (self->polylines[line].reversed ? 1 : 0); // Entry end point
+}
+
+/**
+ * @details
+ * A reversed polyline is left at its first point.
+ */
+static inline size_t _exit(const pathPlan_t *const self, const size_t line)
+{
+    return 2 * line + (self->polylines[line].reversed ? 0 : 1); // Exit end point
+}
+
+/**
+ * @details
+ * Drawing a run of polylines backwards means drawing them in reverse order, each one in the
+ * opposite direction; the pen-up moves inside the run keep their length.
+ */
+static void _reverseRun(pathPlan_t *const self, size_t *const position, size_t first, size_t last)
+{
+    for (size_t k = first; k <= last; k++)                // Every polyline in the run
+        self->polylines[self->order[k]].reversed ^= true; // Draw it the other way
+
+    while (first < last) // Swap from both ends
+    {
+        const size_t line = self->order[first]; // Swap positions
+        self->order[first] = self->order[last]; // of the two
+        self->order[last] = line;               // polylines
+        if (position)                           // Check if positions are tracked
+        {
+            position[self->order[first]] = first; // Record new position
+            position[self->order[last]] = last;   // Record new position
+        }
+        first++;                                // Move inwards
+        last--;                                 // Move inwards
+    }
+}
+
+/**
+ * @details
+ * Before the first polyline the pen is at the start.
+ */
+static inline Coord2D_t _before(const pathTour_t *const tour, const size_t p)
+{
+    const pathPlan_t *const self = tour->plan;                            // Plan being ordered
+    return p ? tour->ends[_exit(self, self->order[p - 1])] : tour->start; // Exit of the previous polyline
+}
+
+/**
+ * @details
+ * After the last polyline the pen only goes somewhere if the tour is closed.
+ */
+static inline bool _after(const pathTour_t *const tour, const size_t p, Coord2D_t *const point)
+{
+    const pathPlan_t *const self = tour->plan; // Plan being ordered
+    if (p < self->numPolylines)                // A polyline follows
+    {
+        *point = tour->ends[_entry(self, self->order[p])]; // Its entry
+        return true; // Pen moves there
+    }
+    *point = tour->end;  // End of the tour
+    return tour->closed; // Pen moves there if closed
+}
+
+/**
+ * @details
+ * A 2-opt move removes the pen-up moves A->B into position p and C->D out of position q-1,
+ * reverses the polylines at p to q-1 and adds A->C and B->D. Moves are found from both ends:
+ * C among the neighbours of A, and D among the neighbours of B. Only neighbours closer than
+ * A->B can give a saving, and the lists are sorted, so the search stops at the first one that
+ * is not. Reversing the tail is allowed; its D is the end of the tour, or nothing if it is open.
+ */
+static bool _twoOptPass(pathTour_t *const tour)
+{
+    pathPlan_t *const self = tour->plan;      // Plan being ordered
+    const Coord2D_t *const ends = tour->ends; // End point coordinates
+    size_t *const position = tour->position;  // Positions
+    const size_t n = self->numPolylines;      // Number of polylines
+    bool improved = false;                    // Any move made in this pass
+
+    for (size_t p = 0; p < n; p++) // Pen-up move into each position
+    {
+        const Coord2D_t a = _before(tour, p);             // A
+        const size_t into = _entry(self, self->order[p]); // End point B
+        const double ab = DistanceCoord2D(a, ends[into]); // A->B
+
+        const size_t *list = p ? &tour->neighbours[_exit(self, self->order[p - 1]) * PATH_NEIGHBOURS] // Candidates for C
+                               : tour->startNeighbours;                                               // around A
+        for (size_t j = 0; j < PATH_NEIGHBOURS && list[j] != PATH_NONE; j++)                          // Closest candidate first
+        {
+            const size_t c = list[j];                           // End point C
+            const double ac = DistanceCoord2D(a, ends[c]);      // A->C
+            if (ac >= ab)                                       // No saving possible
+                break;                                          // from this or any further candidate
+            if (c != _exit(self, c / 2) || position[c / 2] < p) // C must be left by a polyline at p or later
+                continue;                                       // Not a 2-opt move
+
+            const size_t q = position[c / 2] + 1;                                     // Position after the reversed run
+            double gain = ab - ac;                                                    // Saving at the front
+            Coord2D_t d;                                                              // D
+            if (_after(tour, q, &d))                                                  // Pen moves on after the run
+                gain += DistanceCoord2D(ends[c], d) - DistanceCoord2D(ends[into], d); // Saving at the back
+            if (gain > PATH_MIN_GAIN)                                                 // Shorter
+            {
+                _reverseRun(self, position, p, q - 1); // Apply the move
+                improved = true;                       // Remember it
+                break;                                 // Position p has changed
+            }
+        }
+
+        const size_t b = _entry(self, self->order[p]);                       // End point B, possibly after a move
+        const double ab2 = DistanceCoord2D(a, ends[b]);                      // A->B
+        list = &tour->neighbours[b * PATH_NEIGHBOURS];                       // Candidates for D
+        for (size_t j = 0; j < PATH_NEIGHBOURS && list[j] != PATH_NONE; j++) // Closest candidate first
+        {
+            const size_t d = list[j];                             // End point D
+            const double bd = DistanceCoord2D(ends[b], ends[d]);  // B->D
+            if (bd >= ab2)                                        // No saving possible
+                break;                                            // from this or any further candidate
+            if (d != _entry(self, d / 2) || position[d / 2] <= p) // D must enter a polyline after p
+                continue;                                         // Not a 2-opt move
+
+            const size_t q = position[d / 2];                          // Position after the reversed run
+            const Coord2D_t c = ends[_exit(self, self->order[q - 1])]; // C
+            const double gain = ab2 + DistanceCoord2D(c, ends[d])      // Removed moves
+                                - bd - DistanceCoord2D(a, c);          // minus added moves
+            if (gain > PATH_MIN_GAIN)                                  // Shorter
+            {
+                _reverseRun(self, position, p, q - 1); // Apply the move
+                improved = true;                       // Remember it
+                break;                                 // Position p has changed
+            }
+        }
+    }
+    return improved; // Report whether the tour changed
+}
+
+/**
+ * @details
+ * An Or-opt move takes the run of `length` polylines at position p out of the tour, which joins
+ * its neighbours P and N directly, and puts it back between two other polylines X and Y, drawn
+ * forwards or backwards, whichever is shorter. Taking the run out saves P->s1 + s2->N - P->N,
+ * where s1 and s2 are the end points the run is entered and left at. A new place only pays if
+ * X or Y lies closer than that saving to s1 or s2, so X is looked for among the exits and Y
+ * among the entries of the neighbours of s1 and s2.
+ */
+static bool _orOptPass(pathTour_t *const tour)
+{
+    pathPlan_t *const self = tour->plan;           // Plan being ordered
+    const Coord2D_t *const ends = tour->ends;      // End point coordinates
+    const size_t *const position = tour->position; // Positions
+    const size_t n = self->numPolylines;           // Number of polylines
+    bool improved = false;                         // Any move made in this pass
+
+    for (size_t length = 1; length <= PATH_OROPT_LENGTH && length < n; length++) // Runs of each length
+    {
+        for (size_t p = 0; p + length <= n; p++) // Run starting at each position
+        {
+            const size_t s1 = _entry(self, self->order[p]);             // End point the run is entered at
+            const size_t s2 = _exit(self, self->order[p + length - 1]); // End point it is left at
+            const Coord2D_t prev = _before(tour, p);                    // P
+            Coord2D_t next;                                             // N
+            const bool hasNext = _after(tour, p + length, &next);       // Check if the pen moves on
+            const double removed = DistanceCoord2D(prev, ends[s1])      // Saving from taking the run out
+                                   + (hasNext ? DistanceCoord2D(ends[s2], next) - DistanceCoord2D(prev, next) : 0.0);
+            if (removed <= PATH_MIN_GAIN) // Run already sits on the way
+                continue;                 // Nothing to gain
+
+            bool moved = false;                            // Run moved elsewhere
+            for (int side = 0; side < 2 && !moved; side++) // Candidates around s1, then s2
+            {
+                const size_t s = side ? s2 : s1;                                     // End point searched around
+                const size_t *const list = &tour->neighbours[s * PATH_NEIGHBOURS];   // Its neighbours
+                for (size_t j = 0; j < PATH_NEIGHBOURS && list[j] != PATH_NONE; j++) // Closest candidate first
+                {
+                    const size_t x = list[j];                               // Candidate end point
+                    if (DistanceCoord2D(ends[s], ends[x]) >= removed)       // No saving possible
+                        break;                                              // from this or any further candidate
+                    const size_t at = position[x / 2];                      // Position of its polyline
+                    if (at >= p && at < p + length)                         // Inside the run
+                        continue;                                           // Not a move
+                    const size_t i = x == _exit(self, x / 2) ? at + 1 : at; // Insert before this position
+                    if (i == p || i == p + length)                          // Where the run already is
+                        continue;                                           // Not a move
+
+                    const Coord2D_t before = _before(tour, i);                         // X
+                    Coord2D_t after;                                                   // Y
+                    const bool hasAfter = _after(tour, i, &after);                     // Check if the pen moves on
+                    const double xy = hasAfter ? DistanceCoord2D(before, after) : 0.0; // X->Y
+                    const double forwards = DistanceCoord2D(before, ends[s1]) - xy     // Cost of X->s1, s2->Y
+                                            + (hasAfter ? DistanceCoord2D(ends[s2], after) : 0.0);
+                    const double backwards = DistanceCoord2D(before, ends[s2]) - xy // Cost of X->s2, s1->Y
+                                             + (hasAfter ? DistanceCoord2D(ends[s1], after) : 0.0);
+                    const bool reverse = backwards < forwards;                      // Cheaper direction
+                    if (removed - (reverse ? backwards : forwards) > PATH_MIN_GAIN) // Shorter
+                    {
+                        _moveRun(tour, p, length, i, reverse); // Apply the move
+                        improved = moved = true;               // Remember it
+                        break;                                 // Position p has changed
+                    }
+                }
+            }
+        }
+    }
+    return improved; // Report whether the tour changed
+}
+
+/**
+ * @details
+ * The polylines between the old and the new place of the run shift by `length` positions to
+ * close the gap; only their positions need updating.
+ */
+static void _moveRun(pathTour_t *const tour, const size_t p, const size_t length, const size_t i, const bool reverse)
+{
+    pathPlan_t *const self = tour->plan; // Plan being ordered
+    size_t run[PATH_OROPT_LENGTH];       // Polylines of the run
+    for (size_t k = 0; k < length; k++)  // Copy the run
+        run[k] = self->order[p + k];     // out of the order
+
+    size_t at; // New position of the run
+    if (i > p) // Moving towards the end
+    {
+        memmove(&self->order[p], &self->order[p + length], (i - p - length) * sizeof(size_t)); // Close the gap
+        at = i - length;                                                                       // Run ends before position i
+    }
+    else // Moving towards the start
+    {
+        memmove(&self->order[i + length], &self->order[i], (p - i) * sizeof(size_t)); // Open a gap
+        at = i;                                                                       // Run starts at position i
+    }
+
+    for (size_t k = 0; k < length; k++) // Put the run back
+    {
+        const size_t line = reverse ? run[length - 1 - k] : run[k]; // Polyline in its new order
+        self->order[at + k] = line;                                 // Store it
+        if (reverse)                                                // Drawn backwards
+            self->polylines[line].reversed ^= true;                 // in the other direction
+    }
+
+    const size_t low = i > p ? p : i;           // First position that changed
+    const size_t high = i > p ? i : p + length; // Past the last one
+    for (size_t k = low; k < high; k++)         // Every changed position
+        tour->position[self->order[k]] = k;     // Record it
+}
+
+/**
+ * @details
+ * The cell size gives about PATH_GRID_LOAD end points per cell over the bounding box of the end
+ * points. The end points are then sorted into their cells with a counting sort.
+ */
+static errorCode_t _gridBuild(pathGrid_t *const grid, const Coord2D_t *const ends, const size_t count)
+{
+    Coord2D_t low = ends[0];           // Lower left corner
+    Coord2D_t high = ends[0];          // Upper right corner
+    for (size_t e = 1; e < count; e++) // Bounding box
+    {
+        low.x = ends[e].x < low.x ? ends[e].x : low.x;    // Leftmost
+        low.y = ends[e].y < low.y ? ends[e].y : low.y;    // Lowest
+        high.x = ends[e].x > high.x ? ends[e].x : high.x; // Rightmost
+        high.y = ends[e].y > high.y ? ends[e].y : high.y; // Highest
+    }
+
+    const double width = high.x - low.x;                             // Width of the box
+    const double height = high.y - low.y;                            // Height of the box
+    double cellSize = sqrt(width * height * PATH_GRID_LOAD / count); // Cell size for the target load
+    const double longest = width > height ? width : height;          // Longer side of the box
+    if (cellSize < longest * PATH_GRID_LOAD / count)                 // Box is (nearly) a line
+        cellSize = longest * PATH_GRID_LOAD / count;                 // Size cells along it
+    if (!(cellSize > 0.0))                                           // All end points coincide
+        cellSize = 1.0;                                              // Any size will do
+
+    grid->origin = low;                                     // Set origin
+    grid->cellSize = cellSize;                              // Set cell size
+    grid->cols = (long)(width / cellSize) + 1;              // Set number of columns
+    grid->rows = (long)(height / cellSize) + 1;             // Set number of rows
+    const size_t cells = (size_t)(grid->cols * grid->rows); // Number of cells
+
+    grid->start = calloc(cells + 1, sizeof(size_t));                  // Cell offsets
+    grid->live = calloc(cells, sizeof(size_t));                       // Cell fill
+    grid->entries = malloc(count * sizeof(size_t));                   // Grouped end points
+    grid->slot = malloc(count * sizeof(size_t));                      // End point positions
+    if (!grid->start || !grid->live || !grid->entries || !grid->slot) // Check if memory allocation failed
+    {
+        _gridFree(grid);                       // Avoid memory leak
+        return ERROR_MEMORY_ALLOCATION_FAILED; // Report failure
+    }
+
+    for (size_t e = 0; e < count; e++) // Count the end points of each cell
+    {
+        long col, row;                                  // Cell of the end point
+        _gridCell(grid, ends[e], &col, &row);           // Find it
+        grid->live[(size_t)(row * grid->cols + col)]++; // Count it
+    }
+    for (size_t c = 0; c < cells; c++)                       // Offsets from counts
+        grid->start[c + 1] = grid->start[c] + grid->live[c]; // Cell c ends where c + 1 starts
+    for (size_t c = 0; c < cells; c++)                       // Refill while placing
+        grid->live[c] = 0;                                   // Empty cell
+    for (size_t e = 0; e < count; e++)                       // Place every end point
+    {
+        long col, row;                                               // Cell of the end point
+        _gridCell(grid, ends[e], &col, &row);                        // Find it
+        const size_t cell = (size_t)(row * grid->cols + col);        // Cell index
+        const size_t index = grid->start[cell] + grid->live[cell]++; // Next free entry of the cell
+        grid->entries[index] = e;                                    // Store end point
+        grid->slot[e] = index;                                       // Remember where
+    }
+    return SUCCESS; // Return success
+}
+
+/**
+ * @details
+ * Safe to call on a partly built grid.
+ */
+static void _gridFree(pathGrid_t *const grid)
+{
+    free(grid->start);                                            // Free cell offsets
+    free(grid->live);                                             // Free cell fill
+    free(grid->entries);                                          // Free grouped end points
+    free(grid->slot);                                             // Free end point positions
+    grid->start = grid->live = grid->entries = grid->slot = NULL; // Nothing left to free
+}
+
+/**
+ * @details
+ * Points outside the grid fall into the nearest border cell.
+ */
+static inline void _gridCell(const pathGrid_t *const grid, const Coord2D_t point, long *const col, long *const row)
+{
+    const double x = (point.x - grid->origin.x) / grid->cellSize; // Column as a real number
+    const double y = (point.y - grid->origin.y) / grid->cellSize; // Row as a real number
+    *col = x <= 0.0 ? 0 : x >= grid->cols - 1 ? grid->cols - 1 : (long)x; // Clamp column
+    *row = y <= 0.0 ? 0 : y >= grid->rows - 1 ? grid->rows - 1 : (long)y; // Clamp row
+}
+
+/**
+ * @details
+ * The end point swaps places with the last live end point of its cell, which keeps the live end
+ * points of every cell at the front of its range.
+ */
+static void _gridRemove(pathGrid_t *const grid, const Coord2D_t *const ends, const size_t end)
+{
+    long col, row;                                        // Cell of the end point
+    _gridCell(grid, ends[end], &col, &row);               // Find it
+    const size_t cell = (size_t)(row * grid->cols + col); // Cell index
+
+    const size_t index = grid->slot[end];                       // Where the end point is
+    const size_t last = grid->start[cell] + --grid->live[cell]; // Last live entry of the cell
+    const size_t other = grid->entries[last];                   // End point stored there
+    grid->entries[last] = end;                                  // Move removed end point behind
+    grid->entries[index] = other;                               // Move live end point forward
+    grid->slot[end] = last;                                     // Record new position
+    grid->slot[other] = index;                                  // Record new position
+}
+
+/**
+ * @details
+ * Searches square rings of cells around the cell of the query point, keeping the k closest end
+ * points in a small sorted list. Every cell beyond ring r is at least r cells away from the
+ * query point, so the search stops once the list is full and its farthest entry is no farther
+ * than that. Equal distances are resolved towards the lower end point, which keeps the result
+ * independent of the order of the cells.
+ */
+static size_t _gridNearest(const pathGrid_t *const grid, const Coord2D_t *const ends, const Coord2D_t point,
+                           const size_t skip, const size_t k, size_t *const found)
+{
+    double distance[PATH_NEIGHBOURS]; // Distance of each end point found
+    size_t count = 0;                 // End points found
+
+    long col0, row0;                                                      // Cell of the query point
+    _gridCell(grid, point, &col0, &row0);                                 // Find it
+    const long rings = grid->cols > grid->rows ? grid->cols : grid->rows; // Rings that cover the grid
+    for (long r = 0; r < rings; r++)                                      // Ring by ring
+    {
+        for (long row = row0 - r; row <= row0 + r; row++) // Rows of the ring
+        {
+            if (row < 0 || row >= grid->rows) // Outside the grid
+                continue;                     // Skip row
+
+            const long step = (row == row0 - r || row == row0 + r) ? 1 : 2 * r; // Whole edge rows, two cells otherwise
+            for (long col = col0 - r; col <= col0 + r; col += step)             // Cells of the ring in this row
+            {
+                if (col < 0 || col >= grid->cols) // Outside the grid
+                    continue;                     // Skip cell
+
+                const size_t cell = (size_t)(row * grid->cols + col);    // Cell index
+                const size_t *entry = &grid->entries[grid->start[cell]]; // First end point
+                const size_t *const stop = entry + grid->live[cell];     // Past the live ones
+                for (; entry < stop; entry++)                            // Every live end point
+                {
+                    const size_t e = *entry;                          // End point
+                    if (e == skip)                                    // Left out
+                        continue;                                     // Skip it
+                    const double d = DistanceCoord2D(point, ends[e]); // Its distance
+                    if (count == k && (d > distance[k - 1] ||         // Farther than the k found
+                                       (d == distance[k - 1] && e > found[k - 1])))
+                        continue; // Skip it
+
+                    size_t i = count < k ? count++ : k - 1;                                              // Slot to fill
+                    while (i > 0 && (d < distance[i - 1] || (d == distance[i - 1] && e < found[i - 1]))) // Keep sorted
+                    {
+                        distance[i] = distance[i - 1]; // Shift farther entry
+                        found[i] = found[i - 1];       // back by one
+                        i--;                           // Next slot
+                    }
+                    distance[i] = d; // Insert distance
+                    found[i] = e;    // Insert end point
+                }
+            }
+        }
+
+        if (count == k && distance[k - 1] <= r * grid->cellSize) // Nothing closer beyond this ring
+            break;                                               // Stop searching
+    }
+    return count; // Return number found
+}
@@ -0,0 +1,147 @@
+/**
+ * @file pathPlan.h
+ * @brief Declaration of the pathPlan_t structure, which reorders pen-down polylines to shorten pen-up travel.
+ * @details
+ * Glyphs are drawn stroke by stroke in the order of the font file, one character after the other,
+ * so the pen often travels back across a glyph it has just drawn, and every glyph ends with a
+ * pen-up move to the next character. The path plan collects the pen-down strokes of a whole page
+ * as polylines in absolute coordinates, then chooses the order in which they are drawn and the
+ * direction in which each one is drawn so that the pen-up moves between them get shorter. The ink
+ * on the page stays exactly the same.
+ *
+ * The order is built with a nearest-neighbour tour and improved with 2-opt and Or-opt moves.
+ * All of them use a uniform grid over the polyline end points so that a page with thousands of
+ * glyphs is planned in a few milliseconds.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../misc/coord.h"
+#include "../misc/error.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define PATH_INITIAL_CAPACITY 256 /**< Points and polylines allocated before the first growth. */
+#define PATH_NEIGHBOURS 8         /**< Nearest end points considered for each move. */
+#define PATH_OROPT_LENGTH 8       /**< Longest run of polylines an Or-opt move relocates, about a short word. */
+#define PATH_IMPROVE_PASSES 8     /**< Most rounds of 2-opt and Or-opt passes over the tour. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A run of connected pen-down strokes.
+ */
+typedef struct pathPolyline_s
+{
+    size_t first;  /**< Index of the first point in pathPlan_t::points. */
+    size_t count;  /**< Number of points, at least two. */
+    bool reversed; /**< true to draw the polyline from its last point to its first. */
+} pathPolyline_t;
+
+/**
+ * @brief Structure holding the polylines of a page and the order in which to draw them.
+ * @details
+ * Strokes are added in font order with add(). optimise() fills `order` with the polylines in
+ * drawing order and sets their `reversed` flags; until then `order` holds the order they were
+ * added in. clear() empties the plan for the next page.
+ */
+typedef struct pathPlan_s
+{
+    Coord2D_t *points;     /**< Points of every polyline, polyline after polyline. */
+    size_t numPoints;      /**< Number of points. */
+    size_t pointCapacity;  /**< Points allocated. */
+
+    pathPolyline_t *polylines; /**< Polylines in the order they were added. */
+    size_t *order;             /**< Index into polylines of the polyline drawn at each position. */
+    size_t numPolylines;       /**< Number of polylines. */
+    size_t polylineCapacity;   /**< Polylines allocated. */
+    bool open;                 /**< true if the next pen-down stroke may extend the last polyline. */
+
+    /**
+     * @brief Adds a stroke from one point to another.
+     * @details A pen-up stroke only ends the current polyline. A pen-down stroke extends the current
+     *          polyline if it starts where the polyline ends, or starts a new one otherwise.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     * @param[in] from Start point of the stroke.
+     * @param[in] to End point of the stroke.
+     * @param[in] penDown true if the stroke draws.
+     * @return SUCCESS, ERROR_MEMORY_ALLOCATION_FAILED, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*add)(struct pathPlan_s *const self, const Coord2D_t from, const Coord2D_t to, const bool penDown);
+
+    /**
+     * @brief Removes the points that do not change the drawing, or change it by less than a tolerance.
+     * @details Collinear points are always merged, see MergeCollinear(). With a positive tolerance the
+     *          polylines are then simplified, see SimplifyPolyline(). If the working memory for that
+     *          cannot be allocated only the exact merge is made.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     * @param[in] tolerance Largest distance in mm between a removed point and the drawing, 0 for the exact merge only.
+     * @return Number of points removed, which is the number of G1 moves saved.
+     */
+    size_t (*simplify)(struct pathPlan_s *const self, const double tolerance);
+
+    /**
+     * @brief Reorders and reverses the polylines to shorten the pen-up travel.
+     * @details If the working memory cannot be allocated the plan keeps the order it was added in.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     * @param[in] start Position of the pen before the first polyline.
+     * @param[in] end Position the pen goes to after the last polyline, or NULL if it stays there.
+     * @return SUCCESS, ERROR_MEMORY_ALLOCATION_FAILED, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*optimise)(struct pathPlan_s *const self, const Coord2D_t start, const Coord2D_t *const end);
+
+    /**
+     * @brief Reverses the drawing order and direction of the polylines from a position to the end.
+     * @details The pen-up moves between the reversed polylines keep their length.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     * @param[in] first Position of the first polyline to reverse.
+     */
+    void (*reverse)(struct pathPlan_s *const self, const size_t first);
+
+    /**
+     * @brief Calculates the pen-up travel of the current order.
+     * @param[in] self Pointer to the pathPlan_t structure.
+     * @param[in] start Position of the pen before the first polyline.
+     * @return Sum of the distances from the start to the first polyline and between polylines, in mm.
+     */
+    double (*travel)(const struct pathPlan_s *const self, const Coord2D_t start);
+
+    /**
+     * @brief Removes every polyline.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     */
+    void (*clear)(struct pathPlan_s *const self);
+
+    /**
+     * @brief Frees the plan and its polylines.
+     * @param[in,out] self Pointer to the pathPlan_t structure.
+     * @return SUCCESS on success, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct pathPlan_s *self);
+} pathPlan_t;
+
+/**
+ * @brief Returns a point of a polyline in drawing direction.
+ * @param[in] self Pointer to the pathPlan_t structure.
+ * @param[in] line The polyline.
+ * @param[in] i Index of the point along the drawing direction.
+ * @return The point.
+ */
+static inline Coord2D_t PathPoint(const pathPlan_t *const self, const pathPolyline_t *const line, const size_t i)
+{
+    return self->points[line->first + (line->reversed ? line->count - 1 - i : i)];
+}
+
+/**
+ * @brief Constructs and initializes a new, empty pathPlan_t object.
+ * @return A pointer to the newly created pathPlan_t object, or NULL if allocation fails.
+ */
+pathPlan_t *pathPlanConstructor(void);
@@ -0,0 +1,181 @@
+/**
+ * @file preflight.c
+ * @brief Implementation of the check a laid out job gets before the robot moves.
+ * @details
+ * The glyphs are visited line by line, as generate_gcode() draws them, and each is put where it
+ * will be drawn. The ink box of its metrics, scaled, is enough for the box of the job and for
+ * almost every character, which lies well inside the drawing area. Only when the ink box leaves
+ * the area are the strokes of the character followed from the cursor, scaled by StrokeVector()
+ * exactly as the glyph cache scales them, to measure how far each pen-down stroke leaves it.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "preflight.h"
+#include "robot.h"
+
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Calculates how far a point lies outside the drawing area.
+ * @param[in] point The point, in mm.
+ * @return Distance in mm along the axis it leaves the area by most, 0 inside the area.
+ */
+static inline double _outside(const Coord2D_t point);
+
+/**
+ * @brief Follows the strokes of a character to find those that leave the drawing area.
+ * @param[in,out] report The result, whose overshoot and strokes out of bounds are updated.
+ * @param[in] fontCharacter The character.
+ * @param[in] strokes The strokes of the font.
+ * @param[in] origin Where the strokes of the character start, in mm.
+ * @param[in] scale Scale factor of the text.
+ */
+static void _followStrokes(preflight_t *const report, const fontCharacter_t *const fontCharacter,
+                           const stroke_t *const strokes, const Coord2D_t origin, const double scale);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The missing characters are not looked for again: the layout counted them when it skipped them,
+ * and the report copies the first few. The strokes are counted from the characters, not scaled,
+ * so the count is that of the strokes sent before any are merged.
+ */
+preflight_t CheckLayout(const layout_t *const layout, const double tolerance)
+{
+    preflight_t report;                 // Result
+    memset(&report, 0, sizeof(report)); // Start from nothing
+    report.tolerance = tolerance;       // Keep the tolerance for the report
+    if (!layout)                        // Check if layout is NULL
+        return report;                  // Nothing to check
+
+    const fontData_t *const fontData = layout->fontData; // Font of the layout
+    const double scale = layout->cursor.scale;           // Scale of the text
+    report.pages = layout->numPages;                     // Pages of the job
+    report.lines = layout->numLines;                     // Lines of the job
+    report.characters = layout->numGlyphs;               // Characters drawn
+    report.missingKinds = layout->numMissing;            // Different characters missing
+    for (size_t i = 0; i < layout->numMissing; i++)      // Iterate through missing characters
+    {
+        report.missing += layout->missing[i].count; // Count every occurrence
+        if (i < PREFLIGHT_MISSING_SHOWN)            // Check if there is room to show it
+            report.shown[i] = layout->missing[i];   // Keep it
+    }
+
+    for (size_t line = 0; line < layout->numLines; line++) // Iterate through lines
+    {
+        const size_t end = line + 1 < layout->numLines ? layout->lines[line + 1].first // End of the line
+                                                       : layout->numGlyphs;
+        const double y = layout->lines[line].y;                  // Height of the line
+        for (size_t i = layout->lines[line].first; i < end; i++) // Iterate through its glyphs
+        {
+            const layoutGlyph_t *const placed = &layout->glyphs[i];                                     // Glyph placed
+            const fontCharacter_t *const fontCharacter = fontData->lookup(fontData, placed->codePoint); // Its character
+            const fontMetrics_t *const metrics = fontData->measure(fontData, placed->codePoint);        // Its metrics
+            if (!fontCharacter || !metrics)                                                             // Check if the font lost it
+                continue;                                                                               // Nothing to check
+            report.strokes += fontCharacter->numStrokes;                                                // Count its strokes
+            if (!metrics->inked)                                                                        // Check if it draws anything
+                continue;                                                                               // Nothing to bound
+
+            Coord2D_t origin;                                                            // Where its strokes start
+            origin.x = placed->x - (layout->proportional ? metrics->left * scale : 0.0); // Shifted as generate_gcode() shifts it
+            origin.y = y;                                                                // On its line
+            Coord2D_t low, high;                                                         // Ink box of the character
+            low.x = origin.x + metrics->left * scale;                                    // Left of the ink
+            low.y = origin.y + metrics->bottom * scale;                                  // Bottom of the ink
+            high.x = origin.x + metrics->right * scale;                                  // Right of the ink
+            high.y = origin.y + metrics->top * scale;                                    // Top of the ink
+
+            if (!report.inked) // Check if it is the first ink
+            {
+                report.min = low;    // Start the box
+                report.max = high;   // with the character
+                report.inked = true; // The job draws
+            }
+            report.min.x = low.x < report.min.x ? low.x : report.min.x;   // Grow the box
+            report.min.y = low.y < report.min.y ? low.y : report.min.y;   // to hold
+            report.max.x = high.x > report.max.x ? high.x : report.max.x; // the ink
+            report.max.y = high.y > report.max.y ? high.y : report.max.y; // of the character
+
+            if (_outside(low) > 0.0 || _outside(high) > 0.0)                                                           // Check if the ink may leave the area
+                _followStrokes(&report, fontCharacter, &fontData->table.strokes[fontCharacter->first], origin, scale); // Measure its strokes
+        }
+    }
+    return report; // Return result
+}
+
+/**
+ * @details
+ * Missing characters are listed by code point, with the times each occurs, up to
+ * PREFLIGHT_MISSING_SHOWN of them.
+ */
+void PrintPreflight(FILE *const file, const preflight_t *const report)
+{
+    if (!file || !report) // Check if file or report is NULL
+        return;           // Nothing to print
+
+    fprintf(file, "Preflight: %zu pages, %zu lines, %zu characters, %lu strokes\n", report->pages, report->lines, // Size of the job
+            report->characters, report->strokes);
+    if (report->inked)                                                                                            // Check if the job draws anything
+        fprintf(file, "Preflight: ink from X %.2f to %.2f mm, Y %.2f to %.2f mm\n", report->min.x, report->max.x, // Box of the ink
+                report->min.y, report->max.y);
+    if (report->outOfBounds > 0)                                                                                         // Check if strokes leave the area
+        fprintf(file, "Preflight: %lu strokes leave the drawing area by up to %.2f mm, more than the %.2f mm allowed\n", // Strokes out of bounds
+                report->outOfBounds, report->overshoot, report->tolerance);
+    if (report->missing == 0) // Check if every character is defined
+        return;               // Done
+
+    fprintf(file, "Preflight: %zu characters skipped, not in the font:", report->missing); // Missing characters
+    const size_t shown = report->missingKinds < PREFLIGHT_MISSING_SHOWN ? report->missingKinds // Characters kept
+                                                                        : PREFLIGHT_MISSING_SHOWN;
+    for (size_t i = 0; i < shown; i++)                                                                     // Iterate through those kept
+        fprintf(file, " U+%04lX x%zu", (unsigned long)report->shown[i].codePoint, report->shown[i].count); // Code point and times
+    if (report->missingKinds > shown)                                                                      // Check if there are more
+        fprintf(file, " and %zu more", report->missingKinds - shown);                                      // Count the rest
+    fputc('\n', file);                                                                                     // End the line
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+static inline double _outside(const Coord2D_t point)
+{
+    double distance = 0.0;                                                                // Inside the area
+    distance = MIN_X_VALUE_MM - point.x > distance ? MIN_X_VALUE_MM - point.x : distance; // Left of it
+    distance = point.x - MAX_X_VALUE_MM > distance ? point.x - MAX_X_VALUE_MM : distance; // Right of it
+    distance = MIN_Y_VALUE_MM - point.y > distance ? MIN_Y_VALUE_MM - point.y : distance; // Below it
+    distance = point.y - MAX_Y_VALUE_MM > distance ? point.y - MAX_Y_VALUE_MM : distance; // Above it
+    return distance;                                                                      // Return distance
+}
+
+static void _followStrokes(preflight_t *const report, const fontCharacter_t *const fontCharacter,
+                           const stroke_t *const strokes, const Coord2D_t origin, const double scale)
+{
+    Coord2D_t pen = origin;                                 // Pen starts at the cursor
+    for (uint8_t k = 0; k < fontCharacter->numStrokes; k++) // Iterate through strokes
+    {
+        const Vect2d_t vector = StrokeVector(strokes[k], scale); // Scaled like the glyph cache
+        Coord2D_t point;                                         // End of the stroke
+        point.x = origin.x + vector.x;                           // Strokes are relative
+        point.y = origin.y + vector.y;                           // to the cursor
+        if (StrokePenDown(strokes[k]))                           // Check if the stroke draws
+        {
+            const double from = _outside(pen);             // Start outside the area
+            const double to = _outside(point);             // End outside the area
+            const double distance = from > to ? from : to; // A straight stroke is farthest at an end
+            if (distance > report->overshoot)              // Check if it is the farthest yet
+                report->overshoot = distance;              // Keep it
+            if (distance > report->tolerance)              // Check if it leaves by too much
+                report->outOfBounds++;                     // Count it
+        }
+        pen = point; // Move the pen
+    }
+}
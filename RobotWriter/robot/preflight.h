@@ -0,0 +1,79 @@
+/**
+ * @file preflight.h
+ * @brief Declaration of the preflight_t structure, the check a laid out job gets before the robot moves.
+ * @details
+ * Once a job is laid out, every character of it has its place, so the whole job can be checked
+ * before its first command is sent: the box its ink fills, the strokes that leave the drawing
+ * area, the characters the font does not define, and the number of strokes it sends. A job that
+ * leaves the drawing area is rejected there, instead of after the robot has drawn everything up
+ * to the stroke that leaves it.
+ *
+ * The check looks up each character and the metrics the font measured when it was loaded, and
+ * scales no stroke. Only a character whose ink box leaves the drawing area has its strokes
+ * followed, to find those that really leave it, so checking a job takes a fraction of the time
+ * laying it out does, and well under a second for a text of tens of megabytes.
+ *
+ * Characters may reach a little outside their character space, such as brackets above capitals
+ * or descenders below the line, and have always been drawn there. A stroke only counts as out of
+ * bounds if it leaves the drawing area by more than a tolerance.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "../misc/coord.h"
+#include "layout.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define PREFLIGHT_TOLERANCE_MM 2.0 /**< Default distance in mm a stroke may leave the drawing area by. */
+#define PREFLIGHT_MISSING_SHOWN 8  /**< Most missing characters listed by PrintPreflight(). */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Result of checking a laid out job.
+ */
+typedef struct preflight_s
+{
+    size_t pages;              /**< Pages of the job. */
+    size_t lines;              /**< Lines of the job. */
+    size_t characters;         /**< Characters drawn. */
+    unsigned long strokes;     /**< Strokes sent, before simplification. */
+    bool inked;                /**< true if the job draws anything; the box is only meaningful then. */
+    Coord2D_t min;             /**< Bottom left of the box the ink fills, in mm. */
+    Coord2D_t max;             /**< Top right of the box the ink fills, in mm. */
+    double overshoot;          /**< Farthest a pen-down stroke leaves the drawing area, in mm. */
+    double tolerance;          /**< Distance in mm a stroke may leave the drawing area by. */
+    unsigned long outOfBounds; /**< Pen-down strokes that leave the drawing area by more than the tolerance. */
+    size_t missing;            /**< Characters skipped because the font does not define them. */
+    size_t missingKinds;       /**< Different characters among them. */
+
+    layoutMissing_t shown[PREFLIGHT_MISSING_SHOWN]; /**< The first missing characters by code point. */
+} preflight_t;
+
+/**
+ * @brief Checks a laid out job against the drawing area of robot.h.
+ * @param[in] layout The layout of the job.
+ * @param[in] tolerance Distance in mm a stroke may leave the drawing area by.
+ * @return The result; the job may be drawn if `outOfBounds` is 0.
+ */
+preflight_t CheckLayout(const layout_t *const layout, const double tolerance);
+
+/**
+ * @brief Prints the result of a check.
+ * @details The pages, lines, characters and strokes are printed on one line, the box of the ink
+ *          on a second. The strokes out of bounds and the missing characters are only printed if
+ *          there are any.
+ * @param[in] file Stream to print to, e.g. stderr.
+ * @param[in] report The result of CheckLayout().
+ */
+void PrintPreflight(FILE *const file, const preflight_t *const report);
@@ -9,9 +9,13 @@
  * - Send stroke commands that move the pen or tool along specified coordinates
  *   and toggle its state.
  *
- * All movements and actions are communicated to the robot via serial commands,
- * and the code ensures proper handling of command acknowledgments and waiting
- * periods.
+ * All movements and actions are communicated to the robot via serial commands.
+ * Commands go through a grblStream_t which, in streaming mode, keeps the
+ * controller's receive buffer full and matches each acknowledgement to the
+ * command it answers. The stream sits in a serial gcodeSink_t, and every line
+ * is also written to the output sink chosen by the caller. With path
+ * optimisation enabled, strokes are collected in a pathPlan_t until the page is
+ * finished and then drawn in an order that keeps the pen-up travel short.
  * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
  */
 #include "robot.h"
@@ -23,9 +27,94 @@
 /**
  * @brief Sends a command buffer to the robot and waits for a reply.
  * @param[in] buffer The command buffer to send.
+ * @param[in] length Length of the command.
  * @return SUCCESS on successful command transmission, or an appropriate error code.
  */
-static errorCode_t SendCommands(char *const buffer);
+static errorCode_t SendCommands(char *const buffer, const size_t length);
+
+/**
+ * @brief Builds a move line with the writer and sends it.
+ * @param[in] spindle Spindle word, e.g. "S1000".
+ * @param[in] motion Motion word, e.g. "G1".
+ * @param[in] pos Target position in millimetres.
+ * @param[in] comment Trailing comment, or NULL for none.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t SendMove(const char *spindle, const char *motion, const Coord2D_t pos, const char *comment);
+
+/**
+ * @brief Builds an arc line with the writer and sends it.
+ * @param[in] motion Motion word, "G2" or "G3".
+ * @param[in] pos Target position in millimetres.
+ * @param[in] offset Centre of the arc relative to its start, in millimetres.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t SendArc(const char *motion, const Coord2D_t pos, const Coord2D_t offset);
+
+/**
+ * @brief Sends a command that waits for the machine to stop, and times it.
+ * @param[in] command The command, without line end.
+ * @param[in] seconds Time the command holds the machine, 0 if unknown.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t SendPause(const char *command, const double seconds);
+
+/**
+ * @brief Sends a line built by the writer to the robot and echoes it.
+ * @param[in] buffer The terminated line.
+ * @param[in] length Length of the line.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t SendLine(char *const buffer, const size_t length);
+
+/**
+ * @brief Draws one polyline of the plan, fitting arcs if enabled.
+ * @param[in,out] line The polyline; arc fitting turns a reversed one around in place.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t DrawPolyline(pathPolyline_t *const line);
+
+/**
+ * @brief Draws the collected strokes and empties the plan.
+ * @param[in] end Position the robot moves to afterwards, or NULL if unknown.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+static errorCode_t DrawPlan(const Coord2D_t *const end);
+
+static gcodeSink_t *controller = NULL;      /**< Serial sink to the controller, created by StartUpRobot(). */
+static grblStream_t *stream = NULL;         /**< Stream of the controller sink, which owns it. */
+static bool streamingMode = STREAMING_MODE; /**< Transfer mode used when the stream is created. */
+static gcodeWriter_t writer;                /**< Builds move lines, constructed on first use. */
+static bool gcodeCompact = GCODE_COMPACT;   /**< Writer mode used when the writer is constructed. */
+static int gcodeDecimals = GCODE_DECIMALS;  /**< Coordinate precision used when the writer is constructed. */
+static pathPlan_t *plan = NULL;             /**< Strokes waiting to be drawn, created on first use. */
+static bool pathOptimise = PATH_OPTIMISE;   /**< Collect strokes and reorder them before sending. */
+static bool serpentine = SERPENTINE_MODE;   /**< Draw line by line, alternate lines right to left. */
+static bool lineBackwards = false;          /**< The line being collected is drawn right to left. */
+static unsigned long strokeLine = 0;        /**< Cursor line of the last stroke collected. */
+
+static bool simplify = SIMPLIFY_MODE;                    /**< Merge collinear strokes before sending. */
+static double simplifyTolerance = SIMPLIFY_TOLERANCE_MM; /**< Douglas-Peucker tolerance in mm, 0 for the exact merge. */
+static bool arcFitting = ARC_FIT_MODE;                   /**< Send curved runs of strokes as arcs. */
+static double arcTolerance = ARC_TOLERANCE_MM;           /**< Largest distance in mm between an arc and its strokes. */
+
+static const char *pageCommands[MAX_PAGE_COMMANDS] = {PAGE_CHANGE_GCODE}; /**< Commands sent between pages. */
+static int numPageCommands = 1;                                            /**< Number of commands sent between pages. */
+static double pagePause = PAGE_PAUSE_S;                                    /**< Dwell in s sent between pages, 0 for none. */
+
+static bool dryRun = DRY_RUN_MODE; /**< Estimate the job without opening the port. */
+static plotEstimate_t estimate;    /**< Times the moves sent, constructed on first use. */
+static gcodeSink_t *output = NULL; /**< Sink the G-code is written to, none if NULL. */
+
+static Coord2D_t penPosition = {HOME_X_VALUE_MM, HOME_Y_VALUE_MM};   /**< Pen position in font order. */
+static Coord2D_t robotPosition = {HOME_X_VALUE_MM, HOME_Y_VALUE_MM}; /**< Last position sent to the robot. */
+static double travelFontOrder = 0.0;                                 /**< Pen-up travel of the job in font order, in mm. */
+static double travelSent = 0.0;                                      /**< Pen-up travel of the job as sent, in mm. */
+static unsigned long drawMoves = 0;                                  /**< Pen-down moves of the job before simplification. */
+static unsigned long drawMovesRemoved = 0;                           /**< Pen-down moves of the job removed by simplification. */
+static unsigned long arcsSent = 0;                                   /**< Arcs sent in the job. */
+static unsigned long arcMovesReplaced = 0;                           /**< Straight pen-down moves of the job replaced by arcs. */
+static unsigned long pageChanges = 0;                                /**< Page changes in the job. */
 
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DEFINITIONS                       //
@@ -33,45 +122,101 @@ static errorCode_t SendCommands(char *const buffer);
 
 /**
  * @details
- * Moves the robot to a defined home position by sending the appropriate G-code
- * command. After constructing the G-code command with the home coordinates, it
- * sends the command to the robot and prints the command for debugging purposes.
+ * Draws the strokes still collected, moves the robot to a defined home position by sending the
+ * appropriate G-code command, then waits until every command sent so far has been acknowledged
+ * and the output holds every line of the job.
+ * The return home counts as pen-up travel both in font order and as sent, and the estimate
+ * ends with the robot standing still at home.
+ *
+ * The move home lifts the pen and sets the rapid motion mode that the next job relies on, so the
+ * replies to the lines drawn before it are waited for first, and a rejected move home is told
+ * apart from a rejected drawing line and ends the job.
  */
 errorCode_t HomeRobot(void)
 {
-    char buffer[256];                                                                                   // Buffer to hold command
-    snprintf(buffer, sizeof(buffer), "S0 G0 X%.2lf Y%.2lf ; Home\n", HOME_X_VALUE_MM, HOME_Y_VALUE_MM); // Construct command
+    const Coord2D_t home = {HOME_X_VALUE_MM, HOME_Y_VALUE_MM}; // Home position
+    errorCode_t error = DrawPlan(&home);                       // Draw the collected strokes on the way home
+    lineBackwards = false;                                     // Next job starts left to right
+    if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY)   // Check if the robot stopped answering
+        return error;                                          // Return error
+
+    travelFontOrder += DistanceCoord2D(penPosition, home); // Font order ends at home too
+    penPosition = home;                                    // Pen is home
+    if (controller)                                        // Check if there is a robot
+    {
+        const errorCode_t drawn = controller->flush(controller); // Wait for the replies to the drawing
+        if (drawn != SUCCESS && drawn != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+            return drawn;                                        // Return error
+        if (drawn != SUCCESS)                                    // Check if a drawing line was rejected
+            error = drawn;                                       // Remember the error
+    }
 
-#ifdef Serial_Mode
-    SendCommands(buffer); // Send command
-#endif
-                          // Send command
-    printf("%s", buffer); // Print command
+    const errorCode_t moved = SendMove("S0", "G0", home, "Home");            // Send command
+    errorCode_t synced = SUCCESS;                                            // Reply to the move home
+    if ((moved == SUCCESS || moved == ERROR_CONTROLLER_REPLY) && controller) // Check if the command was queued
+        synced = controller->flush(controller);                              // Wait until it is acknowledged
+    if (moved == ERROR_CONTROLLER_REPLY || synced == ERROR_CONTROLLER_REPLY) // Check if the move home was rejected
+        error = ErrorHandler(ERROR_CONTROLLER_STATE);                        // The pen may still be down
+    else if (moved != SUCCESS)                                               // Check if the command failed
+        error = moved;                                                       // Remember the error
+    else if (synced != SUCCESS)                                              // Check if the controller failed
+        error = synced;                                                      // Remember the error
+    if (output)                                            // Check if there is an output
+    {
+        const errorCode_t written = output->flush(output); // Write out the job
+        if (written != SUCCESS)                            // Check if writing failed
+            error = written;                               // Remember the error
+    }
 
-    return SUCCESS; // Return success
+    if (estimate.init)              // Check if estimator is initialized
+        estimate.finish(&estimate); // Robot stops at home
+    return error;                   // Return worst controller reply
 }
 
 /**
  * @details
  * Sends a stroke command to the robot based on the provided cursor position and stroke data.
- * The stroke includes a vector (defining the movement direction and distance) and a pen state
- * (up or down). Depending on the pen state, the command uses either a rapid move (G0) with no
- * drawing or a linear move (G1) with drawing. After forming the command, the function sends it
- * to the robot and prints the command for debugging.
+ * The stroke includes a vector (defining the movement direction and distance), already scaled
+ * by the glyph cache, and a pen state (up or down). Depending on the pen state, the command uses either a rapid move (G0) with no
+ * drawing or a linear move (G1) with drawing.
+ *
+ * With path optimisation or serpentine mode enabled the stroke is added to the plan instead,
+ * together with the position it starts from in font order, and drawn by FlushStrokes(). Pen-up
+ * strokes are counted as font-order travel either way. In serpentine mode the first stroke on a
+ * new cursor line sends the previous line before it is collected. With only simplification or
+ * arc fitting the strokes stay in font order, so each polyline is sent as soon as a pen-up
+ * stroke ends it.
  */
-errorCode_t SendStoke(const cursor_t *const cursor, const stroke_t stroke)
+errorCode_t SendStoke(const cursor_t *const cursor, const glyphStroke_t stroke)
 {
-    Coord2D_t pos = AddCoord2D(cursor->posisiton, stroke.vec);                     // Calculate new position
-    const char *command = stroke.pen_state ? "S1000 G1" : "S0 G0";                 // Set command based on pen state
-    char buffer[256];                                                              // Buffer to hold command
-    snprintf(buffer, sizeof(buffer), "%s X%.2lf Y%.2lf\n", command, pos.x, pos.y); // Construct command
+    const bool penDown = stroke.penDown;                             // Pen state of the stroke
+    const Coord2D_t pos = AddCoord2D(cursor->posisiton, stroke.vec); // Calculate new position
+    const Coord2D_t from = penPosition;                              // Where the stroke starts
+    penPosition = pos;                                               // Pen position in font order
+    if (!penDown)                                                    // Pen-up stroke
+        travelFontOrder += DistanceCoord2D(from, pos);               // Count font-order travel
+
+    if (!pathOptimise && !serpentine && !simplify && !arcFitting) // Send straight away
+        return SendMove(penDown ? "S1000" : "S0",                 // Pen down or up
+                        penDown ? "G1" : "G0", pos, NULL);        // Draw or travel
 
-#ifdef Serial_Mode
-    SendCommands(buffer); // Send command
-#endif
+    const bool lineDone = serpentine && cursor->line != strokeLine;     // Stroke starts a new line
+    const bool polylineDone = !pathOptimise && !serpentine && !penDown; // Font order ends the polyline
+    errorCode_t result = SUCCESS;                                       // Worst controller reply
+    if (lineDone || polylineDone)                                       // Check if the collected strokes are complete
+    {
+        result = FlushStrokes();                                   // Draw them
+        strokeLine = cursor->line;                                 // Collect the new line
+        if (result != SUCCESS && result != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+            return result;                                         // Return error
+    }
 
-    printf("%s", buffer); // Print command
-    return SUCCESS;
+    if (!plan)                                                     // Check if plan is created
+        plan = pathPlanConstructor();                              // Create plan
+    if (!plan)                                                     // Check if plan is NULL
+        return ERROR_MEMORY_ALLOCATION_FAILED;                     // Return error
+    const errorCode_t error = plan->add(plan, from, pos, penDown); // Collect stroke
+    return error != SUCCESS ? error : result;                      // Return worst result
 }
 
 /**
@@ -80,32 +225,316 @@ errorCode_t SendStoke(const cursor_t *const cursor, const stroke_t stroke)
  * sending a sequence of commands to prepare the robot. It sets the robot
  * to a known position, starts the spindle or pen movement, sets initial
  * speed parameters, and finally moves the robot to the home position.
- * If the COM port cannot be opened, it reports an error.
+ * If the COM port cannot be opened, or the controller does not send its
+ * startup banner or stops answering, it reports an error. The start-up
+ * commands set the feed rate and the pen state every later line relies
+ * on, so their replies are waited for, and a rejected one stops the start
+ * instead of letting every move of the job be rejected after it. In a dry
+ * run the port is left closed and only the move home is made.
  */
 errorCode_t StartUpRobot(void)
 {
+    if (dryRun)             // No robot to start
+        return HomeRobot(); // Move home
+
     if (CanRS232PortBeOpened() == -1)                       // Check if COM port can be opened
         return ErrorHandler(ERROR_UNABLE_TO_OPEN_COM_PORT); // Handle error
 
-    char buffer[100];        // Buffer to hold command
-    sprintf(buffer, "\n");   // Construct command
-    PrintBuffer(&buffer[0]); // Print command
+    char buffer[100];                            // Buffer to hold command
+    sprintf(buffer, "\n");                       // Construct command
+    if (PrintBuffer(&buffer[0]) != 0)            // Print command
+        return ErrorHandler(ERROR_SERIAL_WRITE); // Handle error
+
+    Sleep(100);                                    // Wait for command to be sent
+    if (WaitForDollar() != 0)                      // Wait for the startup banner
+        return ErrorHandler(ERROR_SERIAL_TIMEOUT); // Handle error
+    Sleep(100);                                    // Let any reply to the wake-up line arrive
+
+    FlushReplyLines();                                                                // Drop replies to the wake-up line
+    stream = grblStreamConstructor(GRBL_RX_BUFFER_SIZE, streamingMode); // Create the command stream
+    controller = gcodeSerialSinkConstructor(stream);                    // Send the job through it
+    if (!controller)                                                    // Check if sink is NULL
+    {
+        stream = NULL;                                       // The sink freed it
+        return ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+    }
+
+    static const char *const setup[] = {"G1 X0 Y0 F1000\n", "M3\n", "S0\n"}; // Start-up commands
+    errorCode_t rejected = SUCCESS;                                          // Worst reply to them
+    for (size_t i = 0; i < sizeof(setup) / sizeof(setup[0]); i++)            // Send each start-up command
+    {
+        const int length = sprintf(buffer, "%s", setup[i]);             // Construct command
+        const errorCode_t error = SendCommands(buffer, (size_t)length); // Send command
+        if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY)        // Check if the robot stopped answering
+            return error;                                               // Return error
+        if (error != SUCCESS)                                           // Check if it was rejected
+            rejected = error;                                           // Remember the error
+    }
+    const errorCode_t synced = controller->flush(controller);  // Wait for every reply
+    if (synced != SUCCESS && synced != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+        return synced;                                         // Return error
+    if (synced != SUCCESS || rejected != SUCCESS)              // Check if a start-up command was rejected
+        return ErrorHandler(ERROR_CONTROLLER_STATE);           // Handle error
+
+    if (writer.init)            // Check if writer is initialized
+        writer.forget(&writer); // The start-up commands changed the controller's state
+
+    return HomeRobot(); // Move robot to home position
+}
+
+/**
+ * @details
+ * The page is finished the way a job is, with HomeRobot(), so the robot stands still at home and
+ * the controller has acknowledged every command of the page before the paper is changed. Each
+ * page command is then sent on a line of its own, followed by the dwell if there is one. The
+ * estimate stops the machine for each of them and adds the dwell; the time a pause takes is not
+ * known. The commands may change any state of the controller, so the writer sends every word of
+ * the next move again, and their replies are waited for: a rejected page command leaves the
+ * controller in a state the next page was not planned for, and ends the job.
+ */
+errorCode_t ChangePage(void)
+{
+    errorCode_t error = HomeRobot();                         // Draw the page and move out of the way
+    if (error != SUCCESS && error != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+        return error;                                        // Return error
+    pageChanges++;                                           // Count the page
+
+    char dwell[32];                                        // Dwell command
+    snprintf(dwell, sizeof(dwell), "G4 P%.3f", pagePause); // Construct it
+    for (int i = 0; i <= numPageCommands; i++)             // Every command, then the dwell
+    {
+        if (i == numPageCommands && pagePause <= 0.0)                                  // Check if there is no dwell
+            break;                                                                     // Done
+        const errorCode_t sent = i < numPageCommands ? SendPause(pageCommands[i], 0.0) // Send command
+                                                     : SendPause(dwell, pagePause);    // Send dwell
+        if (sent != SUCCESS && sent != ERROR_CONTROLLER_REPLY)                         // Check if the robot stopped answering
+            return sent;                                                               // Return error
+        if (sent != SUCCESS)                                                           // Check if it was rejected
+            return ErrorHandler(ERROR_CONTROLLER_STATE);                               // Handle error
+    }
+    if (controller) // Check if there is a robot
+    {
+        const errorCode_t synced = controller->flush(controller); // Wait for the replies to the commands
+        if (synced != SUCCESS && synced != ERROR_CONTROLLER_REPLY) // Check if the robot stopped answering
+            return synced;                                         // Return error
+        if (synced != SUCCESS)                                     // Check if a command was rejected
+            return ErrorHandler(ERROR_CONTROLLER_STATE);           // Handle error
+    }
+
+    if (writer.init)            // Check if writer is initialized
+        writer.forget(&writer); // The commands may have changed the controller's state
+    return error;               // Return worst controller reply
+}
+
+/**
+ * @details
+ * The pen stays where the last polyline ends, so the planner does not count a move after it.
+ */
+errorCode_t FlushStrokes(void)
+{
+    return DrawPlan(NULL); // Draw the collected strokes
+}
+
+/**
+ * @details
+ * Drains the command stream so that every command has been executed or rejected before the
+ * port is closed, then releases the stream and the path plan and flushes the output, which
+ * stays with the caller. A dry run has no stream or port.
+ */
+errorCode_t ShutDownRobot(void)
+{
+    errorCode_t error = SUCCESS; // Worst controller reply
+    if (!dryRun)                 // Check if the robot was used
+    {
+        if (!controller)                             // Check if the robot was started
+            return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+        error = controller->flush(controller);       // Wait for outstanding replies
+        controller->free(controller);                // Free the stream
+        controller = NULL;                           // Forget the stream
+        stream = NULL;                               // Freed with it
+        CloseRS232Port();                            // Close the COM port
+    }
+    if (output)                                            // Check if there is an output
+    {
+        const errorCode_t written = output->flush(output); // Write out the rest
+        if (written != SUCCESS)                            // Check if writing failed
+            error = written;                               // Remember the error
+    }
+
+    if (plan)             // Check if plan is created
+        plan->free(plan); // Free the plan
+    plan = NULL;          // Forget the plan
+    return error;         // Return worst controller reply
+}
+
+/**
+ * @details
+ * Replaces the writer, so the next line carries every word again and the job counters restart.
+ */
+void SetGcodeFormat(const bool compact, const int decimals)
+{
+    gcodeCompact = compact;                             // Set writer mode
+    gcodeDecimals = decimals;                           // Set precision
+    writer = gcodeWriterConstructor(compact, decimals); // Rebuild the writer
+}
+
+/**
+ * @details
+ * Sends the strokes collected so far in the old mode, then records the new one. The next line
+ * is drawn left to right.
+ */
+errorCode_t SetSerpentine(const bool enabled)
+{
+    const errorCode_t error = FlushStrokes(); // Draw what was collected
+    serpentine = enabled;                     // Set line order
+    lineBackwards = false;                    // Start left to right
+    return error;                             // Return worst controller reply
+}
 
-    Sleep(100);      // Wait for command to be sent
-    WaitForDollar(); // Wait for reply
-    Sleep(100);      // Wait for reply
+/**
+ * @details
+ * Sends the strokes collected so far in the old mode, then records the new one. A negative
+ * tolerance is treated as 0.
+ */
+errorCode_t SetSimplify(const bool enabled, const double tolerance)
+{
+    const errorCode_t error = FlushStrokes();              // Draw what was collected
+    simplify = enabled;                                    // Set simplification
+    simplifyTolerance = tolerance > 0.0 ? tolerance : 0.0; // Set tolerance
+    return error;                                          // Return worst controller reply
+}
 
-    sprintf(buffer, "G1 X0 Y0 F1000\n"); // Construct command
-    SendCommands(buffer);                // Send command
+/**
+ * @details
+ * Sends the strokes collected so far in the old mode, then records the new one. A negative
+ * tolerance is treated as 0, which only fits arcs through points lying exactly on a circle.
+ */
+errorCode_t SetArcFitting(const bool enabled, const double tolerance)
+{
+    const errorCode_t error = FlushStrokes();         // Draw what was collected
+    arcFitting = enabled;                             // Set arc fitting
+    arcTolerance = tolerance > 0.0 ? tolerance : 0.0; // Set tolerance
+    return error;                                     // Return worst controller reply
+}
 
-    sprintf(buffer, "M3\n"); // Construct command
-    SendCommands(buffer);    // Send command
+/**
+ * @details
+ * Sends the strokes collected so far in the old mode, then records the new one.
+ */
+errorCode_t SetPathOptimise(const bool enabled)
+{
+    const errorCode_t error = FlushStrokes(); // Draw what was collected
+    pathOptimise = enabled;                   // Set stroke order
+    return error;                             // Return worst controller reply
+}
 
-    sprintf(buffer, "S0\n"); // Construct command
-    SendCommands(buffer);    // Send command
+/**
+ * @details
+ * Clears the writer's line and byte counters, the pen-up travel counters, the simplification
+ * counters and the arc counters, and restarts the estimate from the last position sent.
+ */
+void ResetJobStats(void)
+{
+    if (!writer.init)                                                 // Check if writer is initialized
+        writer = gcodeWriterConstructor(gcodeCompact, gcodeDecimals); // Initialize writer
+    writer.resetCounters(&writer);                                    // Clear counters
+    travelFontOrder = 0.0;                                            // Clear font-order travel
+    travelSent = 0.0;                                                 // Clear sent travel
+    drawMoves = 0;                                                    // Clear pen-down moves
+    drawMovesRemoved = 0;                                             // Clear removed moves
+    arcsSent = 0;                                                     // Clear arcs
+    arcMovesReplaced = 0;                                             // Clear replaced moves
+    pageChanges = 0;                                                  // Clear page changes
 
-    HomeRobot();    // Move robot to home position
-    return SUCCESS; // Return success
+    if (!estimate.init)                                                          // Check if estimator is initialized
+        estimate = plotEstimateConstructor(DefaultMotionModel(), robotPosition); // Initialize estimator
+    estimate.reset(&estimate, robotPosition);                                    // Clear estimate
+}
+
+/**
+ * @details
+ * Prints the number of move lines and bytes sent since ResetJobStats(), and how many bytes modal
+ * compression saved compared with writing every word on every line. The pen-up travel is given
+ * for the strokes in font order and for the moves actually sent. With simplification enabled
+ * the pen-down moves it removed are given as well, with arc fitting enabled the arcs sent, and
+ * the number of pages if the job took more than one.
+ * The estimate gives the plot time and the distances the robot moves with the pen down and up.
+ */
+void PrintJobStats(FILE *const file)
+{
+    const unsigned long saved = writer.bytesFull - writer.bytes;              // Bytes saved by compression
+    fprintf(file, "G-code: %lu lines, %lu bytes (%lu bytes saved, %.1f%%)\n", // Print counters
+            writer.lines, writer.bytes, saved,
+            writer.bytesFull ? 100.0 * saved / writer.bytesFull : 0.0);
+    fprintf(file, "Pen-up travel: %.1f mm in font order, %.1f mm sent (%.1f%% less)\n", // Print travel
+            travelFontOrder, travelSent,
+            travelFontOrder > 0.0 ? 100.0 * (travelFontOrder - travelSent) / travelFontOrder : 0.0);
+    if (simplify)                                                                     // Check if strokes were simplified
+        fprintf(file, "Simplification: %lu of %lu pen-down moves removed (%.1f%%)\n", // Print counters
+                drawMovesRemoved, drawMoves, drawMoves ? 100.0 * drawMovesRemoved / drawMoves : 0.0);
+    if (arcFitting)                                                          // Check if arcs were fitted
+        fprintf(file, "Arc fitting: %lu arcs replaced %lu straight moves\n", // Print counters
+                arcsSent, arcMovesReplaced);
+    if (pageChanges > 0)                                                                                     // Check if the job took several pages
+        fprintf(file, "Pages: %lu, %lu page changes\n", pageChanges + 1, pageChanges);                       // Print pages
+    if (estimate.init)                                                                                       // Check if anything was timed
+        fprintf(file, "Estimate: %.1f s, %.1f mm pen down, %.1f mm pen up, %lu commands, %lu pen changes\n", // Print estimate
+                estimate.time, estimate.penDownDistance, estimate.penUpDistance, estimate.commands, estimate.penLifts);
+}
+
+/**
+ * @details
+ * Records the transfer mode; the stream created by StartUpRobot() picks it up.
+ */
+void SetStreamingMode(const bool enabled)
+{
+    streamingMode = enabled; // Set transfer mode
+}
+
+/**
+ * @details
+ * Records the mode; StartUpRobot() and ShutDownRobot() pick it up.
+ */
+void SetDryRun(const bool enabled)
+{
+    dryRun = enabled; // Set dry run
+}
+
+/**
+ * @details
+ * Records the sink; the next line is written to it. The sink that was set before is not flushed.
+ */
+void SetOutput(gcodeSink_t *const sink)
+{
+    output = sink; // Set output
+}
+
+/**
+ * @details
+ * Checks every command before recording any, so a wrong one leaves the commands as they were.
+ */
+errorCode_t SetPageChange(const char *const commands[], const int numCommands, const double pause)
+{
+    if (numCommands < 0 || numCommands > MAX_PAGE_COMMANDS || !(pause >= 0.0)) // Check if the counts are allowed
+        return ErrorHandler(ERROR_INVALID_INPUT);                              // Handle error
+    for (int i = 0; i < numCommands; i++)                                      // Every command
+        if (!commands[i] || strlen(commands[i]) + 1 > PAGE_COMMAND_LENGTH)     // Check if it fits a line
+            return ErrorHandler(ERROR_INVALID_INPUT);                          // Handle error
+
+    for (int i = 0; i < numCommands; i++) // Every command
+        pageCommands[i] = commands[i];    // Record it
+    numPageCommands = numCommands;        // Record the count
+    pagePause = pause;                    // Record the dwell
+    return SUCCESS;                       // Return success
+}
+
+/**
+ * @details
+ * Replaces the estimator, which starts from the last position sent with empty totals.
+ */
+void SetMotionModel(const motionModel_t model)
+{
+    estimate = plotEstimateConstructor(model, robotPosition); // Rebuild the estimator
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -113,13 +542,214 @@ errorCode_t StartUpRobot(void)
 ///////////////////////////////////////////////////////////////////////
 
 /**
- * @details Sends the provided command buffer to the robot and waits for a
- * reply using the rs232 library.
+ * @details
+ * The command is sent as it is, and not through the writer, which does not know it.
  */
-static errorCode_t SendCommands(char *const buffer)
+static errorCode_t SendPause(const char *command, const double seconds)
 {
-    PrintBuffer(&buffer[0]); // Print command
-    WaitForReply();          // Wait for reply
-    Sleep(1);                // Wait for reply
-    return SUCCESS;          // Return success
+    char buffer[PAGE_COMMAND_LENGTH + 1];                                 // Buffer to hold command
+    const int length = snprintf(buffer, sizeof(buffer), "%s\n", command); // Construct command
+    if (length < 0 || (size_t)length >= sizeof(buffer))                   // Check if it fits
+        return ErrorHandler(ERROR_INVALID_INPUT);                         // Handle error
+    if (estimate.init)                                                    // Check if estimator is initialized
+        estimate.pause(&estimate, seconds);                               // Machine stops
+    return SendLine(buffer, (size_t)length);                              // Send command
+}
+
+/**
+ * @details
+ * G0 moves are counted as pen-up travel. The writer may decide that a move changes nothing on
+ * the controller, in which case nothing is sent, printed or timed.
+ */
+static errorCode_t SendMove(const char *spindle, const char *motion, const Coord2D_t pos, const char *comment)
+{
+    const bool rapid = strcmp(motion, "G0") == 0;          // Pen-up move
+    if (rapid)                                             // Check if the pen is up
+        travelSent += DistanceCoord2D(robotPosition, pos); // Count sent travel
+    robotPosition = pos;                                   // Robot goes there
+
+    if (!writer.init)                                                            // Check if writer is initialized
+        writer = gcodeWriterConstructor(gcodeCompact, gcodeDecimals);            // Initialize writer
+    if (!estimate.init)                                                          // Check if estimator is initialized
+        estimate = plotEstimateConstructor(DefaultMotionModel(), robotPosition); // Initialize estimator
+
+    if (stream)                                                                                                // Check if lines are streamed to a robot
+        writer.track(&writer, stream->linesSent + 1, stream->linesAcked + stream->linesError, stream->linesError); // Tell the writer what has been answered
+
+    char buffer[GCODE_LINE_LENGTH];                                                    // Buffer to hold command
+    const size_t length = writer.move(&writer, buffer, spindle, motion, pos, comment); // Construct command
+    if (length == 0)                                                                   // Nothing to send
+        return SUCCESS;                                                                // Return success
+    estimate.line(&estimate, pos, !rapid);                                             // Time the move
+    return SendLine(buffer, length);                                                   // Send command
+}
+
+/**
+ * @details
+ * An arc always starts with the pen down where the previous move ended, so only the end of the
+ * arc has to be recorded.
+ */
+static errorCode_t SendArc(const char *motion, const Coord2D_t pos, const Coord2D_t offset)
+{
+    robotPosition = pos; // Robot goes there
+
+    if (!writer.init)                                                 // Check if writer is initialized
+        writer = gcodeWriterConstructor(gcodeCompact, gcodeDecimals); // Initialize writer
+
+    if (stream)                                                                                                // Check if lines are streamed to a robot
+        writer.track(&writer, stream->linesSent + 1, stream->linesAcked + stream->linesError, stream->linesError); // Tell the writer what has been answered
+
+    char buffer[GCODE_LINE_LENGTH];                                                  // Buffer to hold command
+    const size_t length = writer.arc(&writer, buffer, "S1000", motion, pos, offset); // Construct command
+    estimate.arc(&estimate, pos, offset, strcmp(motion, "G2") == 0);                 // Time the arc
+    return SendLine(buffer, length);                                                 // Send command
+}
+
+/**
+ * @details
+ * The line goes to the controller, if the robot was started, and then to the output. An error
+ * reply means some line was not applied, so the writer stops relying on the modal state. A
+ * failed output outweighs a rejected line, but not a lost controller.
+ */
+static errorCode_t SendLine(char *const buffer, const size_t length)
+{
+    errorCode_t error = SUCCESS;              // Controller reply
+    if (controller)                           // Check if there is a robot
+        error = SendCommands(buffer, length); // Send command
+    if (error == ERROR_CONTROLLER_REPLY)      // A rejected line did not change the controller's state
+        writer.forget(&writer);               // Send every word again
+
+    if (output) // Check if there is an output
+    {
+        const errorCode_t written = output->write(output, buffer, length);               // Write command
+        if (written != SUCCESS && (error == SUCCESS || error == ERROR_CONTROLLER_REPLY)) // Check if the output failed
+            error = written;                                                             // Report it
+    }
+    return error; // Return worst result
+}
+
+/**
+ * @details Queues the provided command buffer on the controller stream. In streaming
+ * mode this only waits until the command fits in the controller's receive buffer;
+ * otherwise it waits for the command's own reply.
+ */
+static errorCode_t SendCommands(char *const buffer, const size_t length)
+{
+    if (!controller)                             // Check if the robot was started
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    return controller->write(controller, buffer, length); // Send command
+}
+
+/**
+ * @details
+ * Simplifies the collected polylines if enabled, then orders them starting from the robot's
+ * current position, counting the move to `end` after the last one if given, and draws each one
+ * with a G0 move to its first point followed by G1 moves along it. The plan is emptied even if
+ * the robot stops answering. The lines already queued for the robot are written out before the
+ * plan is made, so it keeps drawing while the next strokes are simplified and ordered. If the plan cannot allocate its working memory the polylines are
+ * drawn in font order.
+ *
+ * Without path optimisation the polylines keep font order; in serpentine mode every second
+ * non-empty line is drawn backwards, from the last polyline to the first, each one reversed.
+ */
+static errorCode_t DrawPlan(const Coord2D_t *const end)
+{
+    if (!plan || plan->numPolylines == 0) // Check if there is anything to draw
+    {
+        if (plan)              // Check if plan is created
+            plan->clear(plan); // Forget trailing pen-up strokes
+        return SUCCESS;        // Return success
+    }
+
+    if (stream) // Check if there is a robot
+    {
+        const errorCode_t pushed = stream->push(stream); // Let it draw the lines already sent while planning
+        if (pushed != SUCCESS)                           // Check if the port failed
+        {
+            plan->clear(plan); // Empty the plan
+            return pushed;     // Return error
+        }
+    }
+
+    if (simplify) // Check if strokes may be simplified
+    {
+        drawMoves += plan->numPoints - plan->numPolylines;           // Pen-down moves before
+        drawMovesRemoved += plan->simplify(plan, simplifyTolerance); // Drop the points that change little or nothing
+    }
+
+    if (pathOptimise)                             // Check if the order may change
+        plan->optimise(plan, robotPosition, end); // Order the polylines
+    else if (serpentine && lineBackwards)         // Check if this line runs right to left
+        plan->reverse(plan, 0);                   // Draw it backwards
+    lineBackwards = !lineBackwards;               // Alternate direction
+
+    errorCode_t result = SUCCESS;                   // Worst controller reply
+    for (size_t k = 0; k < plan->numPolylines; k++) // Every polyline in drawing order
+    {
+        const errorCode_t error = DrawPolyline(&plan->polylines[plan->order[k]]); // Draw it
+        if (error == ERROR_CONTROLLER_REPLY)                                      // Check if a command was rejected
+            result = error;                                                       // Remember the error
+        else if (error != SUCCESS)                                                // Check if the robot stopped answering
+        {
+            plan->clear(plan); // Drop the rest of the page
+            return error;      // Return error
+        }
+    }
+
+    plan->clear(plan); // Page done
+    return result;     // Return worst controller reply
+}
+
+/**
+ * @details
+ * Sends a G0 move to the first point, then walks along the polyline. With arc fitting enabled,
+ * each step first tries to fit an arc from the current position; if one covers at least
+ * ARC_MIN_POINTS points and GRBL will accept it after rounding, the whole run is sent as one G2
+ * or G3 move, otherwise the next point is sent as a G1 move. The fitter reads the points in
+ * drawing order, so a reversed polyline is turned around in place first; the plan is cleared
+ * once it has been drawn anyway.
+ */
+static errorCode_t DrawPolyline(pathPolyline_t *const line)
+{
+    Coord2D_t *const points = &plan->points[line->first]; // Points of the polyline
+    if (arcFitting && line->reversed)                     // Check if the points run backwards
+    {
+        for (size_t i = 0, j = line->count - 1; i < j; i++, j--) // Swap from both ends
+        {
+            const Coord2D_t point = points[i]; // Swap the
+            points[i] = points[j];             // two
+            points[j] = point;                 // points
+        }
+        line->reversed = false; // Points now run forwards
+    }
+
+    errorCode_t result = SUCCESS;        // Worst controller reply
+    for (size_t i = 0; i < line->count;) // Every point along it
+    {
+        errorCode_t error;                                                                                          // Controller reply
+        arc_t arc;                                                                                                  // Arc from the current position
+        Coord2D_t offset;                                                                                           // Its I and J words
+        const size_t fitted = arcFitting && i > 0                                                                   // Check if an arc may start here
+                                  ? FitArc(&points[i - 1], line->count - i + 1, arcTolerance, &arc)                 // Fit one
+                                  : 0;                                                                              // No arc
+        if (fitted && ArcCentreOffset(points[i - 1], points[i + fitted - 2], arc.centre, writer.decimals, &offset)) // Check if GRBL will accept it
+        {
+            error = SendArc(arc.clockwise ? "G2" : "G3", points[i + fitted - 2], offset); // Draw the run as one arc
+            arcsSent++;                                                                   // Count arc
+            arcMovesReplaced += fitted - 1;                                               // Count the moves it replaces
+            i += fitted - 1;                                                              // Continue after the run
+        }
+        else // Straight move
+        {
+            error = SendMove(i ? "S1000" : "S0", i ? "G1" : "G0", PathPoint(plan, line, i), NULL); // Travel to the start, then draw
+            i++;                                                                                   // Next point
+        }
+
+        if (error == ERROR_CONTROLLER_REPLY) // Check if the command was rejected
+            result = error;                  // Remember the error
+        else if (error != SUCCESS)           // Check if the robot stopped answering
+            return error;                    // Return error
+    }
+    return result; // Return worst controller reply
 }
@@ -13,9 +13,15 @@
 
 #include "../lib/rs232.h"
 #include "../lib/serial.h"
-#include "../font/fontChar.h"
+#include "../font/glyphCache.h"
 #include "../misc/error.h"
+#include "arcFit.h"
 #include "cursor.h"
+#include "estimate.h"
+#include "gcodeFormat.h"
+#include "gcodeSink.h"
+#include "grbl.h"
+#include "pathPlan.h"
 
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DEFINITIONS                       //
@@ -31,32 +37,194 @@
 
 #define CHARACTER_SPACE_MM 18.0 /**< Default spacing in millimeters between characters. */
 #define LINE_SPACE_MM 5.0       /**< Default line spacing in millimeters. */
+#define LETTER_GAP_UNITS 4.0    /**< Gap between the ink of two letters with proportional spacing, in font units. */
 
 #define MINIMUM_TEXT_HEIGHT_MM 4.0  /**< Minimum permissible text height in millimeters. */
 #define MAXIMUM_TEXT_HEIGHT_MM 10.0 /**< Maximum permissible text height in millimeters. */
 
 #define FONT_FILE "SingleStrokeFont.txt" /**< Default font file name. */
 
+#define STREAMING_MODE true     /**< Default transfer mode: true = character-counting stream, false = wait for each "ok". */
+#define PATH_OPTIMISE false     /**< Default stroke order: true = reorder the strokes of a page, false = font order. */
+#define SERPENTINE_MODE false   /**< Default line order: true = draw line by line, alternate lines right to left. */
+#define PROPORTIONAL_MODE false /**< Default spacing: true = each letter as wide as its ink, false = a character space each. */
+#define BALANCE_MODE false      /**< Default line breaking: true = balance the lines of each paragraph, false = greedy. */
+
+#define SIMPLIFY_MODE false       /**< Default stroke simplification: true = merge collinear strokes, false = send every stroke. */
+#define SIMPLIFY_TOLERANCE_MM 0.0 /**< Default Douglas-Peucker tolerance in mm on the page, 0 for the exact merge only. */
+#define ARC_FIT_MODE false        /**< Default arc fitting: true = send curved runs as G2/G3, false = G1 only. */
+#define ARC_TOLERANCE_MM 0.02     /**< Default distance in mm a fitted arc may stray from the strokes. */
+
+#define DRY_RUN_MODE false /**< Default run mode: true = estimate the job without opening the port, false = drive the robot. */
+
+#define PAGE_CHANGE_GCODE "M0" /**< Default command sent between pages: pause until the cycle is started again. */
+#define PAGE_PAUSE_S 0.0       /**< Default dwell in s sent between pages, 0 for none. */
+#define MAX_PAGE_COMMANDS 4    /**< Most commands sent between pages. */
+#define PAGE_COMMAND_LENGTH 80 /**< Longest command sent between pages, including its line end. */
+
 ///////////////////////////////////////////////////////////////////////
 //                        PUBLIC   DECLARATIONS                      //
 ///////////////////////////////////////////////////////////////////////
 
 /**
  * @brief Initializes and starts up the robot.
- * @return SUCCESS on successful startup, or an appropriate error code if startup fails.
+ * @return SUCCESS on successful startup, ERROR_CONTROLLER_STATE if the controller rejected a
+ *         start-up command, or an appropriate error code if startup fails.
  */
 errorCode_t StartUpRobot(void);
 
+/**
+ * @brief Waits for every queued command to be acknowledged, then closes the COM port.
+ * @return SUCCESS on success, or the worst error reported by the controller while draining.
+ */
+errorCode_t ShutDownRobot(void);
+
+/**
+ * @brief Selects how commands are transferred to the robot.
+ * @details Must be called before StartUpRobot() to take effect.
+ * @param[in] enabled true to stream with character counting, false to wait for each reply.
+ */
+void SetStreamingMode(const bool enabled);
+
+/**
+ * @brief Selects whether the job is only estimated.
+ * @details
+ * In a dry run StartUpRobot() does not open the COM port and no command is sent; the G-code is
+ * still written to stdout and the estimate printed by PrintJobStats() is made as usual. Must be
+ * called before StartUpRobot() to take effect.
+ * @param[in] enabled true for a dry run, false to drive the robot.
+ */
+void SetDryRun(const bool enabled);
+
+/**
+ * @brief Selects where the G-code is written as it is sent, besides the controller.
+ * @details The output is flushed at the end of every job and by ShutDownRobot().
+ * @param[in] sink Sink to write to, or NULL to write the G-code nowhere. The caller frees it.
+ */
+void SetOutput(gcodeSink_t *const sink);
+
+/**
+ * @brief Selects the machine settings used to estimate the plot time.
+ * @details Takes effect immediately and restarts the estimate.
+ * @param[in] model Maximum rate, acceleration, junction deviation and the other settings of the machine.
+ */
+void SetMotionModel(const motionModel_t model);
+
+/**
+ * @brief Selects how move lines are written.
+ * @details Takes effect immediately and restarts the job counters.
+ * @param[in] compact true to leave out words the controller already holds, false to write every word.
+ * @param[in] decimals Number of decimals for coordinates (0 to GCODE_MAX_DECIMALS).
+ */
+void SetGcodeFormat(const bool compact, const int decimals);
+
+/**
+ * @brief Selects whether strokes are reordered to shorten pen-up travel.
+ * @details Strokes already collected are sent first, in the mode they were collected in.
+ * @param[in] enabled true to collect the strokes of a page and draw them in an optimised order,
+ *            false to send every stroke as soon as it arrives.
+ */
+errorCode_t SetPathOptimise(const bool enabled);
+
+/**
+ * @brief Selects whether the page is drawn line by line in serpentine order.
+ * @details
+ * In serpentine mode each line of text is drawn as soon as the cursor leaves it, so the pen never
+ * travels back to the left margin: in font order every second line is drawn right to left, with
+ * path optimisation each line is ordered starting from where the previous one ended. The text
+ * still reads normally. Strokes already collected are sent first.
+ * @param[in] enabled true to draw line by line in serpentine order, false to draw as before.
+ * @return SUCCESS on success, or an appropriate error code if sending the collected strokes fails.
+ */
+errorCode_t SetSerpentine(const bool enabled);
+
+/**
+ * @brief Selects whether pen-down strokes are simplified before they are sent.
+ * @details
+ * Simplification merges runs of collinear strokes into one G1 move, which leaves the drawing
+ * exactly as it was. With a positive tolerance, points that lie closer than that to the
+ * simplified line are removed as well. The tolerance is a distance on the page, so the same
+ * tolerance removes more detail from smaller text. Strokes already collected are sent first.
+ * @param[in] enabled true to simplify, false to send every stroke.
+ * @param[in] tolerance Douglas-Peucker tolerance in mm, 0 for the exact merge only.
+ * @return SUCCESS on success, or an appropriate error code if sending the collected strokes fails.
+ */
+errorCode_t SetSimplify(const bool enabled, const double tolerance);
+
+/**
+ * @brief Selects whether curved runs of pen-down strokes are sent as arcs.
+ * @details
+ * With arc fitting enabled, every run of at least ARC_MIN_POINTS points that lies on a circular
+ * arc within the tolerance is sent as one G2 or G3 move instead of a G1 move per stroke. Arcs
+ * GRBL would reject after rounding are sent as straight moves. Strokes already collected are
+ * sent first.
+ * @param[in] enabled true to fit arcs, false to send straight moves only.
+ * @param[in] tolerance Largest distance in mm between an arc and the strokes it replaces.
+ * @return SUCCESS on success, or an appropriate error code if sending the collected strokes fails.
+ */
+errorCode_t SetArcFitting(const bool enabled, const double tolerance);
+
+/**
+ * @brief Selects what is sent between the pages of a job.
+ * @details
+ * A job longer than a page is drawn page by page, each from the top of the page. Between two
+ * pages the robot draws the page, moves home, waits until every command is acknowledged, and
+ * then sends these commands so that the paper can be changed: by default M0, which pauses the
+ * robot until its cycle is started again, or commands that drive a paper feeder, or a dwell that
+ * gives time to change the paper by hand. The commands are sent as they are given.
+ * @param[in] commands G-code lines without line ends; they are not copied and must outlive the jobs.
+ * @param[in] numCommands Number of lines, from 0 to MAX_PAGE_COMMANDS.
+ * @param[in] pause Dwell in s sent after the lines, 0 for none.
+ * @return SUCCESS, or ERROR_INVALID_INPUT if there are too many lines, a line is longer than
+ *         PAGE_COMMAND_LENGTH allows, or the dwell is negative.
+ */
+errorCode_t SetPageChange(const char *const commands[], const int numCommands, const double pause);
+
+/**
+ * @brief Ends a page of the job and starts the next.
+ * @details Sends the page, moves home like HomeRobot() and sends the commands chosen with
+ *          SetPageChange(). The page is counted in the job statistics.
+ * @return SUCCESS on success, ERROR_CONTROLLER_REPLY if a line of the page was rejected,
+ *         ERROR_CONTROLLER_STATE if the move home or a page command was rejected, or an
+ *         appropriate error code if sending fails.
+ */
+errorCode_t ChangePage(void);
+
+/**
+ * @brief Sends the strokes collected since the last flush, in optimised order.
+ * @details HomeRobot() draws the collected strokes before moving home, planning the way home with
+ *          them, so a job is complete once it has homed.
+ * @return SUCCESS on success, or an appropriate error code if sending fails.
+ */
+errorCode_t FlushStrokes(void);
+
+/**
+ * @brief Restarts the line, byte and travel counters and the estimate of the current job.
+ */
+void ResetJobStats(void);
+
+/**
+ * @brief Prints the counters of the current job, including the bytes saved by compression, the
+ *        pen-up travel before and after reordering, and the estimated plot time.
+ * @param[in] file Stream to print to, e.g. stderr.
+ */
+void PrintJobStats(FILE *const file);
+
 /**
  * @brief Sends a stroke command to the robot based on the current cursor position.
+ * @details With path optimisation, serpentine mode, simplification or arc fitting enabled the
+ *          stroke is collected and sent by FlushStrokes().
  * @param[in] cursor Pointer to the cursor_t structure representing the robot's current position.
- * @param[in] stroke The stroke_t structure containing the vector and pen state to apply.
+ * @param[in] stroke The stroke, scaled to the size of the cursor, containing the vector and pen
+ *                   state to apply.
  * @return SUCCESS on success, or an appropriate error code if sending the stroke fails.
  */
-errorCode_t SendStoke(const cursor_t *const cursor, const stroke_t stroke);
+errorCode_t SendStoke(const cursor_t *const cursor, const glyphStroke_t stroke);
 
 /**
  * @brief Moves the robot to its home position.
- * @return SUCCESS on success, or an appropriate error code if moving to home fails.
+ * @return SUCCESS on success, ERROR_CONTROLLER_REPLY if a line drawn before was rejected,
+ *         ERROR_CONTROLLER_STATE if the move home itself was rejected, which leaves the pen
+ *         state unknown, or an appropriate error code if moving to home fails.
  */
 errorCode_t HomeRobot(void);
@@ -0,0 +1,139 @@
+/**
+ * @file simplify.c
+ * @brief Implementation of the collinear merge and the Douglas-Peucker simplification.
+ * @details
+ * Both functions write the points they keep to the front of the array while reading further
+ * ahead, so no second array is needed. Douglas-Peucker is run with an explicit stack of split
+ * points instead of recursion, and finishes the ranges from left to right, which is what lets it
+ * write its result in place.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "simplify.h"
+
+#include <stdbool.h>
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Checks whether a point can be left out between two others without changing the ink.
+ * @param[in] a The point before.
+ * @param[in] b The point in question.
+ * @param[in] c The point after.
+ * @return true if b lies on the segment from a to c and a->b->c never turns back.
+ */
+static inline bool _onSegment(const Coord2D_t a, const Coord2D_t b, const Coord2D_t c);
+
+/**
+ * @brief Calculates the distance from a point to a segment.
+ * @param[in] p The point.
+ * @param[in] a Start of the segment.
+ * @param[in] b End of the segment.
+ * @return Distance in mm.
+ */
+static inline double _segmentDistance(const Coord2D_t p, const Coord2D_t a, const Coord2D_t b);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * Each point is appended to the kept ones after removing the kept points it makes redundant, so
+ * a straight run of any length collapses onto its two ends in a single pass.
+ */
+size_t MergeCollinear(Coord2D_t *const points, const size_t count)
+{
+    if (count <= 2)   // Nothing can be removed
+        return count; // Keep every point
+
+    size_t kept = 1;                   // The first point is always kept
+    for (size_t i = 1; i < count; i++) // Every further point
+    {
+        const Coord2D_t next = points[i];                                         // Point to append
+        while (kept >= 2 && _onSegment(points[kept - 2], points[kept - 1], next)) // Last kept point is redundant
+            kept--;                                                               // Drop it
+        points[kept++] = next;                                                    // Keep the new point
+    }
+    return kept; // Return number of points left
+}
+
+/**
+ * @details
+ * The stack holds the ends of the ranges still to be checked, the nearest on top; every range
+ * starts at the last point kept. If some point of the range lies farther than the tolerance
+ * from its chord, the range is split there, otherwise the end of the range is kept.
+ */
+size_t SimplifyPolyline(Coord2D_t *const points, const size_t count, const double tolerance, size_t *const stack)
+{
+    if (count <= 2)   // Nothing can be removed
+        return count; // Keep every point
+
+    size_t kept = 1;            // The first point is always kept
+    size_t anchor = 0;          // Index of the last point kept
+    Coord2D_t from = points[0]; // The last point kept
+    size_t depth = 0;           // Ranges on the stack
+    stack[depth++] = count - 1; // Whole polyline
+
+    while (depth > 0) // Until every range is done
+    {
+        const size_t last = stack[depth - 1];      // End of the range
+        size_t farthest = anchor;                  // Point farthest from the chord
+        double distance = 0.0;                     // Its distance
+        for (size_t i = anchor + 1; i < last; i++) // Every point inside the range
+        {
+            const double d = _segmentDistance(points[i], from, points[last]); // Distance from the chord
+            if (d > distance)                                                 // Farther than the others
+            {
+                distance = d; // Remember distance
+                farthest = i; // Remember point
+            }
+        }
+
+        if (distance > tolerance)      // Chord too far from the polyline
+            stack[depth++] = farthest; // Split the range at the farthest point
+        else                           // Chord close enough
+        {
+            from = points[last];   // End of the range
+            points[kept++] = from; // is kept
+            anchor = last;         // Next range starts there
+            depth--;               // Range done
+        }
+    }
+    return kept; // Return number of points left
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The cross product of a->b and b->c is the distance of b from the line a->c times its length,
+ * so b is on the line when that distance is below SIMPLIFY_EPSILON_MM, far below the resolution
+ * of the G-code. A negative dot product means the pen turns back at b and draws over itself,
+ * which would leave the part beyond c undrawn if b were removed.
+ */
+static inline bool _onSegment(const Coord2D_t a, const Coord2D_t b, const Coord2D_t c)
+{
+    const Coord2D_t ab = SubCoord2D(b, a);                                                         // First segment
+    const Coord2D_t bc = SubCoord2D(c, b);                                                         // Second segment
+    const bool onLine = fabs(CrossCoord2D(ab, bc)) <= SIMPLIFY_EPSILON_MM * DistanceCoord2D(a, c); // Close enough to the line
+    return onLine && DotCoord2D(ab, bc) >= 0.0;                                                    // and in the same direction
+}
+
+/**
+ * @details
+ * The point is projected onto the line through the segment and the projection clamped to the
+ * segment, which also covers a segment of zero length, e.g. the chord of a closed loop.
+ */
+static inline double _segmentDistance(const Coord2D_t p, const Coord2D_t a, const Coord2D_t b)
+{
+    const Coord2D_t ab = SubCoord2D(b, a);                                       // Segment direction
+    const double length2 = DotCoord2D(ab, ab);                                   // Squared length
+    double t = length2 > 0.0 ? DotCoord2D(SubCoord2D(p, a), ab) / length2 : 0.0; // Position of the projection
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;                                       // Clamp to the segment
+    return DistanceCoord2D(p, AddCoord2D(a, ScaleCoord2D(ab, t)));               // Distance to it
+}
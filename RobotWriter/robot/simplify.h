@@ -0,0 +1,53 @@
+/**
+ * @file simplify.h
+ * @brief Declarations of the polyline simplification functions used on the pen-down strokes.
+ * @details
+ * The strokes of a glyph often come as runs of short segments along one straight line, such as
+ * the vertical stem of a '1'. Each segment becomes a G1 command of its own that the controller
+ * has to plan, and at every junction between them it may have to slow down. MergeCollinear()
+ * removes the points that lie on the straight line between their neighbours, which leaves the
+ * ink exactly as it was. SimplifyPolyline() goes further and removes every point that is closer
+ * than a tolerance to the simplified line (Douglas-Peucker).
+ *
+ * Both work in place on an array of points in millimetres, so the tolerance is a distance on the
+ * page at the current text height.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "../misc/coord.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define SIMPLIFY_EPSILON_MM 1e-9 /**< Distance from a line below which a point counts as lying on it. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Removes the points of a polyline that lie on the segment between their neighbours.
+ * @details Repeated points are removed too. A point where the polyline turns back on itself is
+ *          kept, as is a polyline of two points even if they coincide, since it still marks a dot.
+ * @param[in,out] points The points, shortened in place.
+ * @param[in] count Number of points.
+ * @return Number of points left, at least min(count, 2).
+ */
+size_t MergeCollinear(Coord2D_t *const points, const size_t count);
+
+/**
+ * @brief Simplifies a polyline with the Douglas-Peucker algorithm.
+ * @details The first and last points are always kept. Every point removed lies within
+ *          `tolerance` of the segment that replaces it.
+ * @param[in,out] points The points, shortened in place.
+ * @param[in] count Number of points.
+ * @param[in] tolerance Largest distance in mm between a removed point and the simplified line.
+ * @param[out] stack Working memory with room for `count` indices.
+ * @return Number of points left, at least min(count, 2).
+ */
+size_t SimplifyPolyline(Coord2D_t *const points, const size_t count, const double tolerance, size_t *const stack);
@@ -0,0 +1,222 @@
+/**
+ * @file textReader.c
+ * @brief Implementation of the text reader.
+ * @details
+ * The buffer holds the word being read and the bytes read after it. When the search for the end
+ * of the word reaches the end of the bytes read, the word is moved to the front of the buffer and
+ * the rest of the buffer filled from the file in one fread(); the buffer doubles first if the word
+ * fills all of it. The search goes on from where it stopped, so every byte is looked at once.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#include "textReader.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TEXT_READER_SWAR /**< Delimiters are searched for eight bytes at a time. */
+#endif
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DECLARATIONS                     //
+///////////////////////////////////////////////////////////////////////
+
+#define TEXT_READER_ONES 0x0101010101010101u  /**< A one in every byte of a uint64_t. */
+#define TEXT_READER_HIGHS 0x8080808080808080u /**< The high bit of every byte of a uint64_t. */
+
+/**
+ * @brief Reads the next word.
+ * @param[in,out] self Pointer to the textReader_t structure.
+ * @param[out] word The word, of length 0 at the end of the file.
+ * @return SUCCESS, ERROR_NULL_POINTER, ERROR_TEXT_READ or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _read(textReader_t *const self, textView_t *const word);
+
+/**
+ * @brief Finds the first space, newline or carriage return in a range of bytes.
+ * @param[in] text Start of the range.
+ * @param[in] end End of the range.
+ * @return The delimiter, or NULL if the range has none.
+ */
+static const char *_delimiter(const char *text, const char *const end);
+
+/**
+ * @brief Moves the word being read to the front of the buffer and fills the rest from the file.
+ * @param[in,out] self Pointer to the textReader_t structure, with the file not yet at its end.
+ * @return SUCCESS, ERROR_TEXT_READ or ERROR_MEMORY_ALLOCATION_FAILED.
+ */
+static errorCode_t _fill(textReader_t *const self);
+
+/**
+ * @brief Frees the buffer and the reader itself.
+ * @param[in,out] self Pointer to the textReader_t structure.
+ * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+ */
+static errorCode_t _free(textReader_t *self);
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The buffer is allocated with the reader, but nothing is read from the file until the first
+ * word is.
+ */
+textReader_t *textReaderConstructor(FILE *const file)
+{
+    if (!file) // Check if file is NULL
+    {
+        ErrorHandler(ERROR_NO_TEXT_FILE); // Handle error
+        return NULL;                      // Return NULL
+    }
+
+    textReader_t *reader = calloc(1, sizeof(textReader_t)); // Allocate cleared memory for textReader_t
+    if (!reader)                                            // Check if memory allocation failed
+    {
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    reader->buffer = malloc(TEXT_READER_BLOCK); // Allocate buffer
+    if (!reader->buffer)                        // Check if memory allocation failed
+    {
+        free(reader);                                 // Free textReader_t
+        ErrorHandler(ERROR_MEMORY_ALLOCATION_FAILED); // Handle error
+        return NULL;                                  // Return NULL
+    }
+
+    reader->file = file;                  // Set file
+    reader->capacity = TEXT_READER_BLOCK; // Set buffer size
+    reader->start = reader->buffer;       // No word yet
+    reader->scan = reader->buffer;        // Nothing searched yet
+    reader->end = reader->buffer;         // Nothing read yet
+    reader->endOfFile = false;            // File not read to its end
+    reader->read = _read;                 // Function pointer to read a word
+    reader->free = _free;                 // Function pointer to free the reader
+    return reader;                        // Return textReader_t
+}
+
+///////////////////////////////////////////////////////////////////////
+//                        PRIVATE   DEFINITIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @details
+ * The word ends at its delimiter, which it includes. The bytes after the last delimiter of the
+ * file are the last word, and the word after that is empty.
+ */
+static errorCode_t _read(textReader_t *const self, textView_t *const word)
+{
+    if (!self || !word)                          // Check if self or word is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    for (;;) // Search until the word ends
+    {
+        const char *const delimiter = _delimiter(self->scan, self->end); // End of the word
+        if (delimiter)                                                   // Check if it was found
+        {
+            word->text = self->start;                             // Set word
+            word->length = (size_t)(delimiter + 1 - self->start); // Set its length, delimiter included
+            self->start = self->scan = delimiter + 1;             // Next word starts after it
+            return SUCCESS;                                       // Return success
+        }
+        self->scan = self->end; // Everything read has been searched
+
+        if (self->endOfFile) // Check if the file has been read to its end
+        {
+            word->text = self->start;                         // Set the last word
+            word->length = (size_t)(self->end - self->start); // Set its length, 0 if there is none
+            self->start = self->end;                          // Nothing left
+            return SUCCESS;                                   // Return success
+        }
+
+        const errorCode_t error = _fill(self); // Read more of the file
+        if (error != SUCCESS)                  // Check if it could be read
+            return ErrorHandler(error);        // Handle error
+    }
+}
+
+/**
+ * @details
+ * Where the compiler can find the lowest set bit of a word and the machine is little-endian,
+ * eight bytes are tested at once for any byte up to the space, and only the first such byte is
+ * looked at; otherwise, and for the last bytes of the range, the bytes are tested one at a time.
+ * Either way a byte above the space, which is nearly every byte of a text, is passed over with
+ * no more than a comparison.
+ */
+static const char *_delimiter(const char *text, const char *const end)
+{
+#ifdef TEXT_READER_SWAR
+    while (end - text >= (ptrdiff_t)sizeof(uint64_t)) // Eight bytes at a time
+    {
+        uint64_t bytes;                                                                      // Next eight bytes
+        memcpy(&bytes, text, sizeof(bytes));                                                 // Load them
+        const uint64_t low = (bytes - TEXT_READER_ONES * 0x21) & ~bytes & TEXT_READER_HIGHS; // High bit of each byte up to the space
+        if (!low)                                                                            // Check if there is none
+        {
+            text += sizeof(bytes); // Move past them
+            continue;              // Test the next eight
+        }
+
+        text += __builtin_ctzll(low) / 8;                   // First byte up to the space
+        if (*text == ' ' || *text == '\n' || *text == '\r') // Check if it is a delimiter
+            return text;                                    // Return it
+        text++;                                             // Move past it
+    }
+#endif
+    for (; text < end; text++)                                                               // Iterate through bytes
+        if ((unsigned char)*text <= ' ' && (*text == ' ' || *text == '\n' || *text == '\r')) // Check if it is a delimiter
+            return text;                                                                     // Return it
+    return NULL;                                                                             // No delimiter
+}
+
+/**
+ * @details
+ * A word that fills the whole buffer doubles it, so a word has no length limit; the buffer is
+ * never shrunk again, which keeps it as large as the longest word of the file.
+ */
+static errorCode_t _fill(textReader_t *const self)
+{
+    const size_t kept = (size_t)(self->end - self->start);     // Bytes of the word being read
+    const size_t scanned = (size_t)(self->scan - self->start); // Bytes of it already searched
+    if (kept == self->capacity)                                // Check if the word fills the buffer
+    {
+        if (self->capacity > SIZE_MAX / 2)         // Check if the buffer can double
+            return ERROR_MEMORY_ALLOCATION_FAILED; // Return error
+
+        char *const grown = realloc(self->buffer, self->capacity * 2); // Double the buffer
+        if (!grown)                                                    // Check if memory allocation failed
+            return ERROR_MEMORY_ALLOCATION_FAILED;                     // Return error
+        self->buffer = grown;                                          // Use the larger buffer
+        self->capacity *= 2;                                           // Remember its size
+    }
+    else if (kept > 0 && self->start != self->buffer) // Check if the word has to move
+        memmove(self->buffer, self->start, kept);     // Move it to the front
+
+    self->start = self->buffer;                                           // Word at the front
+    self->scan = self->buffer + scanned;                                  // Search goes on where it stopped
+    const size_t wanted = self->capacity - kept;                          // Bytes free after the word
+    const size_t got = fread(self->buffer + kept, 1, wanted, self->file); // Fill them
+    self->end = self->buffer + kept + got;                                // End of the bytes read
+    if (got < wanted)                                                     // Check if the file ended
+    {
+        if (ferror(self->file))     // Check if reading failed
+            return ERROR_TEXT_READ; // Return error
+        self->endOfFile = true;     // File read to its end
+    }
+    return SUCCESS; // Return success
+}
+
+static errorCode_t _free(textReader_t *self)
+{
+    if (!self)                                   // Check if self is NULL
+        return ErrorHandler(ERROR_NULL_POINTER); // Handle error
+
+    free(self->buffer); // Free buffer
+    free(self);         // Free textReader_t
+
+    return SUCCESS; // Return success
+}
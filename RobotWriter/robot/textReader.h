@@ -0,0 +1,78 @@
+/**
+ * @file textReader.h
+ * @brief Declaration of the textReader_t structure, which splits a text file into words.
+ * @details
+ * The reader reads the file in blocks of TEXT_READER_BLOCK bytes into one buffer and hands out
+ * each word as a view into that buffer, without copying it. A word is the text up to and
+ * including the next space, newline or carriage return, or up to the end of the file for the
+ * last word. Only the word being read has to fit the buffer, which grows when a word is longer
+ * than it, so memory depends on the longest word and not on the size of the file, and a word has
+ * no length limit. Files that cannot be sized or mapped, such as a pipe on standard input, are
+ * read the same way.
+ * @note View documentation at https://georgedowning20.github.io/MMME3085-RobotWriter/
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "../misc/error.h"
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DEFINITIONS                       //
+///////////////////////////////////////////////////////////////////////
+
+#define TEXT_READER_BLOCK 65536 /**< Bytes read from the file at a time, and the initial size of the buffer. */
+
+///////////////////////////////////////////////////////////////////////
+//                        PUBLIC   DECLARATIONS                      //
+///////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A word of the text, viewed in place in the reader's buffer.
+ * @details The view is not NUL-terminated and stays valid until the next word is read.
+ */
+typedef struct textView_s
+{
+    const char *text; /**< First byte of the word. */
+    size_t length;    /**< Bytes of the word, its delimiter included; 0 at the end of the file. */
+} textView_t;
+
+/**
+ * @brief Structure reading the words of a text file through one buffer.
+ */
+typedef struct textReader_s
+{
+    FILE *file;        /**< File read, not owned. */
+    char *buffer;      /**< Buffer the file is read into. */
+    size_t capacity;   /**< Bytes the buffer holds. */
+    const char *start; /**< Start of the word being read. */
+    const char *scan;  /**< Where the search for the end of the word goes on from. */
+    const char *end;   /**< End of the bytes read into the buffer. */
+    bool endOfFile;    /**< true once the file has been read to its end. */
+
+    /**
+     * @brief Reads the next word.
+     * @param[in,out] self Pointer to the textReader_t structure.
+     * @param[out] word The word, of length 0 at the end of the file.
+     * @return SUCCESS, ERROR_TEXT_READ if the file cannot be read, or
+     *         ERROR_MEMORY_ALLOCATION_FAILED if the buffer cannot grow for a long word.
+     */
+    errorCode_t (*read)(struct textReader_s *const self, textView_t *const word);
+
+    /**
+     * @brief Frees the reader and its buffer; the file is left open.
+     * @param[in,out] self Pointer to the textReader_t structure.
+     * @return SUCCESS, or ERROR_NULL_POINTER if `self` is NULL.
+     */
+    errorCode_t (*free)(struct textReader_s *self);
+} textReader_t;
+
+/**
+ * @brief Constructs a reader for a text file.
+ * @param[in] file The file, read from its current position.
+ * @return A pointer to the newly created textReader_t object, or NULL if allocation fails.
+ */
+textReader_t *textReaderConstructor(FILE *const file);